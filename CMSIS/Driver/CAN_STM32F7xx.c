@@ -18,8 +18,8 @@
  * 3. This notice may not be removed or altered from any source distribution.
  *
  *
- * $Date:        4. November 2016
- * $Revision:    V1.6
+ * $Date:        19. October 2026
+ * $Revision:    V1.12
  *
  * Driver:       Driver_CAN1/2/3
  * Configured:   via RTE_Device.h configuration file
@@ -44,9 +44,51 @@
  *   CAN2_FILTER_BANK_NUM: defines maximum number of Filter Banks used for CAN2 controller (0..28)
  *                         (sum of maximum number of Filter Banks used for CAN1 and CAN2 must not exceed 28)
  *     - default value:    14
+ *   CANn_RX_QUEUE_SIZE:   defines size (in messages) of software receive queue per receive object
+ *                         of CANn controller (n = 1..3), 0 = disabled
+ *     - default value:    RTE_CANn_RX_QUEUE_SIZE from RTE_Device.h, otherwise 0
+ *   CANn_TX_QUEUE_SIZE:   defines size (in messages) of software transmit priority queue
+ *                         of CANn controller (n = 1..3), 0 = disabled
+ *     - default value:    RTE_CANn_TX_QUEUE_SIZE from RTE_Device.h, otherwise 0
+ *   CAN_FILTER_TERM_NUM:  defines maximum number of merged filter terms handled by filter table compiler
+ *     - default value:    56
+ *   CAN_LOAD_WINDOW_MS:   defines length (in ms) of sliding window used for bus load calculation
+ *                         (multiple of 10 ms)
+ *     - default value:    1000
+ *   CAN_ROUTE_NUM:        defines maximum number of routing entries per controller, 0 = routing disabled
+ *                         (routing requires software receive queue on input and software transmit
+ *                         queue on output controller)
+ *     - default value:    0
+ *   CAN_ROUTE_QUEUE_SIZE: defines size (in messages) of forwarding queue per output controller
+ *     - default value:    16
  * -------------------------------------------------------------------------- */
 
 /* History:
+ *  Version 1.12
+ *    Added frame routing between controllers in receive interrupt routine (ARM_CAN_SET_ROUTE_TABLE)
+ *    Time stamp counter wraps during idle bus are resynchronized from HAL tick
+ *    latched in receive and transmit interrupt routines
+ *    SetMode(ARM_CAN_MODE_NORMAL) enters initialization mode before clearing loopback and silent mode
+ *    Transmit interrupt routine without transmit queue clears request completed flag also for failed
+ *    (automatic retransmission disabled) and aborted transmissions
+ *    Standard identifier maskable filter with ARM_CAN_ID_IDE_Msk in mask compares identifier format
+ *    (was remote frame bit)
+ *    Unused half of dual 16-bit filter bank (ObjectSetFilter) repeats the other half instead of
+ *    staying 0 (16-bit mask 0 accepted all frames, 16-bit list 0 accepted identifier 0)
+ *  Version 1.11
+ *    Added bus load and error statistics (ARM_CAN_CONTROL_STATISTICS, ARM_CAN_GET_STATISTICS)
+ *    Error interrupt flag is cleared also when unit event callback is not registered
+ *  Version 1.10
+ *    Added time stamping in time triggered communication mode (ARM_CAN_CONTROL_TIMESTAMP)
+ *    Added 64-bit receive and transmit time stamps (ARM_CAN_GET_TIMESTAMP, software receive queue)
+ *  Version 1.9
+ *    Added filter table compiler (ARM_CAN_SET_FILTER_TABLE) with CAN1/CAN2 filter bank rebalancing
+ *  Version 1.8
+ *    Added optional software transmit queue ordered by identifier priority
+ *    Added abort and replace of lower priority transmit mailbox (ARM_CAN_CONTROL_TX_REPLACE)
+ *  Version 1.7
+ *    Added optional software receive queue filled in receive interrupt routine
+ *    Added batched read from software receive queue (ARM_CAN_READ_RX_QUEUE)
  *  Version 1.6
  *    Added CAN3
  *  Version 1.5
@@ -117,6 +159,19 @@ Configuration tab
           PA11     | CAN1_RX       | Alternate ..| No pull-up and no..| High        |.
           PA12     | CAN1_TX       | Alternate ..| No pull-up and no..| High        |.
      - Click \b OK to close the CAN1 Configuration dialog
+
+Time stamps
+-----------
+  With \b ARM_CAN_CONTROL_TIMESTAMP enabled the controller captures a 16-bit bit time counter at
+  start of each frame; the driver extends it to the 64-bit time returned by \b ARM_CAN_GET_TIMESTAMP.
+  The 16-bit counter wraps every 65536 bit times. Wraps while the bus is idle are counted from the
+  elapsed HAL tick (\b HAL_GetTick, 1 ms) and the bitrate set by \b SetBitrate, so the time base
+  also stays correct after idle periods longer than 32768 bit times. The tick is latched in the
+  receive and transmit interrupt routines when the message is signaled, so a message may be read
+  any time later; only messages read with the receive interrupt disabled (polling) use the tick at
+  read time. Without this reference (tick not running) time stamps must be captured at least every
+  32768 bit times. Time stamps older than the newest captured one (for example message read later
+  from the other receive FIFO) must be less than 32768 bit times older.
 */
 
 /*! \cond */
@@ -143,6 +198,82 @@ Configuration tab
 
 #define CAN3_FILTER_BANK_NUM            (14UL)
 
+// Maximum number of merged filter terms handled by filter table compiler
+#ifndef CAN_FILTER_TERM_NUM
+#define CAN_FILTER_TERM_NUM             (56U)
+#endif
+
+// Software receive queue size (in messages per receive object) for CAN1 controller
+#ifndef CAN1_RX_QUEUE_SIZE
+#ifdef  RTE_CAN1_RX_QUEUE_SIZE
+#define CAN1_RX_QUEUE_SIZE              (RTE_CAN1_RX_QUEUE_SIZE)
+#else
+#define CAN1_RX_QUEUE_SIZE              (0U)
+#endif
+#endif
+// Software receive queue size (in messages per receive object) for CAN2 controller
+#ifndef CAN2_RX_QUEUE_SIZE
+#ifdef  RTE_CAN2_RX_QUEUE_SIZE
+#define CAN2_RX_QUEUE_SIZE              (RTE_CAN2_RX_QUEUE_SIZE)
+#else
+#define CAN2_RX_QUEUE_SIZE              (0U)
+#endif
+#endif
+// Software receive queue size (in messages per receive object) for CAN3 controller
+#ifndef CAN3_RX_QUEUE_SIZE
+#ifdef  RTE_CAN3_RX_QUEUE_SIZE
+#define CAN3_RX_QUEUE_SIZE              (RTE_CAN3_RX_QUEUE_SIZE)
+#else
+#define CAN3_RX_QUEUE_SIZE              (0U)
+#endif
+#endif
+
+// Software transmit queue size (in messages) for CAN1 controller
+#ifndef CAN1_TX_QUEUE_SIZE
+#ifdef  RTE_CAN1_TX_QUEUE_SIZE
+#define CAN1_TX_QUEUE_SIZE              (RTE_CAN1_TX_QUEUE_SIZE)
+#else
+#define CAN1_TX_QUEUE_SIZE              (0U)
+#endif
+#endif
+// Software transmit queue size (in messages) for CAN2 controller
+#ifndef CAN2_TX_QUEUE_SIZE
+#ifdef  RTE_CAN2_TX_QUEUE_SIZE
+#define CAN2_TX_QUEUE_SIZE              (RTE_CAN2_TX_QUEUE_SIZE)
+#else
+#define CAN2_TX_QUEUE_SIZE              (0U)
+#endif
+#endif
+// Software transmit queue size (in messages) for CAN3 controller
+#ifndef CAN3_TX_QUEUE_SIZE
+#ifdef  RTE_CAN3_TX_QUEUE_SIZE
+#define CAN3_TX_QUEUE_SIZE              (RTE_CAN3_TX_QUEUE_SIZE)
+#else
+#define CAN3_TX_QUEUE_SIZE              (0U)
+#endif
+#endif
+
+// Length of sliding window (in ms) for bus load calculation
+#ifndef CAN_LOAD_WINDOW_MS
+#define CAN_LOAD_WINDOW_MS              (1000U)
+#endif
+
+#define CAN_LOAD_BUCKET_NUM             (10U)         // Number of sliding window sections
+#define CAN_LOAD_BUCKET_MS              (CAN_LOAD_WINDOW_MS / CAN_LOAD_BUCKET_NUM)
+
+// Maximum number of routing entries per controller (0 = routing disabled)
+#ifndef CAN_ROUTE_NUM
+#define CAN_ROUTE_NUM                   (0U)
+#endif
+// Forwarding queue size (in messages) per output controller
+#ifndef CAN_ROUTE_QUEUE_SIZE
+#define CAN_ROUTE_QUEUE_SIZE            (16U)
+#endif
+
+#if   (CAN_LOAD_WINDOW_MS < CAN_LOAD_BUCKET_NUM)
+#error  Bus load window too short, minimum CAN_LOAD_WINDOW_MS is 10 !!!
+#endif
+
 #if   ((CAN1_FILTER_BANK_NUM + CAN2_FILTER_BANK_NUM) > 28U)
 #error  Too many Filter Banks defined, maximum sum of Filter Banks for both CAN1 and CAN2 is 28 !!!
 #endif
@@ -188,7 +319,7 @@ static void Enable_GPIO_Clock (const GPIO_TypeDef *GPIOx) {
 
 // CAN Driver ******************************************************************
 
-#define ARM_CAN_DRV_VERSION ARM_DRIVER_VERSION_MAJOR_MINOR(1,6) // CAN driver version
+#define ARM_CAN_DRV_VERSION ARM_DRIVER_VERSION_MAJOR_MINOR(1,12) // CAN driver version
 
 // Driver Version
 static const ARM_DRIVER_VERSION can_driver_version = { ARM_CAN_API_VERSION, ARM_CAN_DRV_VERSION };
@@ -240,6 +371,92 @@ typedef enum _CAN_FILTER_TYPE {
   CAN_FILTER_TYPE_MASKABLE_ID = 1U
 } CAN_FILTER_TYPE;
 
+// Software receive queue
+typedef struct _CAN_RX_QUEUE {
+  CAN_RX_MSG           *msg;            // Message buffer
+  uint32_t              size;           // Buffer size in messages, one is always kept empty (0 = queue disabled)
+  volatile uint32_t     wr;             // Write index (updated in interrupt routine)
+  volatile uint32_t     rd;             // Read index
+} CAN_RX_QUEUE;
+
+// Message in software transmit queue (mailbox register values)
+typedef struct _CAN_TX_MSG {
+  uint32_t              tir;            // Identifier (TIxR without TXRQ)
+  uint32_t              tdtr;           // Data length code (TDTxR)
+  uint32_t              tdlr;           // Data bytes 0..3 (TDLxR)
+  uint32_t              tdhr;           // Data bytes 4..7 (TDHxR)
+  uint32_t              obj_idx;        // Transmit object index
+} CAN_TX_MSG;
+
+// Software transmit queue
+typedef struct _CAN_TX_QUEUE {
+  CAN_TX_MSG           *msg;            // Message buffer, sorted by priority (highest priority last)
+  uint32_t              size;           // Buffer size in messages (0 = queue disabled)
+  uint32_t              cnt;            // Number of queued messages
+  uint8_t               mb_obj[3];      // Transmit object index of message in mailbox
+  uint8_t               mb_abort;       // Mailboxes aborted for replacement (bit mask)
+  uint8_t               replace;        // Abort and replace enabled
+  uint8_t               reserved[3];
+} CAN_TX_QUEUE;
+
+// Time base extended from 16-bit time stamps (bit time counter)
+typedef struct _CAN_TIME {
+  uint64_t              time;           // Extended time of newest time stamp
+  uint32_t              tick;           // HAL tick when newest time stamp was captured
+  uint16_t              last;           // Newest 16-bit time stamp
+  uint8_t               valid;          // Time base started
+  uint8_t               reserved[1];
+} CAN_TIME;
+
+// HAL ticks latched in receive interrupt for messages in receive FIFO (no software receive queue)
+typedef struct _CAN_RX_TICK {
+  uint32_t              tick[3];        // HAL tick when message was signaled (oldest first)
+  uint32_t              cnt;            // Number of latched ticks
+} CAN_RX_TICK;
+
+// Bus statistics collection
+typedef struct _CAN_STAT {
+  CAN_STATISTICS        cnt;            // Counters (bus load is calculated when read)
+  uint32_t              load_bits[CAN_LOAD_BUCKET_NUM]; // Frame bits in sliding window sections
+  uint32_t              load_tick;      // Start tick of current section
+  uint32_t              start_tick;     // Tick when collection was enabled
+  uint32_t              bucket;         // Current section
+  uint32_t              bitrate;        // Nominal bitrate
+  uint8_t               tec;            // Last transmit error counter
+  uint8_t               enabled;        // Collection enabled
+  uint8_t               reserved[2];
+} CAN_STAT;
+
+// Forwarding queue of output controller (filled in receive interrupt routines of input controllers)
+typedef struct _CAN_FWD_QUEUE {
+  CAN_TX_MSG            msg[CAN_ROUTE_QUEUE_SIZE + 1U]; // Message buffer, one is always kept empty
+  volatile uint32_t     wr;             // Write index (updated in receive interrupt routines)
+  volatile uint32_t     rd;             // Read index (updated in transmit interrupt routine)
+} CAN_FWD_QUEUE;
+
+// Filter term (identifiers matching value in all compared bits)
+typedef struct _CAN_FILTER_TERM {
+  uint32_t              value;          // Identifier value
+  uint32_t              care;           // Compared identifier bits
+  uint8_t               flags;          // Term flags (CAN_TERM_xxx)
+  uint8_t               reserved[3];
+} CAN_FILTER_TERM;
+
+#define CAN_TERM_EXT                    (1U << 0)     // Extended identifier
+#define CAN_TERM_DATA_ONLY              (1U << 1)     // Data frames only
+#define CAN_TERM_FIFO1                  (1U << 2)     // Assigned to FIFO1
+
+// Filter bank image built by filter table compiler
+typedef struct _CAN_FILTER_IMAGE {
+  uint32_t              fr[28][2];      // Filter bank registers FR1, FR2
+  uint32_t              fm1r;           // Identifier list mode banks
+  uint32_t              fs1r;           // 32-bit scale banks
+  uint32_t              ffa1r;          // FIFO1 assigned banks
+  uint32_t              banks;          // Number of filter banks
+  uint32_t              slot[4];        // Slots of filter bank being filled
+  uint32_t              n;              // Number of filled slots
+} CAN_FILTER_IMAGE;
+
 #if    defined(RTE_DEVICE_FRAMEWORK_CUBE_MX)
 extern CAN_HandleTypeDef hcan1;
 extern CAN_HandleTypeDef hcan2;
@@ -262,9 +479,834 @@ static uint8_t                     can_obj_cfg           [CAN_CTRL_NUM][CAN_TOT_
 static ARM_CAN_SignalUnitEvent_t   CAN_SignalUnitEvent   [CAN_CTRL_NUM];
 static ARM_CAN_SignalObjectEvent_t CAN_SignalObjectEvent [CAN_CTRL_NUM];
 
+#if   ((MX_CAN1 == 1U) && (CAN1_RX_QUEUE_SIZE > 0U))
+static CAN_RX_MSG                  can1_rx_msg           [CAN_RX_OBJ_NUM][CAN1_RX_QUEUE_SIZE + 1U];
+#define CAN1_RX_QUEUE(n)          { &can1_rx_msg[n][0], CAN1_RX_QUEUE_SIZE + 1U, 0U, 0U }
+#else
+#define CAN1_RX_QUEUE(n)          { NULL, 0U, 0U, 0U }
+#endif
+#if   ((MX_CAN2 == 1U) && (CAN2_RX_QUEUE_SIZE > 0U))
+static CAN_RX_MSG                  can2_rx_msg           [CAN_RX_OBJ_NUM][CAN2_RX_QUEUE_SIZE + 1U];
+#define CAN2_RX_QUEUE(n)          { &can2_rx_msg[n][0], CAN2_RX_QUEUE_SIZE + 1U, 0U, 0U }
+#else
+#define CAN2_RX_QUEUE(n)          { NULL, 0U, 0U, 0U }
+#endif
+#if   ((MX_CAN3 == 1U) && (CAN3_RX_QUEUE_SIZE > 0U))
+static CAN_RX_MSG                  can3_rx_msg           [CAN_RX_OBJ_NUM][CAN3_RX_QUEUE_SIZE + 1U];
+#define CAN3_RX_QUEUE(n)          { &can3_rx_msg[n][0], CAN3_RX_QUEUE_SIZE + 1U, 0U, 0U }
+#else
+#define CAN3_RX_QUEUE(n)          { NULL, 0U, 0U, 0U }
+#endif
+
+static CAN_RX_QUEUE                can_rx_queue[3][CAN_RX_OBJ_NUM] = { { CAN1_RX_QUEUE(0), CAN1_RX_QUEUE(1) },
+                                                                       { CAN2_RX_QUEUE(0), CAN2_RX_QUEUE(1) },
+                                                                       { CAN3_RX_QUEUE(0), CAN3_RX_QUEUE(1) }
+                                                                     };
+
+#if   ((MX_CAN1 == 1U) && (CAN1_TX_QUEUE_SIZE > 0U))
+static CAN_TX_MSG                  can1_tx_msg           [CAN1_TX_QUEUE_SIZE];
+#define CAN1_TX_QUEUE             { &can1_tx_msg[0], CAN1_TX_QUEUE_SIZE, 0U, { 0U, 0U, 0U }, 0U, 0U, { 0U, 0U, 0U } }
+#else
+#define CAN1_TX_QUEUE             { NULL, 0U, 0U, { 0U, 0U, 0U }, 0U, 0U, { 0U, 0U, 0U } }
+#endif
+#if   ((MX_CAN2 == 1U) && (CAN2_TX_QUEUE_SIZE > 0U))
+static CAN_TX_MSG                  can2_tx_msg           [CAN2_TX_QUEUE_SIZE];
+#define CAN2_TX_QUEUE             { &can2_tx_msg[0], CAN2_TX_QUEUE_SIZE, 0U, { 0U, 0U, 0U }, 0U, 0U, { 0U, 0U, 0U } }
+#else
+#define CAN2_TX_QUEUE             { NULL, 0U, 0U, { 0U, 0U, 0U }, 0U, 0U, { 0U, 0U, 0U } }
+#endif
+#if   ((MX_CAN3 == 1U) && (CAN3_TX_QUEUE_SIZE > 0U))
+static CAN_TX_MSG                  can3_tx_msg           [CAN3_TX_QUEUE_SIZE];
+#define CAN3_TX_QUEUE             { &can3_tx_msg[0], CAN3_TX_QUEUE_SIZE, 0U, { 0U, 0U, 0U }, 0U, 0U, { 0U, 0U, 0U } }
+#else
+#define CAN3_TX_QUEUE             { NULL, 0U, 0U, { 0U, 0U, 0U }, 0U, 0U, { 0U, 0U, 0U } }
+#endif
+
+static CAN_TX_QUEUE                can_tx_queue[3] = { CAN1_TX_QUEUE, CAN2_TX_QUEUE, CAN3_TX_QUEUE };
+
+// Filter bank range (first, last + 1) of controller, CAN1/CAN2 split can be rebalanced at run-time
+static uint8_t                     can_filter_bank[3][2] = { { 0U,                            CAN1_FILTER_BANK_NUM                         },
+                                                             { CAN1_FILTER_BANK_NUM,          CAN1_FILTER_BANK_NUM + CAN2_FILTER_BANK_NUM  },
+                                                             { 0U,                            CAN3_FILTER_BANK_NUM                         }
+                                                           };
+static CAN_FILTER_TERM             can_filter_term[CAN_FILTER_TERM_NUM];
+
+static CAN_TIME                    can_time              [CAN_CTRL_NUM];
+static CAN_RX_TICK                 can_rx_tick           [CAN_CTRL_NUM][CAN_RX_OBJ_NUM];
+static uint64_t                    can_obj_time          [CAN_CTRL_NUM][CAN_TOT_OBJ_NUM];
+static CAN_STAT                    can_stat              [CAN_CTRL_NUM];
+
+#if   (CAN_ROUTE_NUM > 0U)
+static CAN_ROUTE                   can_route             [CAN_CTRL_NUM][CAN_ROUTE_NUM];
+static volatile uint32_t           can_route_num         [CAN_CTRL_NUM];
+static CAN_FWD_QUEUE               can_fwd               [CAN_CTRL_NUM];
+#endif
+
+// Transmit interrupt numbers (transmit queue is accessed with transmit interrupt disabled)
+static const IRQn_Type             can_tx_irqn[CAN_CTRL_NUM] = {  CAN1_TX_IRQn
+#if (CAN_CTRL_NUM > 1U)
+                                                               , CAN2_TX_IRQn
+#endif
+#if (CAN_CTRL_NUM > 2U)
+                                                               , CAN3_TX_IRQn
+#endif
+                                                               };
+
+// Error and status change interrupt numbers
+static const IRQn_Type             can_sce_irqn[CAN_CTRL_NUM] = { CAN1_SCE_IRQn
+#if (CAN_CTRL_NUM > 1U)
+                                                               , CAN2_SCE_IRQn
+#endif
+#if (CAN_CTRL_NUM > 2U)
+                                                               , CAN3_SCE_IRQn
+#endif
+                                                               };
+
 
 // Helper Functions
 
+/**
+  \fn          uint64_t CANx_TimeExtend (uint32_t stamp, uint32_t tick, uint8_t x)
+  \brief       Extend 16-bit time stamp to 64-bit time base.
+  \param[in]   stamp    Time stamp (TIME field of RDTxR or TDTxR)
+  \param[in]   tick     HAL tick latched when time stamp was captured (interrupt routine)
+  \param[in]   x        Controller number (0..2)
+  \return      time stamp in bit times
+  \note        Counter wraps during idle bus are resynchronized from the HAL tick and bitrate,
+               without running HAL tick time stamps must be captured at least every 32768 bit times.
+               Time stamps older than newest captured time stamp are allowed
+               (for example message read later from other FIFO).
+*/
+static uint64_t CANx_TimeExtend (uint32_t stamp, uint32_t tick, uint8_t x) {
+  CAN_TIME *ptr_time;
+  uint64_t  time, win;
+  int64_t   offs;
+  int32_t   elapsed;
+  uint32_t  primask, delta;
+
+  ptr_time = &can_time[x];
+  stamp   &= 0xFFFFU;
+
+  primask = __get_PRIMASK();
+  __disable_irq();                                      // Time base is updated from several interrupt routines
+  delta = (stamp - ptr_time->last) & 0xFFFFU;
+  if (ptr_time->valid == 0U) {                          // First time stamp starts time base
+    ptr_time->time  = stamp;
+    ptr_time->last  = (uint16_t)stamp;
+    ptr_time->tick  = tick;
+    ptr_time->valid = 1U;
+    time = ptr_time->time;
+  } else {
+    // Latest possible offset from newest time stamp: elapsed bit times (from HAL tick) with 2 ms margin,
+    // at least 32767 (time stamp within +/- 32768 bit times of newest time stamp)
+    elapsed = (int32_t)(tick - ptr_time->tick);         // Tick of an older message may be older
+    if (elapsed < 0) { elapsed = 0; }
+    win = (((uint64_t)elapsed + 2U) * can_stat[x].bitrate) / 1000U;
+    if (win < 0x7FFFU) { win = 0x7FFFU; }
+    // Offset equal to delta (modulo 16-bit counter) in window (win - 65536, win]
+    offs = (int64_t)win - (int64_t)((win - delta) & 0xFFFFU);
+    if (offs >= 0) {                                    // Newer than newest time stamp (possibly after wraps)
+      ptr_time->time += (uint64_t)offs;
+      ptr_time->last  = (uint16_t)stamp;
+      ptr_time->tick  = tick;
+      time = ptr_time->time;
+    } else {                                            // Older than newest time stamp
+      time = ptr_time->time - (uint64_t)(-offs);
+    }
+  }
+  __set_PRIMASK(primask);
+
+  return time;
+}
+
+/**
+  \fn          void CANx_TxTimeCapture (uint8_t x)
+  \brief       Capture transmit time stamps of successfully sent mailboxes (called from IRQ).
+  \param[in]   x        Controller number (0..2)
+*/
+static void CANx_TxTimeCapture (uint8_t x) {
+  CAN_TypeDef *ptr_CAN;
+  uint32_t     tsr, mb, obj_idx, tick;
+
+  ptr_CAN = ptr_CANx[x];
+  tsr     = ptr_CAN->TSR;
+  tick    = HAL_GetTick();
+
+  for (mb = 0U; mb < 3U; mb++) {
+    if ((tsr & ((CAN_TSR_RQCP0 | CAN_TSR_TXOK0) << (mb * 8U))) == ((CAN_TSR_RQCP0 | CAN_TSR_TXOK0) << (mb * 8U))) {
+      if (can_tx_queue[x].size != 0U) {
+        obj_idx = can_tx_queue[x].mb_obj[mb];
+      } else {
+        obj_idx = CAN_RX_OBJ_NUM + mb;
+      }
+      can_obj_time[x][obj_idx] = CANx_TimeExtend (ptr_CAN->sTxMailBox[mb].TDTR >> 16, tick, x);
+    }
+  }
+}
+
+/**
+  \fn          void CANx_RxTickLatch (uint32_t obj_idx, uint8_t x)
+  \brief       Latch HAL tick for messages newly received into receive FIFO (called from IRQ).
+  \param[in]   obj_idx  Receive object index (FIFO number)
+  \param[in]   x        Controller number (0..2)
+*/
+static void CANx_RxTickLatch (uint32_t obj_idx, uint8_t x) {
+  CAN_TypeDef *ptr_CAN;
+  CAN_RX_TICK *ptr_tick;
+  uint32_t     rfr, pending, tick;
+
+  ptr_CAN = ptr_CANx[x];
+  if ((ptr_CAN->MCR & CAN_MCR_TTCM) == 0U) { return; }
+
+  ptr_tick = &can_rx_tick[x][obj_idx];
+  if (obj_idx == 1U) {                                  // RF0R and RF1R have the same bit layout
+    rfr = ptr_CAN->RF1R;
+  } else {
+    rfr = ptr_CAN->RF0R;
+  }
+  pending = rfr & CAN_RF0R_FMP0;
+  tick    = HAL_GetTick();
+
+  if (ptr_tick->cnt > pending) {                        // Messages released without read
+    ptr_tick->cnt = pending;
+  }
+  if (((rfr & CAN_RF0R_FOVR0) != 0U) && (pending != 0U)) {
+    ptr_tick->tick[pending - 1U] = tick;                // Newest message in FIFO was overwritten
+  }
+  while (ptr_tick->cnt < pending) {
+    ptr_tick->tick[ptr_tick->cnt] = tick;
+    ptr_tick->cnt++;
+  }
+}
+
+/**
+  \fn          uint32_t CANx_RxTickGet (uint32_t obj_idx, uint8_t x)
+  \brief       Get HAL tick latched for oldest message in receive FIFO and remove it.
+  \param[in]   obj_idx  Receive object index (FIFO number)
+  \param[in]   x        Controller number (0..2)
+  \return      HAL tick when message was signaled (current tick if not signaled by interrupt)
+*/
+static uint32_t CANx_RxTickGet (uint32_t obj_idx, uint8_t x) {
+  CAN_RX_TICK *ptr_tick;
+  uint32_t     primask, tick, i;
+
+  ptr_tick = &can_rx_tick[x][obj_idx];
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+  if (ptr_tick->cnt != 0U) {
+    tick = ptr_tick->tick[0];
+    for (i = 1U; i < ptr_tick->cnt; i++) {
+      ptr_tick->tick[i - 1U] = ptr_tick->tick[i];
+    }
+    ptr_tick->cnt--;
+  } else {                                              // Message read by polling
+    tick = HAL_GetTick();
+  }
+  __set_PRIMASK(primask);
+
+  return tick;
+}
+
+/**
+  \fn          uint32_t CAN_FrameBits (uint32_t ide, uint32_t rtr, uint32_t dlc)
+  \brief       Get number of bits of frame on bus (without stuff bits).
+  \param[in]   ide      Extended identifier frame
+  \param[in]   rtr      Remote transmission request frame
+  \param[in]   dlc      Data length code
+  \return      number of bits including interframe space
+*/
+static uint32_t CAN_FrameBits (uint32_t ide, uint32_t rtr, uint32_t dlc) {
+  uint32_t bits;
+
+  if (ide != 0U) {
+    bits = 67U;                         // Extended frame overhead
+  } else {
+    bits = 47U;                         // Standard frame overhead
+  }
+  if (rtr == 0U) {
+    if (dlc > 8U) { dlc = 8U; }
+    bits += dlc * 8U;
+  }
+
+  return bits;
+}
+
+/**
+  \fn          void CANx_StatAdvance (uint32_t tick, uint8_t x)
+  \brief       Advance bus load sliding window to current tick (called with interrupts disabled).
+  \param[in]   tick     Current tick (in ms)
+  \param[in]   x        Controller number (0..2)
+*/
+static void CANx_StatAdvance (uint32_t tick, uint8_t x) {
+  CAN_STAT *ptr_stat;
+
+  ptr_stat = &can_stat[x];
+  if ((tick - ptr_stat->load_tick) >= CAN_LOAD_WINDOW_MS) {
+    memset(ptr_stat->load_bits, 0U, sizeof(ptr_stat->load_bits));
+    ptr_stat->load_tick = tick;
+    return;
+  }
+  while ((tick - ptr_stat->load_tick) >= CAN_LOAD_BUCKET_MS) {
+    ptr_stat->bucket++;
+    if (ptr_stat->bucket == CAN_LOAD_BUCKET_NUM) { ptr_stat->bucket = 0U; }
+    ptr_stat->load_bits[ptr_stat->bucket] = 0U;
+    ptr_stat->load_tick += CAN_LOAD_BUCKET_MS;
+  }
+}
+
+/**
+  \fn          void CANx_StatFrame (uint32_t bits, bool tx, uint8_t x)
+  \brief       Count transmitted or received frame.
+  \param[in]   bits     Number of frame bits
+  \param[in]   tx       Frame was transmitted
+  \param[in]   x        Controller number (0..2)
+*/
+static void CANx_StatFrame (uint32_t bits, bool tx, uint8_t x) {
+  CAN_STAT *ptr_stat;
+  uint32_t  primask;
+
+  ptr_stat = &can_stat[x];
+
+  primask = __get_PRIMASK();
+  __disable_irq();                                      // Statistics are updated from several interrupt routines
+  CANx_StatAdvance (HAL_GetTick(), x);
+  if (tx) {
+    ptr_stat->cnt.tx_frames++;
+    ptr_stat->cnt.tx_bits += bits;
+  } else {
+    ptr_stat->cnt.rx_frames++;
+    ptr_stat->cnt.rx_bits += bits;
+  }
+  ptr_stat->load_bits[ptr_stat->bucket] += bits;
+  __set_PRIMASK(primask);
+}
+
+/**
+  \fn          void CANx_StatTxIRQ (uint8_t x)
+  \brief       Count completed transmissions (called from IRQ).
+  \param[in]   x        Controller number (0..2)
+*/
+static void CANx_StatTxIRQ (uint8_t x) {
+  CAN_TypeDef *ptr_CAN;
+  uint32_t     tsr, tir, mb;
+
+  ptr_CAN = ptr_CANx[x];
+  tsr     = ptr_CAN->TSR;
+
+  for (mb = 0U; mb < 3U; mb++) {
+    if ((tsr & (CAN_TSR_RQCP0 << (mb * 8U))) != 0U) {
+      if ((tsr & (CAN_TSR_TXOK0 << (mb * 8U))) != 0U) {
+        tir = ptr_CAN->sTxMailBox[mb].TIR;
+        CANx_StatFrame (CAN_FrameBits (tir & CAN_TI0R_IDE, tir & CAN_TI0R_RTR, ptr_CAN->sTxMailBox[mb].TDTR & CAN_TDT0R_DLC), true, x);
+      } else if ((tsr & (CAN_TSR_ALST0 << (mb * 8U))) != 0U) {
+        can_stat[x].cnt.arb_lost++;
+      }
+    }
+  }
+}
+
+/**
+  \fn          void CANx_StatError (uint32_t esr, uint8_t x)
+  \brief       Count bus error (called from IRQ).
+  \param[in]   esr      Error status register value
+  \param[in]   x        Controller number (0..2)
+*/
+static void CANx_StatError (uint32_t esr, uint8_t x) {
+  CAN_TypeDef *ptr_CAN;
+  CAN_STAT    *ptr_stat;
+  uint32_t     lec, tec;
+
+  ptr_CAN  = ptr_CANx[x];
+  ptr_stat = &can_stat[x];
+  lec      = (esr & CAN_ESR_LEC) >> 4;
+  tec      = (esr & CAN_ESR_TEC) >> 16;
+
+  if ((lec != 0U) && (lec != 7U)) {
+    ptr_stat->cnt.lec[lec]++;
+    ptr_CAN->ESR = CAN_ESR_LEC;                         // Set last error code to 7 (detect next error)
+    if ((tec > ptr_stat->tec) && ((ptr_CAN->MCR & CAN_MCR_NART) == 0U)) {
+      ptr_stat->cnt.retransmit++;                       // Transmit error, frame is sent again
+    }
+  }
+  ptr_stat->tec = (uint8_t)tec;
+}
+
+/**
+  \fn          void CANx_StatRead (CAN_STATISTICS *stat, uint8_t x)
+  \brief       Read bus statistics and calculate bus load.
+  \param[out]  stat     Pointer to statistics
+  \param[in]   x        Controller number (0..2)
+*/
+static void CANx_StatRead (CAN_STATISTICS *stat, uint8_t x) {
+  CAN_STAT *ptr_stat;
+  uint64_t  bits;
+  uint32_t  primask, tick, time, i;
+
+  ptr_stat = &can_stat[x];
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+  tick = HAL_GetTick();
+  CANx_StatAdvance (tick, x);
+  *stat = ptr_stat->cnt;
+  bits  = 0U;
+  for (i = 0U; i < CAN_LOAD_BUCKET_NUM; i++) {
+    bits += ptr_stat->load_bits[i];
+  }
+  time = ((CAN_LOAD_BUCKET_NUM - 1U) * CAN_LOAD_BUCKET_MS) + (tick - ptr_stat->load_tick);
+  if ((tick - ptr_stat->start_tick) < time) {           // Window not filled yet
+    time = tick - ptr_stat->start_tick;
+  }
+  __set_PRIMASK(primask);
+
+  // Bus load in 0.1 %: bits * 1000 / (bitrate * time / 1000)
+  stat->bus_load = 0U;
+  if ((ptr_stat->bitrate != 0U) && (time != 0U)) {
+    bits = (bits * 1000000U) / ((uint64_t)ptr_stat->bitrate * time);
+    if (bits > 1000U) { bits = 1000U; }
+    stat->bus_load = (uint32_t)bits;
+  }
+}
+
+#if (CAN_ROUTE_NUM > 0U)
+/**
+  \fn          bool CANx_RouteForward (const CAN_TX_MSG *msg, uint8_t x)
+  \brief       Put message into forwarding queue of output controller (called from IRQ).
+  \param[in]   msg      Pointer to message
+  \param[in]   x        Output controller number (0..2)
+  \return      true if message was queued
+*/
+static bool CANx_RouteForward (const CAN_TX_MSG *msg, uint8_t x) {
+  CAN_FWD_QUEUE *ptr_fwd;
+  uint32_t       primask, wr, next;
+
+  if (can_driver_powered[x] == 0U) { return false; }
+
+  ptr_fwd = &can_fwd[x];
+
+  primask = __get_PRIMASK();
+  __disable_irq();                                      // Several input controllers can forward to same output
+  wr   = ptr_fwd->wr;
+  next = wr + 1U;
+  if (next == (CAN_ROUTE_QUEUE_SIZE + 1U)) { next = 0U; }
+  if (next == ptr_fwd->rd) {
+    __set_PRIMASK(primask);
+    return false;                                       // Forwarding queue full
+  }
+  ptr_fwd->msg[wr] = *msg;
+  ptr_fwd->wr      = next;
+  __set_PRIMASK(primask);
+
+  NVIC_SetPendingIRQ (can_tx_irqn[x]);                  // Transmit interrupt moves message to transmit queue
+
+  return true;
+}
+
+/**
+  \fn          bool CANx_RouteFrame (uint32_t rir, uint32_t rdtr, const uint32_t *data, uint32_t id, uint32_t *event, uint8_t x)
+  \brief       Forward received frame according to routing table of input controller (called from IRQ).
+  \param[in]   rir      Receive mailbox identifier register value
+  \param[in]   rdtr     Receive mailbox data length and time stamp register value
+  \param[in]   data     Pointer to data registers values (RDLR, RDHR)
+  \param[in]   id       Identifier (ARM_CAN_ID_IDE_Msk set for extended identifier)
+  \param[out]  event    Pointer to object events (receive overrun is added if frame could not be forwarded)
+  \param[in]   x        Input controller number (0..2)
+  \return      true if frame is to be put also into receive queue
+*/
+static bool CANx_RouteFrame (uint32_t rir, uint32_t rdtr, const uint32_t *data, uint32_t id, uint32_t *event, uint8_t x) {
+  const CAN_ROUTE *ptr_route;
+  CAN_TX_MSG       msg;
+  uint32_t         i, new_id;
+  bool             local, routed;
+
+  local  = false;
+  routed = false;
+  for (i = 0U; i < can_route_num[x]; i++) {
+    ptr_route = &can_route[x][i];
+    if (((id ^ ptr_route->id) & ptr_route->mask) != 0U) { continue; }
+
+    routed  = true;
+    msg.tir = rir & ~CAN_TI0R_TXRQ;                     // RIxR and TIxR have the same identifier layout
+    if (ptr_route->new_mask != 0U) {                    // Rewrite identifier
+      new_id = (id & ~ptr_route->new_mask) | (ptr_route->new_id & ptr_route->new_mask);
+      if ((new_id & ARM_CAN_ID_IDE_Msk) != 0U) {        // Extended Identifier
+        msg.tir = (new_id <<  3) | CAN_TI0R_IDE | (rir & CAN_RI0R_RTR);
+      } else {                                          // Standard Identifier
+        msg.tir = (new_id << 21) | (rir & CAN_RI0R_RTR);
+      }
+    }
+    msg.tdtr    = rdtr & CAN_RDT0R_DLC;
+    msg.tdlr    = data[0];
+    msg.tdhr    = data[1];
+    msg.obj_idx = ptr_route->obj_idx;
+    if (!CANx_RouteForward (&msg, ptr_route->ctrl)) {
+      *event |= ARM_CAN_EVENT_RECEIVE_OVERRUN;
+    }
+    if ((ptr_route->flags & CAN_ROUTE_LOCAL) != 0U) {
+      local = true;
+    }
+  }
+
+  return (local || !routed);
+}
+
+/**
+  \fn          int32_t CANx_SetRouteTable (const CAN_ROUTE_TABLE *table, uint8_t x)
+  \brief       Set frame routing table of input controller.
+  \param[in]   table    Pointer to routing table
+  \param[in]   x        Input controller number (0..2)
+  \return      execution status
+*/
+static int32_t CANx_SetRouteTable (const CAN_ROUTE_TABLE *table, uint8_t x) {
+  const CAN_ROUTE *ptr_route;
+  uint32_t         i, primask;
+
+  if (table == NULL)                                     { return ARM_DRIVER_ERROR_PARAMETER;   }
+  if (table->num > CAN_ROUTE_NUM)                        { return ARM_DRIVER_ERROR_PARAMETER;   }
+  if ((table->route == NULL) && (table->num != 0U))      { return ARM_DRIVER_ERROR_PARAMETER;   }
+  if ((can_rx_queue[x][0].size == 0U) &&
+      (can_rx_queue[x][1].size == 0U))                   { return ARM_DRIVER_ERROR_UNSUPPORTED; }
+
+  for (i = 0U; i < table->num; i++) {
+    ptr_route = &table->route[i];
+    if (ptr_route->ctrl >= CAN_CTRL_NUM)                 { return ARM_DRIVER_ERROR_PARAMETER;   }
+    if ((ptr_route->obj_idx <  CAN_RX_OBJ_NUM) ||
+        (ptr_route->obj_idx >= CAN_TOT_OBJ_NUM))         { return ARM_DRIVER_ERROR_PARAMETER;   }
+    if (can_tx_queue[ptr_route->ctrl].size == 0U)        { return ARM_DRIVER_ERROR_UNSUPPORTED; }
+  }
+
+  primask = __get_PRIMASK();
+  __disable_irq();                                      // Routing table is used in receive interrupt routines
+  for (i = 0U; i < table->num; i++) {
+    can_route[x][i] = table->route[i];
+  }
+  can_route_num[x] = table->num;
+  __set_PRIMASK(primask);
+
+  return ARM_DRIVER_OK;
+}
+#endif
+
+/**
+  \fn          uint32_t CANx_RxQueueFill (uint32_t obj_idx, uint8_t x)
+  \brief       Move all messages from receive FIFO to software receive queue (called from IRQ).
+  \param[in]   obj_idx  Receive object index (FIFO number)
+  \param[in]   x        Controller number (0..2)
+  \return      object events to signal
+*/
+static uint32_t CANx_RxQueueFill (uint32_t obj_idx, uint8_t x) {
+  CAN_TypeDef             *ptr_CAN;
+  CAN_FIFOMailBox_TypeDef *ptr_MB;
+  CAN_RX_QUEUE            *ptr_queue;
+  CAN_RX_MSG              *ptr_msg;
+  volatile uint32_t       *ptr_RFR;
+  uint64_t                 time;
+  uint32_t                 data_rx[2];
+  uint32_t                 rir, rdtr, id, wr, next, event, ttcm, tick;
+  bool                     local;
+
+  ptr_CAN   = ptr_CANx[x];
+  ptr_MB    = &ptr_CAN->sFIFOMailBox[obj_idx];
+  ptr_queue = &can_rx_queue[x][obj_idx];
+  if (obj_idx == 1U) {                                  // RF0R and RF1R have the same bit layout
+    ptr_RFR = &ptr_CAN->RF1R;
+  } else {
+    ptr_RFR = &ptr_CAN->RF0R;
+  }
+
+  event = 0U;
+  if ((*ptr_RFR & CAN_RF0R_FOVR0) != 0U) {
+    *ptr_RFR = CAN_RF0R_FOVR0;                          // Clear overrun flag
+    event    = ARM_CAN_EVENT_RECEIVE_OVERRUN;
+  }
+
+  ttcm = ptr_CAN->MCR & CAN_MCR_TTCM;
+  tick = HAL_GetTick();                                 // Messages are captured now (interrupt routine)
+  wr   = ptr_queue->wr;
+  while ((*ptr_RFR & CAN_RF0R_FMP0) != 0U) {
+    rir        = ptr_MB->RIR;
+    rdtr       = ptr_MB->RDTR;
+    data_rx[0] = ptr_MB->RDLR;
+    data_rx[1] = ptr_MB->RDHR;
+    if ((rir & CAN_RI0R_IDE) != 0U) {                   // Extended Identifier
+      id = (0x1FFFFFFFUL & (rir >>  3)) | ARM_CAN_ID_IDE_Msk;
+    } else {                                            // Standard Identifier
+      id = (    0x07FFUL & (rir >> 21));
+    }
+    if (ttcm != 0U) {
+      time = CANx_TimeExtend (rdtr >> 16, tick, x);
+    } else {
+      time = 0U;
+    }
+    if (can_stat[x].enabled != 0U) {
+      CANx_StatFrame (CAN_FrameBits (rir & CAN_RI0R_IDE, rir & CAN_RI0R_RTR, rdtr & CAN_RDT0R_DLC), false, x);
+    }
+
+    local = true;
+#if (CAN_ROUTE_NUM > 0U)
+    if (can_route_num[x] != 0U) {                       // Forward frame to output controllers
+      local = CANx_RouteFrame (rir, rdtr, data_rx, id, &event, x);
+    }
+#endif
+
+    if (local) {
+      next = wr + 1U;
+      if (next == ptr_queue->size) { next = 0U; }
+      if (next != ptr_queue->rd) {
+        ptr_msg            = &ptr_queue->msg[wr];
+        ptr_msg->id        = id;
+        ptr_msg->rtr       = ((rir & CAN_RI0R_RTR) != 0U) ? 1U : 0U;
+        ptr_msg->dlc       = (uint8_t)(rdtr & CAN_RDT0R_DLC);
+        ptr_msg->timestamp = time;
+        memcpy(ptr_msg->data, (uint8_t *)(&data_rx[0]), 8U);
+        wr            = next;
+        ptr_queue->wr = wr;
+        event |= ARM_CAN_EVENT_RECEIVE;
+      } else {                                          // Queue full, message is discarded
+        event |= ARM_CAN_EVENT_RECEIVE_OVERRUN;
+      }
+    }
+    *ptr_RFR = CAN_RF0R_RFOM0;                          // Release FIFO output mailbox
+    while ((*ptr_RFR & CAN_RF0R_RFOM0) != 0U);          // Wait until mailbox is released
+  }
+
+  if (event != 0U) {
+    event |= ARM_CAN_EVENT_RECEIVE;
+  }
+
+  return event;
+}
+
+/**
+  \fn          uint32_t CANx_RxQueueRead (uint32_t obj_idx, CAN_RX_MSG *msg, uint32_t num, uint8_t x)
+  \brief       Read messages from software receive queue.
+  \param[in]   obj_idx  Receive object index
+  \param[out]  msg      Pointer to message array
+  \param[in]   num      Maximum number of messages to read
+  \param[in]   x        Controller number (0..2)
+  \return      number of messages read
+*/
+static uint32_t CANx_RxQueueRead (uint32_t obj_idx, CAN_RX_MSG *msg, uint32_t num, uint8_t x) {
+  CAN_RX_QUEUE *ptr_queue;
+  uint32_t      rd, wr, cnt;
+
+  ptr_queue = &can_rx_queue[x][obj_idx];
+  rd        = ptr_queue->rd;
+  wr        = ptr_queue->wr;
+
+  for (cnt = 0U; (cnt < num) && (rd != wr); cnt++) {
+    msg[cnt] = ptr_queue->msg[rd];
+    rd++;
+    if (rd == ptr_queue->size) { rd = 0U; }
+  }
+  ptr_queue->rd = rd;
+
+  return cnt;
+}
+
+/**
+  \fn          uint32_t CAN_TxPriority (uint32_t tir)
+  \brief       Get arbitration priority of message (lower value wins arbitration).
+  \param[in]   tir      Transmit mailbox identifier register value
+  \return      priority value
+*/
+static uint32_t CAN_TxPriority (uint32_t tir) {
+
+  // Arbitration field order: base identifier, RTR/SRR, IDE, extended identifier, RTR
+  if ((tir & CAN_TI0R_IDE) != 0U) {                     // Extended Identifier
+    return ((tir & CAN_TI0R_STID) | (3UL << 19) | ((tir >> 2) & 0x0007FFFEUL) | ((tir >> 1) & 1UL));
+  } else {                                              // Standard Identifier
+    return ((tir & CAN_TI0R_STID) | ((tir & CAN_TI0R_RTR) << 19));
+  }
+}
+
+/**
+  \fn          void CANx_TxQueueInsert (const CAN_TX_MSG *msg, bool requeue, uint8_t x)
+  \brief       Insert message into software transmit queue by priority.
+  \param[in]   msg      Pointer to message
+  \param[in]   requeue  Message was queued before (sent before messages of same priority)
+  \param[in]   x        Controller number (0..2)
+*/
+static void CANx_TxQueueInsert (const CAN_TX_MSG *msg, bool requeue, uint8_t x) {
+  CAN_TX_QUEUE *ptr_queue;
+  uint32_t      prio, i;
+
+  ptr_queue = &can_tx_queue[x];
+  prio      = CAN_TxPriority (msg->tir);
+
+  // Messages with higher (or same, when not requeued) priority stay above new message
+  for (i = ptr_queue->cnt; i > 0U; i--) {
+    if (requeue) {
+      if (CAN_TxPriority (ptr_queue->msg[i-1U].tir) >= prio) { break; }
+    } else {
+      if (CAN_TxPriority (ptr_queue->msg[i-1U].tir) >  prio) { break; }
+    }
+    ptr_queue->msg[i] = ptr_queue->msg[i-1U];
+  }
+  ptr_queue->msg[i] = *msg;
+  ptr_queue->cnt++;
+}
+
+/**
+  \fn          uint32_t CANx_TxQueueSpace (uint8_t x)
+  \brief       Get number of free entries in software transmit queue.
+  \param[in]   x        Controller number (0..2)
+  \return      number of free entries (space for messages in aborted mailboxes is reserved)
+*/
+static uint32_t CANx_TxQueueSpace (uint8_t x) {
+  CAN_TX_QUEUE *ptr_queue;
+  uint32_t      mb, used;
+
+  ptr_queue = &can_tx_queue[x];
+  used      = ptr_queue->cnt;
+  for (mb = 0U; mb < 3U; mb++) {
+    if ((ptr_queue->mb_abort & (1U << mb)) != 0U) { used++; }
+  }
+
+  return (ptr_queue->size - used);
+}
+
+/**
+  \fn          uint32_t CANx_TxMailboxLoad (const CAN_TX_MSG *msg, uint8_t x)
+  \brief       Load message into free transmit mailbox and request transmission.
+  \param[in]   msg      Pointer to message
+  \param[in]   x        Controller number (0..2)
+  \return      mailbox number, 3 if no mailbox available
+*/
+static uint32_t CANx_TxMailboxLoad (const CAN_TX_MSG *msg, uint8_t x) {
+  CAN_TypeDef *ptr_CAN;
+  uint32_t     tsr, prio, mb, free_mb;
+
+  ptr_CAN = ptr_CANx[x];
+  tsr     = ptr_CAN->TSR;
+  prio    = CAN_TxPriority (msg->tir);
+  free_mb = 3U;
+
+  for (mb = 0U; mb < 3U; mb++) {
+    if ((tsr & (CAN_TSR_TME0 << mb)) == 0U) {
+      // Mailboxes with same identifier are not sent in request order, keep message queued
+      if (CAN_TxPriority (ptr_CAN->sTxMailBox[mb].TIR) == prio) { return 3U; }
+    } else if ((free_mb == 3U) && ((tsr & (CAN_TSR_RQCP0 << (mb * 8U))) == 0U)) {
+      free_mb = mb;                                     // Empty and completion already handled
+    }
+  }
+
+  if (free_mb < 3U) {
+    ptr_CAN->sTxMailBox[free_mb].TDTR = msg->tdtr;
+    ptr_CAN->sTxMailBox[free_mb].TDLR = msg->tdlr;
+    ptr_CAN->sTxMailBox[free_mb].TDHR = msg->tdhr;
+    ptr_CAN->sTxMailBox[free_mb].TIR  = msg->tir | CAN_TI0R_TXRQ;
+    can_tx_queue[x].mb_obj[free_mb]   = (uint8_t)msg->obj_idx;
+  }
+
+  return free_mb;
+}
+
+/**
+  \fn          void CANx_TxQueueReplace (uint8_t x)
+  \brief       Abort lowest priority pending mailbox if highest priority queued message wins over it.
+  \param[in]   x        Controller number (0..2)
+*/
+static void CANx_TxQueueReplace (uint8_t x) {
+  CAN_TypeDef  *ptr_CAN;
+  CAN_TX_QUEUE *ptr_queue;
+  uint32_t      tsr, prio, prio_max, mb, mb_max;
+
+  ptr_CAN   = ptr_CANx[x];
+  ptr_queue = &can_tx_queue[x];
+  if (ptr_queue->cnt == 0U)        { return; }
+  if (CANx_TxQueueSpace (x) == 0U) { return; }          // No space to queue aborted message again
+
+  tsr      = ptr_CAN->TSR;
+  prio_max = 0U;
+  mb_max   = 3U;
+  for (mb = 0U; mb < 3U; mb++) {
+    if (((tsr & (CAN_TSR_TME0 << mb)) == 0U) && ((ptr_queue->mb_abort & (1U << mb)) == 0U)) {
+      prio = CAN_TxPriority (ptr_CAN->sTxMailBox[mb].TIR);
+      if (prio >= prio_max) {
+        prio_max = prio;
+        mb_max   = mb;
+      }
+    }
+  }
+
+  if ((mb_max < 3U) && (CAN_TxPriority (ptr_queue->msg[ptr_queue->cnt - 1U].tir) < prio_max)) {
+    ptr_queue->mb_abort |= (uint8_t)(1U << mb_max);
+    ptr_CAN->TSR = CAN_TSR_ABRQ0 << (mb_max * 8U);      // Abort transmission
+  }
+}
+
+#if (CAN_ROUTE_NUM > 0U)
+/**
+  \fn          void CANx_RouteDrain (uint8_t x)
+  \brief       Move forwarded messages into software transmit queue of output controller (called from IRQ).
+  \param[in]   x        Output controller number (0..2)
+*/
+static void CANx_RouteDrain (uint8_t x) {
+  CAN_FWD_QUEUE *ptr_fwd;
+  uint32_t       rd;
+
+  ptr_fwd = &can_fwd[x];
+  rd      = ptr_fwd->rd;
+  while ((rd != ptr_fwd->wr) && (CANx_TxQueueSpace (x) != 0U)) {
+    CANx_TxQueueInsert (&ptr_fwd->msg[rd], false, x);
+    rd++;
+    if (rd == (CAN_ROUTE_QUEUE_SIZE + 1U)) { rd = 0U; }
+    ptr_fwd->rd = rd;
+  }
+}
+#endif
+
+/**
+  \fn          void CANx_TxQueueIRQ (uint8_t x)
+  \brief       Handle transmit mailbox completion and refill mailboxes from software transmit queue.
+  \param[in]   x        Controller number (0..2)
+*/
+static void CANx_TxQueueIRQ (uint8_t x) {
+  CAN_TypeDef  *ptr_CAN;
+  CAN_TX_QUEUE *ptr_queue;
+  CAN_TX_MSG    msg;
+  uint32_t      tsr, mb, obj_idx;
+
+  ptr_CAN   = ptr_CANx[x];
+  ptr_queue = &can_tx_queue[x];
+
+  for (mb = 0U; mb < 3U; mb++) {
+    tsr = ptr_CAN->TSR;
+    if ((tsr & (CAN_TSR_RQCP0 << (mb * 8U))) != 0U) {
+      ptr_CAN->TSR = CAN_TSR_RQCP0 << (mb * 8U);        // Request completed on transmit mailbox
+      obj_idx      = ptr_queue->mb_obj[mb];
+      if ((tsr & (CAN_TSR_TXOK0 << (mb * 8U))) != 0U) {
+        if (can_obj_cfg[x][obj_idx] == ARM_CAN_OBJ_TX) {
+          if (CAN_SignalObjectEvent[x] != NULL) { CAN_SignalObjectEvent[x](obj_idx, ARM_CAN_EVENT_SEND_COMPLETE); }
+        }
+      } else if ((ptr_queue->mb_abort & (1U << mb)) != 0U) {
+        // Aborted for higher priority message, queue it again
+        msg.tir     = ptr_CAN->sTxMailBox[mb].TIR & ~CAN_TI0R_TXRQ;
+        msg.tdtr    = ptr_CAN->sTxMailBox[mb].TDTR;
+        msg.tdlr    = ptr_CAN->sTxMailBox[mb].TDLR;
+        msg.tdhr    = ptr_CAN->sTxMailBox[mb].TDHR;
+        msg.obj_idx = obj_idx;
+        CANx_TxQueueInsert (&msg, true, x);
+      }
+      ptr_queue->mb_abort &= (uint8_t)~(1U << mb);
+    }
+  }
+
+#if (CAN_ROUTE_NUM > 0U)
+  CANx_RouteDrain (x);                                  // Queue messages forwarded from other controllers
+#endif
+
+  while (ptr_queue->cnt != 0U) {                        // Refill mailboxes with highest priority messages
+    if (CANx_TxMailboxLoad (&ptr_queue->msg[ptr_queue->cnt - 1U], x) == 3U) { break; }
+    ptr_queue->cnt--;
+  }
+  if (ptr_queue->replace != 0U) {
+    CANx_TxQueueReplace (x);
+  }
+}
+
 /**
   \fn          int32_t CANx_AddFilter (uint32_t obj_idx, CAN_FILTER_TYPE filter_type, uint32_t id, uint32_t mask, uint8_t x)
   \brief       Add receive filter for specified id or id with mask.
@@ -285,9 +1327,8 @@ static int32_t CANx_AddFilter (uint32_t obj_idx, CAN_FILTER_TYPE filter_type, ui
 
   if (x >= CAN_CTRL_NUM)         { return ARM_DRIVER_ERROR;           }
   if (obj_idx >= CAN_RX_OBJ_NUM) { return ARM_DRIVER_ERROR_PARAMETER; }
-  if      (x == 2U)              { bank = 0U;                   bank_end = CAN3_FILTER_BANK_NUM;                        }
-  else if (x == 1U)              { bank = CAN1_FILTER_BANK_NUM; bank_end = CAN1_FILTER_BANK_NUM + CAN2_FILTER_BANK_NUM; }
-  else                           { bank = 0U;                   bank_end = CAN1_FILTER_BANK_NUM;                        }
+  bank     = can_filter_bank[x][0];
+  bank_end = can_filter_bank[x][1];
   if (bank >= bank_end)          { return ARM_DRIVER_ERROR;           }
 
   if (x <= 1U) {
@@ -374,15 +1415,13 @@ static int32_t CANx_AddFilter (uint32_t obj_idx, CAN_FILTER_TYPE filter_type, ui
               ptr_CAN_master->FFA1R &= ~msk;                            // Assign to FIFO0
             }
             ptr_CAN_master->sFilterRegister[bank].FR1 = frx;
+            ptr_CAN_master->sFilterRegister[bank].FR2 = frx;            // Unused half repeats first half
             break;
           } else if  (((ptr_CAN_master->FM1R & msk) != 0U) &&           // If identifier list mode
                       ((ptr_CAN_master->FS1R & msk) == 0U) &&           // If dual 16-bit scale configuration
                      (((ptr_CAN_master->FFA1R>>bank)&1U) == obj_idx)) { // If bank has same FIFO assignment as requested
-            if         (ptr_CAN_master->sFilterRegister[bank].FR1==0U){ // If n and n+1 entry are not used
-              ptr_CAN_master->FA1R &= ~msk;                             // Put filter in inactive mode
-              ptr_CAN_master->sFilterRegister[bank].FR1 = frx;          // id and id + RTR
-              break;
-            } else if (ptr_CAN_master->sFilterRegister[bank].FR2==0U) { // If n+2 and n+3 entry are not used
+            if (ptr_CAN_master->sFilterRegister[bank].FR1 ==            // If n+2 and n+3 entry are not used
+                ptr_CAN_master->sFilterRegister[bank].FR2) {            // (repeat n and n+1 entry)
               ptr_CAN_master->FA1R &= ~msk;                             // Put filter in inactive mode
               ptr_CAN_master->sFilterRegister[bank].FR2 = frx;          // id and id + RTR
               break;
@@ -396,7 +1435,7 @@ static int32_t CANx_AddFilter (uint32_t obj_idx, CAN_FILTER_TYPE filter_type, ui
         frx = ((id   & 0xFFFFU) <<  5) |                                // Low 16 bits = id
               ((mask & 0xFFFFU) << 21) ;                                // High 16 bits = mask
         if ((mask & ARM_CAN_ID_IDE_Msk) != 0U) {                        // If IDE masking enabled
-          frx |= CAN_FRx_16BIT_H_RTR;                                   // High 16 bits = mask + IDE
+          frx |= CAN_FRx_16BIT_H_IDE;                                   // High 16 bits = mask + IDE
         }
         while (bank <= bank_end) {                                      // Find empty place for id
           if (bank == bank_end) {                                       // If no free found exit
@@ -412,14 +1451,12 @@ static int32_t CANx_AddFilter (uint32_t obj_idx, CAN_FILTER_TYPE filter_type, ui
               ptr_CAN_master->FFA1R &= ~msk;                            // Assign to FIFO0
             }
             ptr_CAN_master->sFilterRegister[bank].FR1 = frx;
+            ptr_CAN_master->sFilterRegister[bank].FR2 = frx;            // Unused half repeats first half
             break;
           } else if ((((ptr_CAN_master->FM1R | ptr_CAN_master->FS1R)&msk)==0U) && // If identifier mask mode and dual 16-bit scale configuration
                      (((ptr_CAN_master->FFA1R >> bank)&1U)==obj_idx)) { // If bank has same FIFO assignment as requested
-            if         (ptr_CAN_master->sFilterRegister[bank].FR1==0U){ // If n entry is not used
-              ptr_CAN_master->FA1R &= ~msk;                             // Put filter in inactive mode
-              ptr_CAN_master->sFilterRegister[bank].FR1 = frx;          // id and mask
-              break;
-            } else if  (ptr_CAN_master->sFilterRegister[bank].FR2==0U){ // If n+1 entry is not used
+            if (ptr_CAN_master->sFilterRegister[bank].FR1 ==            // If n+1 entry is not used
+                ptr_CAN_master->sFilterRegister[bank].FR2) {            // (repeats n entry)
               ptr_CAN_master->FA1R &= ~msk;                             // Put filter in inactive mode
               ptr_CAN_master->sFilterRegister[bank].FR2 = frx;          // id and mask
               break;
@@ -463,9 +1500,8 @@ static int32_t CANx_RemoveFilter (uint32_t obj_idx, CAN_FILTER_TYPE filter_type,
 
   if (x >= CAN_CTRL_NUM)         { return ARM_DRIVER_ERROR;           }
   if (obj_idx >= CAN_RX_OBJ_NUM) { return ARM_DRIVER_ERROR_PARAMETER; }
-  if      (x == 2U)              { bank = 0U;                   bank_end = CAN3_FILTER_BANK_NUM;                        }
-  else if (x == 1U)              { bank = CAN1_FILTER_BANK_NUM; bank_end = CAN1_FILTER_BANK_NUM + CAN2_FILTER_BANK_NUM; }
-  else                           { bank = 0U;                   bank_end = CAN1_FILTER_BANK_NUM;                        }
+  bank     = can_filter_bank[x][0];
+  bank_end = can_filter_bank[x][1];
   if (bank >= bank_end)          { return ARM_DRIVER_ERROR;           }
 
   if (x <= 1U) {
@@ -544,13 +1580,19 @@ static int32_t CANx_RemoveFilter (uint32_t obj_idx, CAN_FILTER_TYPE filter_type,
               ((ptr_CAN_master->FM1R & msk) != 0U) &&                   // If identifier list mode
               ((ptr_CAN_master->FS1R & msk) == 0U) &&                   // If dual 16-bit scale configuration
              (((ptr_CAN_master->FFA1R >> bank) & 1U) == obj_idx)) {     // If bank has same FIFO assignment as requested
-            if        (ptr_CAN_master->sFilterRegister[bank].FR1==frx){
+            if        ((ptr_CAN_master->sFilterRegister[bank].FR1==frx) &&
+                       (ptr_CAN_master->sFilterRegister[bank].FR2==frx)){ // If last entry of filter bank
               ptr_CAN_master->FA1R &= ~msk;                             // Put filter in inactive mode
               ptr_CAN_master->sFilterRegister[bank].FR1 = 0U;
+              ptr_CAN_master->sFilterRegister[bank].FR2 = 0U;
+              break;
+            } else if (ptr_CAN_master->sFilterRegister[bank].FR1==frx){
+              ptr_CAN_master->FA1R &= ~msk;                             // Put filter in inactive mode
+              ptr_CAN_master->sFilterRegister[bank].FR1 = ptr_CAN_master->sFilterRegister[bank].FR2;
               break;
             } else if (ptr_CAN_master->sFilterRegister[bank].FR2==frx){
               ptr_CAN_master->FA1R &= ~msk;                             // Put filter in inactive mode
-              ptr_CAN_master->sFilterRegister[bank].FR2 = 0U;
+              ptr_CAN_master->sFilterRegister[bank].FR2 = ptr_CAN_master->sFilterRegister[bank].FR1;
               break;
             }
           }
@@ -572,13 +1614,19 @@ static int32_t CANx_RemoveFilter (uint32_t obj_idx, CAN_FILTER_TYPE filter_type,
           if (((fa1r & msk) != 0U) &&                                   // If filter is active
              (((ptr_CAN_master->FM1R|ptr_CAN_master->FS1R)&msk)==0U) && // If identifier mask mode and dual 16-bit scale configuration
              (((ptr_CAN_master->FFA1R >> bank) & 1U) == obj_idx)) {     // If bank has same FIFO assignment as requested
-            if        (ptr_CAN_master->sFilterRegister[bank].FR1==frx){
+            if        ((ptr_CAN_master->sFilterRegister[bank].FR1==frx) &&
+                       (ptr_CAN_master->sFilterRegister[bank].FR2==frx)){ // If last entry of filter bank
               ptr_CAN_master->FA1R &= ~msk;                             // Put filter in inactive mode
               ptr_CAN_master->sFilterRegister[bank].FR1 = 0U;
+              ptr_CAN_master->sFilterRegister[bank].FR2 = 0U;
+              break;
+            } else if (ptr_CAN_master->sFilterRegister[bank].FR1==frx){
+              ptr_CAN_master->FA1R &= ~msk;                             // Put filter in inactive mode
+              ptr_CAN_master->sFilterRegister[bank].FR1 = ptr_CAN_master->sFilterRegister[bank].FR2;
               break;
             } else if (ptr_CAN_master->sFilterRegister[bank].FR2==frx){
               ptr_CAN_master->FA1R &= ~msk;                             // Put filter in inactive mode
-              ptr_CAN_master->sFilterRegister[bank].FR2 = 0U;
+              ptr_CAN_master->sFilterRegister[bank].FR2 = ptr_CAN_master->sFilterRegister[bank].FR1;
               break;
             }
           }
@@ -602,6 +1650,336 @@ static int32_t CANx_RemoveFilter (uint32_t obj_idx, CAN_FILTER_TYPE filter_type,
   return status;
 }
 
+/**
+  \fn          uint32_t CAN_FilterTermAdd (CAN_FILTER_TERM term, uint32_t num)
+  \brief       Add term to filter term list, merging it with existing terms.
+  \param[in]   term     Term to add
+  \param[in]   num      Number of terms in list
+  \return      number of terms in list, CAN_FILTER_TERM_NUM + 1 if list is full
+  \note        Terms are only merged when the result matches exactly the same identifiers,
+               so compiled filters never accept identifiers that were not requested.
+*/
+static uint32_t CAN_FilterTermAdd (CAN_FILTER_TERM term, uint32_t num) {
+  CAN_FILTER_TERM *ptr_t;
+  uint32_t         i, diff;
+
+  i = 0U;
+  while (i < num) {
+    ptr_t = &can_filter_term[i];
+    if (((ptr_t->flags ^ term.flags) & (CAN_TERM_EXT | CAN_TERM_FIFO1)) != 0U) { i++; continue; }
+
+    // Existing term covers new term
+    if (((ptr_t->care & term.care) == ptr_t->care) && ((term.value & ptr_t->care) == ptr_t->value) &&
+        ((ptr_t->flags & CAN_TERM_DATA_ONLY) <= (term.flags & CAN_TERM_DATA_ONLY))) {
+      return num;
+    }
+    // New term covers existing term, remove existing term
+    if (((ptr_t->care & term.care) == term.care) && ((ptr_t->value & term.care) == term.value) &&
+        ((term.flags & CAN_TERM_DATA_ONLY) <= (ptr_t->flags & CAN_TERM_DATA_ONLY))) {
+      num--;
+      *ptr_t = can_filter_term[num];
+      continue;
+    }
+    // Terms differing in exactly one compared bit are merged, merged term is added again
+    diff = ptr_t->value ^ term.value;
+    if ((ptr_t->care == term.care) && (ptr_t->flags == term.flags) && (diff != 0U) && ((diff & (diff - 1U)) == 0U)) {
+      term.care  &= ~diff;
+      term.value &= ~diff;
+      num--;
+      *ptr_t = can_filter_term[num];
+      i = 0U;
+      continue;
+    }
+    i++;
+  }
+
+  if (num == CAN_FILTER_TERM_NUM) { return (CAN_FILTER_TERM_NUM + 1U); }
+  can_filter_term[num] = term;
+
+  return (num + 1U);
+}
+
+/**
+  \fn          int32_t CAN_FilterCompile (const CAN_FILTER_TABLE *table, uint32_t *ptr_num)
+  \brief       Convert filter table entries to merged filter terms.
+  \param[in]   table    Pointer to filter table
+  \param[out]  ptr_num  Number of filter terms
+  \return      execution status
+*/
+static int32_t CAN_FilterCompile (const CAN_FILTER_TABLE *table, uint32_t *ptr_num) {
+  const CAN_FILTER_ENTRY *ptr_e;
+  CAN_FILTER_TERM         term;
+  uint32_t                i, num, id_msk, first, last, blk;
+
+  num = 0U;
+  for (i = 0U; i < table->num; i++) {
+    ptr_e = &table->entry[i];
+    if (ptr_e->obj_idx >= CAN_RX_OBJ_NUM) { return ARM_DRIVER_ERROR_PARAMETER; }
+
+    term.flags = 0U;
+    if ((ptr_e->id & ARM_CAN_ID_IDE_Msk) != 0U) {
+      term.flags |= CAN_TERM_EXT;
+      id_msk      = 0x1FFFFFFFUL;
+    } else {
+      id_msk      = 0x000007FFUL;
+    }
+    if ((ptr_e->type & CAN_FILTER_ENTRY_DATA_ONLY) != 0U) { term.flags |= CAN_TERM_DATA_ONLY; }
+    if (ptr_e->obj_idx == 1U)                             { term.flags |= CAN_TERM_FIFO1;     }
+    first = ptr_e->id & id_msk;
+
+    switch (ptr_e->type & CAN_FILTER_ENTRY_TYPE_Msk) {
+      case CAN_FILTER_ENTRY_EXACT:
+        term.care  = id_msk;
+        term.value = first;
+        num = CAN_FilterTermAdd (term, num);
+        break;
+      case CAN_FILTER_ENTRY_MASK:
+        term.care  = ptr_e->arg & id_msk;
+        term.value = first & term.care;
+        num = CAN_FilterTermAdd (term, num);
+        break;
+      case CAN_FILTER_ENTRY_RANGE:
+        last = ptr_e->arg & id_msk;
+        if (last < first) { return ARM_DRIVER_ERROR_PARAMETER; }
+        // Split range into aligned power of 2 sized blocks
+        while (num <= CAN_FILTER_TERM_NUM) {
+          blk = (first == 0U) ? (id_msk + 1U) : (first & (~first + 1U));
+          while ((blk - 1U) > (last - first)) { blk >>= 1; }
+          term.care  = id_msk & ~(blk - 1U);
+          term.value = first;
+          num = CAN_FilterTermAdd (term, num);
+          if ((last - first) == (blk - 1U)) { break; }
+          first += blk;
+        }
+        break;
+      default:
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+    if (num > CAN_FILTER_TERM_NUM) { return ARM_DRIVER_ERROR; }
+  }
+
+  *ptr_num = num;
+
+  return ARM_DRIVER_OK;
+}
+
+/**
+  \fn          bool CAN_FilterFlush (CAN_FILTER_IMAGE *img, uint32_t kind, uint32_t fifo)
+  \brief       Write pending filter slots to next filter bank of image.
+  \param[in]   img      Pointer to filter bank image
+  \param[in]   kind     Filter bank kind (bit 0: mask mode, bit 1: 32-bit scale)
+  \param[in]   fifo     FIFO assignment
+  \return      true if filter bank is available
+*/
+static bool CAN_FilterFlush (CAN_FILTER_IMAGE *img, uint32_t kind, uint32_t fifo) {
+  uint32_t i, msk;
+
+  if (img->n == 0U)    { return true;  }
+  if (img->banks == 28U) { return false; }
+
+  for (i = img->n; i < 4U; i++) {                       // Unused slots repeat first slot
+    img->slot[i] = img->slot[0];
+  }
+  if (kind == 0U) {                                     // 16-bit list mode: four 16-bit identifiers
+    img->fr[img->banks][0] = (img->slot[0] & 0xFFFFU) | (img->slot[1] << 16);
+    img->fr[img->banks][1] = (img->slot[2] & 0xFFFFU) | (img->slot[3] << 16);
+  } else {
+    img->fr[img->banks][0] = img->slot[0];
+    img->fr[img->banks][1] = img->slot[1];
+  }
+
+  msk = (uint32_t)1U << img->banks;
+  if ((kind & 1U) == 0U) { img->fm1r  |= msk; }         // Identifier list mode
+  if ((kind & 2U) != 0U) { img->fs1r  |= msk; }         // Single 32-bit scale configuration
+  if (fifo != 0U)        { img->ffa1r |= msk; }         // Assigned to FIFO1
+  img->banks++;
+  img->n = 0U;
+
+  return true;
+}
+
+/**
+  \fn          bool CAN_FilterSlot (CAN_FILTER_IMAGE *img, uint32_t val, uint32_t kind, uint32_t fifo)
+  \brief       Add slot value to filter bank image.
+  \param[in]   img      Pointer to filter bank image
+  \param[in]   val      Slot value (16-bit identifier, 16-bit identifier/mask pair or 32-bit register value)
+  \param[in]   kind     Filter bank kind (bit 0: mask mode, bit 1: 32-bit scale)
+  \param[in]   fifo     FIFO assignment
+  \return      true if filter bank is available
+*/
+static bool CAN_FilterSlot (CAN_FILTER_IMAGE *img, uint32_t val, uint32_t kind, uint32_t fifo) {
+
+  img->slot[img->n++] = val;
+  if (img->n == ((kind == 0U) ? 4U : 2U)) {             // Bank full
+    return CAN_FilterFlush (img, kind, fifo);
+  }
+
+  return true;
+}
+
+/**
+  \fn          void CAN_FilterBankMove (CAN_TypeDef *ptr_CAN_master, uint32_t dst, uint32_t src)
+  \brief       Move filter bank configuration (filter initialization mode must be active).
+  \param[in]   ptr_CAN_master  Pointer to master CAN controller
+  \param[in]   dst             Destination filter bank
+  \param[in]   src             Source filter bank
+*/
+static void CAN_FilterBankMove (CAN_TypeDef *ptr_CAN_master, uint32_t dst, uint32_t src) {
+  uint32_t msk_src, msk_dst;
+
+  if (dst == src) { return; }
+
+  msk_src = (uint32_t)1U << src;
+  msk_dst = (uint32_t)1U << dst;
+
+  ptr_CAN_master->FA1R &= ~msk_dst;
+  ptr_CAN_master->sFilterRegister[dst].FR1 = ptr_CAN_master->sFilterRegister[src].FR1;
+  ptr_CAN_master->sFilterRegister[dst].FR2 = ptr_CAN_master->sFilterRegister[src].FR2;
+  if ((ptr_CAN_master->FM1R  & msk_src) != 0U) { ptr_CAN_master->FM1R  |= msk_dst; } else { ptr_CAN_master->FM1R  &= ~msk_dst; }
+  if ((ptr_CAN_master->FS1R  & msk_src) != 0U) { ptr_CAN_master->FS1R  |= msk_dst; } else { ptr_CAN_master->FS1R  &= ~msk_dst; }
+  if ((ptr_CAN_master->FFA1R & msk_src) != 0U) { ptr_CAN_master->FFA1R |= msk_dst; } else { ptr_CAN_master->FFA1R &= ~msk_dst; }
+  if ((ptr_CAN_master->FA1R  & msk_src) != 0U) { ptr_CAN_master->FA1R  |= msk_dst; }
+
+  ptr_CAN_master->FA1R &= ~msk_src;
+  ptr_CAN_master->sFilterRegister[src].FR1 = 0U;
+  ptr_CAN_master->sFilterRegister[src].FR2 = 0U;
+}
+
+/**
+  \fn          int32_t CANx_SetFilterTable (CAN_FILTER_TABLE *table, uint8_t x)
+  \brief       Replace all filters of controller with filters compiled from table.
+  \param[in]   table    Pointer to filter table
+  \param[in]   x        Controller number (0..2)
+  \return      execution status
+  \note        Terms are packed per FIFO into the least filter banks:
+                 - standard exact identifiers:  16-bit list mode (4 per bank, 2 if remote frames accepted)
+                 - standard masked identifiers: 16-bit mask mode (2 per bank)
+                 - extended exact identifiers:  32-bit list mode (2 per bank, 1 if remote frames accepted)
+                 - extended masked identifiers: 32-bit mask mode (1 per bank)
+               For CAN1/CAN2 the filter banks of the other controller are compacted and the
+               CAN2 start bank (CAN2SB) is moved if the controller needs more filter banks.
+*/
+static int32_t CANx_SetFilterTable (CAN_FILTER_TABLE *table, uint8_t x) {
+  CAN_TypeDef      *ptr_CAN_master;
+  CAN_FILTER_TERM  *ptr_t;
+  CAN_FILTER_IMAGE  img;
+  uint32_t          num, i, fifo, kind, banks, val, msk;
+  uint32_t          first, split, used, end;
+  int32_t           status;
+  bool              ok;
+
+  if (table == NULL)                           { return ARM_DRIVER_ERROR_PARAMETER; }
+  if ((table->entry == NULL) && (table->num != 0U)) { return ARM_DRIVER_ERROR_PARAMETER; }
+
+  status = CAN_FilterCompile (table, &num);
+  if (status != ARM_DRIVER_OK) { return status; }
+
+  // Pack terms of each FIFO into filter bank image: 16-bit list, 16-bit mask, 32-bit list, 32-bit mask
+  memset(&img, 0, sizeof(img));
+  for (fifo = 0U; fifo < 2U; fifo++) {
+    for (kind = 0U; kind < 4U; kind++) {
+      for (i = 0U; i < num; i++) {
+        ptr_t = &can_filter_term[i];
+        if (((ptr_t->flags & CAN_TERM_FIFO1) != 0U) != (fifo != 0U))        { continue; }
+        if (((ptr_t->flags & CAN_TERM_EXT)   != 0U) != ((kind & 2U) != 0U)) { continue; }
+        msk = ((ptr_t->flags & CAN_TERM_EXT) != 0U) ? 0x1FFFFFFFUL : 0x000007FFUL;
+        if ((ptr_t->care != msk) != ((kind & 1U) != 0U))                    { continue; }
+        if ((kind & 2U) == 0U) {                        // 16-bit scale: STID[15:5] RTR[4] IDE[3]
+          val = ptr_t->value << 5;
+          msk = (ptr_t->care << 5) | CAN_FRx_16BIT_L_IDE;
+          if ((ptr_t->flags & CAN_TERM_DATA_ONLY) != 0U) { msk |= CAN_FRx_16BIT_L_RTR; }
+          if ((kind & 1U) != 0U) {                      // Mask mode: id in low, mask in high half-word
+            ok = CAN_FilterSlot (&img, val | (msk << 16), kind, fifo);
+          } else {                                      // List mode: id, id + RTR
+            ok = CAN_FilterSlot (&img, val, kind, fifo);
+            if ((ptr_t->flags & CAN_TERM_DATA_ONLY) == 0U) { ok = ok && CAN_FilterSlot (&img, val | CAN_FRx_16BIT_L_RTR, kind, fifo); }
+          }
+        } else {                                        // 32-bit scale: STID/EXID[31:3] IDE[2] RTR[1]
+          val = (ptr_t->value << 3) | CAN_FRx_32BIT_IDE;
+          msk = (ptr_t->care  << 3) | CAN_FRx_32BIT_IDE;
+          if ((ptr_t->flags & CAN_TERM_DATA_ONLY) != 0U) { msk |= CAN_FRx_32BIT_RTR; }
+          if ((kind & 1U) != 0U) {                      // Mask mode: id in FR1, mask in FR2
+            ok = CAN_FilterSlot (&img, val, kind, fifo) && CAN_FilterSlot (&img, msk, kind, fifo);
+          } else {                                      // List mode: id, id + RTR
+            ok = CAN_FilterSlot (&img, val, kind, fifo);
+            if ((ptr_t->flags & CAN_TERM_DATA_ONLY) == 0U) { ok = ok && CAN_FilterSlot (&img, val | CAN_FRx_32BIT_RTR, kind, fifo); }
+          }
+        }
+        if (!ok) { return ARM_DRIVER_ERROR; }
+      }
+      if (!CAN_FilterFlush (&img, kind, fifo)) { return ARM_DRIVER_ERROR; }
+    }
+  }
+  banks = img.banks;
+
+  if (x <= 1U) {
+    ptr_CAN_master = ptr_CANx[0];
+  } else {
+    ptr_CAN_master = ptr_CANx[2];
+  }
+
+  ptr_CAN_master->FMR |= CAN_FMR_FINIT;                 // Enter filter initialization mode
+
+  if (x <= 1U) {
+    // Compact filter banks of other controller (CAN1 to bottom, CAN2 to top) and rebalance CAN2 start bank
+    used = 0U;
+    if (x == 0U) {
+      end = 28U;
+      for (i = can_filter_bank[1][1]; i > can_filter_bank[1][0]; i--) {
+        if ((ptr_CAN_master->FA1R & ((uint32_t)1U << (i - 1U))) != 0U) {
+          end--;
+          used++;
+          CAN_FilterBankMove (ptr_CAN_master, end, i - 1U);
+        }
+      }
+      split = can_filter_bank[0][1];
+      if (split < banks)       { split = banks;       }
+      if (split > (28U - used)) { split = 28U - used; }
+    } else {
+      for (i = can_filter_bank[0][0]; i < can_filter_bank[0][1]; i++) {
+        if ((ptr_CAN_master->FA1R & ((uint32_t)1U << i)) != 0U) {
+          CAN_FilterBankMove (ptr_CAN_master, used, i);
+          used++;
+        }
+      }
+      split = can_filter_bank[1][0];
+      if (split > (28U - banks)) { split = 28U - banks; }
+      if (split < used)          { split = used;        }
+    }
+    can_filter_bank[0][1] = (uint8_t)split;
+    can_filter_bank[1][0] = (uint8_t)split;
+    can_filter_bank[1][1] = 28U;
+    ptr_CAN_master->FMR = (ptr_CAN_master->FMR & ~CAN_FMR_CAN2SB) | ((split << 8) & CAN_FMR_CAN2SB);
+  }
+
+  first = can_filter_bank[x][0];
+  end   = can_filter_bank[x][1];
+  if (banks > (end - first)) {                          // Not enough filter banks available
+    status = ARM_DRIVER_ERROR;
+  } else {
+    msk = (((uint32_t)1U << (end - first)) - 1U) << first;
+    ptr_CAN_master->FA1R  &= ~msk;                      // Put all filters of controller in inactive mode
+    ptr_CAN_master->FM1R   = (ptr_CAN_master->FM1R  & ~msk) | ((img.fm1r  << first) & msk);
+    ptr_CAN_master->FS1R   = (ptr_CAN_master->FS1R  & ~msk) | ((img.fs1r  << first) & msk);
+    ptr_CAN_master->FFA1R  = (ptr_CAN_master->FFA1R & ~msk) | ((img.ffa1r << first) & msk);
+    for (i = first; i < end; i++) {
+      if ((i - first) < banks) {
+        ptr_CAN_master->sFilterRegister[i].FR1 = img.fr[i - first][0];
+        ptr_CAN_master->sFilterRegister[i].FR2 = img.fr[i - first][1];
+      } else {
+        ptr_CAN_master->sFilterRegister[i].FR1 = 0U;
+        ptr_CAN_master->sFilterRegister[i].FR2 = 0U;
+      }
+    }
+    ptr_CAN_master->FA1R  |= (((uint32_t)1U << banks) - 1U) << first;
+    table->banks = banks;
+  }
+
+  ptr_CAN_master->FMR &= ~CAN_FMR_FINIT;                // Exit filter initialization mode
+
+  return status;
+}
+
 // CAN Driver Functions
 
 /**
@@ -851,9 +2229,8 @@ static int32_t CANx_PowerControl (ARM_POWER_STATE state, uint8_t x) {
   uint8_t      bank, bank_end;
 
   if (x >= CAN_CTRL_NUM) { return ARM_DRIVER_ERROR; }
-  if      (x == 2U)      { bank = 0U;                   bank_end = CAN3_FILTER_BANK_NUM;                        }
-  else if (x == 1U)      { bank = CAN1_FILTER_BANK_NUM; bank_end = CAN1_FILTER_BANK_NUM + CAN2_FILTER_BANK_NUM; }
-  else                   { bank = 0U;                   bank_end = CAN1_FILTER_BANK_NUM;                        }
+  bank     = can_filter_bank[x][0];
+  bank_end = can_filter_bank[x][1];
   if (bank >= bank_end)  { return ARM_DRIVER_ERROR; }
 
   if (x <= 1U) {
@@ -919,6 +2296,20 @@ static int32_t CANx_PowerControl (ARM_POWER_STATE state, uint8_t x) {
       while ((ptr_CAN->MCR & CAN_MCR_RESET) != 0U);
 
       memset(&can_obj_cfg[x][0], 0U, CAN_TOT_OBJ_NUM);
+      can_rx_queue[x][0].wr = 0U;               // Empty software receive queues
+      can_rx_queue[x][0].rd = 0U;
+      can_rx_queue[x][1].wr = 0U;
+      can_rx_queue[x][1].rd = 0U;
+      can_tx_queue[x].cnt      = 0U;            // Empty software transmit queue
+      can_tx_queue[x].mb_abort = 0U;
+      can_time[x].valid = 0U;                   // Restart time base
+      can_stat[x].enabled = 0U;                 // Stop statistics collection
+#if (CAN_ROUTE_NUM > 0U)
+      can_route_num[x]    = 0U;                 // Clear routing table and forwarding queue
+      can_fwd[x].rd       = can_fwd[x].wr;
+#endif
+      memset(&can_obj_time[x][0], 0U, sizeof(can_obj_time[x]));
+      memset(&can_rx_tick[x][0],  0U, sizeof(can_rx_tick[x]));
 
 #if (MX_CAN1 == 1U)
       if (x == 0U) {
@@ -1013,7 +2404,7 @@ static int32_t CANx_PowerControl (ARM_POWER_STATE state, uint8_t x) {
 
       // Initialize filter banks
       if (x == 0U) {
-        CAN1->FMR =  CAN_FMR_FINIT | ((CAN1_FILTER_BANK_NUM << 8) & CAN_FMR_CAN2SB);
+        CAN1->FMR =  CAN_FMR_FINIT | (((uint32_t)can_filter_bank[0][1] << 8) & CAN_FMR_CAN2SB);
       }
       msk         =  ((uint32_t)1U << bank_end) - ((uint32_t)1U << bank);
       ptr_CAN_master->FMR  |=  CAN_FMR_FINIT;   // Enter filter initialization mode
@@ -1028,6 +2419,20 @@ static int32_t CANx_PowerControl (ARM_POWER_STATE state, uint8_t x) {
       }
 
       memset(&can_obj_cfg[x][0], 0U, CAN_TOT_OBJ_NUM);
+      can_rx_queue[x][0].wr = 0U;               // Empty software receive queues
+      can_rx_queue[x][0].rd = 0U;
+      can_rx_queue[x][1].wr = 0U;
+      can_rx_queue[x][1].rd = 0U;
+      can_tx_queue[x].cnt      = 0U;            // Empty software transmit queue
+      can_tx_queue[x].mb_abort = 0U;
+      can_time[x].valid = 0U;                   // Restart time base
+      can_stat[x].enabled = 0U;                 // Stop statistics collection
+#if (CAN_ROUTE_NUM > 0U)
+      can_route_num[x]    = 0U;                 // Clear routing table and forwarding queue
+      can_fwd[x].rd       = can_fwd[x].wr;
+#endif
+      memset(&can_obj_time[x][0], 0U, sizeof(can_obj_time[x]));
+      memset(&can_rx_tick[x][0],  0U, sizeof(can_rx_tick[x]));
 
       ptr_CAN->IER =   CAN_IER_TMEIE  |         // Enable Interrupts
                        CAN_IER_FMPIE0 |
@@ -1044,7 +2449,7 @@ static int32_t CANx_PowerControl (ARM_POWER_STATE state, uint8_t x) {
 #if defined(RTE_DEVICE_FRAMEWORK_CLASSIC)
 #if (MX_CAN1 == 1U)
       if (x == 0U) {
-        if ((CAN_SignalUnitEvent[0] != NULL) || (CAN_SignalObjectEvent[0] != NULL)) {
+        if ((CAN_SignalUnitEvent[0] != NULL) || (CAN_SignalObjectEvent[0] != NULL) || (CAN1_RX_QUEUE_SIZE > 0U) || (CAN1_TX_QUEUE_SIZE > 0U)) {
           NVIC_ClearPendingIRQ (CAN1_TX_IRQn);
           NVIC_EnableIRQ       (CAN1_TX_IRQn);
           NVIC_ClearPendingIRQ (CAN1_RX0_IRQn);
@@ -1060,7 +2465,7 @@ static int32_t CANx_PowerControl (ARM_POWER_STATE state, uint8_t x) {
 #endif
 #if (MX_CAN2 == 1U)
       if (x == 1U) {
-        if ((CAN_SignalUnitEvent[1] != NULL) || (CAN_SignalObjectEvent[1] != NULL)) {
+        if ((CAN_SignalUnitEvent[1] != NULL) || (CAN_SignalObjectEvent[1] != NULL) || (CAN2_RX_QUEUE_SIZE > 0U) || (CAN2_TX_QUEUE_SIZE > 0U)) {
           NVIC_ClearPendingIRQ (CAN2_TX_IRQn);
           NVIC_EnableIRQ       (CAN2_TX_IRQn);
           NVIC_ClearPendingIRQ (CAN2_RX0_IRQn);
@@ -1076,7 +2481,7 @@ static int32_t CANx_PowerControl (ARM_POWER_STATE state, uint8_t x) {
 #endif
 #if (MX_CAN3 == 1U)
       if (x == 2U) {
-        if ((CAN_SignalUnitEvent[2] != NULL) || (CAN_SignalObjectEvent[2] != NULL)) {
+        if ((CAN_SignalUnitEvent[2] != NULL) || (CAN_SignalObjectEvent[2] != NULL) || (CAN3_RX_QUEUE_SIZE > 0U) || (CAN3_TX_QUEUE_SIZE > 0U)) {
           NVIC_ClearPendingIRQ (CAN3_TX_IRQn);
           NVIC_EnableIRQ       (CAN3_TX_IRQn);
           NVIC_ClearPendingIRQ (CAN3_RX0_IRQn);
@@ -1164,6 +2569,8 @@ static int32_t CANx_SetBitrate (ARM_CAN_BITRATE_SELECT select, uint32_t bitrate,
   ptr_CAN->BTR = ((brp - 1U) & CAN_BTR_BRP) | ((sjw - 1U) << 24) | ((phase_seg2 - 1U) << 20) | ((prop_seg + phase_seg1 - 1U) << 16);
   ptr_CAN->MCR =  mcr;                          // Return to previous mode
 
+  can_stat[x].bitrate = bitrate;                // Used for bus load calculation
+
   return ARM_DRIVER_OK;
 }
 #if (MX_CAN1 == 1U)
@@ -1207,13 +2614,17 @@ static int32_t CANx_SetMode (ARM_CAN_MODE mode, uint8_t x) {
   switch (mode) {
     case ARM_CAN_MODE_INITIALIZATION:
       ptr_CAN_master->FMR |=  CAN_FMR_FINIT;    // Filter initialization mode
-      ptr_CAN->MCR  =  CAN_MCR_INRQ;            // Enter initialization mode
+      ptr_CAN->MCR  = (ptr_CAN->MCR & CAN_MCR_TTCM) |
+                       CAN_MCR_INRQ ;           // Enter initialization mode
       while ((ptr_CAN->MSR&CAN_MSR_INAK)==0U);  // Wait to enter initialization mode
       event = ARM_CAN_EVENT_UNIT_BUS_OFF;
       break;
     case ARM_CAN_MODE_NORMAL:
+      ptr_CAN->MCR |=  CAN_MCR_INRQ;            // Enter initialization mode (BTR is write protected)
+      while ((ptr_CAN->MSR&CAN_MSR_INAK)==0U);  // Wait to enter initialization mode
       ptr_CAN->BTR &=~(CAN_BTR_LBKM | CAN_BTR_SILM);
-      ptr_CAN->MCR  =  CAN_MCR_ABOM |           // Activate automatic bus-off
+      ptr_CAN->MCR  = (ptr_CAN->MCR & CAN_MCR_TTCM) |
+                       CAN_MCR_ABOM |           // Activate automatic bus-off
                        CAN_MCR_AWUM ;           // Enable automatic wakeup mode
       while ((ptr_CAN->MSR&CAN_MSR_INAK)!=0U);  // Wait to exit initialization mode
       ptr_CAN_master->FMR &= ~CAN_FMR_FINIT;    // Filter active mode
@@ -1425,13 +2836,52 @@ static int32_t CAN3_ObjectConfigure (uint32_t obj_idx, ARM_CAN_OBJ_CONFIG obj_cf
 */
 static int32_t CANx_MessageSend (uint32_t obj_idx, ARM_CAN_MSG_INFO *msg_info, const uint8_t *data, uint8_t size, uint8_t x) {
   CAN_TypeDef *ptr_CAN;
+  CAN_TX_MSG   msg;
   uint32_t     tir;
+  int32_t      status;
 
   if (x >= CAN_CTRL_NUM)                                          { return ARM_DRIVER_ERROR;           }
   if ((obj_idx < CAN_RX_OBJ_NUM) || (obj_idx >= CAN_TOT_OBJ_NUM)) { return ARM_DRIVER_ERROR_PARAMETER; }
   if (can_driver_powered[x] == 0U)                                { return ARM_DRIVER_ERROR;           }
   if (can_obj_cfg[x][obj_idx] != ARM_CAN_OBJ_TX)                  { return ARM_DRIVER_ERROR;           }
 
+  if (can_tx_queue[x].size != 0U) {                     // Send through software transmit queue
+    if ((msg_info->id & ARM_CAN_ID_IDE_Msk) != 0U) {    // Extended Identifier
+      msg.tir = (msg_info->id <<  3) | CAN_TI0R_IDE;
+    } else {                                            // Standard Identifier
+      msg.tir = (msg_info->id << 21);
+    }
+    if (size > 8U) { size = 8U; }
+    if (msg_info->rtr != 0U) {                          // If send RTR requested
+      size      = 0U;
+      msg.tir  |= CAN_TI0R_RTR;
+      msg.tdtr  = msg_info->dlc & CAN_TDT0R_DLC;
+      msg.tdlr  = 0U;
+      msg.tdhr  = 0U;
+    } else {
+      msg.tdtr  = size & CAN_TDT0R_DLC;
+      msg.tdlr  = *((__packed uint32_t *)(data  ));
+      msg.tdhr  = *((__packed uint32_t *)(data+4));
+    }
+    msg.obj_idx = obj_idx;
+
+    NVIC_DisableIRQ (can_tx_irqn[x]);
+    if ((can_tx_queue[x].cnt == 0U) && (CANx_TxMailboxLoad (&msg, x) < 3U)) {
+      status = (int32_t)size;
+    } else if (CANx_TxQueueSpace (x) != 0U) {
+      CANx_TxQueueInsert (&msg, false, x);
+      if (can_tx_queue[x].replace != 0U) {
+        CANx_TxQueueReplace (x);
+      }
+      status = (int32_t)size;
+    } else {
+      status = ARM_DRIVER_ERROR_BUSY;
+    }
+    NVIC_EnableIRQ  (can_tx_irqn[x]);
+
+    return status;
+  }
+
   obj_idx -= CAN_RX_OBJ_NUM;                            // obj_idx origin to 0
 
   ptr_CAN  = ptr_CANx[x];
@@ -1487,6 +2937,7 @@ static int32_t CAN3_MessageSend (uint32_t obj_idx, ARM_CAN_MSG_INFO *msg_info, c
 */
 static int32_t CANx_MessageRead (uint32_t obj_idx, ARM_CAN_MSG_INFO *msg_info, uint8_t *data, uint8_t size, uint8_t x) {
   CAN_TypeDef *ptr_CAN;
+  CAN_RX_MSG   msg;
   uint32_t     data_rx[2][2];
 
   if (x >= CAN_CTRL_NUM)                         { return ARM_DRIVER_ERROR;           }
@@ -1498,6 +2949,19 @@ static int32_t CANx_MessageRead (uint32_t obj_idx, ARM_CAN_MSG_INFO *msg_info, u
 
   if (size > 8U) { size = 8U; }
 
+  if (can_rx_queue[x][obj_idx].size != 0U) {           // Read from software receive queue
+    if (CANx_RxQueueRead (obj_idx, &msg, 1U, x) == 0U) { return ARM_DRIVER_ERROR; }
+    can_obj_time[x][obj_idx] = msg.timestamp;
+    msg_info->id  = msg.id;
+    msg_info->rtr = msg.rtr;
+    msg_info->dlc = msg.dlc;
+    if (msg.rtr != 0U) { size = 0U; }
+    if (size > 0U) {
+      memcpy(data, msg.data, size);
+    }
+    return ((int32_t)size);
+  }
+
   if ((ptr_CAN->sFIFOMailBox[obj_idx].RIR & CAN_RI0R_IDE) != 0U) {      // Extended Identifier
     msg_info->id = (0x1FFFFFFFUL & (ptr_CAN->sFIFOMailBox[obj_idx].RIR >>  3)) | ARM_CAN_ID_IDE_Msk;
   } else {                                              // Standard Identifier
@@ -1513,6 +2977,15 @@ static int32_t CANx_MessageRead (uint32_t obj_idx, ARM_CAN_MSG_INFO *msg_info, u
 
   msg_info->dlc = ptr_CAN->sFIFOMailBox[obj_idx].RDTR & CAN_RDT0R_DLC;
 
+  if ((ptr_CAN->MCR & CAN_MCR_TTCM) != 0U) {
+    can_obj_time[x][obj_idx] = CANx_TimeExtend (ptr_CAN->sFIFOMailBox[obj_idx].RDTR >> 16, CANx_RxTickGet (obj_idx, x), x);
+  } else {
+    can_obj_time[x][obj_idx] = 0U;
+  }
+  if (can_stat[x].enabled != 0U) {
+    CANx_StatFrame (CAN_FrameBits (ptr_CAN->sFIFOMailBox[obj_idx].RIR & CAN_RI0R_IDE, msg_info->rtr, msg_info->dlc), false, x);
+  }
+
   if (size > 0U) {
     data_rx[x][0] = ptr_CAN->sFIFOMailBox[obj_idx].RDLR;
     data_rx[x][1] = ptr_CAN->sFIFOMailBox[obj_idx].RDHR;
@@ -1546,12 +3019,25 @@ static int32_t CAN3_MessageRead (uint32_t obj_idx, ARM_CAN_MSG_INFO *msg_info, u
                  - ARM_CAN_ABORT_MESSAGE_SEND :     abort sending of CAN message
                  - ARM_CAN_CONTROL_RETRANSMISSION : enable/disable automatic retransmission
                  - ARM_CAN_SET_TRANSCEIVER_DELAY :  set transceiver delay
+                 - ARM_CAN_READ_RX_QUEUE :          read messages from software receive queue
+                 - ARM_CAN_CONTROL_TX_REPLACE :     enable/disable abort and replace of lower priority mailbox
+                 - ARM_CAN_SET_FILTER_TABLE :       replace all filters with filters compiled from table
+                 - ARM_CAN_CONTROL_TIMESTAMP :      enable/disable time triggered communication mode (time stamping)
+                 - ARM_CAN_GET_TIMESTAMP :          get time stamp of last message read or sent on object
+                                                    (idle bus counter wraps resynchronized from HAL tick)
+                 - ARM_CAN_CONTROL_STATISTICS :     enable/disable collection of bus statistics
+                 - ARM_CAN_GET_STATISTICS :         get bus statistics
+                 - ARM_CAN_SET_ROUTE_TABLE :        set routing table for forwarding received frames
   \param[in]   arg      Argument of operation
   \param[in]   x        Controller number (0..2)
   \return      execution status
+                 - for ARM_CAN_READ_RX_QUEUE: value >= 0 number of messages read
 */
 static int32_t CANx_Control (uint32_t control, uint32_t arg, uint8_t x) {
-  CAN_TypeDef *ptr_CAN;
+  CAN_TypeDef       *ptr_CAN;
+  CAN_RX_QUEUE_READ *ptr_read;
+  CAN_TIMESTAMP     *ptr_time;
+  uint32_t           i, j, mb, mcr, primask;
 
   if (x >= CAN_CTRL_NUM)           { return ARM_DRIVER_ERROR; }
   if (can_driver_powered[x] == 0U) { return ARM_DRIVER_ERROR; }
@@ -1561,6 +3047,24 @@ static int32_t CANx_Control (uint32_t control, uint32_t arg, uint8_t x) {
   switch (control & ARM_CAN_CONTROL_Msk) {
     case ARM_CAN_ABORT_MESSAGE_SEND:
       if ((arg < CAN_RX_OBJ_NUM) || (arg >= CAN_TOT_OBJ_NUM)) { return ARM_DRIVER_ERROR_PARAMETER; }
+      if (can_tx_queue[x].size != 0U) {
+        // Remove queued messages of object and abort mailboxes holding its messages
+        NVIC_DisableIRQ (can_tx_irqn[x]);
+        for (i = 0U, j = 0U; i < can_tx_queue[x].cnt; i++) {
+          if (can_tx_queue[x].msg[i].obj_idx != arg) {
+            can_tx_queue[x].msg[j++] = can_tx_queue[x].msg[i];
+          }
+        }
+        can_tx_queue[x].cnt = j;
+        for (mb = 0U; mb < 3U; mb++) {
+          if (((ptr_CAN->TSR & (CAN_TSR_TME0 << mb)) == 0U) && (can_tx_queue[x].mb_obj[mb] == arg)) {
+            can_tx_queue[x].mb_abort &= (uint8_t)~(1U << mb);
+            ptr_CAN->TSR = CAN_TSR_ABRQ0 << (mb * 8U);
+          }
+        }
+        NVIC_EnableIRQ  (can_tx_irqn[x]);
+        break;
+      }
       arg -= CAN_RX_OBJ_NUM;
       switch (arg) {
         case 0:
@@ -1588,6 +3092,87 @@ static int32_t CANx_Control (uint32_t control, uint32_t arg, uint8_t x) {
           return ARM_DRIVER_ERROR_PARAMETER;
       }
       break;
+    case ARM_CAN_READ_RX_QUEUE:
+      ptr_read = (CAN_RX_QUEUE_READ *)arg;
+      if (ptr_read == NULL)                                    { return ARM_DRIVER_ERROR_PARAMETER; }
+      if (ptr_read->obj_idx >= CAN_RX_OBJ_NUM)                 { return ARM_DRIVER_ERROR_PARAMETER; }
+      if ((ptr_read->msg == NULL) && (ptr_read->num != 0U))    { return ARM_DRIVER_ERROR_PARAMETER; }
+      if (can_obj_cfg[x][ptr_read->obj_idx] != ARM_CAN_OBJ_RX) { return ARM_DRIVER_ERROR;           }
+      if (can_rx_queue[x][ptr_read->obj_idx].size == 0U)       { return ARM_DRIVER_ERROR_UNSUPPORTED; }
+      return ((int32_t)CANx_RxQueueRead (ptr_read->obj_idx, ptr_read->msg, ptr_read->num, x));
+    case ARM_CAN_CONTROL_TX_REPLACE:
+      if (can_tx_queue[x].size == 0U) { return ARM_DRIVER_ERROR_UNSUPPORTED; }
+      switch (arg) {
+        case 0:
+        case 1:
+          can_tx_queue[x].replace = (uint8_t)arg;
+          break;
+        default:
+          return ARM_DRIVER_ERROR_PARAMETER;
+      }
+      break;
+    case ARM_CAN_SET_FILTER_TABLE:
+      return CANx_SetFilterTable ((CAN_FILTER_TABLE *)arg, x);
+    case ARM_CAN_CONTROL_TIMESTAMP:
+      if (arg > 1U) { return ARM_DRIVER_ERROR_PARAMETER; }
+      mcr = ptr_CAN->MCR;
+      ptr_CAN->MCR = CAN_MCR_INRQ;                      // Activate initialization mode
+      while ((ptr_CAN->MSR & CAN_MSR_INAK) == 0U);      // Wait to enter initialization mode
+      if (arg == 1U) {
+        can_time[x].valid = 0U;                         // Restart time base
+        mcr |=  CAN_MCR_TTCM;
+      } else {
+        mcr &= ~CAN_MCR_TTCM;
+      }
+      ptr_CAN->MCR = mcr;                               // Return to previous mode
+      break;
+    case ARM_CAN_GET_TIMESTAMP:
+      ptr_time = (CAN_TIMESTAMP *)arg;
+      if (ptr_time == NULL)                    { return ARM_DRIVER_ERROR_PARAMETER; }
+      if (ptr_time->obj_idx >= CAN_TOT_OBJ_NUM) { return ARM_DRIVER_ERROR_PARAMETER; }
+      primask = __get_PRIMASK();
+      __disable_irq();                                  // Transmit time stamps are updated in interrupt routine
+      ptr_time->time = can_obj_time[x][ptr_time->obj_idx];
+      __set_PRIMASK(primask);
+      break;
+    case ARM_CAN_CONTROL_STATISTICS:
+      switch (arg) {
+        case 0:
+          can_stat[x].enabled = 0U;
+          ptr_CAN->IER &= ~CAN_IER_LECIE;               // Disable last error code interrupt
+          break;
+        case 1:
+          primask = __get_PRIMASK();
+          __disable_irq();
+          memset(&can_stat[x].cnt,      0U, sizeof(can_stat[x].cnt));
+          memset(&can_stat[x].load_bits, 0U, sizeof(can_stat[x].load_bits));
+          can_stat[x].start_tick = HAL_GetTick();
+          can_stat[x].load_tick  = can_stat[x].start_tick;
+          can_stat[x].bucket     = 0U;
+          can_stat[x].tec        = (uint8_t)((ptr_CAN->ESR & CAN_ESR_TEC) >> 16);
+          can_stat[x].enabled    = 1U;
+          __set_PRIMASK(primask);
+          ptr_CAN->ESR  = CAN_ESR_LEC;                  // Set last error code to 7 (detect next error)
+          ptr_CAN->IER |= CAN_IER_LECIE;                // Enable last error code interrupt
+#if defined(RTE_DEVICE_FRAMEWORK_CLASSIC)
+          NVIC_EnableIRQ (can_tx_irqn[x]);
+          NVIC_EnableIRQ (can_sce_irqn[x]);
+#endif
+          break;
+        default:
+          return ARM_DRIVER_ERROR_PARAMETER;
+      }
+      break;
+    case ARM_CAN_GET_STATISTICS:
+      if (arg == 0U) { return ARM_DRIVER_ERROR_PARAMETER; }
+      CANx_StatRead ((CAN_STATISTICS *)arg, x);
+      break;
+    case ARM_CAN_SET_ROUTE_TABLE:
+#if (CAN_ROUTE_NUM > 0U)
+      return CANx_SetRouteTable ((const CAN_ROUTE_TABLE *)arg, x);
+#else
+      return ARM_DRIVER_ERROR_UNSUPPORTED;
+#endif
     case ARM_CAN_SET_FD_MODE:
     case ARM_CAN_SET_TRANSCEIVER_DELAY:
     default:
@@ -1677,23 +3262,33 @@ static ARM_CAN_STATUS CAN3_GetStatus (void) { return CANx_GetStatus (2); }
 void CAN1_TX_IRQHandler (void) {
   uint32_t esr, ier;
 
-  if ((CAN1->TSR & CAN_TSR_TXOK0) != 0U) {
-    if (can_obj_cfg[0][CAN_RX_OBJ_NUM] == ARM_CAN_OBJ_TX) {
-      if (CAN_SignalObjectEvent[0] != NULL) { CAN_SignalObjectEvent[0](CAN_RX_OBJ_NUM, ARM_CAN_EVENT_SEND_COMPLETE); }
-    }
-    CAN1->TSR = CAN_TSR_RQCP0;          // Request completed on transmit mailbox 0
+  if ((CAN1->MCR & CAN_MCR_TTCM) != 0U) {
+    CANx_TxTimeCapture (0U);
   }
-  if ((CAN1->TSR & CAN_TSR_TXOK1) != 0U) {
-    if (can_obj_cfg[0][CAN_RX_OBJ_NUM+1U] == ARM_CAN_OBJ_TX) {
-      if (CAN_SignalObjectEvent[0] != NULL) { CAN_SignalObjectEvent[0](CAN_RX_OBJ_NUM+1U, ARM_CAN_EVENT_SEND_COMPLETE); }
-    }
-    CAN1->TSR = CAN_TSR_RQCP1;          // Request completed on transmit mailbox 1
+  if (can_stat[0].enabled != 0U) {
+    CANx_StatTxIRQ (0U);
   }
-  if ((CAN1->TSR & CAN_TSR_TXOK2) != 0U) {
-    if (can_obj_cfg[0][CAN_RX_OBJ_NUM+2U] == ARM_CAN_OBJ_TX) {
-      if (CAN_SignalObjectEvent[0] != NULL) { CAN_SignalObjectEvent[0](CAN_RX_OBJ_NUM+2U, ARM_CAN_EVENT_SEND_COMPLETE); }
+  if (can_tx_queue[0].size != 0U) {
+    CANx_TxQueueIRQ (0U);
+  } else {
+    if ((CAN1->TSR & CAN_TSR_RQCP0) != 0U) {
+      if (((CAN1->TSR & CAN_TSR_TXOK0) != 0U) && (can_obj_cfg[0][CAN_RX_OBJ_NUM] == ARM_CAN_OBJ_TX)) {
+        if (CAN_SignalObjectEvent[0] != NULL) { CAN_SignalObjectEvent[0](CAN_RX_OBJ_NUM, ARM_CAN_EVENT_SEND_COMPLETE); }
+      }
+      CAN1->TSR = CAN_TSR_RQCP0;        // Request completed on transmit mailbox 0 (sent, failed or aborted)
+    }
+    if ((CAN1->TSR & CAN_TSR_RQCP1) != 0U) {
+      if (((CAN1->TSR & CAN_TSR_TXOK1) != 0U) && (can_obj_cfg[0][CAN_RX_OBJ_NUM+1U] == ARM_CAN_OBJ_TX)) {
+        if (CAN_SignalObjectEvent[0] != NULL) { CAN_SignalObjectEvent[0](CAN_RX_OBJ_NUM+1U, ARM_CAN_EVENT_SEND_COMPLETE); }
+      }
+      CAN1->TSR = CAN_TSR_RQCP1;        // Request completed on transmit mailbox 1 (sent, failed or aborted)
+    }
+    if ((CAN1->TSR & CAN_TSR_RQCP2) != 0U) {
+      if (((CAN1->TSR & CAN_TSR_TXOK2) != 0U) && (can_obj_cfg[0][CAN_RX_OBJ_NUM+2U] == ARM_CAN_OBJ_TX)) {
+        if (CAN_SignalObjectEvent[0] != NULL) { CAN_SignalObjectEvent[0](CAN_RX_OBJ_NUM+2U, ARM_CAN_EVENT_SEND_COMPLETE); }
+      }
+      CAN1->TSR = CAN_TSR_RQCP2;        // Request completed on transmit mailbox 2 (sent, failed or aborted)
     }
-    CAN1->TSR = CAN_TSR_RQCP2;          // Request completed on transmit mailbox 2
   }
 
   // Handle transition from from 'bus off', ' error active' state, or re-enable warning interrupt
@@ -1717,13 +3312,18 @@ void CAN1_TX_IRQHandler (void) {
   \brief       CAN1 Receive on FIFO0 Interrupt Routine (IRQ).
 */
 void CAN1_RX0_IRQHandler (void) {
-  uint32_t esr, ier;
+  uint32_t esr, ier, event;
 
   if (can_obj_cfg[0][0] == ARM_CAN_OBJ_RX) {
-    if ((CAN1->RF0R & CAN_RF0R_FOVR0) != 0U) {
+    if (can_rx_queue[0][0].size != 0U) {
+      event = CANx_RxQueueFill (0U, 0U);
+      if ((event != 0U) && (CAN_SignalObjectEvent[0] != NULL)) { CAN_SignalObjectEvent[0](0U, event); }
+    } else if ((CAN1->RF0R & CAN_RF0R_FOVR0) != 0U) {
+      CANx_RxTickLatch (0U, 0U);
       CAN1->RF0R = CAN_RF0R_FOVR0;      // Clear overrun flag
       if (CAN_SignalObjectEvent[0] != NULL) { CAN_SignalObjectEvent[0](0U, ARM_CAN_EVENT_RECEIVE | ARM_CAN_EVENT_RECEIVE_OVERRUN); }
     } else if ((CAN1->RF0R & CAN_RF0R_FMP0) != 0U) {
+      CANx_RxTickLatch (0U, 0U);
       if (CAN_SignalObjectEvent[0] != NULL) { CAN_SignalObjectEvent[0](0U, ARM_CAN_EVENT_RECEIVE); }
     }
   } else {
@@ -1751,13 +3351,18 @@ void CAN1_RX0_IRQHandler (void) {
   \brief       CAN1 Receive on FIFO1 Interrupt Routine (IRQ).
 */
 void CAN1_RX1_IRQHandler (void) {
-  uint32_t esr, ier;
+  uint32_t esr, ier, event;
 
   if (can_obj_cfg[0][1] == ARM_CAN_OBJ_RX) {
-    if ((CAN1->RF1R & CAN_RF1R_FOVR1) != 0U) {
+    if (can_rx_queue[0][1].size != 0U) {
+      event = CANx_RxQueueFill (1U, 0U);
+      if ((event != 0U) && (CAN_SignalObjectEvent[0] != NULL)) { CAN_SignalObjectEvent[0](1U, event); }
+    } else if ((CAN1->RF1R & CAN_RF1R_FOVR1) != 0U) {
+      CANx_RxTickLatch (1U, 0U);
       CAN1->RF1R = CAN_RF1R_FOVR1;      // Clear overrun flag
       if (CAN_SignalObjectEvent[0] != NULL) { CAN_SignalObjectEvent[0](1U, ARM_CAN_EVENT_RECEIVE | ARM_CAN_EVENT_RECEIVE_OVERRUN); }
     } else if ((CAN1->RF1R & CAN_RF1R_FMP1) != 0U) {
+      CANx_RxTickLatch (1U, 0U);
       if (CAN_SignalObjectEvent[0] != NULL) { CAN_SignalObjectEvent[0](1U, ARM_CAN_EVENT_RECEIVE); }
     }
   } else {
@@ -1787,10 +3392,13 @@ void CAN1_RX1_IRQHandler (void) {
 void CAN1_SCE_IRQHandler (void) {
   uint32_t esr, ier;
 
+  esr = CAN1->ESR;
+  ier = CAN1->IER;
+  CAN1->MSR = CAN_MSR_ERRI;               // Clear error interrupt
+  if (can_stat[0].enabled != 0U) {
+    CANx_StatError (esr, 0U);
+  }
   if (CAN_SignalUnitEvent[0] != NULL) {
-    esr = CAN1->ESR;
-    ier = CAN1->IER;
-    CAN1->MSR = CAN_MSR_ERRI;             // Clear error interrupt
     if      (((esr & CAN_ESR_BOFF) != 0U) && ((ier & CAN_IER_BOFIE) != 0U)) { CAN1->IER &= ~CAN_IER_BOFIE; CAN_SignalUnitEvent[0](ARM_CAN_EVENT_UNIT_BUS_OFF); }
     else if (((esr & CAN_ESR_EPVF) != 0U) && ((ier & CAN_IER_EPVIE) != 0U)) { CAN1->IER &= ~CAN_IER_EPVIE; CAN_SignalUnitEvent[0](ARM_CAN_EVENT_UNIT_PASSIVE); }
     else if (((esr & CAN_ESR_EWGF) != 0U) && ((ier & CAN_IER_EWGIE) != 0U)) { CAN1->IER &= ~CAN_IER_EWGIE; CAN_SignalUnitEvent[0](ARM_CAN_EVENT_UNIT_WARNING); }
@@ -1806,23 +3414,33 @@ void CAN1_SCE_IRQHandler (void) {
 void CAN2_TX_IRQHandler (void) {
   uint32_t esr, ier;
 
-  if ((CAN2->TSR & CAN_TSR_TXOK0) != 0U) {
-    if (can_obj_cfg[1][CAN_RX_OBJ_NUM] == ARM_CAN_OBJ_TX) {
-      if (CAN_SignalObjectEvent[1] != NULL) { CAN_SignalObjectEvent[1](CAN_RX_OBJ_NUM, ARM_CAN_EVENT_SEND_COMPLETE); }
-    }
-    CAN2->TSR = CAN_TSR_RQCP0;          // Request completed on transmit mailbox 0
+  if ((CAN2->MCR & CAN_MCR_TTCM) != 0U) {
+    CANx_TxTimeCapture (1U);
   }
-  if ((CAN2->TSR & CAN_TSR_TXOK1) != 0U) {
-    if (can_obj_cfg[1][CAN_RX_OBJ_NUM+1U] == ARM_CAN_OBJ_TX) {
-      if (CAN_SignalObjectEvent[1] != NULL) { CAN_SignalObjectEvent[1](CAN_RX_OBJ_NUM+1U, ARM_CAN_EVENT_SEND_COMPLETE); }
-    }
-    CAN2->TSR = CAN_TSR_RQCP1;          // Request completed on transmit mailbox 1
+  if (can_stat[1].enabled != 0U) {
+    CANx_StatTxIRQ (1U);
   }
-  if ((CAN2->TSR & CAN_TSR_TXOK2) != 0U) {
-    if (can_obj_cfg[1][CAN_RX_OBJ_NUM+2U] == ARM_CAN_OBJ_TX) {
-      if (CAN_SignalObjectEvent[1] != NULL) { CAN_SignalObjectEvent[1](CAN_RX_OBJ_NUM+2U, ARM_CAN_EVENT_SEND_COMPLETE); }
+  if (can_tx_queue[1].size != 0U) {
+    CANx_TxQueueIRQ (1U);
+  } else {
+    if ((CAN2->TSR & CAN_TSR_RQCP0) != 0U) {
+      if (((CAN2->TSR & CAN_TSR_TXOK0) != 0U) && (can_obj_cfg[1][CAN_RX_OBJ_NUM] == ARM_CAN_OBJ_TX)) {
+        if (CAN_SignalObjectEvent[1] != NULL) { CAN_SignalObjectEvent[1](CAN_RX_OBJ_NUM, ARM_CAN_EVENT_SEND_COMPLETE); }
+      }
+      CAN2->TSR = CAN_TSR_RQCP0;        // Request completed on transmit mailbox 0 (sent, failed or aborted)
+    }
+    if ((CAN2->TSR & CAN_TSR_RQCP1) != 0U) {
+      if (((CAN2->TSR & CAN_TSR_TXOK1) != 0U) && (can_obj_cfg[1][CAN_RX_OBJ_NUM+1U] == ARM_CAN_OBJ_TX)) {
+        if (CAN_SignalObjectEvent[1] != NULL) { CAN_SignalObjectEvent[1](CAN_RX_OBJ_NUM+1U, ARM_CAN_EVENT_SEND_COMPLETE); }
+      }
+      CAN2->TSR = CAN_TSR_RQCP1;        // Request completed on transmit mailbox 1 (sent, failed or aborted)
+    }
+    if ((CAN2->TSR & CAN_TSR_RQCP2) != 0U) {
+      if (((CAN2->TSR & CAN_TSR_TXOK2) != 0U) && (can_obj_cfg[1][CAN_RX_OBJ_NUM+2U] == ARM_CAN_OBJ_TX)) {
+        if (CAN_SignalObjectEvent[1] != NULL) { CAN_SignalObjectEvent[1](CAN_RX_OBJ_NUM+2U, ARM_CAN_EVENT_SEND_COMPLETE); }
+      }
+      CAN2->TSR = CAN_TSR_RQCP2;        // Request completed on transmit mailbox 2 (sent, failed or aborted)
     }
-    CAN2->TSR = CAN_TSR_RQCP2;          // Request completed on transmit mailbox 2
   }
 
   // Handle transition from from 'bus off', ' error active' state, or re-enable warning interrupt
@@ -1846,13 +3464,18 @@ void CAN2_TX_IRQHandler (void) {
   \brief       CAN2 Receive on FIFO0 Interrupt Routine (IRQ).
 */
 void CAN2_RX0_IRQHandler (void) {
-  uint32_t esr, ier;
+  uint32_t esr, ier, event;
 
   if (can_obj_cfg[1][0] == ARM_CAN_OBJ_RX) {
-    if ((CAN2->RF0R & CAN_RF0R_FOVR0) != 0U) {
+    if (can_rx_queue[1][0].size != 0U) {
+      event = CANx_RxQueueFill (0U, 1U);
+      if ((event != 0U) && (CAN_SignalObjectEvent[1] != NULL)) { CAN_SignalObjectEvent[1](0U, event); }
+    } else if ((CAN2->RF0R & CAN_RF0R_FOVR0) != 0U) {
+      CANx_RxTickLatch (0U, 1U);
       CAN2->RF0R = CAN_RF0R_FOVR0;      // Clear overrun flag
       if (CAN_SignalObjectEvent[1] != NULL) { CAN_SignalObjectEvent[1](0U, ARM_CAN_EVENT_RECEIVE | ARM_CAN_EVENT_RECEIVE_OVERRUN); }
     } else if ((CAN2->RF0R & CAN_RF0R_FMP0) != 0U) {
+      CANx_RxTickLatch (0U, 1U);
       if (CAN_SignalObjectEvent[1] != NULL) { CAN_SignalObjectEvent[1](0U, ARM_CAN_EVENT_RECEIVE); }
     }
   } else {
@@ -1880,13 +3503,18 @@ void CAN2_RX0_IRQHandler (void) {
   \brief       CAN2 Receive on FIFO1 Interrupt Routine (IRQ).
 */
 void CAN2_RX1_IRQHandler (void) {
-  uint32_t esr, ier;
+  uint32_t esr, ier, event;
 
   if (can_obj_cfg[1][1] == ARM_CAN_OBJ_RX) {
-    if ((CAN2->RF1R & CAN_RF1R_FOVR1) != 0U) {
+    if (can_rx_queue[1][1].size != 0U) {
+      event = CANx_RxQueueFill (1U, 1U);
+      if ((event != 0U) && (CAN_SignalObjectEvent[1] != NULL)) { CAN_SignalObjectEvent[1](1U, event); }
+    } else if ((CAN2->RF1R & CAN_RF1R_FOVR1) != 0U) {
+      CANx_RxTickLatch (1U, 1U);
       CAN2->RF1R = CAN_RF1R_FOVR1;      // Clear overrun flag
       if (CAN_SignalObjectEvent[1] != NULL) { CAN_SignalObjectEvent[1](1U, ARM_CAN_EVENT_RECEIVE | ARM_CAN_EVENT_RECEIVE_OVERRUN); }
     } else if ((CAN2->RF1R & CAN_RF1R_FMP1) != 0U) {
+      CANx_RxTickLatch (1U, 1U);
       if (CAN_SignalObjectEvent[1] != NULL) { CAN_SignalObjectEvent[1](1U, ARM_CAN_EVENT_RECEIVE); }
     }
   } else {
@@ -1916,10 +3544,13 @@ void CAN2_RX1_IRQHandler (void) {
 void CAN2_SCE_IRQHandler (void) {
   uint32_t esr, ier;
 
+  esr = CAN2->ESR;
+  ier = CAN2->IER;
+  CAN2->MSR = CAN_MSR_ERRI;               // Clear error interrupt
+  if (can_stat[1].enabled != 0U) {
+    CANx_StatError (esr, 1U);
+  }
   if (CAN_SignalUnitEvent[1] != NULL) {
-    esr = CAN2->ESR;
-    ier = CAN2->IER;
-    CAN2->MSR = CAN_MSR_ERRI;             // Clear error interrupt
     if      (((esr & CAN_ESR_BOFF) != 0U) && ((ier & CAN_IER_BOFIE) != 0U)) { CAN2->IER &= ~CAN_IER_BOFIE; CAN_SignalUnitEvent[1](ARM_CAN_EVENT_UNIT_BUS_OFF); }
     else if (((esr & CAN_ESR_EPVF) != 0U) && ((ier & CAN_IER_EPVIE) != 0U)) { CAN2->IER &= ~CAN_IER_EPVIE; CAN_SignalUnitEvent[1](ARM_CAN_EVENT_UNIT_PASSIVE); }
     else if (((esr & CAN_ESR_EWGF) != 0U) && ((ier & CAN_IER_EWGIE) != 0U)) { CAN2->IER &= ~CAN_IER_EWGIE; CAN_SignalUnitEvent[1](ARM_CAN_EVENT_UNIT_WARNING); }
@@ -1935,23 +3566,33 @@ void CAN2_SCE_IRQHandler (void) {
 void CAN3_TX_IRQHandler (void) {
   uint32_t esr, ier;
 
-  if ((CAN3->TSR & CAN_TSR_TXOK0) != 0U) {
-    if (can_obj_cfg[2][CAN_RX_OBJ_NUM] == ARM_CAN_OBJ_TX) {
-      if (CAN_SignalObjectEvent[2] != NULL) { CAN_SignalObjectEvent[2](CAN_RX_OBJ_NUM, ARM_CAN_EVENT_SEND_COMPLETE); }
-    }
-    CAN3->TSR = CAN_TSR_RQCP0;          // Request completed on transmit mailbox 0
+  if ((CAN3->MCR & CAN_MCR_TTCM) != 0U) {
+    CANx_TxTimeCapture (2U);
   }
-  if ((CAN3->TSR & CAN_TSR_TXOK1) != 0U) {
-    if (can_obj_cfg[2][CAN_RX_OBJ_NUM+1U] == ARM_CAN_OBJ_TX) {
-      if (CAN_SignalObjectEvent[2] != NULL) { CAN_SignalObjectEvent[2](CAN_RX_OBJ_NUM+1U, ARM_CAN_EVENT_SEND_COMPLETE); }
-    }
-    CAN3->TSR = CAN_TSR_RQCP1;          // Request completed on transmit mailbox 1
+  if (can_stat[2].enabled != 0U) {
+    CANx_StatTxIRQ (2U);
   }
-  if ((CAN3->TSR & CAN_TSR_TXOK2) != 0U) {
-    if (can_obj_cfg[2][CAN_RX_OBJ_NUM+2U] == ARM_CAN_OBJ_TX) {
-      if (CAN_SignalObjectEvent[2] != NULL) { CAN_SignalObjectEvent[2](CAN_RX_OBJ_NUM+2U, ARM_CAN_EVENT_SEND_COMPLETE); }
+  if (can_tx_queue[2].size != 0U) {
+    CANx_TxQueueIRQ (2U);
+  } else {
+    if ((CAN3->TSR & CAN_TSR_RQCP0) != 0U) {
+      if (((CAN3->TSR & CAN_TSR_TXOK0) != 0U) && (can_obj_cfg[2][CAN_RX_OBJ_NUM] == ARM_CAN_OBJ_TX)) {
+        if (CAN_SignalObjectEvent[2] != NULL) { CAN_SignalObjectEvent[2](CAN_RX_OBJ_NUM, ARM_CAN_EVENT_SEND_COMPLETE); }
+      }
+      CAN3->TSR = CAN_TSR_RQCP0;        // Request completed on transmit mailbox 0 (sent, failed or aborted)
+    }
+    if ((CAN3->TSR & CAN_TSR_RQCP1) != 0U) {
+      if (((CAN3->TSR & CAN_TSR_TXOK1) != 0U) && (can_obj_cfg[2][CAN_RX_OBJ_NUM+1U] == ARM_CAN_OBJ_TX)) {
+        if (CAN_SignalObjectEvent[2] != NULL) { CAN_SignalObjectEvent[2](CAN_RX_OBJ_NUM+1U, ARM_CAN_EVENT_SEND_COMPLETE); }
+      }
+      CAN3->TSR = CAN_TSR_RQCP1;        // Request completed on transmit mailbox 1 (sent, failed or aborted)
+    }
+    if ((CAN3->TSR & CAN_TSR_RQCP2) != 0U) {
+      if (((CAN3->TSR & CAN_TSR_TXOK2) != 0U) && (can_obj_cfg[2][CAN_RX_OBJ_NUM+2U] == ARM_CAN_OBJ_TX)) {
+        if (CAN_SignalObjectEvent[2] != NULL) { CAN_SignalObjectEvent[2](CAN_RX_OBJ_NUM+2U, ARM_CAN_EVENT_SEND_COMPLETE); }
+      }
+      CAN3->TSR = CAN_TSR_RQCP2;        // Request completed on transmit mailbox 2 (sent, failed or aborted)
     }
-    CAN3->TSR = CAN_TSR_RQCP2;          // Request completed on transmit mailbox 2
   }
 
   // Handle transition from from 'bus off', ' error active' state, or re-enable warning interrupt
@@ -1975,13 +3616,18 @@ void CAN3_TX_IRQHandler (void) {
   \brief       CAN3 Receive on FIFO0 Interrupt Routine (IRQ).
 */
 void CAN3_RX0_IRQHandler (void) {
-  uint32_t esr, ier;
+  uint32_t esr, ier, event;
 
   if (can_obj_cfg[2][0] == ARM_CAN_OBJ_RX) {
-    if ((CAN3->RF0R & CAN_RF0R_FOVR0) != 0U) {
+    if (can_rx_queue[2][0].size != 0U) {
+      event = CANx_RxQueueFill (0U, 2U);
+      if ((event != 0U) && (CAN_SignalObjectEvent[2] != NULL)) { CAN_SignalObjectEvent[2](0U, event); }
+    } else if ((CAN3->RF0R & CAN_RF0R_FOVR0) != 0U) {
+      CANx_RxTickLatch (0U, 2U);
       CAN3->RF0R = CAN_RF0R_FOVR0;      // Clear overrun flag
       if (CAN_SignalObjectEvent[2] != NULL) { CAN_SignalObjectEvent[2](0U, ARM_CAN_EVENT_RECEIVE | ARM_CAN_EVENT_RECEIVE_OVERRUN); }
     } else if ((CAN3->RF0R & CAN_RF0R_FMP0) != 0U) {
+      CANx_RxTickLatch (0U, 2U);
       if (CAN_SignalObjectEvent[2] != NULL) { CAN_SignalObjectEvent[2](0U, ARM_CAN_EVENT_RECEIVE); }
     }
   } else {
@@ -2009,13 +3655,18 @@ void CAN3_RX0_IRQHandler (void) {
   \brief       CAN3 Receive on FIFO1 Interrupt Routine (IRQ).
 */
 void CAN3_RX1_IRQHandler (void) {
-  uint32_t esr, ier;
+  uint32_t esr, ier, event;
 
   if (can_obj_cfg[2][1] == ARM_CAN_OBJ_RX) {
-    if ((CAN3->RF1R & CAN_RF1R_FOVR1) != 0U) {
+    if (can_rx_queue[2][1].size != 0U) {
+      event = CANx_RxQueueFill (1U, 2U);
+      if ((event != 0U) && (CAN_SignalObjectEvent[2] != NULL)) { CAN_SignalObjectEvent[2](1U, event); }
+    } else if ((CAN3->RF1R & CAN_RF1R_FOVR1) != 0U) {
+      CANx_RxTickLatch (1U, 2U);
       CAN3->RF1R = CAN_RF1R_FOVR1;      // Clear overrun flag
       if (CAN_SignalObjectEvent[2] != NULL) { CAN_SignalObjectEvent[2](1U, ARM_CAN_EVENT_RECEIVE | ARM_CAN_EVENT_RECEIVE_OVERRUN); }
     } else if ((CAN3->RF1R & CAN_RF1R_FMP1) != 0U) {
+      CANx_RxTickLatch (1U, 2U);
       if (CAN_SignalObjectEvent[2] != NULL) { CAN_SignalObjectEvent[2](1U, ARM_CAN_EVENT_RECEIVE); }
     }
   } else {
@@ -2045,10 +3696,13 @@ void CAN3_RX1_IRQHandler (void) {
 void CAN3_SCE_IRQHandler (void) {
   uint32_t esr, ier;
 
+  esr = CAN3->ESR;
+  ier = CAN3->IER;
+  CAN3->MSR = CAN_MSR_ERRI;               // Clear error interrupt
+  if (can_stat[2].enabled != 0U) {
+    CANx_StatError (esr, 2U);
+  }
   if (CAN_SignalUnitEvent[2] != NULL) {
-    esr = CAN3->ESR;
-    ier = CAN3->IER;
-    CAN3->MSR = CAN_MSR_ERRI;             // Clear error interrupt
     if      (((esr & CAN_ESR_BOFF) != 0U) && ((ier & CAN_IER_BOFIE) != 0U)) { CAN3->IER &= ~CAN_IER_BOFIE; CAN_SignalUnitEvent[2](ARM_CAN_EVENT_UNIT_BUS_OFF); }
     else if (((esr & CAN_ESR_EPVF) != 0U) && ((ier & CAN_IER_EPVIE) != 0U)) { CAN3->IER &= ~CAN_IER_EPVIE; CAN_SignalUnitEvent[2](ARM_CAN_EVENT_UNIT_PASSIVE); }
     else if (((esr & CAN_ESR_EWGF) != 0U) && ((ier & CAN_IER_EWGIE) != 0U)) { CAN3->IER &= ~CAN_IER_EWGIE; CAN_SignalUnitEvent[2](ARM_CAN_EVENT_UNIT_WARNING); }
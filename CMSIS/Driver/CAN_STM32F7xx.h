@@ -145,4 +145,94 @@
 #define CAN_CTRL_NUM                    (1U)
 #endif
 
+// Driver specific control codes
+#define ARM_CAN_READ_RX_QUEUE           (0x20UL << ARM_CAN_CONTROL_Pos) // Read messages from software receive queue; arg = pointer to CAN_RX_QUEUE_READ
+#define ARM_CAN_CONTROL_TX_REPLACE      (0x21UL << ARM_CAN_CONTROL_Pos) // Abort lower priority mailbox for higher priority queued message; arg: 0=disabled, 1=enabled
+#define ARM_CAN_SET_FILTER_TABLE        (0x22UL << ARM_CAN_CONTROL_Pos) // Replace all filters of controller with compiled table; arg = pointer to CAN_FILTER_TABLE
+#define ARM_CAN_CONTROL_TIMESTAMP       (0x23UL << ARM_CAN_CONTROL_Pos) // Time triggered communication mode (time stamping); arg: 0=disabled, 1=enabled
+#define ARM_CAN_GET_TIMESTAMP           (0x24UL << ARM_CAN_CONTROL_Pos) // Get time stamp of last message read or sent on object; arg = pointer to CAN_TIMESTAMP (idle wraps of 16-bit counter resynchronized from HAL tick, see driver notes)
+#define ARM_CAN_CONTROL_STATISTICS      (0x25UL << ARM_CAN_CONTROL_Pos) // Collection of bus statistics (enable resets counters); arg: 0=disabled, 1=enabled
+#define ARM_CAN_GET_STATISTICS          (0x26UL << ARM_CAN_CONTROL_Pos) // Get bus statistics; arg = pointer to CAN_STATISTICS
+#define ARM_CAN_SET_ROUTE_TABLE         (0x27UL << ARM_CAN_CONTROL_Pos) // Set frame routing table of input controller; arg = pointer to CAN_ROUTE_TABLE
+
+// Message in software receive queue
+typedef struct _CAN_RX_MSG {
+  uint32_t              id;             // Identifier (ARM_CAN_ID_IDE_Msk set for extended identifier)
+  uint8_t               rtr;            // Remote transmission request frame
+  uint8_t               dlc;            // Data length code
+  uint8_t               reserved[2];
+  uint8_t               data[8];        // Data bytes
+  uint64_t              timestamp;      // Receive time stamp in bit times (0 if time stamping disabled)
+} CAN_RX_MSG;
+
+// Batched read from software receive queue
+typedef struct _CAN_RX_QUEUE_READ {
+  uint32_t              obj_idx;        // Receive object index
+  CAN_RX_MSG           *msg;            // Pointer to message array
+  uint32_t              num;            // Maximum number of messages to read
+} CAN_RX_QUEUE_READ;
+
+// Object time stamp
+typedef struct _CAN_TIMESTAMP {
+  uint32_t              obj_idx;        // Object index
+  uint32_t              reserved;
+  uint64_t              time;           // Time stamp in bit times of last message read (receive object) or sent (transmit object)
+} CAN_TIMESTAMP;
+
+// Bus statistics (frame bits are counted without stuff bits)
+typedef struct _CAN_STATISTICS {
+  uint64_t              tx_bits;        // Bits of transmitted frames
+  uint64_t              rx_bits;        // Bits of received frames (accepted by filters)
+  uint32_t              tx_frames;      // Number of transmitted frames
+  uint32_t              rx_frames;      // Number of received frames (accepted by filters)
+  uint32_t              arb_lost;       // Transmissions ended by lost arbitration (automatic retransmission disabled)
+  uint32_t              retransmit;     // Transmit errors followed by automatic retransmission
+  uint32_t              bus_load;       // Bus load over sliding window (in 0.1 %)
+  uint32_t              lec[8];         // Number of errors by last error code (index 1..6: stuff, form, acknowledgment, bit recessive, bit dominant, CRC)
+} CAN_STATISTICS;
+
+// Routing entry flags
+#define CAN_ROUTE_LOCAL                 (1U << 0) // Frame is also put into receive queue of input controller
+
+// Routing entry (frame received with matching identifier is sent on output controller)
+typedef struct _CAN_ROUTE {
+  uint32_t              id;             // Identifier (ARM_CAN_ID_IDE_Msk set for extended identifier)
+  uint32_t              mask;           // Compared identifier bits (ARM_CAN_ID_IDE_Msk compares identifier format)
+  uint32_t              new_id;         // Identifier bits written to forwarded frame
+  uint32_t              new_mask;       // Identifier bits replaced by new_id (0 = identifier not changed)
+  uint8_t               ctrl;           // Output controller (0 = CAN1, 1 = CAN2, 2 = CAN3)
+  uint8_t               obj_idx;        // Transmit object index on output controller (send complete event, abort)
+  uint8_t               flags;          // Routing entry flags (CAN_ROUTE_xxx)
+  uint8_t               reserved;
+} CAN_ROUTE;
+
+// Routing table
+typedef struct _CAN_ROUTE_TABLE {
+  const CAN_ROUTE      *route;          // Pointer to array of routing entries
+  uint32_t              num;            // Number of routing entries (0 = routing disabled)
+} CAN_ROUTE_TABLE;
+
+// Filter table entry types
+#define CAN_FILTER_ENTRY_EXACT          (0U)    // Exact identifier
+#define CAN_FILTER_ENTRY_MASK           (1U)    // Identifier with mask (arg = mask, bit set = bit compared)
+#define CAN_FILTER_ENTRY_RANGE          (2U)    // Identifier range (arg = last identifier in range)
+#define CAN_FILTER_ENTRY_TYPE_Msk       (3U)
+#define CAN_FILTER_ENTRY_DATA_ONLY      (1U << 4) // Flag: accept data frames only (default: data and remote frames)
+
+// Filter table entry
+typedef struct _CAN_FILTER_ENTRY {
+  uint32_t              id;             // Identifier (ARM_CAN_ID_IDE_Msk set for extended identifier)
+  uint32_t              arg;            // Mask or last identifier of range, depending on type
+  uint8_t               type;           // Entry type and flags (CAN_FILTER_ENTRY_xxx)
+  uint8_t               obj_idx;        // Receive object index
+  uint16_t              reserved;
+} CAN_FILTER_ENTRY;
+
+// Filter table
+typedef struct _CAN_FILTER_TABLE {
+  const CAN_FILTER_ENTRY *entry;        // Pointer to array of filter entries
+  uint32_t                num;          // Number of filter entries
+  uint32_t                banks;        // Number of filter banks used (updated by driver)
+} CAN_FILTER_TABLE;
+
 #endif // __CAN_STM32F7XX_H
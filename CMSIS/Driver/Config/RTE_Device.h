@@ -2684,6 +2684,18 @@
 #error "Invalid CAN1_TX Pin Configuration!"
 #endif
 
+//   <o> Software Receive Queue Size <0-255>
+//   <i> Number of messages buffered per receive object (FIFO0/FIFO1)
+//   <i> Receive interrupt moves messages from hardware FIFO to the queue
+//   <i> 0 = disabled (messages are read directly from hardware FIFO)
+#define RTE_CAN1_RX_QUEUE_SIZE          0
+
+//   <o> Software Transmit Queue Size <0-255>
+//   <i> Number of messages queued in software when all transmit mailboxes are busy
+//   <i> Queued messages are sent in identifier priority order from transmit interrupt
+//   <i> 0 = disabled (messages are written directly to transmit mailbox of object)
+#define RTE_CAN1_TX_QUEUE_SIZE          0
+
 // </e>
 
 
@@ -2715,6 +2727,18 @@
 #error "Invalid CAN2_TX Pin Configuration!"
 #endif
 
+//   <o> Software Receive Queue Size <0-255>
+//   <i> Number of messages buffered per receive object (FIFO0/FIFO1)
+//   <i> Receive interrupt moves messages from hardware FIFO to the queue
+//   <i> 0 = disabled (messages are read directly from hardware FIFO)
+#define RTE_CAN2_RX_QUEUE_SIZE          0
+
+//   <o> Software Transmit Queue Size <0-255>
+//   <i> Number of messages queued in software when all transmit mailboxes are busy
+//   <i> Queued messages are sent in identifier priority order from transmit interrupt
+//   <i> 0 = disabled (messages are written directly to transmit mailbox of object)
+#define RTE_CAN2_TX_QUEUE_SIZE          0
+
 // </e>
 
 
@@ -2747,6 +2771,18 @@
 #error "Invalid CAN3_TX Pin Configuration!"
 #endif
 
+//   <o> Software Receive Queue Size <0-255>
+//   <i> Number of messages buffered per receive object (FIFO0/FIFO1)
+//   <i> Receive interrupt moves messages from hardware FIFO to the queue
+//   <i> 0 = disabled (messages are read directly from hardware FIFO)
+#define RTE_CAN3_RX_QUEUE_SIZE          0
+
+//   <o> Software Transmit Queue Size <0-255>
+//   <i> Number of messages queued in software when all transmit mailboxes are busy
+//   <i> Queued messages are sent in identifier priority order from transmit interrupt
+//   <i> 0 = disabled (messages are written directly to transmit mailbox of object)
+#define RTE_CAN3_TX_QUEUE_SIZE          0
+
 // </e>
 
 
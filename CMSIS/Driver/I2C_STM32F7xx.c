@@ -18,8 +18,8 @@
  * 3. This notice may not be removed or altered from any source distribution.
  *
  *
- * $Date:        24. May 2016
- * $Revision:    V1.5
+ * $Date:        19. October 2026
+ * $Revision:    V1.9
  *
  * Driver:       Driver_I2C1, Driver_I2C2, Driver_I2C3, Driver_I2C4
  * Configured:   via RTE_Device.h configuration file
@@ -37,6 +37,16 @@
  * -------------------------------------------------------------------------- */
 
 /* History:
+ *  Version 1.9
+ *    Added slave register map mode (ARM_I2C_SLAVE_REG_MAP)
+ *  Version 1.8
+ *    Bus timing (TIMINGR) calculated from I2C kernel clock, rise/fall times and filters
+ *    Added bus timing control (ARM_I2C_BUS_TIMING)
+ *  Version 1.7
+ *    Added device memory transfers (ARM_I2C_MEM_WRITE, ARM_I2C_MEM_READ)
+ *  Version 1.6
+ *    Removed busy wait for bus release in MasterTransmit/MasterReceive
+ *    Added queued master transfer lists (ARM_I2C_TRANSFER_LIST)
  *  Version 1.5
  *    Added port configuration for ports supported by new subfamilies.
  *  Version 1.4
@@ -122,7 +132,7 @@ Configuration tab
 
 #include "I2C_STM32F7xx.h"
 
-#define ARM_I2C_DRV_VERSION ARM_DRIVER_VERSION_MAJOR_MINOR(1,5)    /* driver version */
+#define ARM_I2C_DRV_VERSION ARM_DRIVER_VERSION_MAJOR_MINOR(1,9)    /* driver version */
 
 
 #if defined(MX_I2C1_RX_DMA_Instance)
@@ -558,6 +568,189 @@ static void Enable_GPIO_Clock (const GPIO_TypeDef *GPIOx) {
 #endif
 
 
+/* I2C bus characteristics (ns) per speed mode, from the I2C-bus specification */
+typedef const struct _I2C_SPEED_CHAR {
+  uint32_t freq;                        // Maximum SCL frequency
+  uint32_t vd_dat_max;                  // Data valid time (max)
+  uint32_t su_dat_min;                  // Data setup time (min)
+  uint32_t low_min;                     // SCL low period (min)
+  uint32_t high_min;                    // SCL high period (min)
+  uint32_t rise_max;                    // Rise time (max)
+  uint32_t fall_max;                    // Fall time (max)
+} I2C_SPEED_CHAR;
+
+static I2C_SPEED_CHAR I2C_SpeedChar[3] = {
+  {  100000U, 3450U, 250U, 4700U, 4000U, 1000U, 300U },  /* Standard-mode  */
+  {  400000U,  900U, 100U, 1300U,  600U,  300U, 300U },  /* Fast-mode      */
+  { 1000000U,  450U,  50U,  500U,  260U,  120U, 120U }   /* Fast-mode Plus */
+};
+
+
+/**
+  \fn          uint32_t I2C_GetClockFreq (const I2C_TypeDef *reg)
+  \brief       Get I2C kernel clock frequency.
+  \param[in]   reg  Pointer to I2C peripheral registers
+  \return      kernel clock frequency in Hz
+*/
+static uint32_t I2C_GetClockFreq (const I2C_TypeDef *reg) {
+  uint32_t sel;
+
+  if      (reg == I2C1) { sel = (RCC->DCKCFGR2 & RCC_DCKCFGR2_I2C1SEL) >> RCC_DCKCFGR2_I2C1SEL_Pos; }
+  else if (reg == I2C2) { sel = (RCC->DCKCFGR2 & RCC_DCKCFGR2_I2C2SEL) >> RCC_DCKCFGR2_I2C2SEL_Pos; }
+  else if (reg == I2C3) { sel = (RCC->DCKCFGR2 & RCC_DCKCFGR2_I2C3SEL) >> RCC_DCKCFGR2_I2C3SEL_Pos; }
+  else /*(reg == I2C4)*/{ sel = (RCC->DCKCFGR2 & RCC_DCKCFGR2_I2C4SEL) >> RCC_DCKCFGR2_I2C4SEL_Pos; }
+
+  switch (sel) {
+    case 1U:  return HAL_RCC_GetSysClockFreq();
+    case 2U:  return HSI_VALUE;
+    default:  return HAL_RCC_GetPCLK1Freq();
+  }
+}
+
+
+/**
+  \fn          uint32_t I2C_TimingCalc (uint32_t fclk, const I2C_BUS_TIMING *t)
+  \brief       Calculate TIMINGR value for the highest compliant SCL frequency
+               not above the requested bus speed.
+  \param[in]   fclk  I2C kernel clock frequency in Hz
+  \param[in]   t     Pointer to bus timing parameters
+  \return      TIMINGR register value, 0 when no valid timing exists
+*/
+static uint32_t I2C_TimingCalc (uint32_t fclk, const I2C_BUS_TIMING *t) {
+  I2C_SPEED_CHAR *sc;
+  uint32_t tclk, tpresc, tscl, tlow, tsync, tsc_min, tdnf, taf_min, taf_max;
+  uint32_t presc, scldel, sdadel, scll, sclh;
+  uint32_t timingr, err, err_min;
+  int32_t  sda_min, sda_max;
+
+  if ((fclk == 0U) || (t->bus_speed == 0U)) {
+    return 0U;
+  }
+
+  /* Select bus characteristics of the speed mode */
+  if      (t->bus_speed <= I2C_SpeedChar[0].freq) { sc = &I2C_SpeedChar[0]; }
+  else if (t->bus_speed <= I2C_SpeedChar[1].freq) { sc = &I2C_SpeedChar[1]; }
+  else if (t->bus_speed <= I2C_SpeedChar[2].freq) { sc = &I2C_SpeedChar[2]; }
+  else                                            { return 0U; }
+
+  if ((t->rise_time > sc->rise_max) || (t->fall_time > sc->fall_max)) {
+    return 0U;
+  }
+
+  /* Times are calculated in ps */
+  tclk    = (uint32_t)(1000000000000ULL / fclk);
+  tscl    = (uint32_t)(1000000000000ULL / t->bus_speed);
+  tdnf    = t->dnf * tclk;
+  taf_min = (t->anf != 0U) ?  50000U : 0U;
+  taf_max = (t->anf != 0U) ? 260000U : 0U;
+
+  /* SCL synchronization delay: filter delays and 2 kernel clocks on each edge */
+  tsync = 2U * (taf_min + tdnf + (2U * tclk));
+
+  /* Data hold (SDADEL) window */
+  sda_min = (int32_t)(t->fall_time * 1000U) - (int32_t)(taf_min + tdnf + (3U * tclk));
+  sda_max = (int32_t)(sc->vd_dat_max * 1000U) - (int32_t)((t->rise_time * 1000U) + taf_max + tdnf + (4U * tclk));
+  if (sda_max < 0) {
+    /* Worst case delays exceed tVD;DAT(max): allow SDADEL = 0 (as used by ST reference timings) */
+    sda_max = 0;
+  }
+
+  timingr = 0U;
+  err_min = 0xFFFFFFFFU;
+
+  for (presc = 0U; presc < 16U; presc++) {
+    tpresc = (presc + 1U) * tclk;
+
+    /* Data hold delay */
+    sdadel = (sda_min > 0) ? (((uint32_t)sda_min + tpresc - 1U) / tpresc) : 0U;
+    if ((sdadel > 15U) || ((int32_t)(sdadel * tpresc) > sda_max)) {
+      continue;
+    }
+
+    /* Data setup delay */
+    scldel = ((((t->rise_time + sc->su_dat_min) * 1000U) + tpresc - 1U) / tpresc);
+    scldel = (scldel > 0U) ? (scldel - 1U) : 0U;
+    if (scldel > 15U) {
+      continue;
+    }
+
+    for (scll = 0U; scll < 256U; scll++) {
+      tlow = (scll + 1U) * tpresc;
+
+      if ((tlow + (tsync / 2U)) < (sc->low_min * 1000U)) {
+        continue;
+      }
+
+      /* Shortest high period meeting both tHIGH(min) and the SCL period */
+      tsc_min = sc->high_min * 1000U;
+      if (tsc_min > (tsync / 2U)) {
+        tsc_min -= tsync / 2U;
+      }
+      else {
+        tsc_min  = 0U;
+      }
+      if ((tlow + tsync + ((t->rise_time + t->fall_time) * 1000U) + tsc_min) < tscl) {
+        tsc_min = tscl - (tlow + tsync + ((t->rise_time + t->fall_time) * 1000U));
+      }
+
+      sclh = (tsc_min + tpresc - 1U) / tpresc;
+      sclh = (sclh > 0U) ? (sclh - 1U) : 0U;
+      if (sclh > 255U) {
+        continue;
+      }
+
+      err = tlow + ((sclh + 1U) * tpresc) + tsync + ((t->rise_time + t->fall_time) * 1000U) - tscl;
+
+      if (err < err_min) {
+        err_min = err;
+        timingr = (presc  << I2C_TIMINGR_PRESC_Pos)  |
+                  (scldel << I2C_TIMINGR_SCLDEL_Pos) |
+                  (sdadel << I2C_TIMINGR_SDADEL_Pos) |
+                  (sclh   << I2C_TIMINGR_SCLH_Pos)   |
+                  (scll   << I2C_TIMINGR_SCLL_Pos)   ;
+      }
+    }
+  }
+
+  return timingr;
+}
+
+
+/**
+  \fn          int32_t I2C_SetTiming (const I2C_BUS_TIMING *t, I2C_RESOURCES *i2c)
+  \brief       Calculate and apply bus timing.
+  \param[in]   t    Pointer to bus timing parameters
+  \param[in]   i2c  Pointer to I2C resources
+  \return      \ref execution_status
+*/
+static int32_t I2C_SetTiming (const I2C_BUS_TIMING *t, I2C_RESOURCES *i2c) {
+  uint32_t timingr, cr1;
+
+  timingr = I2C_TimingCalc (I2C_GetClockFreq (i2c->reg), t);
+
+  if (timingr == 0U) {
+    return ARM_DRIVER_ERROR_UNSUPPORTED;
+  }
+
+  /* Noise filters and timing are configured with peripheral disabled */
+  cr1 = i2c->reg->CR1 & ~(I2C_CR1_ANFOFF | I2C_CR1_DNF | I2C_CR1_PE);
+
+  cr1 |= (uint32_t)t->dnf << I2C_CR1_DNF_Pos;
+  if (t->anf == 0U) {
+    cr1 |= I2C_CR1_ANFOFF;
+  }
+
+  i2c->reg->CR1    &= ~I2C_CR1_PE;
+  i2c->reg->CR1     = cr1;
+  i2c->reg->TIMINGR = timingr;
+  i2c->reg->CR1    |=  I2C_CR1_PE;
+
+  i2c->info->timing = *t;
+
+  return ARM_DRIVER_OK;
+}
+
+
 /**
   \fn          ARM_DRV_VERSION I2C_GetVersion (void)
   \brief       Get driver version.
@@ -684,6 +877,11 @@ static int32_t I2C_Initialize (ARM_I2C_SignalEvent_t cb_event, I2C_RESOURCES *i2
   i2c->info->cb_event = cb_event;
   i2c->info->flags    = I2C_INIT;
 
+  /* Default bus timing parameters */
+  i2c->info->timing.rise_time = I2C_RISE_TIME_DEFAULT;
+  i2c->info->timing.fall_time = I2C_FALL_TIME_DEFAULT;
+  i2c->info->timing.anf       = 1U;
+
   return ARM_DRIVER_OK;
 }
 
@@ -779,6 +977,9 @@ static int32_t I2C_PowerControl (ARM_POWER_STATE state, I2C_RESOURCES *i2c) {
       i2c->info->status.arbitration_lost = 0U;
       i2c->info->status.bus_error        = 0U;
 
+      i2c->info->list   = NULL;
+      i2c->info->regmap = NULL;
+
       i2c->info->flags &= ~I2C_POWER;
       break;
 
@@ -862,57 +1063,41 @@ static int32_t I2C_PowerControl (ARM_POWER_STATE state, I2C_RESOURCES *i2c) {
 
 
 /**
-  \fn          int32_t I2C_MasterTransmit (uint32_t       addr,
-                                           const uint8_t *data,
-                                           uint32_t       num,
-                                           bool           xfer_pending,
-                                           I2C_RESOURCES *i2c)
-  \brief       Start transmitting data as I2C Master.
+  \fn          int32_t I2C_MasterStart (uint32_t       addr,
+                                        uint8_t       *data,
+                                        uint32_t       num,
+                                        bool           rx,
+                                        bool           xfer_pending,
+                                        I2C_RESOURCES *i2c)
+  \brief       Setup master transfer and generate (repeated) start condition.
   \param[in]   addr          Slave address (7-bit or 10-bit)
-  \param[in]   data          Pointer to buffer with data to send to I2C Slave
-  \param[in]   num           Number of data bytes to send
+  \param[in]   data          Pointer to data buffer
+  \param[in]   num           Number of data bytes to transfer
+  \param[in]   rx            Transfer direction (true = receive from slave)
   \param[in]   xfer_pending  Transfer operation is pending - Stop condition will not be generated
   \param[in]   i2c           Pointer to I2C resources
   \return      \ref execution_status
 */
-static int32_t I2C_MasterTransmit (uint32_t       addr,
-                                   const uint8_t *data,
-                                   uint32_t       num,
-                                   bool           xfer_pending,
-                                   I2C_RESOURCES *i2c) {
+static int32_t I2C_MasterStart (uint32_t       addr,
+                                uint8_t       *data,
+                                uint32_t       num,
+                                bool           rx,
+                                bool           xfer_pending,
+                                I2C_RESOURCES *i2c) {
   uint32_t cr2, cnt;
   bool restart;
 
-  if ((data == NULL) || (num == 0U)) {
-    return ARM_DRIVER_ERROR_PARAMETER;
-  }
-
-  if ((addr & ~(ARM_I2C_ADDRESS_10BIT | ARM_I2C_ADDRESS_GC)) > 0x3FFU) {
-    return ARM_DRIVER_ERROR_PARAMETER;
-  }
-
-  if (i2c->info->status.busy) {
-    return (ARM_DRIVER_ERROR_BUSY);
-  }
-
   restart = (i2c->info->xfer.ctrl & XFER_CTRL_RESTART) != 0U;
 
-  if (!restart) {
-    /* New transfer */
-    while (i2c->reg->ISR & I2C_ISR_BUSY) {
-      ; /* Wait until bus released */
-    }
-  }
-
   i2c->info->status.busy             = 1U;
   i2c->info->status.mode             = 1U;
-  i2c->info->status.direction        = 0U;
+  i2c->info->status.direction        = rx ? 1U : 0U;
   i2c->info->status.bus_error        = 0U;
   i2c->info->status.arbitration_lost = 0U;
 
   i2c->info->xfer.num  = num;
   i2c->info->xfer.cnt  = 0;
-  i2c->info->xfer.data = (uint8_t *)data;
+  i2c->info->xfer.data = data;
   i2c->info->xfer.ctrl = 0U;
 
   if (xfer_pending) {
@@ -926,6 +1111,9 @@ static int32_t I2C_MasterTransmit (uint32_t       addr,
   else {
     cr2 = (addr & 0x7F) << 1;
   }
+  if (rx) {
+    cr2 |= I2C_CR2_RD_WRN;
+  }
 
   /* Set number of bytes to transfer */
   if (num < 256) {
@@ -944,14 +1132,25 @@ static int32_t I2C_MasterTransmit (uint32_t       addr,
   /* Apply transfer setup */
   i2c->reg->CR2 = (cnt << 16) | cr2;
 
-  if (i2c->dma_tx) {
-    /* Enable stream */
-    if (HAL_DMA_Start_IT (i2c->dma_tx->h, (uint32_t)data, (uint32_t)&(i2c->reg->TXDR), num) != HAL_OK) {
-      return ARM_DRIVER_ERROR;
+  if (rx) {
+    if (i2c->dma_rx) {
+      /* Enable stream */
+      if (HAL_DMA_Start_IT (i2c->dma_rx->h, (uint32_t)&(i2c->reg->RXDR), (uint32_t)data, num) != HAL_OK) {
+        return ARM_DRIVER_ERROR;
+      }
+    }
+  }
+  else {
+    if (i2c->dma_tx) {
+      /* Enable stream */
+      if (HAL_DMA_Start_IT (i2c->dma_tx->h, (uint32_t)data, (uint32_t)&(i2c->reg->TXDR), num) != HAL_OK) {
+        return ARM_DRIVER_ERROR;
+      }
     }
   }
 
-  /* Generate start */
+  /* Generate start: when the bus is busy, the peripheral generates */
+  /* the start condition as soon as the bus is released             */
   i2c->reg->CR2 |= I2C_CR2_START;
   /* Enable transfer complete interrupt */
   i2c->reg->CR1 |= I2C_CR1_TCIE;
@@ -961,31 +1160,87 @@ static int32_t I2C_MasterTransmit (uint32_t       addr,
 
 
 /**
-  \fn          int32_t I2C_MasterReceive (uint32_t       addr,
-                                          uint8_t       *data,
-                                          uint32_t       num,
-                                          bool           xfer_pending,
-                                          I2C_RESOURCES *i2c)
-  \brief       Start receiving data as I2C Master.
-  \param[in]   addr          Slave address (7-bit or 10-bit)
-  \param[out]  data          Pointer to buffer for data to receive from I2C Slave
-  \param[in]   num           Number of data bytes to receive
-  \param[in]   xfer_pending  Transfer operation is pending - Stop condition will not be generated
-  \param[in]   i2c           Pointer to I2C resources
+  \fn          int32_t I2C_ListStart (I2C_RESOURCES *i2c)
+  \brief       Start current step of the active transfer list.
+  \param[in]   i2c  Pointer to I2C resources
   \return      \ref execution_status
 */
-static int32_t I2C_MasterReceive (uint32_t       addr,
-                                  uint8_t       *data,
-                                  uint32_t       num,
-                                  bool           xfer_pending,
-                                  I2C_RESOURCES *i2c) {
-  uint32_t cr2, cnt;
-  bool restart;
+static int32_t I2C_ListStart (I2C_RESOURCES *i2c) {
+  I2C_TRANSFER_LIST *list = i2c->info->list;
+  I2C_TRANSFER_STEP *step = &list->step[list->done];
+  bool pending;
 
-  if ((data == NULL) || (num == 0U)) {
+  /* Last step always ends with stop condition */
+  pending = ((step->flags & I2C_STEP_NO_STOP) != 0U) && ((list->done + 1U) < list->num);
+
+  return I2C_MasterStart (step->addr, step->data, step->num, (step->flags & I2C_STEP_READ) != 0U, pending, i2c);
+}
+
+
+/**
+  \fn          uint32_t I2C_ListNext (uint32_t event, I2C_RESOURCES *i2c)
+  \brief       Advance active transfer list (called from interrupt handlers).
+  \param[in]   event  0 when current step completed, otherwise step error event
+  \param[in]   i2c    Pointer to I2C resources
+  \return      event to signal (0 while the list is in progress)
+*/
+static uint32_t I2C_ListNext (uint32_t event, I2C_RESOURCES *i2c) {
+  I2C_TRANSFER_LIST *list = i2c->info->list;
+
+  if (event == 0U) {
+    list->done++;
+
+    if (list->done < list->num) {
+      /* Continue with next step */
+      if (I2C_ListStart (i2c) == ARM_DRIVER_OK) {
+        return 0U;
+      }
+      event = ARM_I2C_EVENT_TRANSFER_DONE | ARM_I2C_EVENT_TRANSFER_INCOMPLETE;
+    }
+    else {
+      event = ARM_I2C_EVENT_TRANSFER_DONE;
+    }
+  }
+
+  /* List completed, start next queued list */
+  list->event = event;
+
+  while (i2c->info->list->next != NULL) {
+    i2c->info->list = i2c->info->list->next;
+
+    if (I2C_ListStart (i2c) == ARM_DRIVER_OK) {
+      return event;
+    }
+    i2c->info->list->event = ARM_I2C_EVENT_TRANSFER_DONE | ARM_I2C_EVENT_TRANSFER_INCOMPLETE;
+  }
+  i2c->info->list = NULL;
+
+  return event;
+}
+
+
+/**
+  \fn          int32_t I2C_MemStart (const I2C_MEM_TRANSFER *mem, bool rx, I2C_RESOURCES *i2c)
+  \brief       Start device memory transfer.
+  \param[in]   mem  Pointer to memory transfer description
+  \param[in]   rx   Transfer direction (true = read from device memory)
+  \param[in]   i2c  Pointer to I2C resources
+  \return      \ref execution_status
+  \note        Memory address bytes are sent by the TXIS interrupt, the data phase
+               is started by the interrupt handler: after TCR (write, same transfer)
+               or after TC with repeated start (read).
+*/
+static int32_t I2C_MemStart (const I2C_MEM_TRANSFER *mem, bool rx, I2C_RESOURCES *i2c) {
+  I2C_TRANSFER_INFO *tr = &i2c->info->xfer;
+  uint32_t cr2;
+
+  if ((mem == NULL) || (mem->data == NULL) || (mem->num == 0U)) {
     return ARM_DRIVER_ERROR_PARAMETER;
   }
-  if ((addr & ~(ARM_I2C_ADDRESS_10BIT | ARM_I2C_ADDRESS_GC)) > 0x3FFU) {
+  if ((mem->mem_addr_size == 0U) || (mem->mem_addr_size > 2U)) {
+    return ARM_DRIVER_ERROR_PARAMETER;
+  }
+  if ((mem->addr & ~(ARM_I2C_ADDRESS_10BIT | ARM_I2C_ADDRESS_GC)) > 0x3FFU) {
     return ARM_DRIVER_ERROR_PARAMETER;
   }
 
@@ -993,61 +1248,48 @@ static int32_t I2C_MasterReceive (uint32_t       addr,
     return (ARM_DRIVER_ERROR_BUSY);
   }
 
-  restart = (i2c->info->xfer.ctrl & XFER_CTRL_RESTART) != 0U;
-
-  if (!restart) {
-    /* New transfer */
-    while (i2c->reg->ISR & I2C_ISR_BUSY) {
-      ; /* Wait until bus released */
-    }
-  }
-
   i2c->info->status.busy             = 1U;
   i2c->info->status.mode             = 1U;
-  i2c->info->status.direction        = 1U;
+  i2c->info->status.direction        = 0U;
   i2c->info->status.bus_error        = 0U;
   i2c->info->status.arbitration_lost = 0U;
 
-  i2c->info->xfer.num  = num;
-  i2c->info->xfer.cnt  = 0;
-  i2c->info->xfer.data = (uint8_t *)data;
-  i2c->info->xfer.ctrl = 0U;
-
-  if (xfer_pending) {
-    i2c->info->xfer.ctrl = XFER_CTRL_RESTART;
-  }
-
-  /* Set slave address and transfer direction */
-  if ((addr & ARM_I2C_ADDRESS_10BIT) != 0) {
-    cr2 = (addr & 0x3FF) | I2C_CR2_ADD10 | I2C_CR2_RD_WRN;
+  /* Memory address is sent MSB first */
+  if (mem->mem_addr_size == 2U) {
+    tr->mem_addr[0] = (uint8_t)(mem->mem_addr >> 8);
+    tr->mem_addr[1] = (uint8_t)(mem->mem_addr);
   }
   else {
-    cr2 = ((addr & 0x7F) << 1) | I2C_CR2_RD_WRN;
+    tr->mem_addr[0] = (uint8_t)(mem->mem_addr);
   }
 
-  /* Set number of bytes to transfer */
-  if (num < 256) {
-    cnt = num;
-    /* Send all data bytes and enable automatic STOP */
-    if (!xfer_pending && !restart) {
-      cr2 |= I2C_CR2_AUTOEND;
-    }
+  tr->num      = mem->mem_addr_size;
+  tr->cnt      = 0;
+  tr->data     = tr->mem_addr;
+  tr->mem_data = mem->data;
+  tr->mem_num  = mem->num;
+  tr->ctrl     = rx ? XFER_CTRL_MEM_RD : XFER_CTRL_MEM_WR;
+
+  /* Set slave address, write direction */
+  if ((mem->addr & ARM_I2C_ADDRESS_10BIT) != 0) {
+    cr2 = (mem->addr & 0x3FF) | I2C_CR2_ADD10;
   }
   else {
-    cnt = 255;
-    /* Send 255 data bytes and enable NBYTES reload */
+    cr2 = (mem->addr & 0x7F) << 1;
+  }
+
+  cr2 |= mem->mem_addr_size << 16;
+
+  if (!rx) {
+    /* Data follows in the same transfer */
     cr2 |= I2C_CR2_RELOAD;
   }
 
   /* Apply transfer setup */
-  i2c->reg->CR2 = (cnt << 16) | cr2;
+  i2c->reg->CR2 = cr2;
 
-  if (i2c->dma_rx) {
-    /* Enable stream */
-    if (HAL_DMA_Start_IT (i2c->dma_rx->h, (uint32_t)&(i2c->reg->RXDR), (uint32_t)data, num) != HAL_OK) {
-      return ARM_DRIVER_ERROR;
-    }
-  }
+  /* Memory address is always sent in interrupt mode */
+  i2c->reg->CR1 |= I2C_CR1_TXIE;
 
   /* Generate start */
   i2c->reg->CR2 |= I2C_CR2_START;
@@ -1058,6 +1300,77 @@ static int32_t I2C_MasterReceive (uint32_t       addr,
 }
 
 
+/**
+  \fn          int32_t I2C_MasterTransmit (uint32_t       addr,
+                                           const uint8_t *data,
+                                           uint32_t       num,
+                                           bool           xfer_pending,
+                                           I2C_RESOURCES *i2c)
+  \brief       Start transmitting data as I2C Master.
+  \param[in]   addr          Slave address (7-bit or 10-bit)
+  \param[in]   data          Pointer to buffer with data to send to I2C Slave
+  \param[in]   num           Number of data bytes to send
+  \param[in]   xfer_pending  Transfer operation is pending - Stop condition will not be generated
+  \param[in]   i2c           Pointer to I2C resources
+  \return      \ref execution_status
+*/
+static int32_t I2C_MasterTransmit (uint32_t       addr,
+                                   const uint8_t *data,
+                                   uint32_t       num,
+                                   bool           xfer_pending,
+                                   I2C_RESOURCES *i2c) {
+
+  if ((data == NULL) || (num == 0U)) {
+    return ARM_DRIVER_ERROR_PARAMETER;
+  }
+
+  if ((addr & ~(ARM_I2C_ADDRESS_10BIT | ARM_I2C_ADDRESS_GC)) > 0x3FFU) {
+    return ARM_DRIVER_ERROR_PARAMETER;
+  }
+
+  if (i2c->info->status.busy) {
+    return (ARM_DRIVER_ERROR_BUSY);
+  }
+
+  return I2C_MasterStart (addr, (uint8_t *)data, num, false, xfer_pending, i2c);
+}
+
+
+/**
+  \fn          int32_t I2C_MasterReceive (uint32_t       addr,
+                                          uint8_t       *data,
+                                          uint32_t       num,
+                                          bool           xfer_pending,
+                                          I2C_RESOURCES *i2c)
+  \brief       Start receiving data as I2C Master.
+  \param[in]   addr          Slave address (7-bit or 10-bit)
+  \param[out]  data          Pointer to buffer for data to receive from I2C Slave
+  \param[in]   num           Number of data bytes to receive
+  \param[in]   xfer_pending  Transfer operation is pending - Stop condition will not be generated
+  \param[in]   i2c           Pointer to I2C resources
+  \return      \ref execution_status
+*/
+static int32_t I2C_MasterReceive (uint32_t       addr,
+                                  uint8_t       *data,
+                                  uint32_t       num,
+                                  bool           xfer_pending,
+                                  I2C_RESOURCES *i2c) {
+
+  if ((data == NULL) || (num == 0U)) {
+    return ARM_DRIVER_ERROR_PARAMETER;
+  }
+  if ((addr & ~(ARM_I2C_ADDRESS_10BIT | ARM_I2C_ADDRESS_GC)) > 0x3FFU) {
+    return ARM_DRIVER_ERROR_PARAMETER;
+  }
+
+  if (i2c->info->status.busy) {
+    return (ARM_DRIVER_ERROR_BUSY);
+  }
+
+  return I2C_MasterStart (addr, data, num, true, xfer_pending, i2c);
+}
+
+
 /**
   \fn          int32_t I2C_SlaveTransmit (const uint8_t *data, uint32_t num, I2C_RESOURCES *i2c)
   \brief       Start transmitting data as I2C Slave.
@@ -1072,6 +1385,11 @@ static int32_t I2C_SlaveTransmit (const uint8_t *data, uint32_t num, I2C_RESOURC
     return ARM_DRIVER_ERROR_PARAMETER;
   }
 
+  if (i2c->info->regmap != NULL) {
+    /* Slave is served from register map */
+    return ARM_DRIVER_ERROR;
+  }
+
   if (i2c->info->status.busy) {
     return (ARM_DRIVER_ERROR_BUSY);
   }
@@ -1118,6 +1436,11 @@ static int32_t I2C_SlaveReceive (uint8_t *data, uint32_t num, I2C_RESOURCES *i2c
     return ARM_DRIVER_ERROR_PARAMETER;
   }
 
+  if (i2c->info->regmap != NULL) {
+    /* Slave is served from register map */
+    return ARM_DRIVER_ERROR;
+  }
+
   if (i2c->info->status.busy) {
     return (ARM_DRIVER_ERROR_BUSY);
   }
@@ -1172,10 +1495,9 @@ static int32_t I2C_Control (uint32_t control, uint32_t arg, I2C_RESOURCES *i2c)
   GPIO_InitTypeDef GPIO_InitStruct;
   GPIO_PinState state;
   uint32_t i, val;
-  uint32_t fpclk, fscl, ferr;
-  uint32_t presc, scl;
-  uint32_t presc_ok, scl_ok;
-  uint32_t err, err_min;
+  I2C_TRANSFER_LIST *list, *tail;
+  I2C_BUS_TIMING timing;
+  I2C_SLAVE_REG_MAP *map;
 
   if ((i2c->info->flags & I2C_POWER) == 0U) {
     /* I2C not powered */
@@ -1208,47 +1530,45 @@ static int32_t I2C_Control (uint32_t control, uint32_t arg, I2C_RESOURCES *i2c)
       break;
 
     case ARM_I2C_BUS_SPEED:
-      fpclk = HAL_RCC_GetPCLK1Freq();
+      timing = i2c->info->timing;
+
       switch (arg) {
         case ARM_I2C_BUS_SPEED_STANDARD: /* Clock = 100kHz */
-          fscl = 200000;
+          timing.bus_speed = 100000U;
           break;
 
         case ARM_I2C_BUS_SPEED_FAST: /* Clock = 400kHz */
-          fscl = 800000;
+          timing.bus_speed = 400000U;
           break;
         
         case ARM_I2C_BUS_SPEED_FAST_PLUS: /* Clock = 1MHz */
-          fscl = 2000000;
+          timing.bus_speed = 1000000U;
           break;
 
         default:
           return ARM_DRIVER_ERROR_UNSUPPORTED;
       }
-      /* Determine prescalers */
-      err_min = 0xFFFFFFFF;
-      for (presc = 1; presc <= 16; presc++) {
-        for (scl = 1; scl <= 256; scl++) {
-          ferr = fscl * scl * presc;
-
-          if (ferr <= fpclk) {
-            err = fpclk - ferr;
-            
-            if (err < err_min) {
-              err_min = err;
-              presc_ok = presc;
-              scl_ok   = scl;
-            }
-          }
-        }
+      return I2C_SetTiming (&timing, i2c);
+
+    case ARM_I2C_BUS_TIMING:
+      if (arg == 0U) {
+        return ARM_DRIVER_ERROR_PARAMETER;
       }
+      timing = *(const I2C_BUS_TIMING *)arg;
 
-      i2c->reg->CR1    &= ~I2C_CR1_PE;
-      i2c->reg->TIMINGR = ((presc_ok-1) << 28) |
-                          ((scl_ok -1)  <<  8) |
-                           (scl_ok -1)         ;
-      i2c->reg->CR1    |=  I2C_CR1_PE;
-      break;
+      if ((timing.dnf > 15U) || (timing.anf > 1U) || (timing.bus_speed > 1000000U)) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+      }
+
+      if (timing.bus_speed == 0U) {
+        timing.bus_speed = i2c->info->timing.bus_speed;
+      }
+      if (timing.bus_speed == 0U) {
+        /* Bus speed not set yet, parameters apply on ARM_I2C_BUS_SPEED */
+        i2c->info->timing = timing;
+        break;
+      }
+      return I2C_SetTiming (&timing, i2c);
 
     case ARM_I2C_BUS_CLEAR:
       /* Configure SCl and SDA pins as GPIO pin */
@@ -1306,6 +1626,10 @@ static int32_t I2C_Control (uint32_t control, uint32_t arg, I2C_RESOURCES *i2c)
       /* Save CR1 register */
       val = i2c->reg->CR1;
 
+      /* Interrupts enabled temporarily in DMA mode */
+      if (i2c->dma_rx != NULL) { val &= ~I2C_CR1_RXIE; }
+      if (i2c->dma_tx != NULL) { val &= ~I2C_CR1_TXIE; }
+
       /* Disable DMA requests and peripheral interrupts */
       i2c->reg->CR1 &= ~(I2C_CR1_RXDMAEN |
                          I2C_CR1_TXDMAEN |
@@ -1361,10 +1685,85 @@ static int32_t I2C_Control (uint32_t control, uint32_t arg, I2C_RESOURCES *i2c)
                       I2C_ICR_NACKCF |
                       I2C_ICR_ADDRCF ;
 
+      /* Queued transfer lists are discarded */
+      i2c->info->list = NULL;
+
       /* Restore settings and enable peripheral */
       i2c->reg->CR1 = val;
       break;
 
+    case ARM_I2C_MEM_WRITE:
+      return I2C_MemStart ((const I2C_MEM_TRANSFER *)arg, false, i2c);
+
+    case ARM_I2C_MEM_READ:
+      return I2C_MemStart ((const I2C_MEM_TRANSFER *)arg, true, i2c);
+
+    case ARM_I2C_SLAVE_REG_MAP:
+      map = (I2C_SLAVE_REG_MAP *)arg;
+
+      if (map != NULL) {
+        if ((map->mem == NULL) || (map->size == 0U) || (map->size > 256U)) {
+          return ARM_DRIVER_ERROR_PARAMETER;
+        }
+        map->wr_addr = 0U;
+        map->wr_num  = 0U;
+      }
+
+      if (i2c->info->status.busy) {
+        return ARM_DRIVER_ERROR_BUSY;
+      }
+
+      i2c->info->reg_ptr = 0U;
+      i2c->info->regmap  = map;
+      break;
+
+    case ARM_I2C_TRANSFER_LIST:
+      list = (I2C_TRANSFER_LIST *)arg;
+
+      if ((list == NULL) || (list->step == NULL) || (list->num == 0U)) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+      }
+      for (i = 0U; i < list->num; i++) {
+        if ((list->step[i].data == NULL) || (list->step[i].num == 0U) ||
+            ((list->step[i].addr & ~(ARM_I2C_ADDRESS_10BIT | ARM_I2C_ADDRESS_GC)) > 0x3FFU)) {
+          return ARM_DRIVER_ERROR_PARAMETER;
+        }
+      }
+
+      list->done  = 0U;
+      list->event = 0U;
+      list->next  = NULL;
+
+      /* Lists are advanced in I2C interrupt handlers */
+      HAL_NVIC_DisableIRQ (i2c->ev_irq_num);
+      HAL_NVIC_DisableIRQ (i2c->er_irq_num);
+
+      if (i2c->info->list != NULL) {
+        /* Append list to the queue */
+        tail = i2c->info->list;
+        while (tail->next != NULL) {
+          tail = tail->next;
+        }
+        tail->next = list;
+        val = ARM_DRIVER_OK;
+      }
+      else if (i2c->info->status.busy) {
+        val = (uint32_t)ARM_DRIVER_ERROR_BUSY;
+      }
+      else {
+        /* Start first step */
+        i2c->info->list = list;
+
+        val = (uint32_t)I2C_ListStart (i2c);
+        if (val != ARM_DRIVER_OK) {
+          i2c->info->list = NULL;
+        }
+      }
+
+      HAL_NVIC_EnableIRQ (i2c->ev_irq_num);
+      HAL_NVIC_EnableIRQ (i2c->er_irq_num);
+      return ((int32_t)val);
+
     default: return ARM_DRIVER_ERROR;
   }
   return ARM_DRIVER_OK;
@@ -1382,6 +1781,145 @@ static ARM_I2C_STATUS I2C_GetStatus (I2C_RESOURCES *i2c) {
 }
 
 
+/**
+  \fn          uint32_t I2C_RegMapEnd (I2C_RESOURCES *i2c)
+  \brief       Complete slave register map access (stop or repeated start).
+  \param[in]   i2c  Pointer to I2C resources
+  \return      event to signal
+*/
+static uint32_t I2C_RegMapEnd (I2C_RESOURCES *i2c) {
+  I2C_TRANSFER_INFO *tr  = &i2c->info->xfer;
+  I2C_SLAVE_REG_MAP *map = i2c->info->regmap;
+  uint32_t event, cnt;
+
+  event = 0U;
+  cnt   = 0U;
+
+  if (i2c->info->status.direction != 0U) {
+    /* Master write */
+    if ((tr->ctrl & XFER_CTRL_REG_PTR) == 0U) {
+      if ((i2c->dma_rx != NULL) && ((i2c->reg->CR1 & I2C_CR1_RXIE) == 0U)) {
+        cnt = tr->num - __HAL_DMA_GET_COUNTER(i2c->dma_rx->h);
+        HAL_DMA_Abort (i2c->dma_rx->h);
+      }
+      else {
+        cnt = (uint32_t)tr->cnt;
+      }
+    }
+    if (i2c->dma_rx != NULL) {
+      i2c->reg->CR1 &= ~I2C_CR1_RXIE;
+    }
+    if ((i2c->reg->ISR & I2C_ISR_RXNE) != 0U) {
+      /* Discard byte received beyond register map end */
+      (void)i2c->reg->RXDR;
+    }
+
+    if (cnt != 0U) {
+      map->wr_addr = i2c->info->reg_ptr;
+      map->wr_num  = cnt;
+
+      event = ARM_I2C_EVENT_REG_WRITE;
+    }
+  }
+  else {
+    /* Master read */
+    if ((i2c->dma_tx != NULL) && ((i2c->reg->CR1 & I2C_CR1_TXIE) == 0U)) {
+      cnt = tr->num - __HAL_DMA_GET_COUNTER(i2c->dma_tx->h);
+      HAL_DMA_Abort (i2c->dma_tx->h);
+    }
+    else {
+      cnt = (uint32_t)tr->cnt;
+    }
+    if (i2c->dma_tx != NULL) {
+      i2c->reg->CR1 &= ~I2C_CR1_TXIE;
+    }
+    if ((i2c->reg->ISR & I2C_ISR_TXE) == 0U) {
+      /* Last byte loaded was not sent, flush transmit data register */
+      i2c->reg->ISR = I2C_ISR_TXE;
+
+      if (cnt != 0U) { cnt--; }
+    }
+    if (cnt > tr->num) {
+      cnt = tr->num;
+    }
+  }
+
+  /* Auto-increment register pointer */
+  i2c->info->reg_ptr = (i2c->info->reg_ptr + cnt) % map->size;
+
+  tr->data = NULL;
+  tr->ctrl = 0U;
+
+  i2c->info->status.busy = 0U;
+
+  return event;
+}
+
+
+/**
+  \fn          uint32_t I2C_RegMapStart (uint32_t isr, I2C_RESOURCES *i2c)
+  \brief       Start slave register map access on address match.
+  \param[in]   isr  Interrupt and status register value
+  \param[in]   i2c  Pointer to I2C resources
+  \return      event to signal
+*/
+static uint32_t I2C_RegMapStart (uint32_t isr, I2C_RESOURCES *i2c) {
+  I2C_TRANSFER_INFO *tr  = &i2c->info->xfer;
+  I2C_SLAVE_REG_MAP *map = i2c->info->regmap;
+  uint32_t event;
+
+  event = 0U;
+
+  if ((tr->ctrl & XFER_CTRL_REG_MAP) != 0U) {
+    /* Repeated start */
+    event = I2C_RegMapEnd (i2c);
+  }
+
+  i2c->info->status.busy         = 1U;
+  i2c->info->status.mode         = 0U;
+  i2c->info->status.general_call = 0U;
+
+  tr->cnt  = 0;
+  tr->ctrl = XFER_CTRL_REG_MAP | XFER_CTRL_ADDR_DONE;
+
+  i2c->reg->CR1 |= I2C_CR1_TCIE;
+
+  if ((isr & I2C_ISR_DIR) == 0U) {
+    /* Master write: register pointer is received first */
+    i2c->info->status.direction = 1U;
+
+    tr->data  = NULL;
+    tr->num   = 0U;
+    tr->ctrl |= XFER_CTRL_REG_PTR;
+
+    /* Acknowledge pointer byte, then stretch until data phase is set up */
+    i2c->reg->CR2 = (1U << 16) | I2C_CR2_RELOAD;
+
+    if (i2c->dma_rx != NULL) {
+      i2c->reg->CR1 |= I2C_CR1_RXIE;
+    }
+  }
+  else {
+    /* Master read from current register pointer */
+    i2c->info->status.direction = 0U;
+
+    tr->data = &map->mem[i2c->info->reg_ptr];
+    tr->num  = map->size - i2c->info->reg_ptr;
+
+    i2c->reg->CR2 = 0U;
+
+    if (i2c->dma_tx != NULL) {
+      if (HAL_DMA_Start_IT (i2c->dma_tx->h, (uint32_t)tr->data, (uint32_t)&(i2c->reg->TXDR), tr->num) != HAL_OK) {
+        /* Send data in interrupt mode */
+        i2c->reg->CR1 |= I2C_CR1_TXIE;
+      }
+    }
+  }
+
+  return event;
+}
+
+
 /**
   \fn          void I2C_EV_IRQHandler (I2C_RESOURCES *i2c)
   \brief       I2C Event Interrupt handler.
@@ -1399,23 +1937,94 @@ static void I2C_EV_IRQHandler (I2C_RESOURCES *i2c) {
   icr   = 0U;
   isr   = i2c->reg->ISR;
 
-  if (isr & I2C_ISR_RXNE) {
+  if (((isr & I2C_ISR_RXNE) != 0U) && ((tr->ctrl & XFER_CTRL_REG_MAP) != 0U)) {
+    /* Register map write */
+    if ((tr->ctrl & XFER_CTRL_REG_PTR) != 0U) {
+      /* Register pointer received */
+      tr->ctrl &= ~XFER_CTRL_REG_PTR;
+
+      i2c->info->reg_ptr = i2c->reg->RXDR % i2c->info->regmap->size;
+
+      tr->data     = &i2c->info->regmap->mem[i2c->info->reg_ptr];
+      tr->num      = i2c->info->regmap->size - i2c->info->reg_ptr;
+      tr->mem_num  = tr->num;
+
+      if (i2c->dma_rx != NULL) {
+        if (HAL_DMA_Start_IT (i2c->dma_rx->h, (uint32_t)&(i2c->reg->RXDR), (uint32_t)tr->data, tr->num) == HAL_OK) {
+          i2c->reg->CR1 &= ~I2C_CR1_RXIE;
+        }
+      }
+    }
+    else if ((i2c->dma_rx == NULL) || ((i2c->reg->CR1 & I2C_CR1_RXIE) != 0U)) {
+      if (tr->cnt < (int32_t)tr->num) {
+        tr->data[tr->cnt++] = i2c->reg->RXDR;
+      }
+      else {
+        /* Beyond register map end */
+        (void)i2c->reg->RXDR;
+      }
+    }
+    else if (__HAL_DMA_GET_COUNTER(i2c->dma_rx->h) == 0U) {
+      /* Beyond register map end */
+      (void)i2c->reg->RXDR;
+    }
+  }
+  else if (isr & I2C_ISR_RXNE) {
     /* Receive data register not empty */
     tr->data[tr->cnt++] = i2c->reg->RXDR;
   }
+  else if (((isr & I2C_ISR_TXIS) != 0U) && ((tr->ctrl & XFER_CTRL_REG_MAP) != 0U)) {
+    /* Register map read */
+    if ((i2c->dma_tx == NULL) || ((i2c->reg->CR1 & I2C_CR1_TXIE) != 0U)) {
+      if (tr->cnt < (int32_t)tr->num) {
+        i2c->reg->TXDR = tr->data[tr->cnt];
+      }
+      else {
+        /* Beyond register map end */
+        i2c->reg->TXDR = 0xFFU;
+      }
+      tr->cnt++;
+    }
+  }
   else if (isr & I2C_ISR_TXIS) {
     /* Transmit data register empty */
     i2c->reg->TXDR = tr->data[tr->cnt++];
   }
+  else if (((isr & I2C_ISR_TC) != 0U) && ((tr->ctrl & XFER_CTRL_MEM_RD) != 0U)) {
+    /* Memory address sent, read data after repeated start */
+    if (i2c->dma_tx != NULL) {
+      i2c->reg->CR1 &= ~I2C_CR1_TXIE;
+    }
+
+    cr = i2c->reg->CR2;
+
+    if ((cr & I2C_CR2_ADD10) != 0U) {
+      cnt = (cr & 0x3FFU) | ARM_I2C_ADDRESS_10BIT;
+    }
+    else {
+      cnt = (cr >> 1) & 0x7FU;
+    }
+
+    if (I2C_MasterStart (cnt, tr->mem_data, tr->mem_num, true, false, i2c) != ARM_DRIVER_OK) {
+      /* Data phase not started, report incomplete transfer on stop */
+      i2c->reg->CR2 |= I2C_CR2_STOP;
+    }
+  }
   else if ((isr & I2C_ISR_TC) != 0U) {
     /* Transfer Complete */
     st->busy  = 0U;
 
     if ((tr->ctrl & XFER_CTRL_RESTART) != 0U) {
-      /* Wait for pending transfer */
-      i2c->reg->CR1 &= ~I2C_CR1_TCIE;
+      if (i2c->info->list != NULL) {
+        /* Continue transfer list with repeated start */
+        event = I2C_ListNext (0U, i2c);
+      }
+      else {
+        /* Wait for pending transfer */
+        i2c->reg->CR1 &= ~I2C_CR1_TCIE;
 
-      event = ARM_I2C_EVENT_TRANSFER_DONE;
+        event = ARM_I2C_EVENT_TRANSFER_DONE;
+      }
     }
     else {
       /* Send stop */
@@ -1423,7 +2032,13 @@ static void I2C_EV_IRQHandler (I2C_RESOURCES *i2c) {
     }
   }
   else if (isr & (I2C_ISR_STOPF | I2C_ISR_NACKF | I2C_ISR_ADDR)) {
-    if (isr & I2C_ISR_STOPF) {
+    if (((isr & I2C_ISR_STOPF) != 0U) && ((tr->ctrl & XFER_CTRL_REG_MAP) != 0U)) {
+      /* Register map access completed */
+      icr |= I2C_ICR_STOPCF;
+
+      event = I2C_RegMapEnd (i2c);
+    }
+    else if (isr & I2C_ISR_STOPF) {
       /* Stop detection flag */
       icr |= I2C_ICR_STOPCF;
 
@@ -1442,11 +2057,30 @@ static void I2C_EV_IRQHandler (I2C_RESOURCES *i2c) {
         }
       }
 
+      if ((i2c->dma_tx != NULL) && ((tr->ctrl & (XFER_CTRL_MEM_WR | XFER_CTRL_MEM_RD)) != 0U)) {
+        /* Stopped in memory address phase */
+        i2c->reg->CR1 &= ~I2C_CR1_TXIE;
+      }
+
       tr->data = NULL;
       tr->ctrl = 0U;
 
       st->busy = 0U;
-      st->mode = 0U;
+
+      if ((i2c->info->list != NULL) && (st->mode != 0U)) {
+        /* Transfer list step completed */
+        st->mode = 0U;
+        event = I2C_ListNext ((event == ARM_I2C_EVENT_TRANSFER_DONE) ? 0U : event, i2c);
+      }
+      else {
+        st->mode = 0U;
+      }
+    }
+    else if (((isr & I2C_ISR_ADDR) != 0U) && (i2c->info->regmap != NULL) && ((isr & I2C_ISR_ADDCODE) != 0U)) {
+      /* Address matched, register map mode */
+      icr |= I2C_ICR_ADDRCF;
+
+      event = I2C_RegMapStart (isr, i2c);
     }
     else if (isr & I2C_ISR_ADDR) {
       /* Address matched (slave mode) */
@@ -1502,7 +2136,52 @@ static void I2C_EV_IRQHandler (I2C_RESOURCES *i2c) {
     }
   }
   else {
-    if ((isr & I2C_ISR_TCR) != 0) {
+    if (((isr & I2C_ISR_TCR) != 0) && ((tr->ctrl & XFER_CTRL_MEM_WR) != 0U)) {
+      /* Memory address sent, continue with data in the same transfer */
+      tr->ctrl &= ~XFER_CTRL_MEM_WR;
+
+      tr->data = tr->mem_data;
+      tr->num  = tr->mem_num;
+      tr->cnt  = 0;
+
+      cr = i2c->reg->CR2 & ~(I2C_CR2_RELOAD | I2C_CR2_NBYTES);
+
+      if (tr->num < 256) {
+        cnt = tr->num;
+        cr |= I2C_CR2_AUTOEND;
+      }
+      else {
+        cnt = 255;
+        cr |= I2C_CR2_RELOAD;
+      }
+
+      if (i2c->dma_tx != NULL) {
+        /* Data phase uses DMA, TXIS interrupt remains enabled on failure */
+        if (HAL_DMA_Start_IT (i2c->dma_tx->h, (uint32_t)tr->data, (uint32_t)&(i2c->reg->TXDR), tr->num) == HAL_OK) {
+          i2c->reg->CR1 &= ~I2C_CR1_TXIE;
+        }
+      }
+
+      i2c->reg->CR2 = (cnt << 16) | cr;
+    }
+    else if (((isr & I2C_ISR_TCR) != 0) && ((tr->ctrl & XFER_CTRL_REG_MAP) != 0U)) {
+      /* Register map write: acknowledge up to the register map end */
+      cr = i2c->reg->CR2 & ~I2C_CR2_NBYTES;
+
+      if (tr->mem_num != 0U) {
+        cnt = (tr->mem_num < 256U) ? tr->mem_num : 255U;
+
+        tr->mem_num -= cnt;
+      }
+      else {
+        /* Register map end reached, NACK next byte */
+        cnt = 1U;
+        cr |= I2C_CR2_NACK;
+      }
+
+      i2c->reg->CR2 = (cnt << 16) | cr;
+    }
+    else if ((isr & I2C_ISR_TCR) != 0) {
       /* Transfer Complete Reload */
       cr = i2c->reg->CR2;
 
@@ -1551,6 +2230,11 @@ static void I2C_ER_IRQHandler (I2C_RESOURCES *i2c) {
     /* Arbitration lost */
     icr |= I2C_ICR_ARLOCF;
 
+    if ((i2c->dma_tx != NULL) && ((tr->ctrl & (XFER_CTRL_MEM_WR | XFER_CTRL_MEM_RD)) != 0U)) {
+      /* Lost in memory address phase */
+      i2c->reg->CR1 &= ~I2C_CR1_TXIE;
+    }
+
     /* Switch to slave mode */
     st->busy             = 0U;
     st->mode             = 0U;
@@ -1560,6 +2244,11 @@ static void I2C_ER_IRQHandler (I2C_RESOURCES *i2c) {
     tr->ctrl = 0U;
 
     event = ARM_I2C_EVENT_TRANSFER_DONE | ARM_I2C_EVENT_ARBITRATION_LOST;
+
+    if (i2c->info->list != NULL) {
+      /* Transfer list aborted */
+      event = I2C_ListNext (event, i2c);
+    }
   }
   else {
     if (isr & I2C_ISR_BERR) {
@@ -1577,6 +2266,19 @@ static void I2C_ER_IRQHandler (I2C_RESOURCES *i2c) {
       }
 
       event = ARM_I2C_EVENT_TRANSFER_DONE | ARM_I2C_EVENT_BUS_ERROR;
+
+      if ((i2c->info->list != NULL) && (st->mode != 0U)) {
+        /* Transfer list aborted, bus is released with stop condition */
+        i2c->reg->CR2 |= I2C_CR2_STOP;
+
+        st->busy = 0U;
+        st->mode = 0U;
+
+        tr->data = NULL;
+        tr->ctrl = 0U;
+
+        event = I2C_ListNext (event, i2c);
+      }
     }
   }
   /* Clear interrupt flags */
@@ -1601,6 +2303,11 @@ static void I2C_DMA_TxEvent (uint32_t event, I2C_RESOURCES *i2c) {
 
   if (event == DMA_COMPLETED) {
     i2c->info->xfer.cnt = i2c->info->xfer.num - __HAL_DMA_GET_COUNTER(i2c->dma_tx->h);
+
+    if ((i2c->info->xfer.ctrl & XFER_CTRL_REG_MAP) != 0U) {
+      /* Reads beyond register map end are served in TXIS interrupt */
+      i2c->reg->CR1 |= I2C_CR1_TXIE;
+    }
   }
 }
 #endif
@@ -233,6 +233,68 @@
 
 #endif /* RTE_DEVICE_FRAMEWORK_CUBE_MX */
 
+/* Driver specific control codes */
+#define ARM_I2C_TRANSFER_LIST       (0x20U)   // Queue master transfer list; arg = pointer to I2C_TRANSFER_LIST
+#define ARM_I2C_MEM_WRITE           (0x21U)   // Write device memory; arg = pointer to I2C_MEM_TRANSFER
+#define ARM_I2C_MEM_READ            (0x22U)   // Read device memory;  arg = pointer to I2C_MEM_TRANSFER
+#define ARM_I2C_BUS_TIMING          (0x23U)   // Set bus timing parameters; arg = pointer to I2C_BUS_TIMING
+#define ARM_I2C_SLAVE_REG_MAP       (0x24U)   // Slave register map mode; arg = pointer to I2C_SLAVE_REG_MAP (NULL = disable)
+
+/* Driver specific events */
+#define ARM_I2C_EVENT_REG_WRITE     (1UL << 16) // Master write to slave register map completed
+
+/* Transfer list step flags */
+#define I2C_STEP_READ               (1U << 0) // Read from slave (default: write to slave)
+#define I2C_STEP_NO_STOP            (1U << 1) // No stop condition, next step starts with repeated start
+
+/* Transfer list step */
+typedef struct _I2C_TRANSFER_STEP {
+  uint32_t              addr;                 // Slave address (7-bit or 10-bit)
+  uint8_t              *data;                 // Pointer to data buffer
+  uint32_t              num;                  // Number of data bytes
+  uint32_t              flags;                // Step flags (I2C_STEP_xxx)
+} I2C_TRANSFER_STEP;
+
+/* Transfer list */
+typedef struct _I2C_TRANSFER_LIST {
+  I2C_TRANSFER_STEP         *step;            // Pointer to array of transfer steps
+  uint32_t                   num;             // Number of transfer steps
+  volatile uint32_t          done;            // Number of completed steps (updated by driver)
+  volatile uint32_t          event;           // Completion event, 0 while pending (updated by driver)
+  struct _I2C_TRANSFER_LIST *next;            // Next queued list (used by driver)
+} I2C_TRANSFER_LIST;
+
+/* Device memory transfer (register address phase followed by data phase) */
+typedef struct _I2C_MEM_TRANSFER {
+  uint32_t              addr;                 // Slave address (7-bit or 10-bit)
+  uint32_t              mem_addr;             // Memory (register) address, sent MSB first
+  uint32_t              mem_addr_size;        // Memory address size in bytes (1 or 2)
+  uint8_t              *data;                 // Pointer to data buffer
+  uint32_t              num;                  // Number of data bytes
+} I2C_MEM_TRANSFER;
+
+/* Bus timing parameters */
+typedef struct _I2C_BUS_TIMING {
+  uint32_t              bus_speed;            // SCL frequency in Hz (0 = keep current), up to 1MHz
+  uint16_t              rise_time;            // SCL/SDA rise time in ns
+  uint16_t              fall_time;            // SCL/SDA fall time in ns
+  uint8_t               dnf;                  // Digital noise filter length in I2C clock periods (0..15, 0 = off)
+  uint8_t               anf;                  // Analog noise filter (0 = off, 1 = on)
+  uint16_t              reserved;
+} I2C_BUS_TIMING;
+
+/* Default bus timing parameters */
+#define I2C_RISE_TIME_DEFAULT       100U      // Rise time in ns
+#define I2C_FALL_TIME_DEFAULT       10U       // Fall time in ns
+
+/* Slave register map */
+typedef struct _I2C_SLAVE_REG_MAP {
+  uint8_t              *mem;                  // Register map memory
+  uint32_t              size;                 // Register map size in bytes (1..256)
+  volatile uint32_t     wr_addr;              // Start address of last completed write (updated by driver)
+  volatile uint32_t     wr_num;               // Number of bytes of last completed write (updated by driver)
+} I2C_SLAVE_REG_MAP;
+
 /* Bus Clear clock period definition */
 #define I2C_BUS_CLEAR_CLOCK_PERIOD   2        // I2C bus clock period in ms
 
@@ -246,6 +308,10 @@
 #define XFER_CTRL_STOP      ((uint8_t)0x02)   // Generate repeated start and readdress
 #define XFER_CTRL_ADDR_NACK ((uint8_t)0x04)   // Slave address not acknowledged
 #define XFER_CTRL_ADDR_DONE ((uint8_t)0x08)   // Addressing done
+#define XFER_CTRL_MEM_WR    ((uint8_t)0x10)   // Memory address phase of memory write
+#define XFER_CTRL_MEM_RD    ((uint8_t)0x20)   // Memory address phase of memory read
+#define XFER_CTRL_REG_MAP   ((uint8_t)0x40)   // Slave register map access
+#define XFER_CTRL_REG_PTR   ((uint8_t)0x80)   // Slave register map pointer expected
 
 /* DMA Event definitions */
 #define DMA_COMPLETED             0U
@@ -287,6 +353,9 @@ typedef struct _I2C_TRANSFER_INFO {
   int32_t               cnt;                  // Data transfer counter
   uint8_t              *data;                 // Data pointer
   uint8_t               ctrl;                 // Transfer control flags
+  uint8_t               mem_addr[2];          // Memory address bytes
+  uint8_t              *mem_data;             // Memory transfer data pointer
+  uint32_t              mem_num;              // Memory transfer number of data
 } I2C_TRANSFER_INFO;
 
 
@@ -295,6 +364,10 @@ typedef struct _I2C_INFO {
   ARM_I2C_SignalEvent_t cb_event;             // Event Callback
   ARM_I2C_STATUS        status;               // Status flags
   I2C_TRANSFER_INFO     xfer;                 // Transfer information
+  I2C_TRANSFER_LIST    *list;                 // Active transfer list (head of queue)
+  I2C_BUS_TIMING        timing;               // Bus timing parameters
+  I2C_SLAVE_REG_MAP    *regmap;               // Slave register map
+  uint32_t              reg_ptr;              // Slave register map pointer
   uint8_t               flags;                // Current I2C state flags
 } I2C_INFO;
 
@@ -18,8 +18,8 @@
  * 3. This notice may not be removed or altered from any source distribution.
  *
  *
- * $Date:        08. November 2016
- * $Revision:    V1.4
+ * $Date:        19. October 2026
+ * $Revision:    V1.9
  *
  * Driver:       Driver_MCI0, Driver_MCI1
  * Configured:   via RTE_Device.h configuration file
@@ -32,9 +32,33 @@
  *   ---------------------                 -----   ---------------
  *   Connect to hardware via Driver_MCI# = 0       use SDMMC1
  *   Connect to hardware via Driver_MCI# = 1       use SDMMC2
+ * --------------------------------------------------------------------------
+ * Defines used for driver configuration (at compile time):
+ *
+ *   MCI_MANAGE_CACHE:  specifies if MCI data is in cacheable area
+ *                      (0 = data in non-cacheable area,
+ *                       1 = data in cacheable area)
+ *     - default value : 1 = data in cacheable area
+ *   MCI_BOUNCE_SIZE:   size in bytes of the per instance bounce buffer used
+ *                      for reads into buffers not aligned to the cache line
+ *     - default value : 512
+ *     - must be a multiple of 32 and not larger than 65504
  * -------------------------------------------------------------------------- */
 
 /* History:
+ *  Version 1.9
+ *    Added write-back block cache (ARM_MCI_CACHE_xxx) and ACMD23 pre-erase of queued writes
+ *    Unaligned reads larger than MCI_BOUNCE_SIZE are rejected when D-Cache is enabled
+ *  Version 1.8
+ *    Added SD high speed switch with read verification (ARM_MCI_HIGH_SPEED_SWITCH)
+ *  Version 1.7
+ *    Added request queue engine (ARM_MCI_QUEUE_REQUEST) with CMD23 block count
+ *  Version 1.6
+ *    Added D-Cache maintenance of data buffers (MCI_MANAGE_CACHE)
+ *  Version 1.5
+ *    Transfers above 64 KB stream continuously using DMA double buffer mode
+ *    (full size chunks, final chunk runs with SDMMC flow control,
+ *    each transfer starts on memory 0)
  *  Version 1.4
  *    Added Driver_MCI1 instance (SDMMC2)
  *  Version 1.3
@@ -60,6 +84,54 @@ The CMSIS-Driver MCI requires:
 
 \note The User Label name is used to connect the CMSIS-Driver to the GPIO pin.
 
+\note Data buffers may be placed in cacheable memory, D-Cache is maintained by the
+driver (MCI_MANAGE_CACHE). Read buffers should be aligned to 32 bytes, unaligned reads
+up to MCI_BOUNCE_SIZE bytes are received through a bounce buffer. Larger unaligned reads
+(buffer address or length not a multiple of 32) are rejected with ARM_DRIVER_ERROR_UNSUPPORTED
+when D-Cache is enabled.
+
+Request queue
+-------------
+Block transfers can be queued with Control (ARM_MCI_QUEUE_REQUEST, (uint32_t)&req), where
+\b req is an MCI_REQUEST (see MCI_STM32F7xx.h) that stays valid until its \b cb_done callback.
+Each request runs from the SDMMC interrupt without thread involvement:
+  - SET_BLOCK_COUNT (CMD23) when \b sbc is set and more than one block is transferred
+  - data command, DMA transfer and, for open-ended or failed multiple block transfers, CMD12
+  - SEND_STATUS (CMD13) polling until the card returns to transfer state after writes
+
+While requests are queued, SendCommand and SetupTransfer return ARM_DRIVER_ERROR_BUSY.
+AbortTransfer discards all queued requests.
+
+High speed switch
+-----------------
+After card initialization (transfer state, bus width set), Control (ARM_MCI_HIGH_SPEED_SWITCH,
+(uint32_t)&hs) with an MCI_HS_SWITCH performs:
+  - CMD6 check function to verify the card supports high speed
+  - reference read of block \b test_addr at current bus speed
+  - CMD6 switch to high speed and SDMMC clock divider bypass (SDMMCCLK)
+  - read of the same block at the new speed, compared with the reference
+
+On success the new bus speed in bps is returned. If the verification fails, the previous
+clock setting is restored and ARM_DRIVER_ERROR is returned. The work buffer \b buf must hold
+1024 bytes. NEGEDGE (dephasing) mode is not used, see device errata.
+
+Block cache
+-----------
+Control (ARM_MCI_CACHE_SETUP, (uint32_t)&cfg) places a set associative write-back sector
+cache in the memory described by MCI_CACHE_CONFIG (typically external SDRAM). The memory
+holds \b stage staging sectors, the cache lines and 12 bytes of descriptor per line.
+Read-ahead is limited to the card capacity (\b sectors), transfers beyond it are rejected.
+  - ARM_MCI_CACHE_READ: hits are served from the cache, misses spanning several sectors or
+    continuing the previous read are read with CMD18 (at least \b read_ahead sectors)
+  - ARM_MCI_CACHE_WRITE: sectors are written into the cache and marked dirty
+  - ARM_MCI_CACHE_FLUSH: all dirty sectors are written back
+
+A dirty line is written back when evicted, together with all other dirty sectors of the
+same erase block (\b erase_size sectors). Consecutive dirty sectors are written with one
+CMD25 preceded by ACMD23 (pre-erase) and CMD23 when MCI_CACHE_CMD23 is set. The cache
+functions wait for completion and must not be called from interrupt context. Flush the
+cache before power off, ARM_POWER_OFF discards the cache content.
+
 The example below uses correct settings for STM32F746G-Discovery:  
   - SDMMC1 Mode:             SD 4bits Wide bus 
   - Card Detect Input pin:   PC13
@@ -132,7 +204,23 @@ Configuration tab
 
 #include "MCI_STM32F7xx.h"
 
-#define ARM_MCI_DRV_VERSION ARM_DRIVER_VERSION_MAJOR_MINOR(1,4)  /* driver version */
+#define ARM_MCI_DRV_VERSION ARM_DRIVER_VERSION_MAJOR_MINOR(1,9)  /* driver version */
+
+/* Define D-Cache maintenance of data buffers */
+#ifndef MCI_MANAGE_CACHE
+  #define MCI_MANAGE_CACHE    1U
+#endif
+
+/* Define bounce buffer size for unaligned reads */
+#ifndef MCI_BOUNCE_SIZE
+  #define MCI_BOUNCE_SIZE     512U
+#endif
+
+#if ((MCI_MANAGE_CACHE == 1U) && (__DCACHE_PRESENT == 1U))
+  #if ((MCI_BOUNCE_SIZE == 0U) || ((MCI_BOUNCE_SIZE & 0x1FU) != 0U) || (MCI_BOUNCE_SIZE > 65504U))
+    #error "MCI_BOUNCE_SIZE must be a non-zero multiple of 32 not larger than 65504!"
+  #endif
+#endif
 
 /* MCI0: Define Card Detect pin active state */
 #if !defined(MemoryCard_CD0_Pin_Active)
@@ -169,6 +257,12 @@ Configuration tab
 #endif
 
 
+/* Memory target parked by DMA double buffer transfers after their last */
+/* chunk. SDMMC FIFO (32 words) and DMA FIFO (4 words) limit the data    */
+/* moved from or to it before the stream is stopped.                    */
+static uint32_t MCI_DMA_Dummy[MCI_DMA_DUMMY_SIZE / 4U] __ALIGNED(32U);
+
+
 #if defined(MX_SDMMC1)
 #if defined(RTE_DEVICE_FRAMEWORK_CLASSIC)
 static DMA_HandleTypeDef hdma_sdmmc1_rx = { 0U };
@@ -182,6 +276,10 @@ extern SD_HandleTypeDef  hsd1;
 /* DMA receive complete callback prototype */
 void MCI0_RX_DMA_Complete(DMA_HandleTypeDef *hdma);
 
+/* DMA double buffer callback prototypes */
+void MCI0_DMA_Chunk(DMA_HandleTypeDef *hdma);
+void MCI0_DMA_Error(DMA_HandleTypeDef *hdma);
+
 /* IRQ handler prototype */
 void SDMMC1_IRQHandler (void);
 
@@ -222,6 +320,8 @@ static MCI_IO MCI0_IO[] = {
 static const MCI_DMA MCI0_RX_DMA = {
   &hdma_sdmmc1_rx,
   &MCI0_RX_DMA_Complete,
+  &MCI0_DMA_Chunk,
+  &MCI0_DMA_Error,
   #if defined(RTE_DEVICE_FRAMEWORK_CLASSIC)
   MX_SDMMC1_RX_DMA_Instance,
   MX_SDMMC1_RX_DMA_IRQn,
@@ -234,6 +334,8 @@ static const MCI_DMA MCI0_RX_DMA = {
 static const MCI_DMA MCI0_TX_DMA = {
   &hdma_sdmmc1_tx,
   NULL,
+  &MCI0_DMA_Chunk,
+  &MCI0_DMA_Error,
   #if defined(RTE_DEVICE_FRAMEWORK_CLASSIC)
   MX_SDMMC1_TX_DMA_Instance,
   MX_SDMMC1_TX_DMA_IRQn,
@@ -245,6 +347,11 @@ static const MCI_DMA MCI0_TX_DMA = {
 /* MCI0 Information (Run-Time) */
 static MCI_INFO MCI0_Info;
 
+#if ((MCI_MANAGE_CACHE == 1U) && (__DCACHE_PRESENT == 1U))
+/* MCI0 Bounce buffer */
+static uint32_t MCI0_Bounce[MCI_BOUNCE_SIZE / 4U] __ALIGNED(32U);
+#endif
+
 /* MCI0 Resources */
 static MCI_RESOURCES MCI0_Resources = {
 #if defined(RTE_DEVICE_FRAMEWORK_CUBE_MX)
@@ -271,6 +378,11 @@ static MCI_RESOURCES MCI0_Resources = {
   #else
   NULL,
   #endif
+  #if ((MCI_MANAGE_CACHE == 1U) && (__DCACHE_PRESENT == 1U))
+  MCI0_Bounce,
+  #else
+  NULL,
+  #endif
   &MCI0_Info
 };
 
@@ -322,6 +434,10 @@ extern SD_HandleTypeDef  hsd2;
 /* DMA receive complete callback prototype */
 void MCI1_RX_DMA_Complete(DMA_HandleTypeDef *hdma);
 
+/* DMA double buffer callback prototypes */
+void MCI1_DMA_Chunk(DMA_HandleTypeDef *hdma);
+void MCI1_DMA_Error(DMA_HandleTypeDef *hdma);
+
 /* IRQ handler prototype */
 void SDMMC2_IRQHandler (void);
 
@@ -362,6 +478,8 @@ static MCI_IO MCI1_IO[] = {
 static const MCI_DMA MCI1_RX_DMA = {
   &hdma_sdmmc2_rx,
   &MCI1_RX_DMA_Complete,
+  &MCI1_DMA_Chunk,
+  &MCI1_DMA_Error,
   #if defined(RTE_DEVICE_FRAMEWORK_CLASSIC)
   MX_SDMMC2_RX_DMA_Instance,
   MX_SDMMC2_RX_DMA_IRQn,
@@ -374,6 +492,8 @@ static const MCI_DMA MCI1_RX_DMA = {
 static const MCI_DMA MCI1_TX_DMA = {
   &hdma_sdmmc2_tx,
   NULL,
+  &MCI1_DMA_Chunk,
+  &MCI1_DMA_Error,
   #if defined(RTE_DEVICE_FRAMEWORK_CLASSIC)
   MX_SDMMC2_TX_DMA_Instance,
   MX_SDMMC2_TX_DMA_IRQn,
@@ -385,6 +505,11 @@ static const MCI_DMA MCI1_TX_DMA = {
 /* MCI1 Information (Run-Time) */
 static MCI_INFO MCI1_Info;
 
+#if ((MCI_MANAGE_CACHE == 1U) && (__DCACHE_PRESENT == 1U))
+/* MCI1 Bounce buffer */
+static uint32_t MCI1_Bounce[MCI_BOUNCE_SIZE / 4U] __ALIGNED(32U);
+#endif
+
 /* MCI1 Resources */
 static MCI_RESOURCES MCI1_Resources = {
 #if defined(RTE_DEVICE_FRAMEWORK_CUBE_MX)
@@ -411,6 +536,11 @@ static MCI_RESOURCES MCI1_Resources = {
   #else
   NULL,
   #endif
+  #if ((MCI_MANAGE_CACHE == 1U) && (__DCACHE_PRESENT == 1U))
+  MCI1_Bounce,
+  #else
+  NULL,
+  #endif
   &MCI1_Info
 };
 
@@ -773,6 +903,9 @@ static int32_t PowerControl (ARM_POWER_STATE state, MCI_RESOURCES *mci) {
       mci->info->status.sdio_interrupt   = 0U;
       mci->info->status.ccs              = 0U;
 
+      /* Drop block cache (must be flushed before power off) */
+      memset (&mci->info->cache, 0, sizeof (MCI_CACHE_INFO));
+
       mci->info->flags &= ~MCI_POWER;
       break;
 
@@ -916,7 +1049,7 @@ static int32_t SendCommand (uint32_t cmd, uint32_t arg, uint32_t flags, uint32_t
   if ((mci->info->flags & MCI_SETUP) == 0U) {
     return ARM_DRIVER_ERROR;
   }
-  if (mci->info->status.command_active) {
+  if (mci->info->status.command_active || (mci->info->flags & MCI_QUEUE)) {
     return ARM_DRIVER_ERROR_BUSY;
   }
   mci->info->status.command_active   = 1U;
@@ -985,39 +1118,56 @@ static int32_t SendCommand (uint32_t cmd, uint32_t arg, uint32_t flags, uint32_t
 
 
 /**
-  \fn            int32_t SetupTransfer (uint8_t *data,
-                                        uint32_t block_count,
-                                        uint32_t block_size,
-                                        uint32_t mode)
-  \brief         Setup read or write transfer operation.
+  \fn            int32_t DataSetup (uint8_t *data,
+                                    uint32_t block_count,
+                                    uint32_t block_size,
+                                    uint32_t mode)
+  \brief         Prepare DMA and data path for read or write transfer.
   \param[in,out] data         Pointer to data block(s) to be written or read
   \param[in]     block_count  Number of blocks
   \param[in]     block_size   Size of a block in bytes
   \param[in]     mode         Transfer mode
   \return        \ref execution_status
 */
-static int32_t SetupTransfer (uint8_t *data, uint32_t block_count, uint32_t block_size, uint32_t mode, MCI_RESOURCES *mci) {
-  uint32_t sz, cnt, dctrl;
+static int32_t DataSetup (uint8_t *data, uint32_t block_count, uint32_t block_size, uint32_t mode, MCI_RESOURCES *mci) {
+  MCI_DMA *dma;
+  uint32_t sz, cnt, len, mem1, dctrl;
 
-  if ((data == NULL) || (block_count == 0U) || (block_size == 0U)) { return ARM_DRIVER_ERROR_PARAMETER; }
+  cnt = block_count * block_size;
 
-  if ((mci->info->flags & MCI_SETUP) == 0U) {
-    return ARM_DRIVER_ERROR;
+  if ((cnt > SDMMC_DLEN_DATALENGTH) || (cnt / block_count != block_size)) {
+    return ARM_DRIVER_ERROR_UNSUPPORTED;
   }
-  if (mci->info->status.transfer_active) {
-    return ARM_DRIVER_ERROR_BUSY;
+
+#if ((MCI_MANAGE_CACHE == 1U) && (__DCACHE_PRESENT == 1U))
+  if (((SCB->CCR & SCB_CCR_DC_Msk) != 0U) && ((mode & ARM_MCI_TRANSFER_WRITE) == 0) &&
+      ((((uint32_t)data | cnt) & 0x1FU) != 0U) && (cnt > MCI_BOUNCE_SIZE)) {
+    /* Unaligned read larger than bounce buffer: cache lines shared with */
+    /* adjacent data can not be maintained while DMA writes to them      */
+    return ARM_DRIVER_ERROR_UNSUPPORTED;
   }
+#endif
 
-  mci->info->xfer.buf = data;
-  mci->info->xfer.cnt = block_count * block_size;
+  mci->info->xfer.buf   = data;
+  mci->info->xfer.cnt   = 0U;
+  mci->info->xfer.chunk = cnt;
+  mci->info->xfer.num   = 1U;
 
-  cnt = mci->info->xfer.cnt;
-  if (cnt > 0xFFFFU) {
-    cnt = 0xFFFFU;
-  }
+  mci->info->xfer.tail  = cnt;
+
+  if (cnt > MCI_DMA_RUN_MAX) {
+    /* Split transfer into full size chunks of whole blocks, the final */
+    /* chunk (tail) holds the remaining blocks                         */
+    if (((block_size & 0xFU) != 0U) || (block_size > 16384U)) {
+      /* Chunk must be a multiple of DMA burst size */
+      return ARM_DRIVER_ERROR_UNSUPPORTED;
+    }
+    len = (MCI_DMA_RUN_MAX / block_size) * block_size;
 
-  mci->info->xfer.cnt -= cnt;
-  mci->info->xfer.buf += cnt;
+    mci->info->xfer.chunk = len;
+    mci->info->xfer.num   = (cnt + len - 1U) / len;
+    mci->info->xfer.tail  = cnt - ((mci->info->xfer.num - 1U) * len);
+  }
 
   dctrl = 0U;
 
@@ -1025,9 +1175,11 @@ static int32_t SetupTransfer (uint8_t *data, uint32_t block_count, uint32_t bloc
     /* Direction: From card to controller */
     mci->info->flags |= MCI_DATA_READ;
     dctrl |= SDMMC_DCTRL_DTDIR;
+    dma    = mci->dma_rx;
   }
   else {
     mci->info->flags &= ~MCI_DATA_READ;
+    dma    = mci->dma_tx;
   }
 
   if (mode & ARM_MCI_TRANSFER_STREAM) {
@@ -1050,16 +1202,84 @@ static int32_t SetupTransfer (uint8_t *data, uint32_t block_count, uint32_t bloc
     }
   }
 
-  if (mode & ARM_MCI_TRANSFER_WRITE) {
-    /* Enable TX DMA stream */
-    if (HAL_DMA_Start_IT (mci->dma_tx->h, (uint32_t)data, (uint32_t)&(mci->reg->FIFO), cnt) != HAL_OK) {
-      return ARM_DRIVER_ERROR;
+  mci->info->xfer.data = data;
+  mci->info->xfer.len  = cnt;
+  mci->info->xfer.user = NULL;
+
+#if ((MCI_MANAGE_CACHE == 1U) && (__DCACHE_PRESENT == 1U))
+  if ((SCB->CCR & SCB_CCR_DC_Msk) != 0U) {      /* If Data Cache is enabled */
+    if (mode & ARM_MCI_TRANSFER_WRITE) {
+      /* Write cached data to memory before DMA reads it */
+      SCB_CleanDCache_by_Addr ((uint32_t *)((uint32_t)data & (~0x1FU)), (int32_t)(cnt + 31U));
+    }
+    else if ((((uint32_t)data | cnt) & 0x1FU) == 0U) {
+      /* Buffer owns whole cache lines, discard them */
+      SCB_InvalidateDCache_by_Addr ((uint32_t *)data, (int32_t)cnt);
+    }
+    else {
+      /* Receive into bounce buffer, copied to caller buffer on completion */
+      mci->info->xfer.user = data;
+      mci->info->xfer.data = (uint8_t *)mci->bounce;
+
+      data = (uint8_t *)mci->bounce;
+      SCB_InvalidateDCache_by_Addr (mci->bounce, (int32_t)cnt);
+    }
+  }
+#endif
+
+  if (cnt <= MCI_DMA_RUN_MAX) {
+    /* Single DMA run, SDMMC is the flow controller */
+    dma->h->XferCpltCallback   = dma->cb_complete;
+    dma->h->XferErrorCallback  = NULL;
+    dma->h->Instance->CR      |= DMA_SxCR_PFCTRL;
+
+    if (mode & ARM_MCI_TRANSFER_WRITE) {
+      /* Enable TX DMA stream */
+      if (HAL_DMA_Start_IT (dma->h, (uint32_t)data, (uint32_t)&(mci->reg->FIFO), cnt) != HAL_OK) {
+        return ARM_DRIVER_ERROR;
+      }
+    }
+    else {
+      /* Enable RX DMA stream */
+      if (HAL_DMA_Start_IT (dma->h, (uint32_t)&(mci->reg->FIFO), (uint32_t)data, cnt) != HAL_OK) {
+        return ARM_DRIVER_ERROR;
+      }
     }
   }
   else {
-    /* Enable RX DMA stream */
-    if (HAL_DMA_Start_IT (mci->dma_rx->h, (uint32_t)&(mci->reg->FIFO), (uint32_t)data, cnt) != HAL_OK) {
-      return ARM_DRIVER_ERROR;
+    /* Double buffer mode, DMA is the flow controller.               */
+    /* Both memory targets are armed up front and each one is moved  */
+    /* two chunks ahead as soon as it completes, so data flows       */
+    /* without gaps for the whole transfer. A shorter final chunk is */
+    /* handed over to SDMMC flow control (see DMA_Chunk). CT still   */
+    /* holds the target a previous run ended on and HAL does not     */
+    /* clear it: start on memory 0.                                  */
+    dma->h->XferCpltCallback   = dma->cb_chunk;
+    dma->h->XferM1CpltCallback = dma->cb_chunk;
+    dma->h->XferErrorCallback  = dma->cb_error;
+    dma->h->Instance->CR      &= ~(DMA_SxCR_PFCTRL | DMA_SxCR_CT);
+
+    len = mci->info->xfer.chunk;
+
+    /* Memory 1 holds the second chunk, which may be the tail */
+    mem1 = (uint32_t)(data + len);
+
+    if (mci->info->xfer.num > 2U) {
+      mci->info->xfer.buf = data + (2U * len);
+      mci->info->xfer.cnt = cnt  - (2U * len);
+    }
+
+    if (mode & ARM_MCI_TRANSFER_WRITE) {
+      /* Enable TX DMA stream */
+      if (HAL_DMAEx_MultiBufferStart_IT (dma->h, (uint32_t)data, (uint32_t)&(mci->reg->FIFO), mem1, len / 4U) != HAL_OK) {
+        return ARM_DRIVER_ERROR;
+      }
+    }
+    else {
+      /* Enable RX DMA stream */
+      if (HAL_DMAEx_MultiBufferStart_IT (dma->h, (uint32_t)&(mci->reg->FIFO), (uint32_t)data, mem1, len / 4U) != HAL_OK) {
+        return ARM_DRIVER_ERROR;
+      }
     }
   }
 
@@ -1070,14 +1290,43 @@ static int32_t SetupTransfer (uint8_t *data, uint32_t block_count, uint32_t bloc
 }
 
 
+/**
+  \fn            int32_t SetupTransfer (uint8_t *data,
+                                        uint32_t block_count,
+                                        uint32_t block_size,
+                                        uint32_t mode)
+  \brief         Setup read or write transfer operation.
+  \param[in,out] data         Pointer to data block(s) to be written or read
+  \param[in]     block_count  Number of blocks
+  \param[in]     block_size   Size of a block in bytes
+  \param[in]     mode         Transfer mode
+  \return        \ref execution_status
+*/
+static int32_t SetupTransfer (uint8_t *data, uint32_t block_count, uint32_t block_size, uint32_t mode, MCI_RESOURCES *mci) {
+
+  if ((data == NULL) || (block_count == 0U) || (block_size == 0U)) { return ARM_DRIVER_ERROR_PARAMETER; }
+
+  if ((mci->info->flags & MCI_SETUP) == 0U) {
+    return ARM_DRIVER_ERROR;
+  }
+  if (mci->info->status.transfer_active || (mci->info->flags & MCI_QUEUE)) {
+    return ARM_DRIVER_ERROR_BUSY;
+  }
+
+  return (DataSetup (data, block_count, block_size, mode, mci));
+}
+
+
 /**
   \fn            int32_t AbortTransfer (void)
   \brief         Abort current read/write data transfer.
   \return        \ref execution_status
 */
 static int32_t AbortTransfer (MCI_RESOURCES *mci) {
-  int32_t  status;
-  uint32_t mask;
+  MCI_REQUEST *req;
+  MCI_REQUEST *next;
+  int32_t      status;
+  uint32_t     mask;
 
   if ((mci->info->flags & MCI_SETUP) == 0U) { return ARM_DRIVER_ERROR; }
 
@@ -1102,6 +1351,24 @@ static int32_t AbortTransfer (MCI_RESOURCES *mci) {
     mci->reg->FIFO;
   }
 
+  /* Discard queued requests */
+  req = mci->info->queue.head;
+
+  mci->info->queue.head  = NULL;
+  mci->info->queue.tail  = NULL;
+  mci->info->queue.state = MCI_Q_IDLE;
+  mci->info->flags      &= ~MCI_QUEUE;
+
+  while (req != NULL) {
+    next        = req->next;
+    req->next   = NULL;
+    req->status = ARM_DRIVER_ERROR;
+    if (req->cb_done != NULL) {
+      req->cb_done (req);
+    }
+    req = next;
+  }
+
   mci->info->status.command_active  = 0U;
   mci->info->status.transfer_active = 0U;
   mci->info->status.sdio_interrupt  = 0U;
@@ -1117,6 +1384,801 @@ static int32_t AbortTransfer (MCI_RESOURCES *mci) {
 }
 
 
+/**
+  \fn            void Queue_Command (uint32_t cmd, uint32_t arg, uint16_t flags)
+  \brief         Send command of queued request (short response, CRC checked).
+  \param[in]     cmd    Memory Card command
+  \param[in]     arg    Command argument
+  \param[in]     flags  Additional driver flags (MCI_DATA_XFER)
+*/
+static void Queue_Command (uint32_t cmd, uint32_t arg, uint16_t flags, MCI_RESOURCES *mci) {
+
+  mci->info->status.command_active = 1U;
+
+  mci->info->response = &mci->info->queue.resp;
+  mci->info->flags    = (mci->info->flags & ~(MCI_RESP_LONG | MCI_DATA_XFER)) | MCI_RESP_CRC | flags;
+
+  /* Clear all interrupt flags */
+  mci->reg->ICR = SDMMC_ICR_BIT_Msk;
+
+  /* Send the command */
+  mci->reg->ARG = arg;
+  mci->reg->CMD = SDMMC_CMD_CPSMEN | SDMMC_CMD_WAITRESP_0 | (cmd & 0xFFU);
+}
+
+
+/**
+  \fn            void Queue_Stop (void)
+  \brief         Stop data path and DMA of queued request.
+*/
+static void Queue_Stop (MCI_RESOURCES *mci) {
+
+  /* Disable DMA and clear data transfer bit */
+  mci->reg->DCTRL &= ~(SDMMC_DCTRL_DMAEN | SDMMC_DCTRL_DTEN);
+
+  HAL_DMA_Abort (mci->dma_rx->h);
+  HAL_DMA_Abort (mci->dma_tx->h);
+
+  /* Clear SDIO FIFO */
+  while (mci->reg->FIFOCNT) {
+    mci->reg->FIFO;
+  }
+
+  mci->info->flags &= ~MCI_DATA_XFER;
+  mci->info->status.transfer_active = 0U;
+}
+
+
+/**
+  \fn            int32_t Queue_Data (MCI_REQUEST *req)
+  \brief         Prepare data path and send data command of queued request.
+  \param[in]     req  Pointer to block transfer request
+  \return        \ref execution_status
+*/
+static int32_t Queue_Data (MCI_REQUEST *req, MCI_RESOURCES *mci) {
+  int32_t status;
+
+  status = DataSetup (req->data, req->block_count, req->block_size, req->mode, mci);
+
+  if (status == ARM_DRIVER_OK) {
+    mci->info->queue.state = MCI_Q_CMD;
+    Queue_Command (req->cmd, req->arg, MCI_DATA_XFER, mci);
+  }
+  return status;
+}
+
+
+/**
+  \fn            int32_t Queue_Block (MCI_REQUEST *req)
+  \brief         Send block count (when used) or data command of queued request.
+  \param[in]     req  Pointer to block transfer request
+  \return        \ref execution_status
+*/
+static int32_t Queue_Block (MCI_REQUEST *req, MCI_RESOURCES *mci) {
+
+  if ((req->block_count > 1U) && (req->sbc != 0U)) {
+    /* Pre-define number of blocks */
+    mci->info->queue.state = MCI_Q_SBC;
+    Queue_Command (MCI_CMD_SET_BLOCK_COUNT, req->block_count, 0U, mci);
+    return ARM_DRIVER_OK;
+  }
+  return (Queue_Data (req, mci));
+}
+
+
+/**
+  \fn            int32_t Queue_Start (MCI_REQUEST *req)
+  \brief         Start processing of queued request.
+  \param[in]     req  Pointer to block transfer request
+  \return        \ref execution_status
+*/
+static int32_t Queue_Start (MCI_REQUEST *req, MCI_RESOURCES *mci) {
+
+  mci->info->queue.err = ARM_DRIVER_OK;
+
+  mci->info->status.command_timeout  = 0U;
+  mci->info->status.command_error    = 0U;
+  mci->info->status.transfer_timeout = 0U;
+  mci->info->status.transfer_error   = 0U;
+
+  if ((req->pre_erase != 0U) && (req->mode & ARM_MCI_TRANSFER_WRITE)) {
+    /* Pre-erase write blocks: APP_CMD followed by ACMD23 */
+    mci->info->queue.state = MCI_Q_APP;
+    Queue_Command (MCI_CMD_APP_CMD, req->rca << 16, 0U, mci);
+    return ARM_DRIVER_OK;
+  }
+  return (Queue_Block (req, mci));
+}
+
+
+/**
+  \fn            void Queue_Done (int32_t status)
+  \brief         Complete request at queue head and start next one.
+  \param[in]     status  Request completion status
+*/
+static void Queue_Done (int32_t status, MCI_RESOURCES *mci) {
+  MCI_REQUEST *req;
+  MCI_REQUEST *next;
+  uint32_t     primask;
+
+  do {
+    req = mci->info->queue.head;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    next = req->next;
+    mci->info->queue.head = next;
+    if (next == NULL) {
+      /* Queue empty, engine stops */
+      mci->info->queue.tail = NULL;
+      mci->info->flags     &= ~MCI_QUEUE;
+    }
+    mci->info->queue.state = MCI_Q_IDLE;
+
+    __set_PRIMASK(primask);
+
+    req->status = status;
+    req->next   = NULL;
+
+    if (req->cb_done != NULL) {
+      req->cb_done (req);
+    }
+
+    if (next == NULL) { break; }
+
+    /* Start next request */
+    status = Queue_Start (next, mci);
+  } while (status != ARM_DRIVER_OK);
+}
+
+
+/**
+  \fn            void Queue_Event (uint32_t event)
+  \brief         Advance request queue engine on command or transfer event.
+  \param[in]     event  \ref ARM_MCI_SignalEvent
+*/
+static void Queue_Event (uint32_t event, MCI_RESOURCES *mci) {
+  MCI_REQUEST *req;
+  uint32_t     cmd_err, xfer_err;
+
+  req = mci->info->queue.head;
+
+  cmd_err  = event & (ARM_MCI_EVENT_COMMAND_ERROR  | ARM_MCI_EVENT_COMMAND_TIMEOUT);
+  xfer_err = event & (ARM_MCI_EVENT_TRANSFER_ERROR | ARM_MCI_EVENT_TRANSFER_TIMEOUT);
+
+  if (event & (ARM_MCI_EVENT_COMMAND_COMPLETE | cmd_err)) {
+    mci->info->status.command_active = 0U;
+  }
+  if (event & (ARM_MCI_EVENT_TRANSFER_COMPLETE | xfer_err)) {
+    mci->info->status.transfer_active = 0U;
+  }
+
+  switch (mci->info->queue.state) {
+    case MCI_Q_APP:
+      if (cmd_err != 0U) {
+        Queue_Done (ARM_DRIVER_ERROR, mci);
+      }
+      else if (event & ARM_MCI_EVENT_COMMAND_COMPLETE) {
+        mci->info->queue.state = MCI_Q_PRE;
+        Queue_Command (MCI_ACMD_SET_WR_ERASE_CNT, req->pre_erase, 0U, mci);
+      }
+      break;
+
+    case MCI_Q_PRE:
+      if (cmd_err != 0U) {
+        Queue_Done (ARM_DRIVER_ERROR, mci);
+      }
+      else if (event & ARM_MCI_EVENT_COMMAND_COMPLETE) {
+        if (Queue_Block (req, mci) != ARM_DRIVER_OK) {
+          Queue_Done (ARM_DRIVER_ERROR, mci);
+        }
+      }
+      break;
+
+    case MCI_Q_SBC:
+      if (cmd_err != 0U) {
+        Queue_Done (ARM_DRIVER_ERROR, mci);
+      }
+      else if (event & ARM_MCI_EVENT_COMMAND_COMPLETE) {
+        if (Queue_Data (req, mci) != ARM_DRIVER_OK) {
+          Queue_Done (ARM_DRIVER_ERROR, mci);
+        }
+      }
+      break;
+
+    case MCI_Q_CMD:
+      if (cmd_err != 0U) {
+        Queue_Stop (mci);
+        Queue_Done (ARM_DRIVER_ERROR, mci);
+        break;
+      }
+      if ((event & ARM_MCI_EVENT_COMMAND_COMPLETE) == 0U) {
+        break;
+      }
+      /* Data transfer started on command response */
+      req->response = mci->info->queue.resp;
+      mci->info->queue.state = MCI_Q_DATA;
+      /* Fall through for transfer events */
+
+    case MCI_Q_DATA:
+      if (xfer_err != 0U) {
+        Queue_Stop (mci);
+        mci->info->queue.err = ARM_DRIVER_ERROR;
+      }
+      else if ((event & ARM_MCI_EVENT_TRANSFER_COMPLETE) == 0U) {
+        break;
+      }
+
+      if ((req->block_count > 1U) && ((req->sbc == 0U) || (xfer_err != 0U))) {
+        /* Terminate open-ended or failed multiple block transfer */
+        mci->info->queue.state = MCI_Q_STOP;
+        Queue_Command (MCI_CMD_STOP_TRANSMISSION, 0U, 0U, mci);
+      }
+      else if (req->mode & ARM_MCI_TRANSFER_WRITE) {
+        /* Wait until card finishes programming */
+        mci->info->queue.state = MCI_Q_STATUS;
+        Queue_Command (MCI_CMD_SEND_STATUS, req->rca << 16, 0U, mci);
+      }
+      else {
+        Queue_Done (mci->info->queue.err, mci);
+      }
+      break;
+
+    case MCI_Q_STOP:
+      if (cmd_err != 0U) {
+        Queue_Done (ARM_DRIVER_ERROR, mci);
+      }
+      else if (event & ARM_MCI_EVENT_COMMAND_COMPLETE) {
+        if (req->mode & ARM_MCI_TRANSFER_WRITE) {
+          /* Wait until card finishes programming */
+          mci->info->queue.state = MCI_Q_STATUS;
+          Queue_Command (MCI_CMD_SEND_STATUS, req->rca << 16, 0U, mci);
+        }
+        else {
+          Queue_Done (mci->info->queue.err, mci);
+        }
+      }
+      break;
+
+    case MCI_Q_STATUS:
+      if (cmd_err != 0U) {
+        Queue_Done (ARM_DRIVER_ERROR, mci);
+      }
+      else if (event & ARM_MCI_EVENT_COMMAND_COMPLETE) {
+        /* Check READY_FOR_DATA and CURRENT_STATE == tran */
+        if (((mci->info->queue.resp & (1UL << 8)) != 0U) && (((mci->info->queue.resp >> 9) & 0xFU) == 4U)) {
+          Queue_Done (mci->info->queue.err, mci);
+        }
+        else {
+          Queue_Command (MCI_CMD_SEND_STATUS, req->rca << 16, 0U, mci);
+        }
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+
+/**
+  \fn            int32_t Queue_Request (MCI_REQUEST *req)
+  \brief         Append request to queue and start engine when idle.
+  \param[in]     req  Pointer to block transfer request
+  \return        \ref execution_status
+*/
+static int32_t Queue_Request (MCI_REQUEST *req, MCI_RESOURCES *mci) {
+  uint32_t primask, start;
+  int32_t  status;
+
+  if ((req == NULL) || (req->data == NULL) || (req->block_count == 0U) || (req->block_size == 0U)) {
+    return ARM_DRIVER_ERROR_PARAMETER;
+  }
+  if ((mci->info->flags & MCI_SETUP) == 0U) {
+    return ARM_DRIVER_ERROR;
+  }
+
+  req->next   = NULL;
+  req->status = ARM_DRIVER_ERROR_BUSY;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  start = 0U;
+  if ((mci->info->flags & MCI_QUEUE) == 0U) {
+    if (mci->info->status.command_active || mci->info->status.transfer_active) {
+      /* Direct command or transfer in progress */
+      __set_PRIMASK(primask);
+      return ARM_DRIVER_ERROR_BUSY;
+    }
+    mci->info->flags     |= MCI_QUEUE;
+    mci->info->queue.head = req;
+    start = 1U;
+  }
+  else {
+    mci->info->queue.tail->next = req;
+  }
+  mci->info->queue.tail = req;
+
+  __set_PRIMASK(primask);
+
+  if (start != 0U) {
+    status = Queue_Start (req, mci);
+    if (status != ARM_DRIVER_OK) {
+      Queue_Done (status, mci);
+    }
+  }
+
+  return ARM_DRIVER_OK;
+}
+
+
+/**
+  \fn            int32_t Queue_Wait (MCI_REQUEST *req)
+  \brief         Queue request and wait for its completion.
+  \param[in]     req  Pointer to block transfer request
+  \return        \ref execution_status
+*/
+static int32_t Queue_Wait (MCI_REQUEST *req, MCI_RESOURCES *mci) {
+  uint32_t i;
+  int32_t  status;
+
+  req->cb_done = NULL;
+
+  status = Queue_Request (req, mci);
+  if (status != ARM_DRIVER_OK) {
+    return status;
+  }
+
+  /* Wait approximately 1s for request completion (covers card write timeout) */
+  for (i = (HAL_RCC_GetHCLKFreq()/5000000U)*1000000U; i; i--) {
+    if (*(volatile int32_t *)&req->status != ARM_DRIVER_ERROR_BUSY) {
+      return req->status;
+    }
+  }
+
+  AbortTransfer (mci);
+
+  return ARM_DRIVER_ERROR_TIMEOUT;
+}
+
+
+/* Function prototypes */
+static int32_t Control     (uint32_t control, uint32_t arg, MCI_RESOURCES *mci);
+static int32_t Cache_Flush (MCI_RESOURCES *mci);
+
+/**
+  \fn            int32_t HighSpeedSwitch (MCI_HS_SWITCH *hs)
+  \brief         Switch SD card to high speed mode and verify it with a read test.
+  \param[in]     hs  Pointer to high speed switch parameters
+  \return        bus speed in bps or \ref execution_status
+*/
+static int32_t HighSpeedSwitch (MCI_HS_SWITCH *hs, MCI_RESOURCES *mci) {
+  MCI_REQUEST req;
+  uint32_t    clkcr;
+  int32_t     bps;
+
+  if ((hs == NULL) || (hs->buf == NULL)) {
+    return ARM_DRIVER_ERROR_PARAMETER;
+  }
+  if ((mci->info->flags & MCI_BUS_HS) == 0U) {
+    return ARM_DRIVER_ERROR_UNSUPPORTED;
+  }
+
+  memset (&req, 0, sizeof (req));
+
+  /* Check function: is high speed (group 1, function 1) supported */
+  req.cmd         = MCI_CMD_SWITCH_FUNC;
+  req.arg         = 0x00FFFFF1U;
+  req.data        = hs->buf;
+  req.block_count = 1U;
+  req.block_size  = 64U;
+  req.mode        = ARM_MCI_TRANSFER_READ;
+
+  if (Queue_Wait (&req, mci) != ARM_DRIVER_OK) {
+    return ARM_DRIVER_ERROR;
+  }
+  if ((hs->buf[13] & 0x02U) == 0U) {
+    /* Support bit 401 not set */
+    return ARM_DRIVER_ERROR_UNSUPPORTED;
+  }
+
+  /* Read reference block at current bus speed */
+  req.cmd         = MCI_CMD_READ_SINGLE_BLOCK;
+  req.arg         = hs->test_addr;
+  req.block_size  = 512U;
+
+  if (Queue_Wait (&req, mci) != ARM_DRIVER_OK) {
+    return ARM_DRIVER_ERROR;
+  }
+
+  /* Switch function: select high speed */
+  req.cmd         = MCI_CMD_SWITCH_FUNC;
+  req.arg         = 0x80FFFFF1U;
+  req.data        = &hs->buf[512];
+  req.block_size  = 64U;
+
+  if (Queue_Wait (&req, mci) != ARM_DRIVER_OK) {
+    return ARM_DRIVER_ERROR;
+  }
+  if ((hs->buf[512 + 16] & 0x0FU) != 1U) {
+    /* Function group 1 result (bits 379:376) is not high speed */
+    return ARM_DRIVER_ERROR_UNSUPPORTED;
+  }
+
+  /* Card output timing is now valid for 50MHz: bypass clock divider.  */
+  /* NEGEDGE is left cleared, dephasing mode corrupts data on SDMMC    */
+  /* (device errata), so data is sampled on SDMMC_CK rising edge.      */
+  clkcr = mci->reg->CLKCR;
+  bps   = Control (ARM_MCI_BUS_SPEED, SDMMCCLK, mci);
+
+  /* Read test block again and compare with reference */
+  req.cmd         = MCI_CMD_READ_SINGLE_BLOCK;
+  req.arg         = hs->test_addr;
+  req.block_size  = 512U;
+
+  if ((Queue_Wait (&req, mci) != ARM_DRIVER_OK) || (memcmp (hs->buf, &hs->buf[512], 512U) != 0)) {
+    /* Not stable, restore previous clock setting (card stays in high speed mode) */
+    mci->reg->CLKCR = clkcr;
+    return ARM_DRIVER_ERROR;
+  }
+
+  return bps;
+}
+
+
+/**
+  \fn            int32_t Cache_Setup (const MCI_CACHE_CONFIG *cfg)
+  \brief         Setup block cache in caller provided memory.
+  \param[in]     cfg  Pointer to cache configuration (NULL = flush and disable cache)
+  \return        \ref execution_status
+*/
+static int32_t Cache_Setup (const MCI_CACHE_CONFIG *cfg, MCI_RESOURCES *mci) {
+  MCI_CACHE_INFO *c = &mci->info->cache;
+  uint32_t        n;
+  int32_t         status;
+
+  status = ARM_DRIVER_OK;
+
+  if (c->line != NULL) {
+    /* Write back current cache content */
+    status = Cache_Flush (mci);
+  }
+  memset (c, 0, sizeof (MCI_CACHE_INFO));
+
+  if (cfg == NULL) {
+    return status;
+  }
+
+  if ((cfg->mem == NULL) || (((uint32_t)cfg->mem & 0x1FU) != 0U)                ||
+      (cfg->ways == 0U)  || (cfg->stage == 0U) || (cfg->read_ahead > cfg->stage) ||
+      (cfg->erase_size == 0U) || ((cfg->erase_size & (cfg->erase_size - 1U)) != 0U) ||
+      (cfg->sectors == 0U)) {
+    return ARM_DRIVER_ERROR_PARAMETER;
+  }
+  if (cfg->size <= (cfg->stage * 512U)) {
+    return ARM_DRIVER_ERROR_PARAMETER;
+  }
+
+  /* Memory layout: [staging buffer][line data][line descriptors] */
+  n = (cfg->size - (cfg->stage * 512U)) / (512U + sizeof (MCI_CACHE_LINE));
+  n = n / cfg->ways;
+
+  if (n == 0U) {
+    return ARM_DRIVER_ERROR_PARAMETER;
+  }
+
+  c->stage      = (uint8_t *)cfg->mem;
+  c->data       = &c->stage[cfg->stage * 512U];
+  c->line       = (MCI_CACHE_LINE *)&c->data[n * cfg->ways * 512U];
+  c->sets       = n;
+  c->ways       = cfg->ways;
+  c->stage_cnt  = cfg->stage;
+  c->read_ahead = cfg->read_ahead;
+  c->erase_size = cfg->erase_size;
+  c->sectors    = cfg->sectors;
+  c->rca        = cfg->rca;
+  c->flags      = cfg->flags;
+
+  memset (c->line, 0, n * cfg->ways * sizeof (MCI_CACHE_LINE));
+
+  return status;
+}
+
+
+/**
+  \fn            int32_t Cache_Transfer (uint32_t sector, uint8_t *buf, uint32_t count, uint32_t mode, uint32_t pre_erase)
+  \brief         Transfer sectors between card and cache memory.
+  \param[in]     sector     First sector
+  \param[in]     buf        Pointer to cache memory
+  \param[in]     count      Number of sectors
+  \param[in]     mode       Transfer mode (ARM_MCI_TRANSFER_READ or ARM_MCI_TRANSFER_WRITE)
+  \param[in]     pre_erase  Number of blocks to pre-erase before write (0 = none)
+  \return        \ref execution_status
+*/
+static int32_t Cache_Transfer (uint32_t sector, uint8_t *buf, uint32_t count, uint32_t mode, uint32_t pre_erase, MCI_RESOURCES *mci) {
+  MCI_CACHE_INFO *c = &mci->info->cache;
+  MCI_REQUEST     req;
+
+  memset (&req, 0, sizeof (req));
+
+  if (mode & ARM_MCI_TRANSFER_WRITE) {
+    req.cmd = (count > 1U) ? MCI_CMD_WRITE_MULTIPLE : MCI_CMD_WRITE_BLOCK;
+  }
+  else {
+    req.cmd = (count > 1U) ? MCI_CMD_READ_MULTIPLE  : MCI_CMD_READ_SINGLE_BLOCK;
+  }
+  req.arg         = (c->flags & MCI_CACHE_BYTE_ADDR) ? (sector * 512U) : sector;
+  req.data        = buf;
+  req.block_count = count;
+  req.block_size  = 512U;
+  req.mode        = mode;
+  req.sbc         = (c->flags & MCI_CACHE_CMD23) ? 1U : 0U;
+  req.rca         = c->rca;
+  req.pre_erase   = pre_erase;
+
+  return (Queue_Wait (&req, mci));
+}
+
+
+/**
+  \fn            int32_t Cache_Find (uint32_t sector)
+  \brief         Find cache line holding sector.
+  \param[in]     sector  Sector number
+  \return        line index or -1 when sector is not cached
+*/
+static int32_t Cache_Find (uint32_t sector, MCI_RESOURCES *mci) {
+  MCI_CACHE_INFO *c = &mci->info->cache;
+  uint32_t        i, idx;
+
+  idx = (sector % c->sets) * c->ways;
+
+  for (i = 0U; i < c->ways; i++, idx++) {
+    if ((c->line[idx].flags & MCI_LINE_VALID) && (c->line[idx].sector == sector)) {
+      return (int32_t)idx;
+    }
+  }
+  return -1;
+}
+
+
+/**
+  \fn            int32_t Cache_WriteBack (uint32_t sector)
+  \brief         Write back dirty sectors of the erase block containing sector.
+  \param[in]     sector  Sector number
+  \return        \ref execution_status
+  \note          Consecutive dirty sectors are coalesced in the staging buffer
+                 and written with one pre-erased multiple block write.
+*/
+static int32_t Cache_WriteBack (uint32_t sector, MCI_RESOURCES *mci) {
+  MCI_CACHE_INFO *c = &mci->info->cache;
+  uint32_t        s, end, k, i;
+  int32_t         idx, status;
+
+  s   = sector & ~(c->erase_size - 1U);
+  end = s + c->erase_size;
+
+  while (s < end) {
+    /* Collect run of consecutive dirty sectors */
+    for (k = 0U; ((s + k) < end) && (k < c->stage_cnt); k++) {
+      idx = Cache_Find (s + k, mci);
+      if ((idx < 0) || ((c->line[idx].flags & MCI_LINE_DIRTY) == 0U)) {
+        break;
+      }
+      memcpy (&c->stage[k * 512U], &c->data[(uint32_t)idx * 512U], 512U);
+    }
+
+    if (k == 0U) {
+      s++;
+      continue;
+    }
+
+    status = Cache_Transfer (s, c->stage, k, ARM_MCI_TRANSFER_WRITE, (k > 1U) ? k : 0U, mci);
+    if (status != ARM_DRIVER_OK) {
+      return status;
+    }
+
+    for (i = 0U; i < k; i++) {
+      idx = Cache_Find (s + i, mci);
+      c->line[idx].flags &= ~MCI_LINE_DIRTY;
+    }
+    s += k;
+  }
+
+  return ARM_DRIVER_OK;
+}
+
+
+/**
+  \fn            int32_t Cache_Alloc (uint32_t sector, uint32_t clean)
+  \brief         Allocate cache line for sector, evicting least recently used line.
+  \param[in]     sector  Sector number
+  \param[in]     clean   Only evict clean lines (staging buffer in use)
+  \return        line index or \ref execution_status on failure
+*/
+static int32_t Cache_Alloc (uint32_t sector, uint32_t clean, MCI_RESOURCES *mci) {
+  MCI_CACHE_INFO *c = &mci->info->cache;
+  MCI_CACHE_LINE *ln;
+  uint32_t        i, idx, age, max;
+  int32_t         victim, status;
+
+  idx    = (sector % c->sets) * c->ways;
+  victim = -1;
+  max    = 0U;
+
+  for (i = 0U; i < c->ways; i++, idx++) {
+    ln = &c->line[idx];
+    if ((ln->flags & MCI_LINE_VALID) == 0U) {
+      victim = (int32_t)idx;
+      break;
+    }
+    if ((clean != 0U) && (ln->flags & MCI_LINE_DIRTY)) {
+      continue;
+    }
+    age = c->tick - ln->age;
+    if ((victim < 0) || (age > max)) {
+      victim = (int32_t)idx;
+      max    = age;
+    }
+  }
+
+  if (victim < 0) {
+    return ARM_DRIVER_ERROR;
+  }
+
+  ln = &c->line[victim];
+  if (ln->flags & MCI_LINE_DIRTY) {
+    status = Cache_WriteBack (ln->sector, mci);
+    if (status != ARM_DRIVER_OK) {
+      return status;
+    }
+  }
+
+  ln->sector = sector;
+  ln->flags  = MCI_LINE_VALID;
+  ln->age    = ++c->tick;
+
+  return victim;
+}
+
+
+/**
+  \fn            int32_t Cache_Read (const MCI_CACHE_IO *io)
+  \brief         Read sectors through block cache.
+  \param[in]     io  Pointer to transfer parameters
+  \return        \ref execution_status
+*/
+static int32_t Cache_Read (const MCI_CACHE_IO *io, MCI_RESOURCES *mci) {
+  MCI_CACHE_INFO *c = &mci->info->cache;
+  uint32_t        i, k, n, s;
+  uint8_t        *src;
+  int32_t         idx, status;
+
+  for (i = 0U; i < io->count; i += n) {
+    s   = io->sector + i;
+    idx = Cache_Find (s, mci);
+
+    if (idx >= 0) {
+      /* Cache hit */
+      c->line[idx].age = ++c->tick;
+      memcpy (&io->buf[i * 512U], &c->data[(uint32_t)idx * 512U], 512U);
+      n = 1U;
+      continue;
+    }
+
+    n = io->count - i;
+
+    if ((n > 1U) || ((c->read_ahead != 0U) && (s == c->next))) {
+      /* Multiple or sequential access: read blocks into staging buffer */
+      if (n < c->read_ahead) { n = c->read_ahead; }
+      if (n > c->stage_cnt)  { n = c->stage_cnt;  }
+      if (n > (c->sectors - s)) {
+        /* Do not read ahead past the end of the card */
+        n = c->sectors - s;
+      }
+
+      status = Cache_Transfer (s, c->stage, n, ARM_MCI_TRANSFER_READ, 0U, mci);
+      if (status != ARM_DRIVER_OK) {
+        return status;
+      }
+
+      for (k = 0U; k < n; k++) {
+        src = &c->stage[k * 512U];
+        idx = Cache_Find (s + k, mci);
+        if (idx >= 0) {
+          /* Cached copy (may be dirty) is up to date */
+          src = &c->data[(uint32_t)idx * 512U];
+        }
+        else {
+          idx = Cache_Alloc (s + k, 1U, mci);
+          if (idx >= 0) {
+            memcpy (&c->data[(uint32_t)idx * 512U], src, 512U);
+          }
+        }
+        if ((i + k) < io->count) {
+          memcpy (&io->buf[(i + k) * 512U], src, 512U);
+        }
+      }
+      if ((i + n) > io->count) {
+        /* Read-ahead beyond requested sectors */
+        n = io->count - i;
+      }
+    }
+    else {
+      /* Single block read into allocated line */
+      idx = Cache_Alloc (s, 0U, mci);
+      if (idx < 0) {
+        return idx;
+      }
+      status = Cache_Transfer (s, &c->data[(uint32_t)idx * 512U], 1U, ARM_MCI_TRANSFER_READ, 0U, mci);
+      if (status != ARM_DRIVER_OK) {
+        c->line[idx].flags = 0U;
+        return status;
+      }
+      memcpy (&io->buf[i * 512U], &c->data[(uint32_t)idx * 512U], 512U);
+      n = 1U;
+    }
+  }
+
+  c->next = io->sector + io->count;
+
+  return ARM_DRIVER_OK;
+}
+
+
+/**
+  \fn            int32_t Cache_Write (const MCI_CACHE_IO *io)
+  \brief         Write sectors into block cache (write-back).
+  \param[in]     io  Pointer to transfer parameters
+  \return        \ref execution_status
+*/
+static int32_t Cache_Write (const MCI_CACHE_IO *io, MCI_RESOURCES *mci) {
+  MCI_CACHE_INFO *c = &mci->info->cache;
+  uint32_t        i;
+  int32_t         idx;
+
+  for (i = 0U; i < io->count; i++) {
+    idx = Cache_Find (io->sector + i, mci);
+    if (idx < 0) {
+      idx = Cache_Alloc (io->sector + i, 0U, mci);
+      if (idx < 0) {
+        return idx;
+      }
+    }
+    memcpy (&c->data[(uint32_t)idx * 512U], &io->buf[i * 512U], 512U);
+
+    c->line[idx].flags = MCI_LINE_VALID | MCI_LINE_DIRTY;
+    c->line[idx].age   = ++c->tick;
+  }
+
+  return ARM_DRIVER_OK;
+}
+
+
+/**
+  \fn            int32_t Cache_Flush (void)
+  \brief         Write back all dirty sectors of block cache.
+  \return        \ref execution_status
+*/
+static int32_t Cache_Flush (MCI_RESOURCES *mci) {
+  MCI_CACHE_INFO *c = &mci->info->cache;
+  uint32_t        i;
+  int32_t         status;
+
+  for (i = 0U; i < (c->sets * c->ways); i++) {
+    if (c->line[i].flags & MCI_LINE_DIRTY) {
+      status = Cache_WriteBack (c->line[i].sector, mci);
+      if (status != ARM_DRIVER_OK) {
+        return status;
+      }
+    }
+  }
+
+  return ARM_DRIVER_OK;
+}
+
+
 /**
   \fn            int32_t Control (uint32_t control, uint32_t arg)
   \brief         Control MCI Interface.
@@ -1245,6 +2307,38 @@ static int32_t Control (uint32_t control, uint32_t arg, MCI_RESOURCES *mci) {
       mci->reg->MASK |= SDMMC_MASK_SDIOITIE;
       break;
 
+    case ARM_MCI_QUEUE_REQUEST:
+      return (Queue_Request ((MCI_REQUEST *)arg, mci));
+
+    case ARM_MCI_HIGH_SPEED_SWITCH:
+      return (HighSpeedSwitch ((MCI_HS_SWITCH *)arg, mci));
+
+    case ARM_MCI_CACHE_SETUP:
+      return (Cache_Setup ((const MCI_CACHE_CONFIG *)arg, mci));
+
+    case ARM_MCI_CACHE_READ:
+    case ARM_MCI_CACHE_WRITE:
+      if ((arg == 0U) || (((MCI_CACHE_IO *)arg)->buf == NULL)) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+      }
+      if (mci->info->cache.line == NULL) {
+        return ARM_DRIVER_ERROR;
+      }
+      if ((((MCI_CACHE_IO *)arg)->sector >= mci->info->cache.sectors) ||
+          (((MCI_CACHE_IO *)arg)->count  >  (mci->info->cache.sectors - ((MCI_CACHE_IO *)arg)->sector))) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+      }
+      if (control == ARM_MCI_CACHE_READ) {
+        return (Cache_Read  ((const MCI_CACHE_IO *)arg, mci));
+      }
+      return (Cache_Write ((const MCI_CACHE_IO *)arg, mci));
+
+    case ARM_MCI_CACHE_FLUSH:
+      if (mci->info->cache.line == NULL) {
+        return ARM_DRIVER_ERROR;
+      }
+      return (Cache_Flush (mci));
+
     case ARM_MCI_CONTROL_READ_WAIT:
       if (arg) {
         /* Assert read wait */
@@ -1388,6 +2482,14 @@ void SDMMC_IRQHandler (MCI_RESOURCES *mci) {
   /* Clear processed interrupts */
   mci->reg->ICR = icr;
 
+  if (mci->info->flags & MCI_QUEUE) {
+    /* Command and transfer events are consumed by request queue engine */
+    if (event & ~ARM_MCI_EVENT_SDIO_INTERRUPT) {
+      Queue_Event (event & ~ARM_MCI_EVENT_SDIO_INTERRUPT, mci);
+    }
+    event &= ARM_MCI_EVENT_SDIO_INTERRUPT;
+  }
+
   if (event) {
     /* Check for transfer events */
     mask = ARM_MCI_EVENT_TRANSFER_ERROR   |
@@ -1442,6 +2544,23 @@ void SDMMC_IRQHandler (MCI_RESOURCES *mci) {
 /* Rx DMA Callback */
 void RX_DMA_Complete (DMA_HandleTypeDef *hdma, MCI_RESOURCES *mci) {
 
+#if ((MCI_MANAGE_CACHE == 1U) && (__DCACHE_PRESENT == 1U))
+  if ((SCB->CCR & SCB_CCR_DC_Msk) != 0U) {      /* If Data Cache is enabled */
+    /* Discard lines speculatively fetched while DMA was writing */
+    SCB_InvalidateDCache_by_Addr ((uint32_t *)((uint32_t)mci->info->xfer.data & (~0x1FU)), (int32_t)(mci->info->xfer.len + 31U));
+  }
+  if (mci->info->xfer.user != NULL) {
+    /* Copy bounced data to caller buffer */
+    memcpy (mci->info->xfer.user, mci->info->xfer.data, mci->info->xfer.len);
+    mci->info->xfer.user = NULL;
+  }
+#endif
+
+  if (mci->info->flags & MCI_QUEUE) {
+    Queue_Event (ARM_MCI_EVENT_TRANSFER_COMPLETE, mci);
+    return;
+  }
+
   mci->info->status.transfer_active = 0U;
 
   if (mci->info->cb_event) {
@@ -1450,6 +2569,100 @@ void RX_DMA_Complete (DMA_HandleTypeDef *hdma, MCI_RESOURCES *mci) {
 }
 
 
+/* DMA double buffer chunk complete callback */
+void DMA_Chunk (DMA_HandleTypeDef *hdma, MCI_RESOURCES *mci) {
+  HAL_DMA_MemoryTypeDef mem;
+  uint32_t primask, tail, done;
+
+  /* Completed target is the one DMA is not currently using */
+  if (hdma->Instance->CR & DMA_SxCR_CT) { mem = MEMORY0; }
+  else                                  { mem = MEMORY1; }
+
+  if (mci->info->xfer.cnt != 0U) {
+    /* Re-arm completed target with the next chunk */
+    HAL_DMAEx_ChangeMemory (hdma, (uint32_t)mci->info->xfer.buf, mem);
+
+    if (mci->info->xfer.cnt > mci->info->xfer.chunk) {
+      mci->info->xfer.buf += mci->info->xfer.chunk;
+      mci->info->xfer.cnt -= mci->info->xfer.chunk;
+    }
+    else {
+      /* Tail armed */
+      mci->info->xfer.cnt  = 0U;
+    }
+  }
+  else {
+    /* No data left, park completed target so that the stream never */
+    /* switches back to a stale chunk after the last one            */
+    HAL_DMAEx_ChangeMemory (hdma, (uint32_t)MCI_DMA_Dummy, mem);
+  }
+
+  mci->info->xfer.num--;
+
+  if ((mci->info->xfer.num == 1U) && (mci->info->xfer.tail != mci->info->xfer.chunk)) {
+    /* DMA runs on the shorter tail, which would never complete as a */
+    /* full chunk: continue the remaining bytes with SDMMC as flow   */
+    /* controller. SDMMC FIFO covers the time the stream is stopped. */
+    mci->info->xfer.num = 0U;
+
+    tail = (uint32_t)mci->info->xfer.data + mci->info->xfer.len - mci->info->xfer.tail;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    HAL_DMA_Abort (hdma);
+    done = mci->info->xfer.chunk - (__HAL_DMA_GET_COUNTER (hdma) * 4U);
+
+    if (done < mci->info->xfer.tail) {
+      hdma->XferCpltCallback   = (hdma == mci->dma_rx->h) ? mci->dma_rx->cb_complete : NULL;
+      hdma->XferErrorCallback  = NULL;
+      hdma->Instance->CR      |= DMA_SxCR_PFCTRL;
+
+      if (hdma == mci->dma_rx->h) {
+        HAL_DMA_Start_IT (hdma, (uint32_t)&(mci->reg->FIFO), tail + done, mci->info->xfer.tail - done);
+      }
+      else {
+        HAL_DMA_Start_IT (hdma, tail + done, (uint32_t)&(mci->reg->FIFO), mci->info->xfer.tail - done);
+      }
+      __set_PRIMASK(primask);
+    }
+    else {
+      /* Whole tail already transferred */
+      __set_PRIMASK(primask);
+
+      if (hdma == mci->dma_rx->h) {
+        RX_DMA_Complete (hdma, mci);
+      }
+    }
+  }
+  else if (mci->info->xfer.num == 0U) {
+    /* Last chunk transferred, stop the stream */
+    HAL_DMA_Abort (hdma);
+
+    if (hdma == mci->dma_rx->h) {
+      RX_DMA_Complete (hdma, mci);
+    }
+  }
+}
+
+
+/* DMA double buffer error callback */
+void DMA_Error (DMA_HandleTypeDef *hdma, MCI_RESOURCES *mci) {
+
+  if (mci->info->flags & MCI_QUEUE) {
+    Queue_Event (ARM_MCI_EVENT_TRANSFER_ERROR, mci);
+    return;
+  }
+
+  mci->info->status.transfer_active = 0U;
+  mci->info->status.transfer_error  = 1U;
+
+  if (mci->info->cb_event) {
+    (mci->info->cb_event)(ARM_MCI_EVENT_TRANSFER_ERROR);
+  }
+}
+
+
 #if defined (MX_SDMMC1)
 /* MCI0 Driver wrapper functions */
 static ARM_MCI_CAPABILITIES MCI0_GetCapabilities (void) {
@@ -1511,6 +2724,12 @@ void MX_SDMMC1_TX_DMA_Handler (void) {
 void MCI0_RX_DMA_Complete(DMA_HandleTypeDef *hdma) {
   RX_DMA_Complete (hdma, &MCI0_Resources);
 }
+void MCI0_DMA_Chunk(DMA_HandleTypeDef *hdma) {
+  DMA_Chunk (hdma, &MCI0_Resources);
+}
+void MCI0_DMA_Error(DMA_HandleTypeDef *hdma) {
+  DMA_Error (hdma, &MCI0_Resources);
+}
 
 /* MCI0 Driver Control Block */
 ARM_DRIVER_MCI Driver_MCI0 = {
@@ -1592,6 +2811,12 @@ void MX_SDMMC2_TX_DMA_Handler (void) {
 void MCI1_RX_DMA_Complete(DMA_HandleTypeDef *hdma) {
   RX_DMA_Complete (hdma, &MCI1_Resources);
 }
+void MCI1_DMA_Chunk(DMA_HandleTypeDef *hdma) {
+  DMA_Chunk (hdma, &MCI1_Resources);
+}
+void MCI1_DMA_Error(DMA_HandleTypeDef *hdma) {
+  DMA_Error (hdma, &MCI1_Resources);
+}
 
 /* MCI1 Driver Control Block */
 ARM_DRIVER_MCI Driver_MCI1 = {
@@ -284,6 +284,10 @@
 /* SDIO Adapter Clock definition */
 #define SDMMCCLK            48000000U    /* SDMMC adapter clock */
 
+/* DMA transfer limits */
+#define MCI_DMA_RUN_MAX     0x0000FFFFU  /* Max bytes in single DMA run      */
+#define MCI_DMA_DUMMY_SIZE  256U         /* Bytes in parked DMA target      */
+
 /* Interrupt clear mask */
 #define SDMMC_ICR_BIT_Msk     (SDMMC_ICR_CCRCFAILC | \
                                SDMMC_ICR_DCRCFAILC | \
@@ -313,12 +317,131 @@
 #define MCI_DATA_READ ((uint16_t)0x0040)  /* Read transfer                 */
 #define MCI_READ_WAIT ((uint16_t)0x0080)  /* Read wait operation start     */
 #define MCI_BUS_HS    ((uint16_t)0x0100)  /* High speed bus mode is active */
+#define MCI_QUEUE     ((uint16_t)0x0200)  /* Request queue engine active   */
 
 #define MCI_RESPONSE_EXPECTED_Msk (ARM_MCI_RESPONSE_SHORT      | \
                                    ARM_MCI_RESPONSE_SHORT_BUSY | \
                                    ARM_MCI_RESPONSE_LONG)
 
 
+/* Driver specific control codes */
+#define ARM_MCI_QUEUE_REQUEST     (0x20UL)  /* Queue block transfer request; arg = pointer to MCI_REQUEST */
+#define ARM_MCI_HIGH_SPEED_SWITCH (0x21UL)  /* Switch SD card to high speed and verify; arg = pointer to MCI_HS_SWITCH */
+#define ARM_MCI_CACHE_SETUP       (0x22UL)  /* Setup block cache; arg = pointer to MCI_CACHE_CONFIG (NULL = disable) */
+#define ARM_MCI_CACHE_READ        (0x23UL)  /* Read sectors through block cache; arg = pointer to MCI_CACHE_IO */
+#define ARM_MCI_CACHE_WRITE       (0x24UL)  /* Write sectors through block cache; arg = pointer to MCI_CACHE_IO */
+#define ARM_MCI_CACHE_FLUSH       (0x25UL)  /* Write back all dirty sectors of block cache */
+
+/* Commands issued by the driver */
+#define MCI_CMD_SWITCH_FUNC       6U        /* CMD6  */
+#define MCI_CMD_STOP_TRANSMISSION 12U       /* CMD12 */
+#define MCI_CMD_SEND_STATUS       13U       /* CMD13 */
+#define MCI_CMD_READ_SINGLE_BLOCK 17U       /* CMD17 */
+#define MCI_CMD_READ_MULTIPLE     18U       /* CMD18 */
+#define MCI_CMD_SET_BLOCK_COUNT   23U       /* CMD23 */
+#define MCI_CMD_WRITE_BLOCK       24U       /* CMD24 */
+#define MCI_CMD_WRITE_MULTIPLE    25U       /* CMD25 */
+#define MCI_CMD_APP_CMD           55U       /* CMD55 */
+#define MCI_ACMD_SET_WR_ERASE_CNT 23U       /* ACMD23 */
+
+/* Request queue engine states */
+#define MCI_Q_IDLE                0U        /* No request in progress         */
+#define MCI_Q_SBC                 1U        /* SET_BLOCK_COUNT sent           */
+#define MCI_Q_CMD                 2U        /* Data command sent              */
+#define MCI_Q_DATA                3U        /* Data transfer in progress      */
+#define MCI_Q_STOP                4U        /* STOP_TRANSMISSION sent         */
+#define MCI_Q_STATUS              5U        /* Waiting for end of programming */
+#define MCI_Q_APP                 6U        /* APP_CMD sent (pre-erase)       */
+#define MCI_Q_PRE                 7U        /* SET_WR_BLK_ERASE_COUNT sent    */
+
+/* Queued request completion callback */
+struct _MCI_REQUEST;
+typedef void (*MCI_SignalRequest_t) (struct _MCI_REQUEST *req);
+
+/* Block transfer request (ARM_MCI_QUEUE_REQUEST) */
+typedef struct _MCI_REQUEST {
+  uint32_t              cmd;            /* Data command (CMD17/18/24/25)      */
+  uint32_t              arg;            /* Data command argument              */
+  uint8_t              *data;           /* Data buffer                        */
+  uint32_t              block_count;    /* Number of blocks                   */
+  uint32_t              block_size;     /* Size of a block in bytes           */
+  uint32_t              mode;           /* Transfer mode (ARM_MCI_TRANSFER_x) */
+  uint32_t              sbc;            /* Block count: 1=CMD23, 0=CMD12 stop */
+  uint32_t              rca;            /* Relative card address (CMD13/55)   */
+  uint32_t              pre_erase;      /* Write: ACMD23 block count (0=none) */
+  MCI_SignalRequest_t   cb_done;        /* Completion callback (IRQ context)  */
+  uint32_t              response;       /* Out: data command response         */
+  int32_t               status;         /* Out: execution status              */
+  struct _MCI_REQUEST  *next;           /* Driver internal                    */
+} MCI_REQUEST;
+
+/* High speed switch (ARM_MCI_HIGH_SPEED_SWITCH) */
+typedef struct _MCI_HS_SWITCH {
+  uint8_t              *buf;            /* Work buffer (1024 bytes)           */
+  uint32_t              test_addr;      /* Read test block address (CMD17)    */
+} MCI_HS_SWITCH;
+
+/* Block cache configuration (ARM_MCI_CACHE_SETUP) */
+typedef struct _MCI_CACHE_CONFIG {
+  void                 *mem;            /* Cache memory (32-byte aligned)     */
+  uint32_t              size;           /* Cache memory size in bytes         */
+  uint32_t              ways;           /* Lines per set                      */
+  uint32_t              stage;          /* Staging buffer size in sectors     */
+  uint32_t              read_ahead;     /* Read-ahead in sectors (<= stage)   */
+  uint32_t              erase_size;     /* Erase block size in sectors        */
+  uint32_t              sectors;        /* Card capacity in sectors           */
+  uint32_t              rca;            /* Relative card address              */
+  uint32_t              flags;          /* MCI_CACHE_xxx flags                */
+} MCI_CACHE_CONFIG;
+
+/* Block cache configuration flags */
+#define MCI_CACHE_BYTE_ADDR       (1UL << 0)  /* Card uses byte addressing (SDSC) */
+#define MCI_CACHE_CMD23           (1UL << 1)  /* Card supports CMD23              */
+
+/* Block cache transfer (ARM_MCI_CACHE_READ, ARM_MCI_CACHE_WRITE) */
+typedef struct _MCI_CACHE_IO {
+  uint32_t              sector;         /* First sector                       */
+  uint8_t              *buf;            /* Data buffer                        */
+  uint32_t              count;          /* Number of sectors                  */
+} MCI_CACHE_IO;
+
+/* Block cache line flags */
+#define MCI_LINE_VALID            ((uint16_t)0x0001)
+#define MCI_LINE_DIRTY            ((uint16_t)0x0002)
+
+/* Block cache line descriptor */
+typedef struct _MCI_CACHE_LINE {
+  uint32_t              sector;         /* Cached sector                      */
+  uint32_t              flags;          /* Line flags                         */
+  uint32_t              age;            /* Last access time (LRU)             */
+} MCI_CACHE_LINE;
+
+/* Block cache state */
+typedef struct _MCI_CACHE_INFO {
+  MCI_CACHE_LINE       *line;           /* Line descriptors                   */
+  uint8_t              *data;           /* Line data (512 bytes per line)     */
+  uint8_t              *stage;          /* Staging buffer                     */
+  uint32_t              sets;           /* Number of sets                     */
+  uint32_t              ways;           /* Lines per set                      */
+  uint32_t              stage_cnt;      /* Staging buffer size in sectors     */
+  uint32_t              read_ahead;     /* Read-ahead in sectors              */
+  uint32_t              erase_size;     /* Erase block size in sectors        */
+  uint32_t              sectors;        /* Card capacity in sectors           */
+  uint32_t              rca;            /* Relative card address              */
+  uint32_t              flags;          /* Configuration flags                */
+  uint32_t              next;           /* Sector following last read         */
+  uint32_t              tick;           /* LRU clock                          */
+} MCI_CACHE_INFO;
+
+/* Request Queue Definition */
+typedef struct _MCI_QUEUE_INFO {
+  MCI_REQUEST          *head;           /* Request in progress                */
+  MCI_REQUEST          *tail;           /* Last queued request                */
+  uint32_t              resp;           /* Response of last command           */
+  int32_t               err;            /* Status of request in progress      */
+  uint8_t volatile      state;          /* Engine state                       */
+} MCI_QUEUE_INFO;
+
 /* DMA Callback functions */
 typedef void (*DMA_Callback_t) (DMA_HandleTypeDef *hdma);
 
@@ -326,6 +449,8 @@ typedef void (*DMA_Callback_t) (DMA_HandleTypeDef *hdma);
 typedef struct _MCI_DMA {
   DMA_HandleTypeDef    *h;
   DMA_Callback_t        cb_complete;
+  DMA_Callback_t        cb_chunk;       /* Double buffer chunk complete       */
+  DMA_Callback_t        cb_error;       /* Transfer error                     */
 #if defined(RTE_DEVICE_FRAMEWORK_CLASSIC)
   DMA_Stream_TypeDef   *stream;         /* Stream register interface          */
   IRQn_Type             irq_num;        /* Stream IRQ number                  */
@@ -346,6 +471,12 @@ typedef const struct _MCI_IO {
 typedef struct _MCI_XFER {
   uint8_t *buf;                         /* Data buffer                        */
   uint32_t cnt;                         /* Data bytes to transfer             */
+  uint32_t chunk;                       /* DMA double buffer chunk size       */
+  uint32_t num;                         /* DMA chunks not yet completed       */
+  uint32_t tail;                        /* DMA double buffer final chunk size */
+  uint8_t *data;                        /* DMA buffer start                   */
+  uint32_t len;                         /* DMA buffer length                  */
+  uint8_t *user;                        /* Caller buffer of bounced read      */
 } MCI_XFER;
 
 /* MCI Driver State Definition */
@@ -356,6 +487,8 @@ typedef struct _MCI_INFO {
   MCI_XFER              xfer;           /* Data transfer description          */
   uint32_t              dctrl;          /* Data control register value        */
   uint32_t              dlen;           /* Data length register value         */
+  MCI_QUEUE_INFO        queue;          /* Request queue                      */
+  MCI_CACHE_INFO        cache;          /* Block cache                        */
   uint16_t volatile     flags;          /* Driver state flags                 */
 } MCI_INFO;
 
@@ -372,6 +505,7 @@ typedef struct {
   MCI_IO           *io;                 /* I/O pins                           */
   MCI_IO           *io_cd;
   MCI_IO           *io_wp;
+  uint32_t         *bounce;             /* Cache line aligned bounce buffer   */
   MCI_INFO         *info;               /* Run-Time information               */
 
 } const MCI_RESOURCES;
@@ -18,8 +18,8 @@
  * 3. This notice may not be removed or altered from any source distribution.
  *
  *
- * $Date:        11. March 2016
- * $Revision:    V1.3
+ * $Date:        19. October 2026
+ * $Revision:    V1.7
  *
  * Driver:       Driver_SAI1, Driver_SAI2
  * Configured:   via RTE_Device.h configuration file
@@ -35,6 +35,16 @@
  * -------------------------------------------------------------------------- */
 
 /* History:
+ *  Version 1.7
+ *      - Added sample rate drift measurement in streaming modes (ARM_SAI_CONTROL_DRIFT_TX/RX)
+ *      - Sample format conversion with one kernel per format, INT24 transmit samples are saturated
+ *  Version 1.6
+ *      - Added sample format conversion in streaming modes (ARM_SAI_CONTROL_FORMAT_TX/RX)
+ *  Version 1.5
+ *      - Added synchronized full-duplex streaming (ARM_SAI_DUPLEX_START/STOP)
+ *  Version 1.4
+ *      - Added circular DMA streaming mode (ARM_SAI_CONTROL_STREAM_TX/RX) with
+ *        half buffer events and refill margin watermark
  *  Version 1.3
  *      - Corrected extern SAI_HandleTypeDef definition, for STM32Cube Configuration
  *  Version 1.2
@@ -105,13 +115,57 @@ Configuration tab
      - Parameter Settings: not used
      - User Constants: not used
      - Click \b OK to close the SAI2 Configuration dialog
+
+Streaming mode
+--------------
+  With DMA configured for the stream, \b ARM_SAI_CONTROL_STREAM_TX (\b ARM_SAI_CONTROL_STREAM_RX) enables
+  continuous transfer. \b Send (\b Receive) then starts a circular DMA over the provided buffer, which
+  must hold an even number of data items. \b ARM_SAI_EVENT_TX_HALF (\b ARM_SAI_EVENT_RX_HALF) signals that
+  the first half is released, \b ARM_SAI_EVENT_SEND_COMPLETE (\b ARM_SAI_EVENT_RECEIVE_COMPLETE) that the
+  second half is released; the transfer continues until \b ARM_SAI_ABORT_SEND (\b ARM_SAI_ABORT_RECEIVE).
+  After each event the driver measures the margin: the number of data items DMA still transfers
+  before it re-enters the released half. When the margin drops below the watermark (arg2 of the
+  stream control) \b ARM_SAI_EVENT_TX_LATE (\b ARM_SAI_EVENT_RX_LATE) is signaled, before an underrun
+  or overwrite actually occurs. \b ARM_SAI_GET_TX_MARGIN (\b ARM_SAI_GET_RX_MARGIN) returns the lowest
+  margin observed since the previous call.
+
+Full-duplex streaming
+---------------------
+  \b ARM_SAI_DUPLEX_START runs receive and transmit block in lockstep. One block must be configured
+  \b ARM_SAI_SYNCHRONOUS (synchronous with the other sub-block) and the other \b ARM_SAI_ASYNCHRONOUS;
+  both must use DMA and be disabled. The driver starts both circular DMA streams over buffers of the
+  same length, then enables the synchronous block before its clock master, so both blocks transfer
+  their first data item in the same frame and stay at the same buffer position. On each receive DMA
+  half and full event \b cb_process of \b SAI_DUPLEX is called with the released receive half and the
+  matching transmit half to be refilled. Margins and late events work as in streaming mode.
+  \b ARM_SAI_DUPLEX_STOP stops both blocks; \b ARM_SAI_ABORT_SEND or \b ARM_SAI_ABORT_RECEIVE also stops both.
+
+Sample format conversion
+------------------------
+  In streaming and full-duplex modes \b ARM_SAI_CONTROL_FORMAT_TX (\b ARM_SAI_CONTROL_FORMAT_RX) attaches
+  an application buffer with the same number of samples as the DMA buffer, in float, Q31, Q15,
+  24-bit in 32-bit or packed 24-bit format. Received halves are converted before the buffer half event,
+  transmit halves after it; the full-duplex callback receives the application buffer halves. With
+  \b ARM_SAI_FORMAT_PLANAR each application buffer half holds the channels one after another and is
+  interleaved into slot order. Interleaved data already in slot format is copied; planar stereo Q15
+  to 16-bit slots uses the Cortex-M7 DSP instruction PKHBT when available.
+
+Sample rate drift measurement
+-----------------------------
+  \b ARM_SAI_CONTROL_DRIFT_TX (\b ARM_SAI_CONTROL_DRIFT_RX) compares DMA progress in streaming modes with
+  the core clock (DWT cycle counter). On each buffer half event the DMA position and cycle counter are
+  sampled; at the end of each window (arg2, in ms) the ratio of transferred to nominal data items gives
+  a drift estimate that is averaged over windows. The window is limited to 2^31 core clock cycles
+  (9.9 s at 216 MHz). \b ARM_SAI_GET_TX_DRIFT (\b ARM_SAI_GET_RX_DRIFT) returns the estimate in parts
+  per billion. In full-duplex mode the receive side is measured. The estimate is meant to drive USB
+  audio feedback or sample rate conversion; PLLSAI/PLLI2S are not trimmed by the driver.
 */
 
 /*! \cond */
 
 #include "SAI_STM32F7xx.h"
 
-#define ARM_SAI_DRV_VERSION ARM_DRIVER_VERSION_MAJOR_MINOR(1,3)
+#define ARM_SAI_DRV_VERSION ARM_DRIVER_VERSION_MAJOR_MINOR(1,7)
 // Driver Version
 static const ARM_DRIVER_VERSION DriverVersion = { ARM_SAI_API_VERSION, ARM_SAI_DRV_VERSION };
 
@@ -213,6 +267,7 @@ static SAI_STREAM_INFO SAI1_Stream_Info_B = { 0U };
 // SAI1 A DMA
 #ifdef MX_SAI1_A_DMA_Instance
   void SAI1_A_DMA_Complete (DMA_HandleTypeDef *hdma);
+  void SAI1_A_DMA_HalfComplete (DMA_HandleTypeDef *hdma);
 
 #ifdef RTE_DEVICE_FRAMEWORK_CLASSIC
   static DMA_HandleTypeDef hdma_sai1_a = { 0U };
@@ -222,6 +277,7 @@ static SAI_STREAM_INFO SAI1_Stream_Info_B = { 0U };
   static SAI_DMA SAI1_A_DMA = {
     &hdma_sai1_a,
     SAI1_A_DMA_Complete,
+    SAI1_A_DMA_HalfComplete,
 #ifdef RTE_DEVICE_FRAMEWORK_CLASSIC
     MX_SAI1_A_DMA_Instance,
     MX_SAI1_A_DMA_Channel,
@@ -234,6 +290,7 @@ static SAI_STREAM_INFO SAI1_Stream_Info_B = { 0U };
 // SAI1 B DMA
 #ifdef MX_SAI1_B_DMA_Instance
   void SAI1_B_DMA_Complete (DMA_HandleTypeDef *hdma);
+  void SAI1_B_DMA_HalfComplete (DMA_HandleTypeDef *hdma);
 
 #ifdef RTE_DEVICE_FRAMEWORK_CLASSIC
   static DMA_HandleTypeDef hdma_sai1_b = { 0U };
@@ -243,6 +300,7 @@ static SAI_STREAM_INFO SAI1_Stream_Info_B = { 0U };
   static SAI_DMA SAI1_B_DMA = {
     &hdma_sai1_b,
     SAI1_B_DMA_Complete,
+    SAI1_B_DMA_HalfComplete,
 #ifdef RTE_DEVICE_FRAMEWORK_CLASSIC
     MX_SAI1_B_DMA_Instance,
     MX_SAI1_B_DMA_Channel,
@@ -406,6 +464,7 @@ static SAI_STREAM_INFO SAI2_Stream_Info_B = { 0U };
 // SAI2 A DMA
 #ifdef MX_SAI2_A_DMA_Instance
   void SAI2_A_DMA_Complete (DMA_HandleTypeDef *hdma);
+  void SAI2_A_DMA_HalfComplete (DMA_HandleTypeDef *hdma);
 
 #ifdef RTE_DEVICE_FRAMEWORK_CLASSIC
   static DMA_HandleTypeDef hdma_sai2_a = { 0U };
@@ -415,6 +474,7 @@ static SAI_STREAM_INFO SAI2_Stream_Info_B = { 0U };
   static SAI_DMA SAI2_A_DMA = {
     &hdma_sai2_a,
     SAI2_A_DMA_Complete,
+    SAI2_A_DMA_HalfComplete,
 #ifdef RTE_DEVICE_FRAMEWORK_CLASSIC
     MX_SAI2_A_DMA_Instance,
     MX_SAI2_A_DMA_Channel,
@@ -427,6 +487,7 @@ static SAI_STREAM_INFO SAI2_Stream_Info_B = { 0U };
 // SAI2 B DMA
 #ifdef MX_SAI2_B_DMA_Instance
   void SAI2_B_DMA_Complete (DMA_HandleTypeDef *hdma);
+  void SAI2_B_DMA_HalfComplete (DMA_HandleTypeDef *hdma);
 
 #ifdef RTE_DEVICE_FRAMEWORK_CLASSIC
   static DMA_HandleTypeDef hdma_sai2_b = { 0U };
@@ -436,6 +497,7 @@ static SAI_STREAM_INFO SAI2_Stream_Info_B = { 0U };
   static SAI_DMA SAI2_B_DMA = {
     &hdma_sai2_b,
     SAI2_B_DMA_Complete,
+    SAI2_B_DMA_HalfComplete,
 #ifdef RTE_DEVICE_FRAMEWORK_CLASSIC
     MX_SAI2_B_DMA_Instance,
     MX_SAI2_B_DMA_Channel,
@@ -972,6 +1034,482 @@ static int32_t SAI_PowerControl (ARM_POWER_STATE  state,
 
 }
 
+#ifdef __SAI_DMA
+/**
+  \fn          uint32_t SAI_FormatSize (uint32_t format)
+  \brief       Get size of one application sample.
+  \param[in]   format  Application sample format
+  \return      sample size in bytes
+*/
+static uint32_t SAI_FormatSize (uint32_t format) {
+  switch (format & ARM_SAI_FORMAT_Msk) {
+    case ARM_SAI_FORMAT_Q15:       return 2U;
+    case ARM_SAI_FORMAT_PACKED_24: return 3U;
+    default:                       return 4U;
+  }
+}
+
+/**
+  \fn          bool SAI_FormatCheck (SAI_STREAM *stream, uint32_t num)
+  \brief       Check streaming buffer length against application sample format.
+  \param[in]   stream  Pointer to SAI stream
+  \param[in]   num     Number of data items in buffer
+  \return      true when each planar buffer half holds whole frames
+*/
+static bool SAI_FormatCheck (SAI_STREAM *stream, uint32_t num) {
+  uint32_t ch;
+
+  if (((stream->info->format & ARM_SAI_FORMAT_Msk)    == ARM_SAI_FORMAT_NONE) ||
+      ((stream->info->format & ARM_SAI_FORMAT_PLANAR) == 0U)) {
+    return true;
+  }
+  ch = ((stream->info->format & ARM_SAI_FORMAT_CHANNELS_Msk) >> ARM_SAI_FORMAT_CHANNELS_Pos) + 1U;
+
+  return (((num / 2U) % ch) == 0U);
+}
+
+/**
+  \fn          void SAI_DriftReset (SAI_STREAM *stream)
+  \brief       Restart drift measurement (on transfer start).
+  \param[in]   stream  Pointer to SAI stream
+*/
+static void SAI_DriftReset (SAI_STREAM *stream) {
+  stream->info->drift.cycles = 0U;
+  stream->info->drift.items  = 0U;
+  stream->info->drift.ppb    = 0;
+  stream->info->drift.state  = 0U;
+}
+
+/**
+  \fn          void SAI_DriftUpdate (SAI_STREAM *stream)
+  \brief       Update sample rate drift measurement on buffer half event.
+  \param[in]   stream  Pointer to SAI stream
+*/
+static void SAI_DriftUpdate (SAI_STREAM *stream) {
+  SAI_DRIFT *drift;
+  uint32_t   primask, stamp, pos;
+  int64_t    diff, den, ppb;
+
+  drift = &stream->info->drift;
+  if (drift->rate == 0U) { return; }
+
+  // Sample cycle counter and DMA position together
+  primask = __get_PRIMASK();
+  __disable_irq();
+  stamp = DWT->CYCCNT;
+  pos   = stream->info->num - __HAL_DMA_GET_COUNTER(stream->dma->hdma);
+  __set_PRIMASK(primask);
+
+  if (drift->state != 0U) {
+    drift->cycles += stamp - drift->stamp;
+    drift->items  += (pos + stream->info->num - drift->pos) % stream->info->num;
+  } else {
+    // First event: reference point only
+    drift->state = 1U;
+  }
+  drift->stamp = stamp;
+  drift->pos   = pos;
+
+  if (drift->cycles < drift->window) { return; }
+
+  // Transferred vs. nominal data items, scaled by core clock: (items * f_core - cycles * rate)
+  diff = ((int64_t)drift->items * SystemCoreClock) - ((int64_t)drift->cycles * drift->rate);
+  den  = ((int64_t)drift->cycles * drift->rate) / 1000000;
+  if (den == 0) { den = 1; }
+  ppb  = (diff * 1000) / den;
+
+  if      (ppb >  0x7FFFFFFF) { ppb =  0x7FFFFFFF; }
+  else if (ppb < -0x7FFFFFFF) { ppb = -0x7FFFFFFF; }
+
+  if (drift->state == 2U) {
+    // Exponential average over windows removes one data item quantization
+    drift->ppb += ((int32_t)ppb - drift->ppb) / 4;
+  } else {
+    drift->ppb   = (int32_t)ppb;
+    drift->state = 2U;
+  }
+
+  drift->cycles = 0U;
+  drift->items  = 0U;
+}
+
+/**
+  \fn          void SAI_SlotWrite (uint8_t *dma, uint32_t bits, uint32_t i, uint32_t val)
+  \brief       Write right aligned slot data to DMA buffer.
+  \param[in]   dma     Pointer to DMA buffer
+  \param[in]   bits    Data size in bits
+  \param[in]   i       Data item index
+  \param[in]   val     Slot data
+*/
+__INLINE static void SAI_SlotWrite (uint8_t *dma, uint32_t bits, uint32_t i, uint32_t val) {
+  if      (bits > 16U) { ((uint32_t *)dma)[i] = val;           }
+  else if (bits >  8U) { ((uint16_t *)dma)[i] = (uint16_t)val; }
+  else                 {              dma [i] = (uint8_t)val;  }
+}
+
+/**
+  \fn          uint32_t SAI_SlotRead (const uint8_t *dma, uint32_t bits, uint32_t i)
+  \brief       Read right aligned slot data from DMA buffer.
+  \param[in]   dma     Pointer to DMA buffer
+  \param[in]   bits    Data size in bits
+  \param[in]   i       Data item index
+  \return      slot data
+*/
+__INLINE static uint32_t SAI_SlotRead (const uint8_t *dma, uint32_t bits, uint32_t i) {
+  if      (bits > 16U) { return (((const uint32_t *)dma)[i]); }
+  else if (bits >  8U) { return (((const uint16_t *)dma)[i]); }
+  else                 { return (              dma [i]);      }
+}
+
+/**
+  \fn          void SAI_TxFloat (const float *src, uint8_t *dma, uint32_t i, uint32_t n, uint32_t step, uint32_t bits)
+  \brief       Convert float samples to transmit slot data (saturated to Q31).
+  \param[in]   src     Pointer to application samples
+  \param[in]   dma     Pointer to DMA buffer
+  \param[in]   i       Index of first data item
+  \param[in]   n       Number of samples
+  \param[in]   step    Data item index step
+  \param[in]   bits    Data size in bits
+*/
+static void SAI_TxFloat (const float *src, uint8_t *dma, uint32_t i, uint32_t n, uint32_t step, uint32_t bits) {
+  uint32_t k;
+  float    f;
+  int32_t  q31;
+
+  for (k = 0U; k < n; k++, i += step) {
+    f = src[k] * 2147483648.0f;
+    if      (f >=  2147483648.0f) { q31 =  0x7FFFFFFF;      }
+    else if (f <= -2147483648.0f) { q31 = (-0x7FFFFFFF - 1); }
+    else                          { q31 = (int32_t)f;        }
+    SAI_SlotWrite (dma, bits, i, (uint32_t)q31 >> (32U - bits));
+  }
+}
+
+/**
+  \fn          void SAI_TxQ31 (const int32_t *src, uint8_t *dma, uint32_t i, uint32_t n, uint32_t step, uint32_t bits)
+  \brief       Convert Q31 samples to transmit slot data.
+  \param[in]   src     Pointer to application samples
+  \param[in]   dma     Pointer to DMA buffer
+  \param[in]   i       Index of first data item
+  \param[in]   n       Number of samples
+  \param[in]   step    Data item index step
+  \param[in]   bits    Data size in bits
+*/
+static void SAI_TxQ31 (const int32_t *src, uint8_t *dma, uint32_t i, uint32_t n, uint32_t step, uint32_t bits) {
+  uint32_t k;
+
+  for (k = 0U; k < n; k++, i += step) {
+    SAI_SlotWrite (dma, bits, i, (uint32_t)src[k] >> (32U - bits));
+  }
+}
+
+/**
+  \fn          void SAI_TxQ15 (const int16_t *src, uint8_t *dma, uint32_t i, uint32_t n, uint32_t step, uint32_t bits)
+  \brief       Convert Q15 samples to transmit slot data.
+  \param[in]   src     Pointer to application samples
+  \param[in]   dma     Pointer to DMA buffer
+  \param[in]   i       Index of first data item
+  \param[in]   n       Number of samples
+  \param[in]   step    Data item index step
+  \param[in]   bits    Data size in bits
+*/
+static void SAI_TxQ15 (const int16_t *src, uint8_t *dma, uint32_t i, uint32_t n, uint32_t step, uint32_t bits) {
+  uint32_t k;
+
+  for (k = 0U; k < n; k++, i += step) {
+    SAI_SlotWrite (dma, bits, i, ((uint32_t)(uint16_t)src[k] << 16) >> (32U - bits));
+  }
+}
+
+/**
+  \fn          void SAI_TxInt24 (const int32_t *src, uint8_t *dma, uint32_t i, uint32_t n, uint32_t step, uint32_t bits)
+  \brief       Convert 24-bit integer samples to transmit slot data (saturated to 24 bits).
+  \param[in]   src     Pointer to application samples
+  \param[in]   dma     Pointer to DMA buffer
+  \param[in]   i       Index of first data item
+  \param[in]   n       Number of samples
+  \param[in]   step    Data item index step
+  \param[in]   bits    Data size in bits
+*/
+static void SAI_TxInt24 (const int32_t *src, uint8_t *dma, uint32_t i, uint32_t n, uint32_t step, uint32_t bits) {
+  uint32_t k;
+
+  for (k = 0U; k < n; k++, i += step) {
+    SAI_SlotWrite (dma, bits, i, ((uint32_t)__SSAT(src[k], 24) << 8) >> (32U - bits));
+  }
+}
+
+/**
+  \fn          void SAI_TxPacked24 (const uint8_t *src, uint8_t *dma, uint32_t i, uint32_t n, uint32_t step, uint32_t bits)
+  \brief       Convert packed 24-bit samples to transmit slot data.
+  \param[in]   src     Pointer to application samples
+  \param[in]   dma     Pointer to DMA buffer
+  \param[in]   i       Index of first data item
+  \param[in]   n       Number of samples
+  \param[in]   step    Data item index step
+  \param[in]   bits    Data size in bits
+*/
+static void SAI_TxPacked24 (const uint8_t *src, uint8_t *dma, uint32_t i, uint32_t n, uint32_t step, uint32_t bits) {
+  uint32_t k, val;
+
+  for (k = 0U; k < n; k++, i += step, src += 3U) {
+    val = ((uint32_t)src[0] << 8) | ((uint32_t)src[1] << 16) | ((uint32_t)src[2] << 24);
+    SAI_SlotWrite (dma, bits, i, val >> (32U - bits));
+  }
+}
+
+/**
+  \fn          void SAI_RxFloat (const uint8_t *dma, float *dst, uint32_t i, uint32_t n, uint32_t step, uint32_t bits)
+  \brief       Convert received slot data to float samples.
+  \param[in]   dma     Pointer to DMA buffer
+  \param[out]  dst     Pointer to application samples
+  \param[in]   i       Index of first data item
+  \param[in]   n       Number of samples
+  \param[in]   step    Data item index step
+  \param[in]   bits    Data size in bits
+*/
+static void SAI_RxFloat (const uint8_t *dma, float *dst, uint32_t i, uint32_t n, uint32_t step, uint32_t bits) {
+  uint32_t k;
+
+  for (k = 0U; k < n; k++, i += step) {
+    dst[k] = (float)(int32_t)(SAI_SlotRead (dma, bits, i) << (32U - bits)) * (1.0f / 2147483648.0f);
+  }
+}
+
+/**
+  \fn          void SAI_RxQ31 (const uint8_t *dma, int32_t *dst, uint32_t i, uint32_t n, uint32_t step, uint32_t bits)
+  \brief       Convert received slot data to Q31 samples.
+  \param[in]   dma     Pointer to DMA buffer
+  \param[out]  dst     Pointer to application samples
+  \param[in]   i       Index of first data item
+  \param[in]   n       Number of samples
+  \param[in]   step    Data item index step
+  \param[in]   bits    Data size in bits
+*/
+static void SAI_RxQ31 (const uint8_t *dma, int32_t *dst, uint32_t i, uint32_t n, uint32_t step, uint32_t bits) {
+  uint32_t k;
+
+  for (k = 0U; k < n; k++, i += step) {
+    dst[k] = (int32_t)(SAI_SlotRead (dma, bits, i) << (32U - bits));
+  }
+}
+
+/**
+  \fn          void SAI_RxQ15 (const uint8_t *dma, int16_t *dst, uint32_t i, uint32_t n, uint32_t step, uint32_t bits)
+  \brief       Convert received slot data to Q15 samples.
+  \param[in]   dma     Pointer to DMA buffer
+  \param[out]  dst     Pointer to application samples
+  \param[in]   i       Index of first data item
+  \param[in]   n       Number of samples
+  \param[in]   step    Data item index step
+  \param[in]   bits    Data size in bits
+*/
+static void SAI_RxQ15 (const uint8_t *dma, int16_t *dst, uint32_t i, uint32_t n, uint32_t step, uint32_t bits) {
+  uint32_t k;
+
+  for (k = 0U; k < n; k++, i += step) {
+    dst[k] = (int16_t)((SAI_SlotRead (dma, bits, i) << (32U - bits)) >> 16);
+  }
+}
+
+/**
+  \fn          void SAI_RxInt24 (const uint8_t *dma, int32_t *dst, uint32_t i, uint32_t n, uint32_t step, uint32_t bits)
+  \brief       Convert received slot data to 24-bit integer samples.
+  \param[in]   dma     Pointer to DMA buffer
+  \param[out]  dst     Pointer to application samples
+  \param[in]   i       Index of first data item
+  \param[in]   n       Number of samples
+  \param[in]   step    Data item index step
+  \param[in]   bits    Data size in bits
+*/
+static void SAI_RxInt24 (const uint8_t *dma, int32_t *dst, uint32_t i, uint32_t n, uint32_t step, uint32_t bits) {
+  uint32_t k;
+
+  for (k = 0U; k < n; k++, i += step) {
+    dst[k] = (int32_t)(SAI_SlotRead (dma, bits, i) << (32U - bits)) >> 8;
+  }
+}
+
+/**
+  \fn          void SAI_RxPacked24 (const uint8_t *dma, uint8_t *dst, uint32_t i, uint32_t n, uint32_t step, uint32_t bits)
+  \brief       Convert received slot data to packed 24-bit samples.
+  \param[in]   dma     Pointer to DMA buffer
+  \param[out]  dst     Pointer to application samples
+  \param[in]   i       Index of first data item
+  \param[in]   n       Number of samples
+  \param[in]   step    Data item index step
+  \param[in]   bits    Data size in bits
+*/
+static void SAI_RxPacked24 (const uint8_t *dma, uint8_t *dst, uint32_t i, uint32_t n, uint32_t step, uint32_t bits) {
+  uint32_t k, val;
+
+  for (k = 0U; k < n; k++, i += step, dst += 3U) {
+    val    = SAI_SlotRead (dma, bits, i) << (32U - bits);
+    dst[0] = (uint8_t)(val >>  8);
+    dst[1] = (uint8_t)(val >> 16);
+    dst[2] = (uint8_t)(val >> 24);
+  }
+}
+
+/**
+  \fn          void SAI_ConvertTx (SAI_STREAM *stream, uint32_t offset, uint32_t num)
+  \brief       Convert application samples to transmit slot data.
+  \param[in]   stream  Pointer to SAI stream
+  \param[in]   offset  Index of first data item (start of buffer half)
+  \param[in]   num     Number of data items
+*/
+static void SAI_ConvertTx (SAI_STREAM *stream, uint32_t offset, uint32_t num) {
+  const uint8_t  *app;
+  uint8_t        *dma;
+  uint32_t        format, bits, ch, frames, c, i, j;
+#if (defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1))
+  const int16_t  *left, *right;
+  uint32_t       *dst, f;
+#endif
+
+  app    = stream->info->app;
+  dma    = stream->info->buf;
+  format = stream->info->format & ARM_SAI_FORMAT_Msk;
+  bits   = stream->info->data_bits;
+  ch     = 1U;
+  if ((stream->info->format & ARM_SAI_FORMAT_PLANAR) != 0U) {
+    ch   = ((stream->info->format & ARM_SAI_FORMAT_CHANNELS_Msk) >> ARM_SAI_FORMAT_CHANNELS_Pos) + 1U;
+  }
+  frames = num / ch;
+
+  if (ch == 1U) {
+    // Interleaved data already in slot format
+    if ((format == ARM_SAI_FORMAT_Q31) && (bits == 32U)) {
+      memcpy(&dma[offset * 4U], &app[offset * 4U], num * 4U);
+      return;
+    }
+    if ((format == ARM_SAI_FORMAT_Q15) && (bits == 16U)) {
+      memcpy(&dma[offset * 2U], &app[offset * 2U], num * 2U);
+      return;
+    }
+  }
+
+#if (defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1))
+  if ((ch == 2U) && (format == ARM_SAI_FORMAT_Q15) && (bits == 16U) && (((uint32_t)dma & 3U) == 0U)) {
+    // Planar stereo Q15: interleave left/right halfwords with one PKHBT per frame
+    left  = (const int16_t *)app + offset;
+    right = left + frames;
+    dst   = (uint32_t *)&dma[offset * 2U];
+    for (f = 0U; f < frames; f++) {
+      dst[f] = __PKHBT((uint32_t)(uint16_t)left[f], (uint32_t)(uint16_t)right[f], 16);
+    }
+    return;
+  }
+#endif
+
+  // One kernel per application format, each channel is converted as contiguous run of samples
+  for (c = 0U; c < ch; c++) {
+    i = offset + c;                     // First slot data item of channel
+    j = offset + (c * frames);          // First application sample of channel
+    switch (format) {
+      case ARM_SAI_FORMAT_FLOAT:
+        SAI_TxFloat    (&((const float   *)app)[j], dma, i, frames, ch, bits);
+        break;
+      case ARM_SAI_FORMAT_Q31:
+        SAI_TxQ31      (&((const int32_t *)app)[j], dma, i, frames, ch, bits);
+        break;
+      case ARM_SAI_FORMAT_Q15:
+        SAI_TxQ15      (&((const int16_t *)app)[j], dma, i, frames, ch, bits);
+        break;
+      case ARM_SAI_FORMAT_INT24:
+        SAI_TxInt24    (&((const int32_t *)app)[j], dma, i, frames, ch, bits);
+        break;
+      case ARM_SAI_FORMAT_PACKED_24:
+        SAI_TxPacked24 (&app[j * 3U],               dma, i, frames, ch, bits);
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+/**
+  \fn          void SAI_ConvertRx (SAI_STREAM *stream, uint32_t offset, uint32_t num)
+  \brief       Convert received slot data to application samples.
+  \param[in]   stream  Pointer to SAI stream
+  \param[in]   offset  Index of first data item (start of buffer half)
+  \param[in]   num     Number of data items
+*/
+static void SAI_ConvertRx (SAI_STREAM *stream, uint32_t offset, uint32_t num) {
+  const uint8_t  *dma;
+  uint8_t        *app;
+  uint32_t        format, bits, ch, frames, c, i, j;
+#if (defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1))
+  const uint32_t *src;
+  uint32_t       *left, *right, f, w0, w1;
+#endif
+
+  app    = stream->info->app;
+  dma    = stream->info->buf;
+  format = stream->info->format & ARM_SAI_FORMAT_Msk;
+  bits   = stream->info->data_bits;
+  ch     = 1U;
+  if ((stream->info->format & ARM_SAI_FORMAT_PLANAR) != 0U) {
+    ch   = ((stream->info->format & ARM_SAI_FORMAT_CHANNELS_Msk) >> ARM_SAI_FORMAT_CHANNELS_Pos) + 1U;
+  }
+  frames = num / ch;
+
+  if (ch == 1U) {
+    // Slot format matches application format
+    if ((format == ARM_SAI_FORMAT_Q31) && (bits == 32U)) {
+      memcpy(&app[offset * 4U], &dma[offset * 4U], num * 4U);
+      return;
+    }
+    if ((format == ARM_SAI_FORMAT_Q15) && (bits == 16U)) {
+      memcpy(&app[offset * 2U], &dma[offset * 2U], num * 2U);
+      return;
+    }
+  }
+
+#if (defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1))
+  if ((ch == 2U) && (format == ARM_SAI_FORMAT_Q15) && (bits == 16U) && ((frames & 1U) == 0U) &&
+      ((((uint32_t)dma | (uint32_t)&app[offset * 2U]) & 3U) == 0U)) {
+    // Planar stereo Q15: deinterleave two frames into left/right halfword pairs with PKHBT/PKHTB
+    src   = (const uint32_t *)&dma[offset * 2U];
+    left  = (uint32_t *)&app[offset * 2U];
+    right = left + (frames / 2U);
+    for (f = 0U; f < (frames / 2U); f++) {
+      w0       = src[2U * f];
+      w1       = src[(2U * f) + 1U];
+      left[f]  = __PKHBT(w0, w1, 16);
+      right[f] = __PKHTB(w1, w0, 16);
+    }
+    return;
+  }
+#endif
+
+  // One kernel per application format, each channel is converted as contiguous run of samples
+  for (c = 0U; c < ch; c++) {
+    i = offset + c;                     // First slot data item of channel
+    j = offset + (c * frames);          // First application sample of channel
+    switch (format) {
+      case ARM_SAI_FORMAT_FLOAT:
+        SAI_RxFloat    (dma, &((float   *)app)[j], i, frames, ch, bits);
+        break;
+      case ARM_SAI_FORMAT_Q31:
+        SAI_RxQ31      (dma, &((int32_t *)app)[j], i, frames, ch, bits);
+        break;
+      case ARM_SAI_FORMAT_Q15:
+        SAI_RxQ15      (dma, &((int16_t *)app)[j], i, frames, ch, bits);
+        break;
+      case ARM_SAI_FORMAT_INT24:
+        SAI_RxInt24    (dma, &((int32_t *)app)[j], i, frames, ch, bits);
+        break;
+      case ARM_SAI_FORMAT_PACKED_24:
+        SAI_RxPacked24 (dma, &app[j * 3U],         i, frames, ch, bits);
+        break;
+      default:
+        break;
+    }
+  }
+}
+#endif
+
 /**
   \fn          int32_t SAI_Send (const void *data, uint32_t num, SAI_RESOURCES *sai)
   \brief       Start sending data to SAI transmitter.
@@ -997,6 +1535,17 @@ static int32_t SAI_Send (const void *data, uint32_t num, SAI_RESOURCES *sai) {
     return ARM_DRIVER_ERROR_BUSY;
   }
 
+  if ((sai->tx->info->stream != 0U) && (((num & 1U) != 0U) || (num > 0xFFFFU))) {
+    // Streaming buffer must consist of two equal halves
+    return ARM_DRIVER_ERROR_PARAMETER;
+  }
+#ifdef __SAI_DMA
+  if ((sai->tx->info->stream != 0U) && (SAI_FormatCheck (sai->tx, num) == false)) {
+    // Each buffer half must hold whole frames
+    return ARM_DRIVER_ERROR_PARAMETER;
+  }
+#endif
+
   // Set Send busy flag
   sai->info->status.tx_busy = 1U;
 
@@ -1007,10 +1556,29 @@ static int32_t SAI_Send (const void *data, uint32_t num, SAI_RESOURCES *sai) {
   sai->tx->info->buf = (uint8_t *)data;
   sai->tx->info->cnt = 0U;
   sai->tx->info->num = num;
+  sai->tx->info->margin = num / 2U;
+#ifdef __SAI_DMA
+  SAI_DriftReset (sai->tx);
+#endif
 
   // DMA mode
 #ifdef __SAI_DMA
   if (sai->tx->dma != NULL) {
+    if (sai->tx->info->stream != 0U) {
+      // Circular DMA with half and full buffer events
+      sai->tx->dma->hdma->Init.Mode            = DMA_CIRCULAR;
+      sai->tx->dma->hdma->XferHalfCpltCallback = sai->tx->dma->cb_half;
+
+      if ((sai->tx->info->format & ARM_SAI_FORMAT_Msk) != ARM_SAI_FORMAT_NONE) {
+        // Convert both halves before transfer start
+        SAI_ConvertTx (sai->tx, 0U,       num / 2U);
+        SAI_ConvertTx (sai->tx, num / 2U, num / 2U);
+      }
+    } else {
+      sai->tx->dma->hdma->Init.Mode            = DMA_NORMAL;
+      sai->tx->dma->hdma->XferHalfCpltCallback = NULL;
+    }
+
     if (sai->tx->info->data_bits > 16U) {
       sai->tx->dma->hdma->Init.PeriphDataAlignment   = DMA_PDATAALIGN_WORD;
       sai->tx->dma->hdma->Init.MemDataAlignment      = DMA_PDATAALIGN_WORD;
@@ -1069,6 +1637,17 @@ static int32_t SAI_Receive (void *data, uint32_t num, SAI_RESOURCES *sai) {
     return ARM_DRIVER_ERROR_BUSY;
   }
 
+  if ((sai->rx->info->stream != 0U) && (((num & 1U) != 0U) || (num > 0xFFFFU))) {
+    // Streaming buffer must consist of two equal halves
+    return ARM_DRIVER_ERROR_PARAMETER;
+  }
+#ifdef __SAI_DMA
+  if ((sai->rx->info->stream != 0U) && (SAI_FormatCheck (sai->rx, num) == false)) {
+    // Each buffer half must hold whole frames
+    return ARM_DRIVER_ERROR_PARAMETER;
+  }
+#endif
+
   // Set receive active flag
   sai->info->status.rx_busy = 1U;
 
@@ -1079,10 +1658,23 @@ static int32_t SAI_Receive (void *data, uint32_t num, SAI_RESOURCES *sai) {
   sai->rx->info->buf = (uint8_t *)data;
   sai->rx->info->cnt = 0U;
   sai->rx->info->num = num;
+  sai->rx->info->margin = num / 2U;
+#ifdef __SAI_DMA
+  SAI_DriftReset (sai->rx);
+#endif
 
   // DMA mode
 #ifdef __SAI_DMA
   if (sai->rx->dma != NULL) {
+    if (sai->rx->info->stream != 0U) {
+      // Circular DMA with half and full buffer events
+      sai->rx->dma->hdma->Init.Mode            = DMA_CIRCULAR;
+      sai->rx->dma->hdma->XferHalfCpltCallback = sai->rx->dma->cb_half;
+    } else {
+      sai->rx->dma->hdma->Init.Mode            = DMA_NORMAL;
+      sai->rx->dma->hdma->XferHalfCpltCallback = NULL;
+    }
+
     if (sai->rx->info->data_bits > 16U) {
       sai->rx->dma->hdma->Init.PeriphDataAlignment   = DMA_PDATAALIGN_WORD;
       sai->rx->dma->hdma->Init.MemDataAlignment      = DMA_PDATAALIGN_WORD;
@@ -1150,6 +1742,188 @@ static uint32_t SAI_GetRxCount (SAI_RESOURCES *sai) {
   }
 }
 
+#ifdef __SAI_DMA
+/**
+  \fn          int32_t SAI_DuplexStreamStart (SAI_STREAM *stream, uint32_t src, uint32_t dst)
+  \brief       Start circular DMA of one stream for full-duplex streaming.
+  \param[in]   stream  Pointer to SAI stream
+  \param[in]   src     DMA source address
+  \param[in]   dst     DMA destination address
+  \return      \ref execution_status
+*/
+static int32_t SAI_DuplexStreamStart (SAI_STREAM *stream, uint32_t src, uint32_t dst) {
+
+  if (stream->info->data_bits > 16U) {
+    stream->dma->hdma->Init.PeriphDataAlignment   = DMA_PDATAALIGN_WORD;
+    stream->dma->hdma->Init.MemDataAlignment      = DMA_PDATAALIGN_WORD;
+  } else {
+    if (stream->info->data_bits > 8U) {
+      stream->dma->hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+      stream->dma->hdma->Init.MemDataAlignment    = DMA_PDATAALIGN_HALFWORD;
+    } else {
+      stream->dma->hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+      stream->dma->hdma->Init.MemDataAlignment    = DMA_PDATAALIGN_BYTE;
+    }
+  }
+  stream->dma->hdma->Init.Mode = DMA_CIRCULAR;
+
+  if (HAL_DMA_Init     (stream->dma->hdma) != HAL_OK) { return ARM_DRIVER_ERROR; }
+  if (HAL_DMA_Start_IT (stream->dma->hdma, src, dst, stream->info->num) != HAL_OK) {
+    return ARM_DRIVER_ERROR;
+  }
+
+  // DMA enable
+  stream->reg->CR1 |= SAI_xCR1_DMAEN;
+
+  return ARM_DRIVER_OK;
+}
+
+/**
+  \fn          int32_t SAI_DuplexStop (SAI_RESOURCES *sai)
+  \brief       Stop full-duplex streaming.
+  \param[in]   sai  Pointer to SAI resources
+  \return      \ref execution_status
+*/
+static int32_t SAI_DuplexStop (SAI_RESOURCES *sai) {
+  SAI_STREAM *stream[2];
+  uint32_t    i;
+
+  sai->info->flags &= ~SAI_FLAG_DUPLEX;
+
+  // Synchronous block is disabled first, while the clock master still generates frames
+  if ((sai->rx->reg->CR1 & SAI_xCR1_SYNCEN) != 0U) {
+    stream[0] = sai->rx;
+    stream[1] = sai->tx;
+  } else {
+    stream[0] = sai->tx;
+    stream[1] = sai->rx;
+  }
+
+  for (i = 0U; i < 2U; i++) {
+    stream[i]->reg->IMR &= ~SAI_xIMR_OVRUDRIE;
+
+    stream[i]->reg->CR1 &= ~SAI_xCR1_SAIEN;
+    while ((stream[i]->reg->CR1 & SAI_xCR1_SAIEN) != 0U);
+
+    // Disable DMA
+    stream[i]->reg->CR1 &= ~SAI_xCR1_DMAEN;
+    HAL_DMA_Abort (stream[i]->dma->hdma);
+
+    // Flush FIFO
+    stream[i]->reg->CR2 |= SAI_xCR2_FFLUSH;
+
+    // Reset counters
+    stream[i]->info->cnt = 0U;
+    stream[i]->info->num = 0U;
+  }
+
+  sai->info->cb_duplex      = NULL;
+  sai->info->status.tx_busy = 0U;
+  sai->info->status.rx_busy = 0U;
+
+  return ARM_DRIVER_OK;
+}
+
+/**
+  \fn          int32_t SAI_DuplexStart (const SAI_DUPLEX *duplex, SAI_RESOURCES *sai)
+  \brief       Start synchronized full-duplex streaming on both SAI sub-blocks.
+  \param[in]   duplex  Pointer to full-duplex streaming configuration
+  \param[in]   sai     Pointer to SAI resources
+  \return      common \ref execution_status and driver specific \ref sai_execution_status
+*/
+static int32_t SAI_DuplexStart (const SAI_DUPLEX *duplex, SAI_RESOURCES *sai) {
+  SAI_STREAM *sync, *clk;
+
+  if ((duplex == NULL) || (duplex->tx_data == NULL) || (duplex->rx_data == NULL) || (duplex->cb_process == NULL) ||
+      (duplex->num == 0U) || ((duplex->num & 1U) != 0U) || (duplex->num > 0xFFFFU)) {
+    return ARM_DRIVER_ERROR_PARAMETER;
+  }
+
+  if ((sai->rx->dma == NULL) || (sai->tx->dma == NULL)) {
+    // Both sub-blocks require DMA
+    return ARM_DRIVER_ERROR_UNSUPPORTED;
+  }
+
+  if ((SAI_FormatCheck (sai->rx, duplex->num) == false) || (SAI_FormatCheck (sai->tx, duplex->num) == false)) {
+    // Each buffer half must hold whole frames
+    return ARM_DRIVER_ERROR_PARAMETER;
+  }
+
+  if ((sai->info->flags & SAI_FLAG_CONFIGURED) == 0U) {
+    // SAI is not configured (mode not selected)
+    return ARM_DRIVER_ERROR;
+  }
+
+  if ((sai->info->status.tx_busy != 0U) || (sai->info->status.rx_busy != 0U) ||
+     (((sai->rx->reg->CR1 | sai->tx->reg->CR1) & SAI_xCR1_SAIEN) != 0U)) {
+    // Transfer active or sub-block already enabled
+    return ARM_DRIVER_ERROR_BUSY;
+  }
+
+  // One sub-block must be synchronous with the other (asynchronous) sub-block
+  if ((sai->rx->reg->CR1 & SAI_xCR1_SYNCEN) == SAI_xCR1_SYNCEN_0) {
+    sync = sai->rx;
+    clk  = sai->tx;
+  } else {
+    sync = sai->tx;
+    clk  = sai->rx;
+  }
+  if (((sync->reg->CR1 & SAI_xCR1_SYNCEN) != SAI_xCR1_SYNCEN_0) ||
+      ((clk->reg->CR1  & SAI_xCR1_SYNCEN) != 0U)) {
+    return ARM_SAI_ERROR_SYNCHRONIZATION;
+  }
+
+  sai->info->status.tx_busy      = 1U;
+  sai->info->status.rx_busy      = 1U;
+  sai->info->status.tx_underflow = 0U;
+  sai->info->status.rx_overflow  = 0U;
+  sai->info->cb_duplex           = duplex->cb_process;
+
+  // Save buffer info
+  sai->rx->info->buf       = (uint8_t *)duplex->rx_data;
+  sai->rx->info->cnt       = 0U;
+  sai->rx->info->num       = duplex->num;
+  sai->rx->info->margin    = duplex->num / 2U;
+  sai->rx->info->watermark = duplex->watermark;
+  sai->tx->info->buf       = (uint8_t *)duplex->tx_data;
+  sai->tx->info->cnt       = 0U;
+  sai->tx->info->num       = duplex->num;
+  sai->tx->info->margin    = duplex->num / 2U;
+  sai->tx->info->watermark = duplex->watermark;
+  SAI_DriftReset (sai->rx);
+  SAI_DriftReset (sai->tx);
+
+  if ((sai->tx->info->format & ARM_SAI_FORMAT_Msk) != ARM_SAI_FORMAT_NONE) {
+    // Convert both transmit halves before transfer start
+    SAI_ConvertTx (sai->tx, 0U,               duplex->num / 2U);
+    SAI_ConvertTx (sai->tx, duplex->num / 2U, duplex->num / 2U);
+  }
+
+  sai->info->flags |= SAI_FLAG_DUPLEX;
+
+  // Receive DMA half and full events drive frame processing
+  sai->rx->dma->hdma->XferHalfCpltCallback = sai->rx->dma->cb_half;
+  sai->tx->dma->hdma->XferHalfCpltCallback = NULL;
+
+  if ((SAI_DuplexStreamStart (sai->rx, (uint32_t)(&sai->rx->reg->DR), (uint32_t)sai->rx->info->buf) != ARM_DRIVER_OK) ||
+      (SAI_DuplexStreamStart (sai->tx, (uint32_t)sai->tx->info->buf, (uint32_t)(&sai->tx->reg->DR)) != ARM_DRIVER_OK)) {
+    SAI_DuplexStop (sai);
+    return ARM_DRIVER_ERROR;
+  }
+  __HAL_DMA_DISABLE_IT (sai->tx->dma->hdma, DMA_IT_TC);
+
+  sync->reg->IMR |= SAI_xIMR_OVRUDRIE;
+  clk->reg->IMR  |= SAI_xIMR_OVRUDRIE;
+
+  // Synchronous block is enabled first and starts with the first frame of the clock master,
+  // both DMA streams then stay at the same buffer position
+  sync->reg->CR1 |= SAI_xCR1_SAIEN;
+  clk->reg->CR1  |= SAI_xCR1_SAIEN;
+
+  return ARM_DRIVER_OK;
+}
+#endif
+
 /**
   \fn          int32_t SAI_Control (uint32_t control, uint32_t arg1, uint32_t arg2, SAI_RESOURCES *sai)
   \brief       Control SAI Interface.
@@ -1317,6 +2091,12 @@ static int32_t SAI_Control (uint32_t control, uint32_t arg1, uint32_t arg2, SAI_
 
     case ARM_SAI_ABORT_SEND:
       stream = sai->tx;
+#ifdef __SAI_DMA
+      if ((sai->info->flags & SAI_FLAG_DUPLEX) != 0U) {
+        // Full-duplex streaming: stop both sub-blocks
+        return SAI_DuplexStop (sai);
+      }
+#endif
       // Disable FIFO request interrupt
       stream->reg->IMR &= ~SAI_xIMR_FREQIE;
 
@@ -1346,6 +2126,12 @@ static int32_t SAI_Control (uint32_t control, uint32_t arg1, uint32_t arg2, SAI_
 
     case ARM_SAI_ABORT_RECEIVE:
       stream = sai->rx;
+#ifdef __SAI_DMA
+      if ((sai->info->flags & SAI_FLAG_DUPLEX) != 0U) {
+        // Full-duplex streaming: stop both sub-blocks
+        return SAI_DuplexStop (sai);
+      }
+#endif
       // Disable FIFO request interrupt
       stream->reg->IMR &= ~SAI_xIMR_FREQIE;
 
@@ -1372,6 +2158,162 @@ static int32_t SAI_Control (uint32_t control, uint32_t arg1, uint32_t arg2, SAI_
       sai->info->status.rx_busy = 0U;
       return ARM_DRIVER_OK;
 
+    case ARM_SAI_CONTROL_STREAM_TX:
+      stream = sai->tx;
+#ifdef __SAI_DMA
+      if (stream->dma == NULL) { return ARM_DRIVER_ERROR_UNSUPPORTED; }
+
+      if (sai->info->status.tx_busy != 0U) { return ARM_DRIVER_ERROR_BUSY; }
+
+      stream->info->stream    = (arg1 != 0U) ? 1U : 0U;
+      stream->info->watermark = arg2;
+      return ARM_DRIVER_OK;
+#else
+      return ARM_DRIVER_ERROR_UNSUPPORTED;
+#endif
+
+    case ARM_SAI_CONTROL_STREAM_RX:
+      stream = sai->rx;
+#ifdef __SAI_DMA
+      if (stream->dma == NULL) { return ARM_DRIVER_ERROR_UNSUPPORTED; }
+
+      if (sai->info->status.rx_busy != 0U) { return ARM_DRIVER_ERROR_BUSY; }
+
+      stream->info->stream    = (arg1 != 0U) ? 1U : 0U;
+      stream->info->watermark = arg2;
+      return ARM_DRIVER_OK;
+#else
+      return ARM_DRIVER_ERROR_UNSUPPORTED;
+#endif
+
+    case ARM_SAI_DUPLEX_START:
+#ifdef __SAI_DMA
+      return SAI_DuplexStart ((const SAI_DUPLEX *)arg1, sai);
+#else
+      return ARM_DRIVER_ERROR_UNSUPPORTED;
+#endif
+
+    case ARM_SAI_DUPLEX_STOP:
+#ifdef __SAI_DMA
+      return SAI_DuplexStop (sai);
+#else
+      return ARM_DRIVER_ERROR_UNSUPPORTED;
+#endif
+
+    case ARM_SAI_CONTROL_FORMAT_TX:
+      stream = sai->tx;
+#ifdef __SAI_DMA
+      if (sai->info->status.tx_busy != 0U) { return ARM_DRIVER_ERROR_BUSY; }
+
+      if (((arg1 & ARM_SAI_FORMAT_Msk) > ARM_SAI_FORMAT_PACKED_24) ||
+         (((arg1 & ARM_SAI_FORMAT_Msk) != ARM_SAI_FORMAT_NONE) && (arg2 == 0U))) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+      }
+
+      stream->info->format = arg1;
+      stream->info->app    = (uint8_t *)arg2;
+      return ARM_DRIVER_OK;
+#else
+      return ARM_DRIVER_ERROR_UNSUPPORTED;
+#endif
+
+    case ARM_SAI_CONTROL_FORMAT_RX:
+      stream = sai->rx;
+#ifdef __SAI_DMA
+      if (sai->info->status.rx_busy != 0U) { return ARM_DRIVER_ERROR_BUSY; }
+
+      if (((arg1 & ARM_SAI_FORMAT_Msk) > ARM_SAI_FORMAT_PACKED_24) ||
+         (((arg1 & ARM_SAI_FORMAT_Msk) != ARM_SAI_FORMAT_NONE) && (arg2 == 0U))) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+      }
+
+      stream->info->format = arg1;
+      stream->info->app    = (uint8_t *)arg2;
+      return ARM_DRIVER_OK;
+#else
+      return ARM_DRIVER_ERROR_UNSUPPORTED;
+#endif
+
+    case ARM_SAI_CONTROL_DRIFT_TX:
+      stream = sai->tx;
+#ifdef __SAI_DMA
+      if (arg2 == 0U) { arg2 = 1000U; }
+      if ((((uint64_t)SystemCoreClock * arg2) / 1000U) > 0x7FFFFFFFU) {
+        // Window plus one buffer half period must fit into 32-bit cycle count
+        return ARM_DRIVER_ERROR_PARAMETER;
+      }
+
+      if (arg1 != 0U) {
+        // Enable cycle counter as time reference
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->LAR          = 0xC5ACCE55U;
+        DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+      }
+
+      stream->info->drift.rate   = arg1;
+      stream->info->drift.window = (uint32_t)(((uint64_t)SystemCoreClock * arg2) / 1000U);
+      SAI_DriftReset (stream);
+      return ARM_DRIVER_OK;
+#else
+      return ARM_DRIVER_ERROR_UNSUPPORTED;
+#endif
+
+    case ARM_SAI_CONTROL_DRIFT_RX:
+      stream = sai->rx;
+#ifdef __SAI_DMA
+      if (arg2 == 0U) { arg2 = 1000U; }
+      if ((((uint64_t)SystemCoreClock * arg2) / 1000U) > 0x7FFFFFFFU) {
+        // Window plus one buffer half period must fit into 32-bit cycle count
+        return ARM_DRIVER_ERROR_PARAMETER;
+      }
+
+      if (arg1 != 0U) {
+        // Enable cycle counter as time reference
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->LAR          = 0xC5ACCE55U;
+        DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+      }
+
+      stream->info->drift.rate   = arg1;
+      stream->info->drift.window = (uint32_t)(((uint64_t)SystemCoreClock * arg2) / 1000U);
+      SAI_DriftReset (stream);
+      return ARM_DRIVER_OK;
+#else
+      return ARM_DRIVER_ERROR_UNSUPPORTED;
+#endif
+
+    case ARM_SAI_GET_TX_DRIFT:
+      stream = sai->tx;
+      if (arg1 == 0U) { return ARM_DRIVER_ERROR_PARAMETER; }
+      if (stream->info->drift.state != 2U) {
+        // No estimate yet
+        return ARM_DRIVER_ERROR;
+      }
+      *(int32_t *)arg1 = stream->info->drift.ppb;
+      return ARM_DRIVER_OK;
+
+    case ARM_SAI_GET_RX_DRIFT:
+      stream = sai->rx;
+      if (arg1 == 0U) { return ARM_DRIVER_ERROR_PARAMETER; }
+      if (stream->info->drift.state != 2U) {
+        // No estimate yet
+        return ARM_DRIVER_ERROR;
+      }
+      *(int32_t *)arg1 = stream->info->drift.ppb;
+      return ARM_DRIVER_OK;
+
+    case ARM_SAI_GET_TX_MARGIN:
+      stream = sai->tx;
+      val = stream->info->margin;
+      stream->info->margin = stream->info->num / 2U;
+      return ((int32_t)val);
+
+    case ARM_SAI_GET_RX_MARGIN:
+      stream = sai->rx;
+      val = stream->info->margin;
+      stream->info->margin = stream->info->num / 2U;
+      return ((int32_t)val);
+
     default: return ARM_DRIVER_ERROR;
   }
 
@@ -1872,13 +2814,155 @@ void SAI_IRQHandler (SAI_RESOURCES *sai) {
   }
 }
 
+#ifdef __SAI_DMA
+/**
+  \fn          uint32_t SAI_StreamMargin (SAI_STREAM *stream, uint32_t boundary)
+  \brief       Get number of data items DMA transfers before it re-enters the released buffer half.
+  \param[in]   stream    Pointer to SAI stream
+  \param[in]   boundary  Buffer position where DMA entered the other half (0 or num/2)
+  \return      margin in data items
+*/
+static uint32_t SAI_StreamMargin (SAI_STREAM *stream, uint32_t boundary) {
+  uint32_t num, pos, used;
+
+  num  = stream->info->num;
+  pos  = num - __HAL_DMA_GET_COUNTER(stream->dma->hdma);
+  used = (pos + num - boundary) % num;
+
+  if (used >= (num / 2U)) { return 0U; }
+
+  return ((num / 2U) - used);
+}
+
+/**
+  \fn          void SAI_StreamEvent (SAI_RESOURCES *sai,
+                                     SAI_STREAM    *stream,
+                                     uint32_t       event,
+                                     uint32_t       event_late,
+                                     uint32_t       boundary)
+  \brief       Signal buffer half event in streaming mode and check margin against watermark.
+  \param[in]   sai         Pointer to SAI resources
+  \param[in]   stream      Pointer to SAI stream
+  \param[in]   event       Buffer half event
+  \param[in]   event_late  Event signaled when margin is below watermark
+  \param[in]   boundary    Buffer position where DMA entered the other half (0 or num/2)
+*/
+static void SAI_StreamEvent (SAI_RESOURCES *sai,
+                             SAI_STREAM    *stream,
+                             uint32_t       event,
+                             uint32_t       event_late,
+                             uint32_t       boundary) {
+  uint32_t margin, half, offset;
+
+  SAI_DriftUpdate (stream);
+
+  // Released half is the one DMA has just left
+  half   = stream->info->num / 2U;
+  offset = (boundary == 0U) ? half : 0U;
+
+  if ((stream == sai->rx) && ((stream->info->format & ARM_SAI_FORMAT_Msk) != ARM_SAI_FORMAT_NONE)) {
+    SAI_ConvertRx (stream, offset, half);
+  }
+
+  if (sai->info->cb_event != NULL) {
+    sai->info->cb_event(event);
+  }
+
+  if (stream->info->num == 0U) {
+    // Stream aborted in callback
+    return;
+  }
+
+  if ((stream == sai->tx) && ((stream->info->format & ARM_SAI_FORMAT_Msk) != ARM_SAI_FORMAT_NONE)) {
+    SAI_ConvertTx (stream, offset, half);
+  }
+
+  // Margin left after interrupt latency, event processing and conversion
+  margin = SAI_StreamMargin (stream, boundary);
+  if (margin < stream->info->margin) {
+    stream->info->margin = margin;
+  }
+
+  if ((margin < stream->info->watermark) && (sai->info->cb_event != NULL)) {
+    sai->info->cb_event(event_late);
+  }
+}
+#endif
+
 #if ((defined(MX_SAI1_A_DMA_Instance) && (SAI1_RX_BLOCK == SAI_BLOCK_A)) || \
      (defined(MX_SAI1_B_DMA_Instance) && (SAI1_RX_BLOCK == SAI_BLOCK_B)) || \
      (defined(MX_SAI2_A_DMA_Instance) && (SAI2_RX_BLOCK == SAI_BLOCK_A)) || \
      (defined(MX_SAI2_B_DMA_Instance) && (SAI2_RX_BLOCK == SAI_BLOCK_B)))
+/**
+  \fn          void SAI_DuplexEvent (SAI_RESOURCES *sai, uint32_t boundary)
+  \brief       Process released receive and transmit buffer halves in full-duplex streaming.
+  \param[in]   sai       Pointer to SAI resources
+  \param[in]   boundary  Buffer position where receive DMA entered the other half (0 or num/2)
+*/
+static void SAI_DuplexEvent (SAI_RESOURCES *sai, uint32_t boundary) {
+  uint32_t half, offset, margin, event;
+  uint8_t *rx_data, *tx_data;
+
+  // Both blocks share the frame clock: receive side is measured
+  SAI_DriftUpdate (sai->rx);
+
+  // Released half is the one DMA has just left
+  half    = sai->rx->info->num / 2U;
+  offset  = (boundary == 0U) ? half : 0U;
+  rx_data = sai->rx->info->buf + (offset * ((sai->rx->info->data_bits > 16U) ? 4U : (sai->rx->info->data_bits > 8U) ? 2U : 1U));
+  tx_data = sai->tx->info->buf + (offset * ((sai->tx->info->data_bits > 16U) ? 4U : (sai->tx->info->data_bits > 8U) ? 2U : 1U));
+
+  if ((sai->rx->info->format & ARM_SAI_FORMAT_Msk) != ARM_SAI_FORMAT_NONE) {
+    SAI_ConvertRx (sai->rx, offset, half);
+    rx_data = sai->rx->info->app + (offset * SAI_FormatSize (sai->rx->info->format));
+  }
+  if ((sai->tx->info->format & ARM_SAI_FORMAT_Msk) != ARM_SAI_FORMAT_NONE) {
+    tx_data = sai->tx->info->app + (offset * SAI_FormatSize (sai->tx->info->format));
+  }
+
+  sai->info->cb_duplex (rx_data, tx_data, half);
+
+  if ((sai->info->flags & SAI_FLAG_DUPLEX) == 0U) {
+    // Streaming stopped in callback
+    return;
+  }
+
+  if ((sai->tx->info->format & ARM_SAI_FORMAT_Msk) != ARM_SAI_FORMAT_NONE) {
+    SAI_ConvertTx (sai->tx, offset, half);
+  }
+
+  // Margin left after interrupt latency, frame processing and conversion
+  event  = 0U;
+  margin = SAI_StreamMargin (sai->rx, boundary);
+  if (margin < sai->rx->info->margin)    { sai->rx->info->margin = margin; }
+  if (margin < sai->rx->info->watermark) { event |= ARM_SAI_EVENT_RX_LATE; }
+
+  margin = SAI_StreamMargin (sai->tx, boundary);
+  if (margin < sai->tx->info->margin)    { sai->tx->info->margin = margin; }
+  if (margin < sai->tx->info->watermark) { event |= ARM_SAI_EVENT_TX_LATE; }
+
+  if ((event != 0U) && (sai->info->cb_event != NULL)) {
+    sai->info->cb_event(event);
+  }
+}
+
 /* SAI RX DMA Handler */
 void SAI_RX_DMA_Complete (SAI_RESOURCES *sai) {
 
+  if ((sai->info->flags & SAI_FLAG_DUPLEX) != 0U) {
+    // Second halves received and sent
+    SAI_DuplexEvent (sai, 0U);
+    return;
+  }
+
+  if (sai->rx->info->stream != 0U) {
+    if (sai->info->status.rx_busy != 0U) {
+      // Second half received, DMA continues with first half
+      SAI_StreamEvent (sai, sai->rx, ARM_SAI_EVENT_RECEIVE_COMPLETE, ARM_SAI_EVENT_RX_LATE, 0U);
+    }
+    return;
+  }
+
   if ((__HAL_DMA_GET_COUNTER(sai->rx->dma->hdma) != 0) && (sai->rx->info->num != 0)) {
     // RX DMA Complete caused by transfer abort
     return;
@@ -1891,6 +2975,21 @@ void SAI_RX_DMA_Complete (SAI_RESOURCES *sai) {
     sai->info->cb_event(ARM_SAI_EVENT_RECEIVE_COMPLETE);
   }
 }
+
+/* SAI RX DMA Half Transfer Handler */
+void SAI_RX_DMA_HalfComplete (SAI_RESOURCES *sai) {
+
+  if ((sai->info->flags & SAI_FLAG_DUPLEX) != 0U) {
+    // First halves received and sent
+    SAI_DuplexEvent (sai, sai->rx->info->num / 2U);
+    return;
+  }
+
+  if ((sai->rx->info->stream != 0U) && (sai->info->status.rx_busy != 0U)) {
+    // First half received, DMA continues with second half
+    SAI_StreamEvent (sai, sai->rx, ARM_SAI_EVENT_RX_HALF, ARM_SAI_EVENT_RX_LATE, sai->rx->info->num / 2U);
+  }
+}
 #endif
 
 
@@ -1901,6 +3000,19 @@ void SAI_RX_DMA_Complete (SAI_RESOURCES *sai) {
 /* SAI TX DMA Handler */
 void SAI_TX_DMA_Complete (SAI_RESOURCES *sai) {
 
+  if ((sai->info->flags & SAI_FLAG_DUPLEX) != 0U) {
+    // Full-duplex streaming is driven by receive DMA
+    return;
+  }
+
+  if (sai->tx->info->stream != 0U) {
+    if (sai->info->status.tx_busy != 0U) {
+      // Second half sent, DMA continues with first half
+      SAI_StreamEvent (sai, sai->tx, ARM_SAI_EVENT_SEND_COMPLETE, ARM_SAI_EVENT_TX_LATE, 0U);
+    }
+    return;
+  }
+
   if ((__HAL_DMA_GET_COUNTER(sai->tx->dma->hdma) != 0) && (sai->tx->info->num != 0)) {
     // TX DMA Complete caused by transfer abort
     return;
@@ -1913,6 +3025,15 @@ void SAI_TX_DMA_Complete (SAI_RESOURCES *sai) {
     sai->info->cb_event(ARM_SAI_EVENT_SEND_COMPLETE);
   }
 }
+
+/* SAI TX DMA Half Transfer Handler */
+void SAI_TX_DMA_HalfComplete (SAI_RESOURCES *sai) {
+
+  if ((sai->tx->info->stream != 0U) && (sai->info->status.tx_busy != 0U)) {
+    // First half sent, DMA continues with second half
+    SAI_StreamEvent (sai, sai->tx, ARM_SAI_EVENT_TX_HALF, ARM_SAI_EVENT_TX_LATE, sai->tx->info->num / 2U);
+  }
+}
 #endif
 
 
@@ -1940,6 +3061,15 @@ void SAI1_A_DMA_Complete (DMA_HandleTypeDef *hdma) {
 #endif
 }
 
+void SAI1_A_DMA_HalfComplete (DMA_HandleTypeDef *hdma) {
+#if (SAI1_RX_BLOCK == SAI_BLOCK_A)
+  SAI_RX_DMA_HalfComplete (&SAI1_Resources);
+#endif
+#if (SAI1_TX_BLOCK == SAI_BLOCK_A)
+  SAI_TX_DMA_HalfComplete (&SAI1_Resources);
+#endif
+}
+
 #ifdef RTE_DEVICE_FRAMEWORK_CLASSIC
 void SAI1_A_DMA_Handler (void) {
   HAL_NVIC_ClearPendingIRQ(MX_SAI1_A_DMA_IRQn);
@@ -1958,6 +3088,15 @@ void SAI1_B_DMA_Complete (DMA_HandleTypeDef *hdma) {
 #endif
 }
 
+void SAI1_B_DMA_HalfComplete (DMA_HandleTypeDef *hdma) {
+#if (SAI1_RX_BLOCK == SAI_BLOCK_B)
+  SAI_RX_DMA_HalfComplete (&SAI1_Resources);
+#endif
+#if (SAI1_TX_BLOCK == SAI_BLOCK_B)
+  SAI_TX_DMA_HalfComplete (&SAI1_Resources);
+#endif
+}
+
 #ifdef RTE_DEVICE_FRAMEWORK_CLASSIC
 void SAI1_B_DMA_Handler (void) {
   HAL_NVIC_ClearPendingIRQ(MX_SAI1_B_DMA_IRQn);
@@ -2007,6 +3146,15 @@ void SAI2_A_DMA_Complete (DMA_HandleTypeDef *hdma) {
 #endif
 }
 
+void SAI2_A_DMA_HalfComplete (DMA_HandleTypeDef *hdma) {
+#if (SAI2_RX_BLOCK == SAI_BLOCK_A)
+  SAI_RX_DMA_HalfComplete (&SAI2_Resources);
+#endif
+#if (SAI2_TX_BLOCK == SAI_BLOCK_A)
+  SAI_TX_DMA_HalfComplete (&SAI2_Resources);
+#endif
+}
+
 #ifdef RTE_DEVICE_FRAMEWORK_CLASSIC
 void SAI2_A_DMA_Handler (void) {
   HAL_NVIC_ClearPendingIRQ(MX_SAI2_A_DMA_IRQn);
@@ -2025,6 +3173,15 @@ void SAI2_B_DMA_Complete (DMA_HandleTypeDef *hdma) {
 #endif
 }
 
+void SAI2_B_DMA_HalfComplete (DMA_HandleTypeDef *hdma) {
+#if (SAI2_RX_BLOCK == SAI_BLOCK_B)
+  SAI_RX_DMA_HalfComplete (&SAI2_Resources);
+#endif
+#if (SAI2_TX_BLOCK == SAI_BLOCK_B)
+  SAI_TX_DMA_HalfComplete (&SAI2_Resources);
+#endif
+}
+
 #ifdef RTE_DEVICE_FRAMEWORK_CLASSIC
 void SAI2_B_DMA_Handler (void) {
   HAL_NVIC_ClearPendingIRQ(MX_SAI2_B_DMA_IRQn);
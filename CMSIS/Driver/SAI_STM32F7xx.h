@@ -299,14 +299,73 @@
 #define SAI_SYNC_SRC_INTERNAL_SUB_BLOCK (1U)
 #define SAI_SYNC_SRC_EXTERNAL_SAI       (2U)
 
+// Driver specific control codes
+#define ARM_SAI_CONTROL_STREAM_TX       (0x20UL << ARM_SAI_CONTROL_Pos)     ///< Circular DMA streaming transmit; arg1: 0=disabled, 1=enabled; arg2 = refill watermark in data items (0 = disabled)
+#define ARM_SAI_CONTROL_STREAM_RX       (0x21UL << ARM_SAI_CONTROL_Pos)     ///< Circular DMA streaming receive; arg1: 0=disabled, 1=enabled; arg2 = processing watermark in data items (0 = disabled)
+#define ARM_SAI_GET_TX_MARGIN           (0x22UL << ARM_SAI_CONTROL_Pos)     ///< Get lowest transmit refill margin in data items since last call; arg1, arg2 = not used
+#define ARM_SAI_GET_RX_MARGIN           (0x23UL << ARM_SAI_CONTROL_Pos)     ///< Get lowest receive processing margin in data items since last call; arg1, arg2 = not used
+#define ARM_SAI_DUPLEX_START            (0x24UL << ARM_SAI_CONTROL_Pos)     ///< Start synchronized full-duplex streaming; arg1 = pointer to SAI_DUPLEX
+#define ARM_SAI_DUPLEX_STOP             (0x25UL << ARM_SAI_CONTROL_Pos)     ///< Stop full-duplex streaming; arg1, arg2 = not used
+#define ARM_SAI_CONTROL_FORMAT_TX       (0x26UL << ARM_SAI_CONTROL_Pos)     ///< Transmit sample format conversion (streaming modes); arg1 = format, arg2 = pointer to application buffer
+#define ARM_SAI_CONTROL_FORMAT_RX       (0x27UL << ARM_SAI_CONTROL_Pos)     ///< Receive sample format conversion (streaming modes); arg1 = format, arg2 = pointer to application buffer
+#define ARM_SAI_CONTROL_DRIFT_TX        (0x28UL << ARM_SAI_CONTROL_Pos)     ///< Transmit sample rate drift measurement (streaming modes); arg1 = nominal data items per second (0 = disabled), arg2 = window in ms (0 = 1000, up to 2^31 core clock cycles)
+#define ARM_SAI_CONTROL_DRIFT_RX        (0x29UL << ARM_SAI_CONTROL_Pos)     ///< Receive sample rate drift measurement (streaming modes); arg1 = nominal data items per second (0 = disabled), arg2 = window in ms (0 = 1000, up to 2^31 core clock cycles)
+#define ARM_SAI_GET_TX_DRIFT            (0x2AUL << ARM_SAI_CONTROL_Pos)     ///< Get transmit drift estimate; arg1 = pointer to int32_t (parts per billion, positive = faster than nominal)
+#define ARM_SAI_GET_RX_DRIFT            (0x2BUL << ARM_SAI_CONTROL_Pos)     ///< Get receive drift estimate; arg1 = pointer to int32_t (parts per billion, positive = faster than nominal)
+
+// ARM_SAI_CONTROL_FORMAT_TX/RX: application sample format (arg1)
+#define ARM_SAI_FORMAT_Pos               0
+#define ARM_SAI_FORMAT_Msk              (0xFUL << ARM_SAI_FORMAT_Pos)
+#define ARM_SAI_FORMAT_NONE             (0UL << ARM_SAI_FORMAT_Pos)         ///< No conversion (default)
+#define ARM_SAI_FORMAT_FLOAT            (1UL << ARM_SAI_FORMAT_Pos)         ///< 32-bit float, full scale -1.0 .. +1.0
+#define ARM_SAI_FORMAT_Q31              (2UL << ARM_SAI_FORMAT_Pos)         ///< 32-bit fixed point Q31 (left aligned)
+#define ARM_SAI_FORMAT_Q15              (3UL << ARM_SAI_FORMAT_Pos)         ///< 16-bit fixed point Q15
+#define ARM_SAI_FORMAT_INT24            (4UL << ARM_SAI_FORMAT_Pos)         ///< 24-bit in 32-bit word, right aligned and sign extended
+#define ARM_SAI_FORMAT_PACKED_24        (5UL << ARM_SAI_FORMAT_Pos)         ///< 24-bit packed in 3 bytes, little endian
+#define ARM_SAI_FORMAT_PLANAR           (1UL << 4)                          ///< Each application buffer half holds channels one after another
+#define ARM_SAI_FORMAT_CHANNELS_Pos      8
+#define ARM_SAI_FORMAT_CHANNELS_Msk     (0x1FUL << ARM_SAI_FORMAT_CHANNELS_Pos)
+#define ARM_SAI_FORMAT_CHANNELS(n)      ((((n) - 1UL) & 0x1FUL) << ARM_SAI_FORMAT_CHANNELS_Pos)  ///< Number of channels (slots) per frame: 1..32
+
+// Driver specific events
+#define ARM_SAI_EVENT_TX_HALF           (1UL << 8)      ///< First half of transmit buffer sent (streaming mode)
+#define ARM_SAI_EVENT_RX_HALF           (1UL << 9)      ///< First half of receive buffer received (streaming mode)
+#define ARM_SAI_EVENT_TX_LATE           (1UL << 10)     ///< Transmit refill margin below watermark: underrun predicted (streaming mode)
+#define ARM_SAI_EVENT_RX_LATE           (1UL << 11)     ///< Receive processing margin below watermark: overwrite predicted (streaming mode)
+
+// Full-duplex frame process callback: called with released receive and transmit buffer halves
+typedef void (*SAI_SignalDuplex_t) (const void *rx_data, void *tx_data, uint32_t num);
+
+// Full-duplex streaming configuration (ARM_SAI_DUPLEX_START)
+typedef struct _SAI_DUPLEX {
+  const void             *tx_data;      // Transmit buffer (two halves)
+        void             *rx_data;      // Receive buffer (two halves)
+  uint32_t                num;          // Number of data items in each buffer (even)
+  uint32_t                watermark;    // Margin threshold for late events (data items, 0 = disabled)
+  SAI_SignalDuplex_t      cb_process;   // Frame process callback (called from DMA interrupt)
+} SAI_DUPLEX;
+
 // SAI flags
 #define SAI_FLAG_INITIALIZED            (     1U)
 #define SAI_FLAG_POWERED                (1U << 1)
 #define SAI_FLAG_CONFIGURED             (1U << 2)
+#define SAI_FLAG_DUPLEX                 (1U << 3)
 
 // DMA Callback functions
 typedef void (*DMA_Callback_t) (DMA_HandleTypeDef *hdma);
 
+// SAI Sample Rate Drift Measurement (Run-Time)
+typedef struct _SAI_DRIFT {
+  uint32_t                rate;         // Nominal data items per second (0 = disabled)
+  uint32_t                window;       // Measurement window (core clock cycles)
+  uint32_t                stamp;        // Cycle counter at previous buffer half event
+  uint32_t                pos;          // Buffer position at previous buffer half event
+  uint32_t                cycles;       // Cycles in current window
+  uint32_t                items;        // Data items transferred in current window
+  int32_t                 ppb;          // Filtered drift estimate (parts per billion)
+  uint8_t                 state;        // 0 = no reference, 1 = measuring, 2 = estimate valid
+} SAI_DRIFT;
+
 // SAI Stream Information (Run-Time)
 typedef struct _SAI_STREAM_INFO {
   
@@ -315,6 +374,12 @@ typedef struct _SAI_STREAM_INFO {
   uint8_t                *buf;          // Pointer to data buffer
   uint8_t                 data_bits;    // Number of data bits
   uint32_t                protocol;     // SAI Protocol
+  uint8_t                 stream;       // Circular DMA streaming mode enabled
+  uint32_t                watermark;    // Streaming: margin threshold for late event (data items)
+  uint32_t                margin;       // Streaming: lowest margin observed (data items)
+  uint32_t                format;       // Streaming: application sample format (ARM_SAI_FORMAT_xxx)
+  uint8_t                *app;          // Streaming: application buffer for format conversion
+  SAI_DRIFT               drift;        // Streaming: sample rate drift measurement
 } SAI_STREAM_INFO;
 
 typedef struct _SAI_STATUS {
@@ -329,6 +394,7 @@ typedef struct _SAI_STATUS {
 typedef const struct _SAI_DMA {
   DMA_HandleTypeDef    *hdma;           // DMA handle
   DMA_Callback_t        cb_complete;    // DMA complete callback
+  DMA_Callback_t        cb_half;        // DMA half complete callback
 #ifdef RTE_DEVICE_FRAMEWORK_CLASSIC
   DMA_Stream_TypeDef   *stream;         // Stream register interface
   uint32_t              channel;        // DMA channel
@@ -356,6 +422,7 @@ typedef const struct _SAI_IO {
 // SAI Information (Run-time)
 typedef struct _SAI_INFO {
   ARM_SAI_SignalEvent_t cb_event;       // Event Callback
+  SAI_SignalDuplex_t    cb_duplex;      // Full-duplex frame process callback
   SAI_STATUS            status;         // Status flags
   uint8_t               flags;          // SAI driver flags
 } SAI_INFO;
@@ -18,8 +18,8 @@
  * 3. This notice may not be removed or altered from any source distribution.
  *
  *
- * $Date:        10. Januay 2017
- * $Revision:    V1.4
+ * $Date:        19. October 2026
+ * $Revision:    V1.6
  *
  * Driver:       Driver_SPI1, Driver_SPI2, Driver_SPI3,
  *               Driver_SPI4, Driver_SPI5, Driver_SPI6
@@ -40,6 +40,10 @@
  * -------------------------------------------------------------------------- */
 
 /* History:
+ *  Version 1.6
+ *    Added slave ring receive mode with NSS framed packets (ARM_SPI_CONTROL_RX_RING)
+ *  Version 1.5
+ *    Added hardware CRC support (ARM_SPI_CONTROL_CRC, ARM_SPI_EVENT_CRC_ERROR)
  *  Version 1.4
  *    Corrected DMA transfer problem
  *  Version 1.3
@@ -115,13 +119,24 @@ Configuration tab
      - User Constants: not used
    
      Click \b OK to close the SPI2 Configuration dialog
+
+Slave ring receive mode
+-----------------------
+  In slave mode with hardware NSS and Rx DMA, \b ARM_SPI_CONTROL_RX_RING enables reception of
+  variable length frames. \b Receive then starts a circular DMA into the provided buffer and
+  each NSS rising edge (EXTI line of the NSS pin) ends a frame and signals \b ARM_SPI_EVENT_RX_FRAME.
+  \b ARM_SPI_GET_RX_FRAME returns the length of the oldest frame; frames follow each other in the buffer.
+  The EXTI interrupt handler of the NSS pin must call \b SPIx_NSS_IRQHandler (x = SPI instance).
+  Ring wraps are counted in the Rx DMA interrupt, which may preempt the NSS EXTI interrupt. A frame longer than the buffer, or unread data being overwritten,
+  is signaled with \b ARM_SPI_EVENT_DATA_LOST. Data still in the Rx FIFO at the NSS edge is
+  accounted to the next frame.
 */
 
 /*! \cond */
 
 #include "SPI_STM32F7xx.h"
 
-#define ARM_SPI_DRV_VERSION ARM_DRIVER_VERSION_MAJOR_MINOR(1,4)
+#define ARM_SPI_DRV_VERSION ARM_DRIVER_VERSION_MAJOR_MINOR(1,6)
 
 // Driver Version
 static const ARM_DRIVER_VERSION DriverVersion = { ARM_SPI_API_VERSION, ARM_SPI_DRV_VERSION };
@@ -826,6 +841,7 @@ void SPI_TX_DMA_Complete(const SPI_RESOURCES *spi);
 #endif
 #ifdef __SPI_DMA_RX
 void SPI_RX_DMA_Complete(const SPI_RESOURCES *spi);
+void SPI_NSS_IRQHandler (const SPI_RESOURCES *spi);
 #endif
 
 #ifdef RTE_DEVICE_FRAMEWORK_CLASSIC
@@ -887,6 +903,72 @@ static void SPI_PeripheralReset (SPI_TypeDef *spi) {
   else if (spi == SPI6) { __HAL_RCC_SPI6_RELEASE_RESET(); }
 }
 
+/**
+  \fn          uint8_t SPI_CRC_Start (const SPI_RESOURCES *spi)
+  \brief       Reset hardware CRC calculation before a new transfer.
+  \param[in]   spi  Pointer to SPI resources
+  \return      number of CRC frames that follow the data frames (0 = CRC disabled)
+*/
+static uint8_t SPI_CRC_Start (const SPI_RESOURCES *spi) {
+
+  if ((spi->reg->CR1 & SPI_CR1_CRCEN) == 0U) { return 0U; }
+
+  // CRC is reset by clearing and setting CRCEN while SPI is disabled
+  spi->reg->CR1 &= ~SPI_CR1_SPE;
+  spi->reg->CR1 &= ~SPI_CR1_CRCEN;
+  spi->reg->CR1 |=  SPI_CR1_CRCEN;
+  spi->reg->CR1 |=  SPI_CR1_SPE;
+
+  if (((spi->reg->CR1 & SPI_CR1_CRCL) != 0U) && ((((spi->reg->CR2 & SPI_CR2_DS) >> 8) + 1U) <= 8U)) {
+    // 16-bit CRC with 8-bit data frame
+    return 2U;
+  }
+  return 1U;
+}
+
+#ifdef __SPI_DMA_RX
+/**
+  \fn          void SPI_NSS_EXTI_Config (const SPI_RESOURCES *spi, bool enable)
+  \brief       Configure NSS pin rising edge interrupt (frame end in ring receive mode).
+  \param[in]   spi     Pointer to SPI resources
+  \param[in]   enable  true = enable, false = disable
+*/
+static void SPI_NSS_EXTI_Config (const SPI_RESOURCES *spi, bool enable) {
+  uint32_t  line, pos;
+  IRQn_Type irq_num;
+
+  if (enable == false) {
+    EXTI->IMR  &= ~spi->io.nss->pin;
+    EXTI->RTSR &= ~spi->io.nss->pin;
+    return;
+  }
+
+  line = POSITION_VAL(spi->io.nss->pin);
+
+  // Connect EXTI line to NSS pin port
+  __HAL_RCC_SYSCFG_CLK_ENABLE();
+  pos = (line & 3U) * 4U;
+  SYSCFG->EXTICR[line >> 2] = (SYSCFG->EXTICR[line >> 2] & ~(0x0FU << pos)) |
+                              ((uint32_t)GPIO_GET_INDEX(spi->io.nss->port) << pos);
+
+  // Interrupt on rising edge (NSS deasserted)
+  EXTI->FTSR &= ~spi->io.nss->pin;
+  EXTI->RTSR |=  spi->io.nss->pin;
+  EXTI->PR    =  spi->io.nss->pin;
+  EXTI->IMR  |=  spi->io.nss->pin;
+
+  if      (line == 0U) { irq_num = EXTI0_IRQn;     }
+  else if (line == 1U) { irq_num = EXTI1_IRQn;     }
+  else if (line == 2U) { irq_num = EXTI2_IRQn;     }
+  else if (line == 3U) { irq_num = EXTI3_IRQn;     }
+  else if (line == 4U) { irq_num = EXTI4_IRQn;     }
+  else if (line <= 9U) { irq_num = EXTI9_5_IRQn;   }
+  else                 { irq_num = EXTI15_10_IRQn; }
+
+  NVIC_EnableIRQ (irq_num);
+}
+#endif
+
 /**
   \fn          ARM_DRIVER_VERSION SPIX_GetVersion (void)
   \brief       Get SPI driver version.
@@ -1101,13 +1183,20 @@ static int32_t SPI_PowerControl (ARM_POWER_STATE state, const SPI_RESOURCES *spi
       else if (spi->reg == SPI6) { __HAL_RCC_SPI6_CLK_DISABLE(); }
 #endif
 
+#ifdef __SPI_DMA_RX
+      if ((spi->info->state & SPI_RX_RING) != 0U) {
+        // Disable NSS interrupt
+        SPI_NSS_EXTI_Config (spi, false);
+      }
+#endif
+
       // Clear status flags
       spi->info->status.busy       = 0U;
       spi->info->status.data_lost  = 0U;
       spi->info->status.mode_fault = 0U;
 
-      // Clear powered flag
-      spi->info->state &= ~SPI_POWERED;
+      // Clear powered and ring receive flags
+      spi->info->state &= ~(SPI_POWERED | SPI_RX_RING);
       break;
 
     case ARM_POWER_FULL:
@@ -1200,6 +1289,9 @@ static int32_t SPI_Send (const void *data, uint32_t num, const SPI_RESOURCES *sp
   spi->xfer->rx_cnt = 0U;
   spi->xfer->tx_cnt = 0U;
 
+  // Reset CRC calculation
+  spi->xfer->crc_cnt = SPI_CRC_Start (spi);
+
 #ifdef __SPI_DMA_RX
   if (spi->rx_dma != NULL) {
     // DMA mode
@@ -1286,6 +1378,10 @@ static int32_t SPI_Receive (void *data, uint32_t num, const SPI_RESOURCES *spi)
   if ((data == NULL) || (num == 0U))             { return ARM_DRIVER_ERROR_PARAMETER; }
   if ((spi->info->state & SPI_CONFIGURED) == 0U) { return ARM_DRIVER_ERROR; }
   if ( spi->info->status.busy)                   { return ARM_DRIVER_ERROR_BUSY; }
+  if (((spi->info->state & SPI_RX_RING) != 0U) && (num > 0xFFFFU)) {
+    // Ring size is limited by DMA counter
+    return ARM_DRIVER_ERROR_PARAMETER;
+  }
 
   // Check if receive pin available
   if ((((spi->io.miso != NULL) && ((spi->info->mode & ARM_SPI_CONTROL_Msk) == ARM_SPI_MODE_MASTER)) ||
@@ -1305,6 +1401,39 @@ static int32_t SPI_Receive (void *data, uint32_t num, const SPI_RESOURCES *spi)
   spi->xfer->rx_cnt = 0U;
   spi->xfer->tx_cnt = 0U;
 
+#ifdef __SPI_DMA_RX
+  if ((spi->info->state & SPI_RX_RING) != 0U) {
+    // Ring receive mode: circular DMA, frames are delimited by NSS
+    memset(&spi->xfer->ring, 0, sizeof(SPI_RX_RING_INFO));
+    spi->xfer->crc_cnt = 0U;
+
+    spi->rx_dma->hdma->Init.Mode                  = DMA_CIRCULAR;
+    spi->rx_dma->hdma->Init.PeriphInc             = DMA_PINC_DISABLE;
+    spi->rx_dma->hdma->Init.MemInc                = DMA_MINC_ENABLE;
+    if ((((spi->reg->CR2 & SPI_CR2_DS) >> 8) + 1U) > 8U) {
+      // 16 - bit data frame
+      spi->rx_dma->hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+      spi->rx_dma->hdma->Init.MemDataAlignment    = DMA_PDATAALIGN_HALFWORD;
+    } else {
+      //  8 - bit data frame
+      spi->rx_dma->hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+      spi->rx_dma->hdma->Init.MemDataAlignment    = DMA_PDATAALIGN_BYTE;
+    }
+    // Initialize and start SPI RX DMA Stream (transfer complete counts ring wraps, frame end is signaled by NSS)
+    if (HAL_DMA_Init     (spi->rx_dma->hdma) != HAL_OK) { return ARM_DRIVER_ERROR; }
+    if (HAL_DMA_Start_IT (spi->rx_dma->hdma, (uint32_t)(&spi->reg->DR), (uint32_t)spi->xfer->rx_buf, num) != HAL_OK) {
+      return ARM_DRIVER_ERROR;
+    }
+
+    // RX Buffer DMA enable
+    spi->reg->CR2 |= SPI_CR2_RXDMAEN;
+    return ARM_DRIVER_OK;
+  }
+#endif
+
+  // Reset CRC calculation
+  spi->xfer->crc_cnt = SPI_CRC_Start (spi);
+
 #ifdef __SPI_DMA_RX
   // DMA mode
   if (spi->rx_dma != NULL) {
@@ -1415,6 +1544,9 @@ static int32_t SPI_Transfer (const void *data_out, void *data_in, uint32_t num,
   spi->xfer->rx_cnt = 0U;
   spi->xfer->tx_cnt = 0U;
 
+  // Reset CRC calculation
+  spi->xfer->crc_cnt = SPI_CRC_Start (spi);
+
 #ifdef __SPI_DMA
   if ((spi->rx_dma != NULL) || (spi->tx_dma != NULL)) {
     // DMA mode
@@ -1533,6 +1665,9 @@ static int32_t SPI_Control (uint32_t control, uint32_t arg, const SPI_RESOURCES
 
       // Abort RX DMA transfer
       HAL_DMA_Abort (spi->rx_dma->hdma);
+
+      // Ring receive uses circular mode
+      spi->rx_dma->hdma->Init.Mode = DMA_NORMAL;
     } else {
       // Interrupt mode
       // Disable RX buffer not empty interrupt
@@ -1544,6 +1679,17 @@ static int32_t SPI_Control (uint32_t control, uint32_t arg, const SPI_RESOURCES
     return ARM_DRIVER_OK;
   }
 
+#ifdef __SPI_DMA_RX
+  if ((control & ARM_SPI_CONTROL_Msk) == ARM_SPI_GET_RX_FRAME) {
+    // Release oldest frame received in ring receive mode
+    if (spi->xfer->ring.rd == spi->xfer->ring.wr) { return 0; }
+    val = spi->xfer->ring.len[spi->xfer->ring.rd % SPI_RX_RING_FRAMES];
+    spi->xfer->ring.consumed += val;
+    spi->xfer->ring.rd++;
+    return ((int32_t)val);
+  }
+#endif
+
   // Check for busy flag
   if (spi->info->status.busy) { return ARM_DRIVER_ERROR_BUSY; }
 
@@ -1593,6 +1739,71 @@ static int32_t SPI_Control (uint32_t control, uint32_t arg, const SPI_RESOURCES
       spi->xfer->def_val = (uint16_t)(arg & 0xFFFFU);
       return ARM_DRIVER_OK;
 
+    case ARM_SPI_CONTROL_CRC:
+      if ((arg > 0xFFFFU) || ((arg != 0U) && ((arg & 1U) == 0U))) {
+        // Polynomial must be odd
+        return ARM_DRIVER_ERROR_PARAMETER;
+      }
+      cr1 = spi->reg->CR1 & ~(SPI_CR1_CRCEN | SPI_CR1_CRCL);
+      val = 0U;
+      if (arg != 0U) {
+        switch (control & ARM_SPI_CRC_LENGTH_Msk) {
+          case ARM_SPI_CRC_LENGTH_DATA_BITS:
+            if ((((spi->reg->CR2 & SPI_CR2_DS) >> 8) + 1U) > 8U) { cr1 |= SPI_CR1_CRCL; }
+            val = 1U;
+            break;
+          case ARM_SPI_CRC_LENGTH_8:
+            break;
+          case ARM_SPI_CRC_LENGTH_16:
+            cr1 |= SPI_CR1_CRCL;
+            break;
+          default: return ARM_DRIVER_ERROR_PARAMETER;
+        }
+        if (((cr1 & SPI_CR1_CRCL) == 0U) && (arg > 0xFFU)) {
+          // Polynomial does not fit 8-bit CRC
+          return ARM_DRIVER_ERROR_PARAMETER;
+        }
+        cr1 |= SPI_CR1_CRCEN;
+      }
+      // CRC length follows later data frame length changes
+      if (val != 0U) {
+        spi->info->state |=  SPI_CRC_DATA_BITS;
+      } else {
+        spi->info->state &= ~SPI_CRC_DATA_BITS;
+      }
+      // Disable SPI, update CRC configuration and enable SPI
+      spi->reg->CR1 &= ~SPI_CR1_SPE;
+      if (arg != 0U) { spi->reg->CRCPR = arg; }
+      spi->reg->CR1  =  cr1 & ~SPI_CR1_SPE;
+      spi->reg->CR1 |=  SPI_CR1_SPE;
+      return ARM_DRIVER_OK;
+
+    case ARM_SPI_GET_RX_CRC:
+      return ((int32_t)(spi->reg->RXCRCR & 0xFFFFU));
+
+    case ARM_SPI_CONTROL_RX_RING:
+#ifdef __SPI_DMA_RX
+      if (arg == 0U) {
+        if ((spi->info->state & SPI_RX_RING) != 0U) {
+          SPI_NSS_EXTI_Config (spi, false);
+          spi->info->state &= ~SPI_RX_RING;
+        }
+        return ARM_DRIVER_OK;
+      }
+      if ((spi->rx_dma == NULL) || (spi->io.nss == NULL)) {
+        return ARM_DRIVER_ERROR_UNSUPPORTED;
+      }
+      if ((spi->info->mode & (ARM_SPI_CONTROL_Msk | ARM_SPI_SS_SLAVE_MODE_Msk)) != (ARM_SPI_MODE_SLAVE | ARM_SPI_SS_SLAVE_HW)) {
+        // Slave mode with hardware slave select required
+        return ARM_DRIVER_ERROR;
+      }
+      SPI_NSS_EXTI_Config (spi, true);
+      spi->info->state |= SPI_RX_RING;
+      return ARM_DRIVER_OK;
+#else
+      return ARM_DRIVER_ERROR_UNSUPPORTED;
+#endif
+
     case ARM_SPI_CONTROL_SS:
       val = (spi->info->mode & ARM_SPI_CONTROL_Msk);
       // Master modes
@@ -1654,6 +1865,10 @@ static int32_t SPI_Control (uint32_t control, uint32_t arg, const SPI_RESOURCES
   if ((val <  4U) || (val > 16)) { return ARM_SPI_ERROR_DATA_BITS; }
   if ( val <= 8U) { cr2 |= SPI_CR2_FRXTH; }
   cr2 |= (val - 1U) << 8;
+  if (((spi->info->state & SPI_CRC_DATA_BITS) != 0U) && ((spi->reg->CR1 & SPI_CR1_CRCEN) != 0U)) {
+    // CRC length follows data frame length, polynomial must fit 8-bit CRC
+    if ((val <= 8U) && (spi->reg->CRCPR > 0xFFU)) { return ARM_SPI_ERROR_DATA_BITS; }
+  }
 
   // Bit order
   if ((control & ARM_SPI_BIT_ORDER_Msk) == ARM_SPI_LSB_MSB) {
@@ -1786,6 +2001,23 @@ static int32_t SPI_Control (uint32_t control, uint32_t arg, const SPI_RESOURCES
   // Save prescaler value
   cr1 |= (val << 3U);
 
+  // Keep hardware CRC configuration
+  cr1 |= spi->reg->CR1 & SPI_CR1_CRCEN;
+  if ((spi->info->state & SPI_CRC_DATA_BITS) != 0U) {
+    // CRC length follows data frame length
+    if ((((cr2 & SPI_CR2_DS) >> 8) + 1U) > 8U) { cr1 |= SPI_CR1_CRCL; }
+  } else {
+    cr1 |= spi->reg->CR1 & SPI_CR1_CRCL;
+  }
+
+#ifdef __SPI_DMA_RX
+  if ((spi->info->state & SPI_RX_RING) != 0U) {
+    // Mode change disables ring receive mode
+    SPI_NSS_EXTI_Config (spi, false);
+    spi->info->state &= ~SPI_RX_RING;
+  }
+#endif
+
   spi->info->mode = mode;
 
   // Configure registers
@@ -1837,7 +2069,7 @@ void SPI_IRQHandler (const SPI_RESOURCES *spi) {
     if ((((spi->reg->CR2 & SPI_CR2_DS) >> 8) + 1U) <= 8U) {
       // 8-bit data frame
       data_8bit = *(volatile uint8_t *)(&spi->reg->DR);
-      if (spi->xfer->rx_cnt < spi->xfer->num) {
+      if ((spi->xfer->rx_cnt < spi->xfer->num) && ((spi->info->state & SPI_RX_RING) == 0U)) {
         if (spi->xfer->rx_buf != NULL) {
           *(spi->xfer->rx_buf++) = data_8bit;
         }
@@ -1845,7 +2077,7 @@ void SPI_IRQHandler (const SPI_RESOURCES *spi) {
     } else {
       // 16-bit data frame
       data_16bit = *(volatile uint16_t *)(&spi->reg->DR);
-      if (spi->xfer->rx_cnt < spi->xfer->num) {
+      if ((spi->xfer->rx_cnt < spi->xfer->num) && ((spi->info->state & SPI_RX_RING) == 0U)) {
         if (spi->xfer->rx_buf != NULL) {
           *(spi->xfer->rx_buf++) = (uint8_t) data_16bit;
           *(spi->xfer->rx_buf++) = (uint8_t)(data_16bit >> 8U);
@@ -1871,6 +2103,15 @@ void SPI_IRQHandler (const SPI_RESOURCES *spi) {
     spi->reg->CR1 = spi->reg->CR1;
     event |= ARM_SPI_EVENT_MODE_FAULT;
   }
+  if ((sr & SPI_SR_CRCERR) != 0U) {
+    // Clear CRC error flag
+    spi->reg->SR = (uint16_t)~SPI_SR_CRCERR;
+
+    // CRC is checked only when received data is used
+    if (spi->xfer->rx_buf != NULL) {
+      event |= ARM_SPI_EVENT_CRC_ERROR;
+    }
+  }
 
   if (((sr & SPI_SR_RXNE) != 0U) && ((spi->reg->CR2 & SPI_CR2_RXNEIE) != 0U)) {
     // Receive Buffer Not Empty
@@ -1893,7 +2134,35 @@ void SPI_IRQHandler (const SPI_RESOURCES *spi) {
 
       spi->xfer->rx_cnt++;
 
-      if (spi->xfer->rx_cnt == spi->xfer->num) {
+      if ((spi->xfer->rx_cnt == spi->xfer->num) && (spi->xfer->crc_cnt == 0U)) {
+
+        // Disable RX Buffer Not Empty Interrupt
+        spi->reg->CR2 &= ~SPI_CR2_RXNEIE;
+
+        // Clear busy flag
+        spi->info->status.busy = 0U;
+
+        // Transfer completed
+        event |= ARM_SPI_EVENT_TRANSFER_COMPLETE;
+      }
+    }
+    else if (spi->xfer->crc_cnt != 0U) {
+      // Received CRC frame, dump it (checked by hardware)
+      if ((((spi->reg->CR2 & SPI_CR2_DS) >> 8) + 1U) <= 8U) {
+        data_8bit  = *(volatile uint8_t  *)(&spi->reg->DR);
+      } else {
+        data_16bit = *(volatile uint16_t *)(&spi->reg->DR);
+      }
+      spi->xfer->crc_cnt--;
+
+      if (spi->xfer->crc_cnt == 0U) {
+        if ((spi->reg->SR & SPI_SR_CRCERR) != 0U) {
+          // Clear CRC error flag
+          spi->reg->SR = (uint16_t)~SPI_SR_CRCERR;
+          if (spi->xfer->rx_buf != NULL) {
+            event |= ARM_SPI_EVENT_CRC_ERROR;
+          }
+        }
 
         // Disable RX Buffer Not Empty Interrupt
         spi->reg->CR2 &= ~SPI_CR2_RXNEIE;
@@ -1935,6 +2204,10 @@ void SPI_IRQHandler (const SPI_RESOURCES *spi) {
       spi->xfer->tx_cnt++;
 
       if (spi->xfer->tx_cnt == spi->xfer->num) {
+        if ((spi->reg->CR1 & SPI_CR1_CRCEN) != 0U) {
+          // Transmit CRC after last data frame
+          spi->reg->CR1 |= SPI_CR1_CRCNEXT;
+        }
         // All data sent, disable TX Buffer Empty Interrupt
         spi->reg->CR2 &= ~SPI_CR2_TXEIE;
       }
@@ -1965,6 +2238,12 @@ void SPI_TX_DMA_Complete(const SPI_RESOURCES *spi) {
 #ifdef __SPI_DMA_RX
 void SPI_RX_DMA_Complete(const SPI_RESOURCES *spi) {
 
+  if ((spi->info->state & SPI_RX_RING) != 0U) {
+    // Ring receive mode: circular DMA wrapped to the buffer start
+    spi->xfer->ring.wraps++;
+    return;
+  }
+
   if ((__HAL_DMA_GET_COUNTER(spi->rx_dma->hdma) != 0) && (spi->xfer->num != 0)) {
     // RX DMA Complete caused by transfer abort
     return;
@@ -1972,11 +2251,75 @@ void SPI_RX_DMA_Complete(const SPI_RESOURCES *spi) {
 
   spi->xfer->rx_cnt = spi->xfer->num;
 
+  if (spi->xfer->crc_cnt != 0U) {
+    // Receive CRC frames in interrupt mode (DMA transfers data frames only)
+    spi->reg->CR2 &= ~SPI_CR2_RXDMAEN;
+    spi->reg->CR2 |=  SPI_CR2_RXNEIE;
+    return;
+  }
+
   spi->info->status.busy = 0U;
   if (spi->info->cb_event != NULL) {
     spi->info->cb_event(ARM_SPI_EVENT_TRANSFER_COMPLETE);
   }
 }
+
+/* SPI NSS (EXTI) IRQ Handler */
+void SPI_NSS_IRQHandler (const SPI_RESOURCES *spi) {
+  uint32_t pos, len, size, cnt, wraps, tc;
+  uint32_t event;
+
+  if ((spi->io.nss == NULL) || ((EXTI->PR & spi->io.nss->pin) == 0U)) { return; }
+
+  // Clear pending flag
+  EXTI->PR = spi->io.nss->pin;
+
+  if (((spi->info->state & SPI_RX_RING) == 0U) || (spi->info->status.busy == 0U)) { return; }
+
+  // Absolute DMA position: counted wraps, pending (not yet counted) wrap and current position.
+  // The snapshot is repeated when a wrap happened or was counted (DMA IRQ) while reading it.
+  // Data still in RX FIFO is moved by DMA later and is accounted to the next frame.
+  size = spi->xfer->num;
+  do {
+    tc    = __HAL_DMA_GET_FLAG(spi->rx_dma->hdma, __HAL_DMA_GET_TC_FLAG_INDEX(spi->rx_dma->hdma));
+    wraps = spi->xfer->ring.wraps;
+    cnt   = __HAL_DMA_GET_COUNTER(spi->rx_dma->hdma);
+  } while ((tc    != __HAL_DMA_GET_FLAG(spi->rx_dma->hdma, __HAL_DMA_GET_TC_FLAG_INDEX(spi->rx_dma->hdma))) ||
+           (wraps != spi->xfer->ring.wraps));
+  if (tc != 0U) { wraps++; }
+  pos  = (wraps * size) + (size - cnt);
+
+  // Frame length since last frame end (may be one or more ring sizes)
+  len  = pos - spi->xfer->ring.received;
+  if (len == 0U) {
+    // No data received since last frame end
+    return;
+  }
+
+  spi->xfer->ring.received += len;
+
+  event = ARM_SPI_EVENT_RX_FRAME;
+
+  if ((uint8_t)(spi->xfer->ring.wr - spi->xfer->ring.rd) < SPI_RX_RING_FRAMES) {
+    spi->xfer->ring.len[spi->xfer->ring.wr % SPI_RX_RING_FRAMES] = len;
+    spi->xfer->ring.wr++;
+  } else {
+    // Frame queue full, frame is appended to last queued frame
+    spi->xfer->ring.len[(uint8_t)(spi->xfer->ring.wr - 1U) % SPI_RX_RING_FRAMES] += len;
+    spi->info->status.data_lost = 1U;
+    event |= ARM_SPI_EVENT_DATA_LOST;
+  }
+
+  if ((spi->xfer->ring.received - spi->xfer->ring.consumed) > size) {
+    // Unread data was overwritten
+    spi->info->status.data_lost = 1U;
+    event |= ARM_SPI_EVENT_DATA_LOST;
+  }
+
+  if (spi->info->cb_event != NULL) {
+    spi->info->cb_event(event);
+  }
+}
 #endif
 
 // SPI1
@@ -1991,6 +2334,9 @@ static uint32_t       SPI1_GetDataCount        (void)
 static int32_t        SPI1_Control             (uint32_t control, uint32_t arg)                    { return SPI_Control (control, arg, &SPI1_Resources); }
 static ARM_SPI_STATUS SPI1_GetStatus           (void)                                              { return SPI_GetStatus (&SPI1_Resources); }
        void           SPI1_IRQHandler          (void)                                              {        SPI_IRQHandler (&SPI1_Resources); }
+#if (defined(MX_SPI1_NSS_Pin) && defined(MX_SPI1_RX_DMA_Instance))
+       void           SPI1_NSS_IRQHandler      (void)                                              {        SPI_NSS_IRQHandler (&SPI1_Resources); }
+#endif
 
 #ifdef MX_SPI1_TX_DMA_Instance
       void            SPI1_TX_DMA_Complete     (DMA_HandleTypeDef *hdma)                           {        SPI_TX_DMA_Complete (&SPI1_Resources); }
@@ -2040,6 +2386,9 @@ static uint32_t       SPI2_GetDataCount        (void)
 static int32_t        SPI2_Control             (uint32_t control, uint32_t arg)                    { return SPI_Control (control, arg, &SPI2_Resources); }
 static ARM_SPI_STATUS SPI2_GetStatus           (void)                                              { return SPI_GetStatus (&SPI2_Resources); }
        void           SPI2_IRQHandler          (void)                                              {        SPI_IRQHandler (&SPI2_Resources); }
+#if (defined(MX_SPI2_NSS_Pin) && defined(MX_SPI2_RX_DMA_Instance))
+       void           SPI2_NSS_IRQHandler      (void)                                              {        SPI_NSS_IRQHandler (&SPI2_Resources); }
+#endif
 
 #ifdef MX_SPI2_TX_DMA_Instance
       void            SPI2_TX_DMA_Complete     (DMA_HandleTypeDef *hdma)                           {        SPI_TX_DMA_Complete (&SPI2_Resources); }
@@ -2089,6 +2438,9 @@ static uint32_t       SPI3_GetDataCount        (void)
 static int32_t        SPI3_Control             (uint32_t control, uint32_t arg)                    { return SPI_Control (control, arg, &SPI3_Resources); }
 static ARM_SPI_STATUS SPI3_GetStatus           (void)                                              { return SPI_GetStatus (&SPI3_Resources); }
        void           SPI3_IRQHandler          (void)                                              {        SPI_IRQHandler (&SPI3_Resources); }
+#if (defined(MX_SPI3_NSS_Pin) && defined(MX_SPI3_RX_DMA_Instance))
+       void           SPI3_NSS_IRQHandler      (void)                                              {        SPI_NSS_IRQHandler (&SPI3_Resources); }
+#endif
 
 #ifdef MX_SPI3_TX_DMA_Instance
       void            SPI3_TX_DMA_Complete     (DMA_HandleTypeDef *hdma)                           {        SPI_TX_DMA_Complete (&SPI3_Resources); }
@@ -2138,6 +2490,9 @@ static uint32_t       SPI4_GetDataCount        (void)
 static int32_t        SPI4_Control             (uint32_t control, uint32_t arg)                    { return SPI_Control (control, arg, &SPI4_Resources); }
 static ARM_SPI_STATUS SPI4_GetStatus           (void)                                              { return SPI_GetStatus (&SPI4_Resources); }
        void           SPI4_IRQHandler          (void)                                              {        SPI_IRQHandler (&SPI4_Resources); }
+#if (defined(MX_SPI4_NSS_Pin) && defined(MX_SPI4_RX_DMA_Instance))
+       void           SPI4_NSS_IRQHandler      (void)                                              {        SPI_NSS_IRQHandler (&SPI4_Resources); }
+#endif
 
 #ifdef MX_SPI4_TX_DMA_Instance
       void            SPI4_TX_DMA_Complete     (DMA_HandleTypeDef *hdma)                           {        SPI_TX_DMA_Complete (&SPI4_Resources); }
@@ -2187,6 +2542,9 @@ static uint32_t       SPI5_GetDataCount        (void)
 static int32_t        SPI5_Control             (uint32_t control, uint32_t arg)                    { return SPI_Control (control, arg, &SPI5_Resources); }
 static ARM_SPI_STATUS SPI5_GetStatus           (void)                                              { return SPI_GetStatus (&SPI5_Resources); }
        void           SPI5_IRQHandler          (void)                                              {        SPI_IRQHandler (&SPI5_Resources); }
+#if (defined(MX_SPI5_NSS_Pin) && defined(MX_SPI5_RX_DMA_Instance))
+       void           SPI5_NSS_IRQHandler      (void)                                              {        SPI_NSS_IRQHandler (&SPI5_Resources); }
+#endif
 
 #ifdef MX_SPI5_TX_DMA_Instance
       void            SPI5_TX_DMA_Complete     (DMA_HandleTypeDef *hdma)                           {        SPI_TX_DMA_Complete (&SPI5_Resources); }
@@ -2236,6 +2594,9 @@ static uint32_t       SPI6_GetDataCount        (void)
 static int32_t        SPI6_Control             (uint32_t control, uint32_t arg)                    { return SPI_Control (control, arg, &SPI6_Resources); }
 static ARM_SPI_STATUS SPI6_GetStatus           (void)                                              { return SPI_GetStatus (&SPI6_Resources); }
        void           SPI6_IRQHandler          (void)                                              {        SPI_IRQHandler (&SPI6_Resources); }
+#if (defined(MX_SPI6_NSS_Pin) && defined(MX_SPI6_RX_DMA_Instance))
+       void           SPI6_NSS_IRQHandler      (void)                                              {        SPI_NSS_IRQHandler (&SPI6_Resources); }
+#endif
 
 #ifdef MX_SPI6_TX_DMA_Instance
       void            SPI6_TX_DMA_Complete     (DMA_HandleTypeDef *hdma)                           {        SPI_TX_DMA_Complete (&SPI6_Resources); }
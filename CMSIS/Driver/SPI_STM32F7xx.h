@@ -559,12 +559,35 @@
 #endif
 
 
+// Driver specific control codes
+#define ARM_SPI_CONTROL_CRC             (0x20UL << ARM_SPI_CONTROL_Pos)     ///< Configure hardware CRC; arg = CRC polynomial (odd, up to 0xFF for 8-bit CRC), 0 = CRC disabled
+#define ARM_SPI_GET_RX_CRC              (0x21UL << ARM_SPI_CONTROL_Pos)     ///< Get CRC calculated over last received data; arg = not used
+#define ARM_SPI_CONTROL_RX_RING         (0x22UL << ARM_SPI_CONTROL_Pos)     ///< Slave NSS framed ring receive; arg: 0=disabled, 1=enabled
+#define ARM_SPI_GET_RX_FRAME            (0x23UL << ARM_SPI_CONTROL_Pos)     ///< Get and release oldest received frame; returns frame length (0 = none)
+
+// ARM_SPI_CONTROL_CRC: CRC length
+#define ARM_SPI_CRC_LENGTH_Pos           8
+#define ARM_SPI_CRC_LENGTH_Msk          (3UL << ARM_SPI_CRC_LENGTH_Pos)
+#define ARM_SPI_CRC_LENGTH_DATA_BITS    (0UL << ARM_SPI_CRC_LENGTH_Pos)     ///< CRC length equal to data frame length, also after data bits change (default)
+#define ARM_SPI_CRC_LENGTH_8            (1UL << ARM_SPI_CRC_LENGTH_Pos)     ///< 8-bit CRC
+#define ARM_SPI_CRC_LENGTH_16           (2UL << ARM_SPI_CRC_LENGTH_Pos)     ///< 16-bit CRC
+
+// Driver specific events
+#define ARM_SPI_EVENT_CRC_ERROR         (1UL << 8)      ///< Received CRC does not match calculated CRC
+#define ARM_SPI_EVENT_RX_FRAME          (1UL << 9)      ///< Frame received in ring receive mode (NSS deasserted)
+
+
 // Current driver status flag definition
 #define SPI_INITIALIZED           ((uint8_t)(1U))           // SPI initialized
 #define SPI_POWERED               ((uint8_t)(1U << 1))     // SPI powered on
 #define SPI_CONFIGURED            ((uint8_t)(1U << 2))     // SPI configured
 #define SPI_DATA_LOST             ((uint8_t)(1U << 3))     // SPI data lost occurred
 #define SPI_MODE_FAULT            ((uint8_t)(1U << 4))     // SPI mode fault occurred
+#define SPI_RX_RING               ((uint8_t)(1U << 5))     // SPI ring receive mode enabled
+#define SPI_CRC_DATA_BITS         ((uint8_t)(1U << 6))     // SPI CRC length follows data frame length
+
+// Number of received frames queued in ring receive mode
+#define SPI_RX_RING_FRAMES        8U
 
 
 // DMA Callback functions
@@ -612,6 +635,16 @@ typedef struct _SPI_INFO {
   uint32_t              mode;           // Current SPI mode
 } SPI_INFO;
 
+// SPI Ring Receive Information (Run-Time)
+typedef struct _SPI_RX_RING_INFO {
+  uint32_t volatile     wraps;                    // Number of DMA ring wraps (updated in DMA IRQ)
+  uint32_t              received;                 // Number of data items received up to last frame end
+  uint32_t              consumed;                 // Number of data items released by application
+  uint32_t              len[SPI_RX_RING_FRAMES];  // Lengths of received frames
+  uint8_t               wr;                       // Frame queue write index
+  uint8_t               rd;                       // Frame queue read index
+} SPI_RX_RING_INFO;
+
 // SPI Transfer Information (Run-Time)
 typedef struct _SPI_TRANSFER_INFO {
   uint32_t              num;            // Total number of transfers
@@ -621,6 +654,8 @@ typedef struct _SPI_TRANSFER_INFO {
   uint32_t              tx_cnt;         // Number of data sent
   uint32_t              dump_val;       // Variable for dumping DMA data
   uint16_t              def_val;        // Default transfer value
+  uint8_t               crc_cnt;        // Number of CRC frames still to be received
+  SPI_RX_RING_INFO      ring;           // Ring receive information
 } SPI_TRANSFER_INFO;
 
 
@@ -18,8 +18,8 @@
  * 3. This notice may not be removed or altered from any source distribution.
  *
  *
- * $Date:        12. December 2016
- * $Revision:    V1.7
+ * $Date:        19. October 2026
+ * $Revision:    V1.9
  *
  * Driver:       Driver_USBD1
  * Configured:   via RTE_Device.h configuration file
@@ -40,9 +40,35 @@
  *                           requirements
  *     - default value:      7
  *     - maximum value:      7
+ *   USB_OTG_HS_DMA:         specifies if this driver uses dedicated DMA
+ *                           (0 = DMA not used, 1 = DMA used)
+ *     - default value:      0 = DMA not used
+ *   USBD1_MANAGE_CACHE:     specifies if USB data is in cacheable area
+ *                           (0 = data in non-cacheable area,
+ *                            1 = data in cacheable area)
+ *     - default value:      0 = data in non-cacheable area
+ *   OTG_RX_FIFO_SIZE:       size in bytes of the shared receive FIFO
+ *     - default value:      1152
+ *   OTG_TXn_FIFO_SIZE:      size in bytes of the transmit FIFO of IN
+ *                           Endpoint n (n = 0..7), for bulk IN throughput
+ *                           use at least 2 maximum packet sizes
+ *     - default value:      512 (n = 0..3), 224 (n = 4..7)
+ *     - sum of all FIFO sizes must not exceed 4096
  * -------------------------------------------------------------------------- */
 
 /* History:
+ *  Version 1.9
+ *    IN transfers send multiple packets per transfer size setting, FIFO is
+ *    refilled on TX FIFO empty interrupt (Slave Mode)
+ *    Multiple packet IN transfers in Slave Mode only if TX FIFO holds at least
+ *    two max packets, default FIFO sizes give no benefit for High-speed bulk
+ *    endpoints (512 byte packets)
+ *    Added check of FIFO sizes against available FIFO memory
+ *    OUT buffers in DMA mode with USBD1_MANAGE_CACHE must be cache line aligned,
+ *    their cache lines are invalidated before the transfer is started
+ *  Version 1.8
+ *    Added DMA usage (RTE_OTG_HS_DMA) with multiple packet transfers
+ *    Added D-Cache maintenance of endpoint buffers in DMA mode (USBD1_MANAGE_CACHE)
  *  Version 1.7
  *    On-chip PHY powered down if external ULPI PHY is used
  *  Version 1.6
@@ -121,6 +147,21 @@ Configuration tab
      - Parameter Settings: not used
      - User Constants: not used
      - Click \b OK to close the USB_OTG_HS Configuration dialog
+
+\note Bulk and interrupt IN transfers are programmed as multiple packet transfers. Without
+DMA this is done only if the transmit FIFO (OTG_TXn_FIFO_SIZE) holds at least two maximum
+packet sizes: the FIFO is filled with as many packets as fit and refilled on the TX FIFO
+half empty interrupt. Smaller FIFOs send one packet per transfer, so the default FIFO
+sizes (512 bytes) give no multiple packet benefit for High-speed bulk endpoints
+(512 byte packets); set OTG_TXn_FIFO_SIZE to 1024 for such endpoints.
+
+\note If dedicated DMA is used (RTE_OTG_HS_DMA), endpoint data buffers have to be 4-byte
+aligned and OUT buffers must provide room for a whole max packet size packet (num rounded
+up to max packet size). Bulk and interrupt endpoints transfer multiple packets per DMA
+request. With USBD1_MANAGE_CACHE buffers may be placed in cacheable memory, cache
+maintenance is done on 32-byte lines: OUT buffers must be 32-byte aligned (otherwise
+EndpointTransfer returns an error) and padded to a multiple of 32 bytes beyond the rounded up
+size, because their cache lines are invalidated before and after the DMA transfer.
 */
 
 /*! \cond */
@@ -140,6 +181,10 @@ Configuration tab
 #error  Too many Endpoints, maximum IN/OUT Endpoint pairs that this driver supports is 7 !!!
 #endif
 
+#ifndef USBD1_MANAGE_CACHE
+#define USBD1_MANAGE_CACHE             (0U)
+#endif
+
 extern uint8_t otg_hs_role;
 
 extern void OTG_HS_PinsConfigure   (uint8_t pins_mask);
@@ -154,7 +199,7 @@ extern PCD_HandleTypeDef hpcd_USB_OTG_HS;
 
 // USBD Driver *****************************************************************
 
-#define ARM_USBD_DRV_VERSION ARM_DRIVER_VERSION_MAJOR_MINOR(1,7)
+#define ARM_USBD_DRV_VERSION ARM_DRIVER_VERSION_MAJOR_MINOR(1,9)
 
 // Driver Version
 static const ARM_DRIVER_VERSION usbd_driver_version = { ARM_USBD_API_VERSION, ARM_USBD_DRV_VERSION };
@@ -206,6 +251,12 @@ static const ARM_USBD_CAPABILITIES usbd_driver_capabilities = {
 #define OTG_TX7_FIFO_SIZE       (224U)
 #endif
 
+#if   ((OTG_RX_FIFO_SIZE  + OTG_TX0_FIFO_SIZE + OTG_TX1_FIFO_SIZE + OTG_TX2_FIFO_SIZE + \
+        OTG_TX3_FIFO_SIZE + OTG_TX4_FIFO_SIZE + OTG_TX5_FIFO_SIZE + OTG_TX6_FIFO_SIZE + \
+        OTG_TX7_FIFO_SIZE) > 4096U)
+#error  Sum of USB OTG HS FIFO sizes exceeds available 4 kB FIFO memory !!!
+#endif
+
 #define OTG_TX_FIFO(n)          *((volatile uint32_t *)(OTG_HS_BASE + 0x1000U + (n * 0x1000U)))
 #define OTG_RX_FIFO             *((volatile uint32_t *)(OTG_HS_BASE + 0x1000U))
 
@@ -216,6 +267,8 @@ static const ARM_USBD_CAPABILITIES usbd_driver_capabilities = {
 #define OTG_DOEPCTL(ep_num)     *((volatile uint32_t *)(&OTG->DOEPCTL0  + (ep_num * 8U)))
 #define OTG_DIEPINT(ep_num)     *((volatile uint32_t *)(&OTG->DIEPINT0  + (ep_num * 8U)))
 #define OTG_DOEPINT(ep_num)     *((volatile uint32_t *)(&OTG->DOEPINT0  + (ep_num * 8U)))
+#define OTG_DIEPDMA(ep_num)     *((volatile uint32_t *)(&OTG->DIEPDMA0  + (ep_num * 8U)))
+#define OTG_DOEPDMA(ep_num)     *((volatile uint32_t *)(&OTG->DOEPDMAB0 + (ep_num * 8U)))
 
 #define OTG_EP_IN_TYPE(ep_num)  ((OTG_DIEPCTL(ep_num) >> 18) & 3U)
 #define OTG_EP_OUT_TYPE(ep_num) ((OTG_DOEPCTL(ep_num) >> 18) & 3U)
@@ -224,7 +277,8 @@ typedef struct {                        // Endpoint structure definition
   uint8_t  *data;
   uint32_t  num;
   uint32_t  num_transferred_total;
-  uint16_t  num_transferring;
+  uint32_t  num_transferring;
+  uint32_t  num_written;
   uint16_t  max_packet_size;
   uint8_t   active;
   uint8_t   packet_count;
@@ -241,10 +295,19 @@ static bool                hw_initialized = false;
 static ARM_USBD_STATE      usbd_state;
 static uint32_t            setup_packet[2];     // Setup packet data
 static volatile uint8_t    setup_received;      // Setup packet received
+#if (USB_OTG_HS_DMA != 0U)                      // If DMA is used
+static uint32_t            setup_buf[8] __ALIGNED(32U); // Setup packets written by DMA
+#endif
 
 // Endpoints runtime information
 static volatile ENDPOINT_t ep[(USBD_MAX_ENDPOINT_NUM + 1U) * 2U];
 
+#if (USB_OTG_HS_DMA == 0U)                      // If DMA is not used (Slave Mode)
+// Transmit FIFO sizes in bytes
+static const uint16_t      tx_fifo_size[8] = { OTG_TX0_FIFO_SIZE, OTG_TX1_FIFO_SIZE, OTG_TX2_FIFO_SIZE, OTG_TX3_FIFO_SIZE,
+                                               OTG_TX4_FIFO_SIZE, OTG_TX5_FIFO_SIZE, OTG_TX6_FIFO_SIZE, OTG_TX7_FIFO_SIZE };
+#endif
+
 // Function prototypes
 static uint16_t USBD_GetFrameNumber (void);
 
@@ -267,6 +330,46 @@ static void USBD_FlushInEpFifo (uint8_t FIFO_num) {
 
 }
 
+#if (USB_OTG_HS_DMA != 0U)                      // If DMA is used
+/**
+  \fn          void USBD_SetupReadSet (void)
+  \brief       Set Control Endpoint 0 for reception of setup packets by DMA.
+*/
+static void USBD_SetupReadSet (void) {
+
+  OTG_DOEPTSIZ(0U) = (1U << OTG_HS_DOEPTSIZx_PKTCNT_POS ) |
+                     (3U << OTG_HS_DOEPTSIZ0_STUPCNT_POS) |
+                      sizeof(setup_buf)                   ;
+  OTG_DOEPDMA(0U)  = (uint32_t)setup_buf;
+  OTG_DOEPCTL(0U) |= OTG_HS_DOEPCTLx_EPENA;
+}
+
+/**
+  \fn          void USBD_SetupRead (void)
+  \brief       Read last setup packet written by DMA.
+*/
+static void USBD_SetupRead (void) {
+  uint32_t *ptr_src;
+
+  // DMA address points behind last received setup packet
+  ptr_src = (uint32_t *)(OTG_DOEPDMA(0U) - 8U);
+
+#if ((USBD1_MANAGE_CACHE == 1U) && (__DCACHE_PRESENT == 1U))
+  if ((SCB->CCR & SCB_CCR_DC_Msk) != 0U) {      // If Data Cache is enabled
+    SCB_InvalidateDCache_by_Addr ((uint32_t *)((uint32_t)ptr_src & (~0x1FU)), 8U + 31U);
+  }
+#endif
+  setup_packet[0] = ptr_src[0];
+  setup_packet[1] = ptr_src[1];
+
+  // Analyze Setup packet for SetAddress
+  if ((setup_packet[0] & 0xFFFFU) == 0x0500U) {
+    OTG->DCFG = (OTG->DCFG & ~OTG_HS_DCFG_DAD_MSK) | OTG_HS_DCFG_DAD((setup_packet[0] >> 16) & 0xFFU);
+  }
+  setup_received = 1U;
+}
+#endif
+
 /**
   \fn          void USBD_Reset (void)
   \brief       Reset USB Endpoint settings and variables.
@@ -282,8 +385,9 @@ static void USBD_Reset (void) {
   memset((void *)(ep), 0U, sizeof(ep));
 
   // Clear Endpoint mask registers
-  OTG->DOEPMSK = 0U;
-  OTG->DIEPMSK = 0U;
+  OTG->DOEPMSK    = 0U;
+  OTG->DIEPMSK    = 0U;
+  OTG->DIEPEMPMSK = 0U;
 
   for (i = 1U; i <= USBD_MAX_ENDPOINT_NUM; i++) {
     // Endpoint set NAK
@@ -367,6 +471,10 @@ static void USBD_Reset (void) {
                       OTG_TX2_FIFO_SIZE + OTG_TX3_FIFO_SIZE + OTG_TX4_FIFO_SIZE +
                       OTG_TX5_FIFO_SIZE + OTG_TX6_FIFO_SIZE)/ 4U) |
                     ((OTG_TX7_FIFO_SIZE / 4U) << OTG_HS_DIEPTXFx_INEPTXFD_POS);
+
+#if (USB_OTG_HS_DMA != 0U)                      // If DMA is used
+  USBD_SetupReadSet ();                         // Enable Endpoint 0 for setup packets
+#endif
 }
 
 /**
@@ -378,21 +486,52 @@ static void USBD_Reset (void) {
 */
 static void USBD_EndpointReadSet (uint8_t ep_addr) {
   volatile ENDPOINT_t *ptr_ep;
-  uint16_t             num;
+  uint32_t             num, pkt;
+#if (USB_OTG_HS_DMA != 0U)                      // If DMA is used
+  uint32_t             addr;
+#endif
   uint8_t              ep_num;
 
   ptr_ep = &ep[EP_ID(ep_addr)];
   ep_num = EP_NUM(ep_addr);
 
   // Set packet count and transfer size
+  pkt = ptr_ep->packet_count;
+#if (USB_OTG_HS_DMA != 0U)                      // If DMA is used
+  // DMA always receives whole packets
+  num = ptr_ep->max_packet_size;
+  if ((ep_num != 0U) && (OTG_EP_OUT_TYPE(ep_num) != ARM_USB_ENDPOINT_ISOCHRONOUS) &&
+      (ptr_ep->num > ptr_ep->max_packet_size)) {
+    // Receive as many whole packets as fit into remaining buffer
+    pkt = ptr_ep->num / ptr_ep->max_packet_size;
+    if (pkt > (OTG_HS_DOEPTSIZx_XFRSIZ_MSK / ptr_ep->max_packet_size)) {
+      pkt = OTG_HS_DOEPTSIZx_XFRSIZ_MSK / ptr_ep->max_packet_size;
+    }
+    if (pkt > (OTG_HS_DOEPTSIZx_PKTCNT_MSK >> OTG_HS_DOEPTSIZx_PKTCNT_POS)) {
+      pkt = OTG_HS_DOEPTSIZx_PKTCNT_MSK >> OTG_HS_DOEPTSIZx_PKTCNT_POS;
+    }
+    num = pkt * ptr_ep->max_packet_size;
+  }
+  ptr_ep->num_transferring = num;
+  addr = (uint32_t)(ptr_ep->data + ptr_ep->num_transferred_total);
+#if ((USBD1_MANAGE_CACHE == 1U) && (__DCACHE_PRESENT == 1U))
+  if ((SCB->CCR & SCB_CCR_DC_Msk) != 0U) {      // If Data Cache is enabled
+    // Invalidate whole cache lines of receive area (buffer is cache line aligned and padded),
+    // so no dirty line is written back over data received by DMA
+    SCB_InvalidateDCache_by_Addr ((uint32_t *)(addr & (~0x1FU)), (int32_t)(((addr & 0x1FU) + num + 31U) & (~0x1FU)));
+  }
+#endif
+  OTG_DOEPDMA(ep_num) = addr;
+#else
   if  (ptr_ep->num > ptr_ep->max_packet_size) { num = ptr_ep->max_packet_size; }
   else                                        { num = ptr_ep->num;             }
+#endif
 
   if (ep_num != 0U) {
-    OTG_DOEPTSIZ(ep_num) = (ptr_ep->packet_count << OTG_HS_DOEPTSIZx_PKTCNT_POS ) |
+    OTG_DOEPTSIZ(ep_num) = (pkt                  << OTG_HS_DOEPTSIZx_PKTCNT_POS ) |
                             num                                                   ;
   } else {
-    OTG_DOEPTSIZ(0U)     = (ptr_ep->packet_count << OTG_HS_DOEPTSIZx_PKTCNT_POS ) |
+    OTG_DOEPTSIZ(0U)     = (pkt                  << OTG_HS_DOEPTSIZx_PKTCNT_POS ) |
                            (3U                   << OTG_HS_DOEPTSIZ0_STUPCNT_POS) |
                             num                                                   ;
   }
@@ -406,6 +545,7 @@ static void USBD_EndpointReadSet (uint8_t ep_addr) {
   OTG_DOEPCTL(ep_num) |= OTG_HS_DOEPCTLx_EPENA | OTG_HS_DOEPCTLx_CNAK;
 }
 
+#if (USB_OTG_HS_DMA == 0U)                      // If DMA is not used (Slave Mode)
 /**
   \fn          int32_t USBD_ReadFromFifo (uint8_t ep_addr, uint16_t num)
   \brief       Read data from USB Endpoint.
@@ -487,16 +627,14 @@ static int32_t USBD_ReadFromFifo (uint8_t ep_addr, uint16_t num) {
 }
 
 /**
-  \fn          void USBD_WriteToFifo (uint8_t ep_addr)
-  \brief       Write data to Endpoint FIFO.
-  \param[in]   ep_addr  Endpoint Address
-                - ep_addr.0..3: Address
-                - ep_addr.7:    Direction
+  \fn          bool USBD_FifoFill (uint8_t ep_num)
+  \brief       Write packets of current IN transfer to Endpoint FIFO while space is available.
+  \param[in]   ep_num   Endpoint Number
+  \return      true = all data of current transfer written, false = FIFO full
 */
-static void USBD_WriteToFifo (uint8_t ep_addr) {
+static bool USBD_FifoFill (uint8_t ep_num) {
   volatile ENDPOINT_t *ptr_ep;
-  uint8_t              ep_num;
-  uint16_t             num, i;
+  uint32_t             num, i;
   volatile uint32_t   *ptr_dest;
 
   // [LNP]
@@ -506,17 +644,84 @@ static void USBD_WriteToFifo (uint8_t ep_addr) {
   uint32_t            *ptr_src;
 #endif
 
+  ptr_ep   = &ep[EP_ID(ep_num | ARM_USB_ENDPOINT_DIRECTION_MASK)];
+  ptr_dest = (volatile uint32_t *)(OTG_HS_BASE + 0x1000U + (ep_num * 0x1000U));
+
+  while (ptr_ep->num_written < ptr_ep->num_transferring) {
+    num = ptr_ep->num_transferring - ptr_ep->num_written;
+    if (num > ptr_ep->max_packet_size) { num = ptr_ep->max_packet_size; }
+
+    // Check if enough space in FIFO for whole packet
+    if ((OTG_DTXFSTS(ep_num) * 4U) < num) { return false; }
+
+    ptr_src = (__packed uint32_t *)(ptr_ep->data + ptr_ep->num_transferred_total + ptr_ep->num_written);
+    ptr_ep->num_written += num;
+
+    // Copy packet to FIFO
+    i = (num + 3U) >> 2;
+    while (i != 0U) {
+      *ptr_dest = *ptr_src++;
+      i--;
+    }
+  }
+
+  return true;
+}
+#endif
+
+/**
+  \fn          void USBD_WriteToFifo (uint8_t ep_addr)
+  \brief       Write data to Endpoint FIFO.
+  \param[in]   ep_addr  Endpoint Address
+                - ep_addr.0..3: Address
+                - ep_addr.7:    Direction
+*/
+static void USBD_WriteToFifo (uint8_t ep_addr) {
+  volatile ENDPOINT_t *ptr_ep;
+  uint32_t             num, pkt, max;
+  uint8_t              ep_num;
+
   ptr_ep = &ep[EP_ID(ep_addr)];
   ep_num = EP_NUM(ep_addr);
 
-  if (ptr_ep->num > ptr_ep->max_packet_size) { num = ptr_ep->max_packet_size; }
-  else                                       { num = ptr_ep->num;             }
+  pkt = ptr_ep->packet_count;
+  if ((ep_num != 0U) && (OTG_EP_IN_TYPE(ep_num) != ARM_USB_ENDPOINT_ISOCHRONOUS) &&
+#if (USB_OTG_HS_DMA == 0U)                      // If DMA is not used (Slave Mode)
+      // FIFO refill on half empty FIFO needs room for at least two packets
+      (tx_fifo_size[ep_num] >= (2U * ptr_ep->max_packet_size)) &&
+#endif
+      (ptr_ep->num > ptr_ep->max_packet_size)) {
+    // Send multiple packets with one transfer size setting
+    max = OTG_HS_DIEPTSIZx_XFRSIZ_MSK - (OTG_HS_DIEPTSIZx_XFRSIZ_MSK % ptr_ep->max_packet_size);
+    if (max > ((OTG_HS_DIEPTSIZx_PKTCNT_MSK >> OTG_HS_DIEPTSIZx_PKTCNT_POS) * ptr_ep->max_packet_size)) {
+      max =    (OTG_HS_DIEPTSIZx_PKTCNT_MSK >> OTG_HS_DIEPTSIZx_PKTCNT_POS) * ptr_ep->max_packet_size;
+    }
+    if (ptr_ep->num > max) { num = max;         }
+    else                   { num = ptr_ep->num; }
+    pkt = (num + ptr_ep->max_packet_size - 1U) / ptr_ep->max_packet_size;
+  } else {
+    if (ptr_ep->num > ptr_ep->max_packet_size) { num = ptr_ep->max_packet_size; }
+    else                                       { num = ptr_ep->num;             }
+  }
 
-  // Check if enough space in FIFO
-  if ((OTG_DTXFSTS(ep_num) * 4U) < num) { return; }
+#if (USB_OTG_HS_DMA != 0U)                      // If DMA is used
+#if ((USBD1_MANAGE_CACHE == 1U) && (__DCACHE_PRESENT == 1U))
+  if ((SCB->CCR & SCB_CCR_DC_Msk) != 0U) {      // If Data Cache is enabled
+    if (num != 0U) {
+      SCB_CleanDCache_by_Addr ((uint32_t *)((uint32_t)(ptr_ep->data + ptr_ep->num_transferred_total) & (~0x1FU)), num + 31U);
+    }
+  }
+#endif
+  OTG_DIEPDMA(ep_num) = (uint32_t)(ptr_ep->data + ptr_ep->num_transferred_total);
+#else                                           // If DMA is not used (Slave Mode)
+  // Check if enough space in FIFO for first packet
+  if (num > ptr_ep->max_packet_size) { max = ptr_ep->max_packet_size; }
+  else                               { max = num;                     }
+  if ((OTG_DTXFSTS(ep_num) * 4U) < max) { return; }
+#endif
 
   // Set transfer size and packet count
-  OTG_DIEPTSIZ(ep_num) = (ptr_ep->packet_count << OTG_HS_DIEPTSIZx_PKTCNT_POS) |
+  OTG_DIEPTSIZ(ep_num) = (pkt                  << OTG_HS_DIEPTSIZx_PKTCNT_POS) |
                          (ptr_ep->packet_count << OTG_HS_DIEPTSIZx_MCNT_POS)   |
                           num                                                  ;
 
@@ -529,19 +734,17 @@ static void USBD_WriteToFifo (uint8_t ep_addr) {
   // Enable Endpoint and clear NAK
   OTG_DIEPCTL(ep_num) |= OTG_HS_DIEPCTLx_EPENA | OTG_HS_DIEPCTLx_CNAK;
 
-  ptr_src  = (__packed uint32_t *)(ptr_ep->data + ptr_ep->num_transferred_total);
-  ptr_dest = (volatile uint32_t *)(OTG_HS_BASE + 0x1000U + (ep_num * 0x1000U));
-
   ptr_ep->num_transferring  = num;
   ptr_ep->num              -= num;
   ptr_ep->in_zlp            = 0U;
 
-  // Copy data to FIFO
-  i = (num + 3U) >> 2;
-  while (i != 0U) {
-    *ptr_dest = *ptr_src++;
-    i--;
+#if (USB_OTG_HS_DMA == 0U)                      // If DMA is not used (Slave Mode)
+  // Copy as many packets as fit into FIFO, rest on TX FIFO empty interrupt
+  ptr_ep->num_written       = 0U;
+  if (USBD_FifoFill (ep_num) == false) {
+    OTG->DIEPEMPMSK |= (1U << ep_num);
   }
+#endif
 }
 
 
@@ -742,7 +945,9 @@ static int32_t USBD_PowerControl (ARM_POWER_STATE state) {
       OTG->GINTMSK   = (OTG_HS_GINTMSK_USBSUSPM |       // Unmask interrupts
                         OTG_HS_GINTMSK_USBRST   |
                         OTG_HS_GINTMSK_ENUMDNEM |
+#if (USB_OTG_HS_DMA == 0U)                              // If DMA is not used (Slave Mode)
                         OTG_HS_GINTMSK_RXFLVLM  |
+#endif
                         OTG_HS_GINTMSK_IEPINT   |
                         OTG_HS_GINTMSK_OEPINT   |
 #if (defined(MX_USB_OTG_HS_VBUS_Pin) || defined(MX_USB_OTG_HS_ULPI_D7_Pin))
@@ -751,8 +956,11 @@ static int32_t USBD_PowerControl (ARM_POWER_STATE state) {
 #endif
                         OTG_HS_GINTMSK_WUIM)    ;
 
-      OTG->GAHBCFG  |= (OTG_HS_GAHBCFG_GINTMSK  |       // Enable interrupts
-                        OTG_HS_GAHBCFG_TXFELVL) ;
+#if (USB_OTG_HS_DMA != 0U)                              // If DMA is used
+      OTG->GAHBCFG  |=  OTG_HS_GAHBCFG_DMAEN;           // Enable DMA
+#endif
+      OTG->GAHBCFG  &= ~OTG_HS_GAHBCFG_TXFELVL;         // TX FIFO empty interrupt at half empty
+      OTG->GAHBCFG  |=  OTG_HS_GAHBCFG_GINTMSK;         // Enable interrupts
 
       hw_powered     = true;                            // Set powered flag
 #ifdef RTE_DEVICE_FRAMEWORK_CLASSIC
@@ -1013,6 +1221,8 @@ static int32_t USBD_EndpointUnconfigure (uint8_t ep_addr) {
 
   // IN Endpoint
   if (ep_dir != 0U) {
+    OTG->DIEPEMPMSK &= ~(1U << ep_num);                 // Stop FIFO refill
+
     // Disable Enabled IN Endpoint
     if ((OTG_DIEPCTL(ep_num) & OTG_HS_DIEPCTLx_EPENA) != 0U) {
       OTG_DIEPCTL(ep_num)  |=  OTG_HS_DIEPCTLx_EPDIS;
@@ -1073,6 +1283,7 @@ static int32_t USBD_EndpointStall (uint8_t ep_addr, bool stall) {
 
   if (stall != 0U) {                                    // Activate STALL
     if (ep_dir != 0U) {                                 // IN Endpoint
+      OTG->DIEPEMPMSK &= ~(1U << ep_num);               // Stop FIFO refill
       if ((OTG_DIEPCTL(ep_num) & OTG_HS_DIEPCTLx_EPENA) != 0U) {
         // Set flush flag to Flush IN FIFO in Endpoint disabled interrupt
         ptr_ep->in_flush = 1U;
@@ -1142,6 +1353,16 @@ static int32_t USBD_EndpointTransfer (uint8_t ep_addr, uint8_t *data, uint32_t n
   ptr_ep = &ep[EP_ID(ep_addr)];
   if (ptr_ep->active != 0U)           { return ARM_DRIVER_ERROR_BUSY; }
 
+#if (USB_OTG_HS_DMA != 0U)                      // If DMA is used
+                                                // Check 4-byte alignment
+  if ((((uint32_t)(data)) & 3U) != 0U)  { return ARM_DRIVER_ERROR; }
+#if (USBD1_MANAGE_CACHE == 1U)                  // Check cache line alignment of OUT buffer
+  if (((ep_addr & ARM_USB_ENDPOINT_DIRECTION_MASK) == 0U) && ((((uint32_t)(data)) & 0x1FU) != 0U)) {
+    return ARM_DRIVER_ERROR;
+  }
+#endif
+#endif
+
   ep_dir = (ep_addr & ARM_USB_ENDPOINT_DIRECTION_MASK) == ARM_USB_ENDPOINT_DIRECTION_MASK;
 
   ptr_ep->active = 1U;
@@ -1208,6 +1429,8 @@ static int32_t USBD_EndpointTransferAbort (uint8_t ep_addr) {
   ptr_ep->in_zlp = 0U;
 
   if ((ep_addr & ARM_USB_ENDPOINT_DIRECTION_MASK) != 0U) {
+    OTG->DIEPEMPMSK &= ~(1U << ep_num);                 // Stop FIFO refill
+
     if ((OTG_DIEPCTL(ep_num) & OTG_HS_DIEPCTLx_EPENA) != 0U) {
       // Set flush flag to Flush IN FIFO in Endpoint disabled interrupt
       ptr_ep->in_flush = 1U;
@@ -1259,7 +1482,12 @@ void USBD_HS_IRQ (uint32_t gintsts) {
 #if (defined(MX_USB_OTG_HS_VBUS_Pin) || defined(MX_USB_OTG_HS_ULPI_D7_Pin))
   uint32_t             gotgint;
 #endif
+#if ((USB_OTG_HS_DMA != 0U) && (USBD1_MANAGE_CACHE == 1U) && (__DCACHE_PRESENT == 1U))
+  uint32_t             addr;
+#endif
+#if (USB_OTG_HS_DMA == 0U)                              // If DMA is not used (Slave Mode)
   uint16_t             num;
+#endif
   uint8_t              ep_num, i;
   static uint32_t      IsoInIncomplete = 0U;
 
@@ -1318,6 +1546,7 @@ void USBD_HS_IRQ (uint32_t gintsts) {
     SignalDeviceEvent(ARM_USBD_EVENT_RESUME);
   }
 
+#if (USB_OTG_HS_DMA == 0U)                              // If DMA is not used (Slave Mode)
   if ((gintsts & OTG_HS_GINTSTS_RXFLVL) != 0U) {        // Receive FIFO interrupt
     val    =  OTG->GRXSTSP;
     ep_num =  val & 0x0FU;
@@ -1344,6 +1573,7 @@ void USBD_HS_IRQ (uint32_t gintsts) {
         break;
     }
   }
+#endif
 
   // OUT Packet
   if ((gintsts & OTG_HS_GINTSTS_OEPINT) != 0U) {
@@ -1359,6 +1589,9 @@ void USBD_HS_IRQ (uint32_t gintsts) {
             // Set packet count and transfer size
             OTG_DOEPTSIZ(ep_num) = (ptr_ep->packet_count << OTG_HS_DOEPTSIZx_PKTCNT_POS) |
                                    (ptr_ep->max_packet_size);
+#if (USB_OTG_HS_DMA != 0U)                              // If DMA is used
+            OTG_DOEPDMA(ep_num)  = (uint32_t)(ptr_ep->data + ptr_ep->num_transferred_total);
+#endif
 
             // Set correct frame
             if ((USBD_GetFrameNumber() & 1U) != 0U) { OTG_DOEPCTL(ep_num) |= OTG_HS_DOEPCTLx_SEVNFRM; }
@@ -1373,12 +1606,49 @@ void USBD_HS_IRQ (uint32_t gintsts) {
         if ((ep_int & OTG_HS_DOEPINTx_STUP) != 0U) {
           ptr_ep->num = 0U;
           OTG_DOEPINT(ep_num) = OTG_HS_DOEPINTx_STUP;
+#if (USB_OTG_HS_DMA != 0U)                              // If DMA is used
+          USBD_SetupRead ();
+          USBD_SetupReadSet ();
+#endif
           SignalEndpointEvent(ep_num, ARM_USBD_EVENT_SETUP);
         }
 
         // Transfer complete interrupt
         if ((ep_int & OTG_HS_DOEPINTx_XFCR) != 0U) {
           OTG_DOEPINT(ep_num) = OTG_HS_DOEPINTx_XFCR;
+#if (USB_OTG_HS_DMA != 0U)                              // If DMA is used
+          if (ptr_ep->active != 0U) {
+            // Number of bytes received by DMA
+            val = ptr_ep->num_transferring - (OTG_DOEPTSIZ(ep_num) & OTG_HS_DOEPTSIZx_XFRSIZ_MSK);
+#if ((USBD1_MANAGE_CACHE == 1U) && (__DCACHE_PRESENT == 1U))
+            if ((SCB->CCR & SCB_CCR_DC_Msk) != 0U) {    // If Data Cache is enabled
+              if (val != 0U) {
+                // Discard lines speculatively loaded during DMA (same lines as invalidated before DMA)
+                addr = (uint32_t)(ptr_ep->data + ptr_ep->num_transferred_total);
+                SCB_InvalidateDCache_by_Addr ((uint32_t *)(addr & (~0x1FU)), (int32_t)(((addr & 0x1FU) + val + 31U) & (~0x1FU)));
+              }
+            }
+#endif
+            ptr_ep->num_transferred_total += val;
+            if (val < ptr_ep->num) { ptr_ep->num -= val; }
+            else                   { ptr_ep->num  = 0U;  }
+
+            if ((ptr_ep->num != 0U) && (val == ptr_ep->num_transferring)) {
+              if (OTG_EP_OUT_TYPE(ep_num) != ARM_USB_ENDPOINT_ISOCHRONOUS) {
+                USBD_EndpointReadSet(ep_num);
+              }
+            } else {                                    // Short packet or buffer full
+              ptr_ep->num    = 0U;
+              ptr_ep->active = 0U;
+              if (ep_num == 0U) {
+                USBD_SetupReadSet ();                   // Re-enable reception of setup packets
+              }
+              SignalEndpointEvent(ep_num, ARM_USBD_EVENT_OUT);
+            }
+          } else if (ep_num == 0U) {
+            USBD_SetupReadSet ();                       // Re-enable reception of setup packets
+          }
+#else                                                   // If DMA is not used (Slave Mode)
           if (ptr_ep->num != 0U) {
             if (OTG_EP_OUT_TYPE(ep_num) != ARM_USB_ENDPOINT_ISOCHRONOUS) {
               USBD_EndpointReadSet(ep_num);
@@ -1387,6 +1657,7 @@ void USBD_HS_IRQ (uint32_t gintsts) {
             ptr_ep->active = 0U;
             SignalEndpointEvent(ep_num, ARM_USBD_EVENT_OUT);
           }
+#endif
         }
       }
       ep_num++;
@@ -1400,6 +1671,9 @@ void USBD_HS_IRQ (uint32_t gintsts) {
     do {
       if (((msk >> ep_num) & 1U) != 0U) {
         ep_int = OTG_DIEPINT(ep_num) & OTG->DIEPMSK;
+        if ((OTG->DIEPEMPMSK & (1U << ep_num)) != 0U) {
+          ep_int |= OTG_DIEPINT(ep_num) & OTG_HS_DIEPINTx_TXFE;
+        }
         ptr_ep = &ep[EP_ID(ep_num | ARM_USB_ENDPOINT_DIRECTION_MASK)];
 
         if ((ep_int & OTG_HS_DIEPINTx_EPDISD) != 0U) {  // If Endpoint disabled
@@ -1444,6 +1718,15 @@ void USBD_HS_IRQ (uint32_t gintsts) {
           OTG_DIEPINT(ep_num) = OTG_HS_DIEPINTx_INEPNE;
         }
 
+#if (USB_OTG_HS_DMA == 0U)                              // If DMA is not used (Slave Mode)
+        // Transmit FIFO empty
+        if ((ep_int & OTG_HS_DIEPINTx_TXFE) != 0U) {
+          if (USBD_FifoFill(ep_num) == true) {
+            OTG->DIEPEMPMSK &= ~(1U << ep_num);         // All packets written
+          }
+        }
+#endif
+
         // Transmit completed
         if ((ep_int & OTG_HS_DIEPINTx_XFCR) != 0U) {
           OTG_DIEPINT(ep_num) = OTG_HS_DIEPINTx_XFCR;
@@ -0,0 +1,179 @@
+/*
+ * Host build of the CAN driver: subset of the CMSIS-Driver Driver_CAN.h
+ * (API V1.2) used by CMSIS/Driver/CAN_STM32F7xx.c and the tests.
+ */
+
+#ifndef DRIVER_CAN_H_
+#define DRIVER_CAN_H_
+
+#include "Driver_Common.h"
+
+#define ARM_CAN_API_VERSION ARM_DRIVER_VERSION_MAJOR_MINOR(1,2)
+
+/* Bitrate selection */
+typedef enum _ARM_CAN_BITRATE_SELECT {
+  ARM_CAN_BITRATE_NOMINAL,              // Select nominal (flexible data-rate arbitration) bitrate
+  ARM_CAN_BITRATE_FD_DATA               // Select flexible data-rate data bitrate
+} ARM_CAN_BITRATE_SELECT;
+
+/* Operating modes */
+typedef enum _ARM_CAN_MODE {
+  ARM_CAN_MODE_INITIALIZATION,          // Initialization mode
+  ARM_CAN_MODE_NORMAL,                  // Normal operation mode
+  ARM_CAN_MODE_RESTRICTED,              // Restricted operation mode
+  ARM_CAN_MODE_MONITOR,                 // Bus monitoring mode
+  ARM_CAN_MODE_LOOPBACK_INTERNAL,       // Loopback internal mode
+  ARM_CAN_MODE_LOOPBACK_EXTERNAL        // Loopback external mode
+} ARM_CAN_MODE;
+
+/* Bit timing segments (SetBitrate) */
+#define ARM_CAN_BIT_PROP_SEG_Pos        0UL
+#define ARM_CAN_BIT_PROP_SEG_Msk        (0xFFUL << ARM_CAN_BIT_PROP_SEG_Pos)
+#define ARM_CAN_BIT_PROP_SEG(x)         (((x) << ARM_CAN_BIT_PROP_SEG_Pos) & ARM_CAN_BIT_PROP_SEG_Msk)
+#define ARM_CAN_BIT_PHASE_SEG1_Pos      8UL
+#define ARM_CAN_BIT_PHASE_SEG1_Msk      (0xFFUL << ARM_CAN_BIT_PHASE_SEG1_Pos)
+#define ARM_CAN_BIT_PHASE_SEG1(x)       (((x) << ARM_CAN_BIT_PHASE_SEG1_Pos) & ARM_CAN_BIT_PHASE_SEG1_Msk)
+#define ARM_CAN_BIT_PHASE_SEG2_Pos      16UL
+#define ARM_CAN_BIT_PHASE_SEG2_Msk      (0xFFUL << ARM_CAN_BIT_PHASE_SEG2_Pos)
+#define ARM_CAN_BIT_PHASE_SEG2(x)       (((x) << ARM_CAN_BIT_PHASE_SEG2_Pos) & ARM_CAN_BIT_PHASE_SEG2_Msk)
+#define ARM_CAN_BIT_SJW_Pos             24UL
+#define ARM_CAN_BIT_SJW_Msk             (0xFFUL << ARM_CAN_BIT_SJW_Pos)
+#define ARM_CAN_BIT_SJW(x)              (((x) << ARM_CAN_BIT_SJW_Pos) & ARM_CAN_BIT_SJW_Msk)
+
+/* Control operations */
+#define ARM_CAN_CONTROL_Pos             0UL
+#define ARM_CAN_CONTROL_Msk             (0xFFUL << ARM_CAN_CONTROL_Pos)
+#define ARM_CAN_SET_FD_MODE             (1UL << ARM_CAN_CONTROL_Pos)
+#define ARM_CAN_ABORT_MESSAGE_SEND      (2UL << ARM_CAN_CONTROL_Pos)
+#define ARM_CAN_CONTROL_RETRANSMISSION  (3UL << ARM_CAN_CONTROL_Pos)
+#define ARM_CAN_SET_TRANSCEIVER_DELAY   (4UL << ARM_CAN_CONTROL_Pos)
+
+/* Identifier */
+#define ARM_CAN_ID_IDE_Pos              31UL
+#define ARM_CAN_ID_IDE_Msk              (1UL << ARM_CAN_ID_IDE_Pos)
+#define ARM_CAN_STANDARD_ID(id)         ((id) & 0x000007FFUL)
+#define ARM_CAN_EXTENDED_ID(id)         (((id) & 0x1FFFFFFFUL) | ARM_CAN_ID_IDE_Msk)
+
+/* Filter operations */
+typedef enum _ARM_CAN_FILTER_OPERATION {
+  ARM_CAN_FILTER_ID_EXACT_ADD,          // Add    exact id filter
+  ARM_CAN_FILTER_ID_EXACT_REMOVE,       // Remove exact id filter
+  ARM_CAN_FILTER_ID_RANGE_ADD,          // Add    range id filter
+  ARM_CAN_FILTER_ID_RANGE_REMOVE,       // Remove range id filter
+  ARM_CAN_FILTER_ID_MASKABLE_ADD,       // Add    maskable id filter
+  ARM_CAN_FILTER_ID_MASKABLE_REMOVE     // Remove maskable id filter
+} ARM_CAN_FILTER_OPERATION;
+
+/* Object configuration */
+typedef enum _ARM_CAN_OBJ_CONFIG {
+  ARM_CAN_OBJ_INACTIVE,                 // Object is inactive
+  ARM_CAN_OBJ_TX,                       // Transmit object
+  ARM_CAN_OBJ_RX,                       // Receive object
+  ARM_CAN_OBJ_RX_RTR_TX_DATA,           // Remote request receive, automatic data transmit
+  ARM_CAN_OBJ_TX_RTR_RX_DATA            // Remote request transmit, automatic data receive
+} ARM_CAN_OBJ_CONFIG;
+
+/* Message information */
+typedef struct _ARM_CAN_MSG_INFO {
+  uint32_t id;                          // Identifier (ARM_CAN_ID_IDE_Msk for extended)
+  uint32_t rtr       :  1;              // Remote transmission request frame
+  uint32_t edl       :  1;              // Flexible data-rate format extended data length
+  uint32_t brs       :  1;              // Flexible data-rate format with bitrate switch
+  uint32_t esi       :  1;              // Flexible data-rate format error state indicator
+  uint32_t dlc       :  4;              // Data length code
+  uint32_t reserved  : 24;
+} ARM_CAN_MSG_INFO;
+
+/* Unit state */
+#define ARM_CAN_UNIT_STATE_INACTIVE     (0U)
+#define ARM_CAN_UNIT_STATE_ACTIVE       (1U)
+#define ARM_CAN_UNIT_STATE_PASSIVE      (2U)
+#define ARM_CAN_UNIT_STATE_BUS_OFF      (3U)
+
+/* Last error code */
+#define ARM_CAN_LEC_NO_ERROR            (0U)
+#define ARM_CAN_LEC_BIT_ERROR           (1U)
+#define ARM_CAN_LEC_STUFF_ERROR         (2U)
+#define ARM_CAN_LEC_CRC_ERROR           (3U)
+#define ARM_CAN_LEC_FORM_ERROR          (4U)
+#define ARM_CAN_LEC_ACK_ERROR           (5U)
+
+/* Status */
+typedef volatile struct _ARM_CAN_STATUS {
+  uint32_t unit_state      : 4;         // Unit bus state
+  uint32_t last_error_code : 4;         // Last error code
+  uint32_t tx_error_count  : 8;         // Transmitter error count
+  uint32_t rx_error_count  : 8;         // Receiver error count
+  uint32_t reserved        : 8;
+} ARM_CAN_STATUS;
+
+/* Unit events */
+#define ARM_CAN_EVENT_UNIT_INACTIVE     (0U)
+#define ARM_CAN_EVENT_UNIT_ACTIVE       (1U)
+#define ARM_CAN_EVENT_UNIT_WARNING      (3U)
+#define ARM_CAN_EVENT_UNIT_PASSIVE      (4U)
+#define ARM_CAN_EVENT_UNIT_BUS_OFF      (5U)
+
+/* Object events */
+#define ARM_CAN_EVENT_SEND_COMPLETE     (1UL << 0)
+#define ARM_CAN_EVENT_RECEIVE           (1UL << 1)
+#define ARM_CAN_EVENT_RECEIVE_OVERRUN   (1UL << 2)
+
+/* Driver specific error codes */
+#define ARM_CAN_INVALID_BITRATE_SELECT  (ARM_DRIVER_ERROR_SPECIFIC - 1)
+#define ARM_CAN_INVALID_BITRATE         (ARM_DRIVER_ERROR_SPECIFIC - 2)
+#define ARM_CAN_INVALID_BIT_PROP_SEG    (ARM_DRIVER_ERROR_SPECIFIC - 3)
+#define ARM_CAN_INVALID_BIT_PHASE_SEG1  (ARM_DRIVER_ERROR_SPECIFIC - 4)
+#define ARM_CAN_INVALID_BIT_PHASE_SEG2  (ARM_DRIVER_ERROR_SPECIFIC - 5)
+#define ARM_CAN_INVALID_BIT_SJW         (ARM_DRIVER_ERROR_SPECIFIC - 6)
+#define ARM_CAN_NO_MESSAGE_AVAILABLE    (ARM_DRIVER_ERROR_SPECIFIC - 7)
+
+typedef void (*ARM_CAN_SignalUnitEvent_t)   (uint32_t event);
+typedef void (*ARM_CAN_SignalObjectEvent_t) (uint32_t obj_idx, uint32_t event);
+
+/* Driver capabilities */
+typedef struct _ARM_CAN_CAPABILITIES {
+  uint32_t num_objects         :  8;
+  uint32_t reentrant_operation :  1;
+  uint32_t fd_mode             :  1;
+  uint32_t restricted_mode     :  1;
+  uint32_t monitor_mode        :  1;
+  uint32_t internal_loopback   :  1;
+  uint32_t external_loopback   :  1;
+  uint32_t reserved            : 18;
+} ARM_CAN_CAPABILITIES;
+
+/* Object capabilities */
+typedef struct _ARM_CAN_OBJ_CAPABILITIES {
+  uint32_t tx               :  1;
+  uint32_t rx               :  1;
+  uint32_t rx_rtr_tx_data   :  1;
+  uint32_t tx_rtr_rx_data   :  1;
+  uint32_t multiple_filters :  1;
+  uint32_t exact_filtering  :  1;
+  uint32_t range_filtering  :  1;
+  uint32_t mask_filtering   :  1;
+  uint32_t message_depth    :  8;
+  uint32_t reserved         : 16;
+} ARM_CAN_OBJ_CAPABILITIES;
+
+/* Access structure of the CAN Driver */
+typedef struct _ARM_DRIVER_CAN {
+  ARM_DRIVER_VERSION       (*GetVersion)            (void);
+  ARM_CAN_CAPABILITIES     (*GetCapabilities)       (void);
+  int32_t                  (*Initialize)            (ARM_CAN_SignalUnitEvent_t cb_unit_event, ARM_CAN_SignalObjectEvent_t cb_object_event);
+  int32_t                  (*Uninitialize)          (void);
+  int32_t                  (*PowerControl)          (ARM_POWER_STATE state);
+  uint32_t                 (*GetClock)              (void);
+  int32_t                  (*SetBitrate)            (ARM_CAN_BITRATE_SELECT select, uint32_t bitrate, uint32_t bit_segments);
+  int32_t                  (*SetMode)               (ARM_CAN_MODE mode);
+  ARM_CAN_OBJ_CAPABILITIES (*ObjectGetCapabilities) (uint32_t obj_idx);
+  int32_t                  (*ObjectSetFilter)       (uint32_t obj_idx, ARM_CAN_FILTER_OPERATION operation, uint32_t id, uint32_t arg);
+  int32_t                  (*ObjectConfigure)       (uint32_t obj_idx, ARM_CAN_OBJ_CONFIG obj_cfg);
+  int32_t                  (*MessageSend)           (uint32_t obj_idx, ARM_CAN_MSG_INFO *msg_info, const uint8_t *data, uint8_t size);
+  int32_t                  (*MessageRead)           (uint32_t obj_idx, ARM_CAN_MSG_INFO *msg_info, uint8_t *data, uint8_t size);
+  int32_t                  (*Control)               (uint32_t control, uint32_t arg);
+  ARM_CAN_STATUS           (*GetStatus)             (void);
+} const ARM_DRIVER_CAN;
+
+#endif /* DRIVER_CAN_H_ */
@@ -0,0 +1,37 @@
+/*
+ * Host build of the CAN driver: subset of the CMSIS-Driver Driver_Common.h
+ * (API V2.0) used by CMSIS/Driver/CAN_STM32F7xx.c.
+ */
+
+#ifndef DRIVER_COMMON_H_
+#define DRIVER_COMMON_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ARM_DRIVER_VERSION_MAJOR_MINOR(major,minor) (((major) << 8) | (minor))
+
+/* Driver Version */
+typedef struct _ARM_DRIVER_VERSION {
+  uint16_t api;                         // API version
+  uint16_t drv;                         // Driver version
+} ARM_DRIVER_VERSION;
+
+/* Status and Error Codes */
+#define ARM_DRIVER_OK                 0 // Operation succeeded
+#define ARM_DRIVER_ERROR             -1 // Unspecified error
+#define ARM_DRIVER_ERROR_BUSY        -2 // Driver is busy
+#define ARM_DRIVER_ERROR_TIMEOUT     -3 // Timeout occurred
+#define ARM_DRIVER_ERROR_UNSUPPORTED -4 // Operation not supported
+#define ARM_DRIVER_ERROR_PARAMETER   -5 // Parameter error
+#define ARM_DRIVER_ERROR_SPECIFIC    -6 // Start of driver specific errors
+
+/* General power states */
+typedef enum _ARM_POWER_STATE {
+  ARM_POWER_OFF,                        // Power off
+  ARM_POWER_LOW,                        // Low Power mode
+  ARM_POWER_FULL                        // Power on: full operation at maximum performance
+} ARM_POWER_STATE;
+
+#endif /* DRIVER_COMMON_H_ */
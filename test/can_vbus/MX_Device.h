@@ -0,0 +1,7 @@
+/*
+ * Host build of the CAN driver: CAN1 and CAN2 enabled (no pins, the
+ * CubeMX framework path of the driver does not configure GPIO).
+ */
+
+#define MX_CAN1                         1
+#define MX_CAN2                         1
@@ -0,0 +1,7 @@
+/*
+ * Host build of the CAN driver: STM32CubeMX framework, CAN1 and CAN2.
+ */
+
+#define RTE_DEVICE_FRAMEWORK_CUBE_MX
+#define RTE_Drivers_CAN1
+#define RTE_Drivers_CAN2
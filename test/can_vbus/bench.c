@@ -0,0 +1,275 @@
+/*
+ * Host benchmark of the STM32F7xx CAN driver on the virtual bus.
+ *
+ * Frames of 8 data bytes go from CAN1 (software transmit queue) to CAN2
+ * (message read in the object callback) and from CAN2 (three mailboxes)
+ * to CAN1 (software receive queue, read in batches of 16):
+ *  - single: one frame on the way at a time, the next one is sent when
+ *    the previous one was received;
+ *  - stream: the sender keeps its queue or mailboxes full.
+ *
+ * For each workload the table lists the bus time per frame, the bus load
+ * reported by the driver statistics of the sender (ARM_CAN_GET_STATISTICS,
+ * sliding window), the latency from MessageSend to the frame in the
+ * receiver's hands (bus bit times, resolution one bus tick), the register
+ * writes and interrupt handler calls per frame and the host CPU time per
+ * frame (driver and bus model). Every frame is checked to arrive once
+ * with its data. All frames have the same identifier: the controller sends
+ * equal identifiers from the lowest mailbox first, so in the CAN2 stream a
+ * frame can wait in mailbox 2 while mailboxes 0 and 1 are refilled (maximum
+ * latency), unlike the request order kept by the CAN1 transmit queue.
+ *
+ * Bus times are bit times of the virtual bus (500 kbit/s: 2 us per bit),
+ * not target timing; register writes are trapped, so the CPU time is
+ * dominated by the bus model.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "vbus.h"
+
+#define FRAMES          2000U           // Frames per workload
+#define TIMEOUT         20000U          // Wait limit in bus ticks (2 s)
+
+/* 500 kbit/s at 50 MHz: 10 time quanta, BRP 10 */
+#define SEGMENTS        (ARM_CAN_BIT_PROP_SEG (3U) | ARM_CAN_BIT_PHASE_SEG1 (3U) \
+                         | ARM_CAN_BIT_PHASE_SEG2 (3U) | ARM_CAN_BIT_SJW (1U))
+
+/* Control argument: static objects have 32-bit addresses (no PIE) */
+#define ADDR(p)         ((uint32_t) (uintptr_t) (p))
+
+typedef struct
+{
+  const char *name;
+  uint32_t from;                        // Sending controller (0: CAN1, 1: CAN2)
+  uint32_t stream;                      // Keep the sender busy
+} workload_t;
+
+static ARM_DRIVER_CAN * const drv[2] = { &Driver_CAN1, &Driver_CAN2 };
+
+/* Control arguments (static: 32-bit addresses) */
+static CAN_FILTER_ENTRY ft_entry[1];
+static CAN_FILTER_TABLE ft;
+static CAN_RX_QUEUE_READ rq;
+static CAN_RX_MSG rx_buf[16];
+static CAN_STATISTICS stat;
+
+static uint64_t sent_at[FRAMES];
+static uint8_t seen[FRAMES];
+static volatile uint32_t received;
+static uint64_t lat_min, lat_max, lat_sum;
+static uint32_t errors;
+
+static uint32_t
+ticks (void)
+{
+  return *(volatile uint32_t *) &vbus.ticks;
+}
+
+/* Frame with sequence number seq received */
+static void
+frame_in (const uint8_t *data, uint32_t dlc)
+{
+  uint32_t seq, i;
+  uint64_t lat;
+
+  seq = (uint32_t) data[0] | ((uint32_t) data[1] << 8);
+  if ((dlc != 8U) || (seq >= FRAMES) || (seen[seq] != 0U))
+    {
+      errors++;
+      return;
+    }
+  for (i = 2U; i < 8U; i++)
+    {
+      if (data[i] != (uint8_t) (seq + i))
+        {
+          errors++;
+          return;
+        }
+    }
+  seen[seq] = 1U;
+  lat = vbus_time () - sent_at[seq];
+  if (lat < lat_min)
+    {
+      lat_min = lat;
+    }
+  if (lat > lat_max)
+    {
+      lat_max = lat;
+    }
+  lat_sum += lat;
+  received++;
+}
+
+static void
+can2_object_event (uint32_t obj_idx, uint32_t event)
+{
+  ARM_CAN_MSG_INFO info;
+  uint8_t data[8];
+
+  if ((obj_idx < 2U) && (event & ARM_CAN_EVENT_RECEIVE))
+    {
+      if (drv[1]->MessageRead (obj_idx, &info, data, 8U) >= 0)
+        {
+          frame_in (data, info.dlc);
+        }
+    }
+}
+
+static int32_t
+start (uint32_t x)
+{
+  ARM_DRIVER_CAN *d = drv[x];
+  uint32_t obj;
+  int32_t err;
+
+  err = d->PowerControl (ARM_POWER_OFF);
+  err |= d->PowerControl (ARM_POWER_FULL);
+  err |= d->SetMode (ARM_CAN_MODE_INITIALIZATION);
+  err |= d->SetBitrate (ARM_CAN_BITRATE_NOMINAL, 500000U, SEGMENTS);
+  for (obj = 0U; obj < 5U; obj++)
+    {
+      err |= d->ObjectConfigure (obj, (obj < 2U) ? ARM_CAN_OBJ_RX : ARM_CAN_OBJ_TX);
+    }
+  ft_entry[0].id      = ARM_CAN_STANDARD_ID (0U);
+  ft_entry[0].type    = CAN_FILTER_ENTRY_MASK;
+  ft_entry[0].obj_idx = 0U;
+  ft.entry = ft_entry;
+  ft.num   = 1U;
+  err |= d->Control (ARM_CAN_SET_FILTER_TABLE, ADDR (&ft));
+  err |= d->SetMode (ARM_CAN_MODE_NORMAL);
+  return err;
+}
+
+/* Send frame seq, returns 0 if the sender is busy */
+static uint32_t
+frame_out (uint32_t x, uint32_t seq)
+{
+  static uint8_t data[8];
+  ARM_CAN_MSG_INFO info;
+  uint32_t i, obj;
+
+  memset (&info, 0, sizeof (info));
+  info.id = 0x100U;
+  data[0] = (uint8_t) seq;
+  data[1] = (uint8_t) (seq >> 8);
+  for (i = 2U; i < 8U; i++)
+    {
+      data[i] = (uint8_t) (seq + i);
+    }
+  sent_at[seq] = vbus_time ();
+  for (obj = 2U; obj < ((x == 0U) ? 3U : 5U); obj++)
+    {
+      if (drv[x]->MessageSend (obj, &info, data, 8U) == 8)
+        {
+          return 1U;
+        }
+    }
+  return 0U;
+}
+
+/* Read the CAN1 receive queue */
+static void
+queue_in (void)
+{
+  int32_t n, i;
+
+  rq.obj_idx = 0U;
+  rq.msg     = rx_buf;
+  rq.num     = 16U;
+  n = drv[0]->Control (ARM_CAN_READ_RX_QUEUE, ADDR (&rq));
+  for (i = 0; i < n; i++)
+    {
+      frame_in (rx_buf[i].data, rx_buf[i].dlc);
+    }
+}
+
+static void
+run (const workload_t *w)
+{
+  uint32_t sent, t0, writes, irqs;
+  uint64_t bits;
+  clock_t cpu;
+
+  memset (seen, 0, sizeof (seen));
+  received = 0U;
+  lat_min = UINT64_MAX;
+  lat_max = 0U;
+  lat_sum = 0U;
+  errors = 0U;
+  if ((start (0U) != ARM_DRIVER_OK) || (start (1U) != ARM_DRIVER_OK))
+    {
+      printf ("%-22s setup failed\n", w->name);
+      return;
+    }
+  drv[w->from]->Control (ARM_CAN_CONTROL_STATISTICS, 1U);
+
+  vbus_clear ();
+  bits = vbus_time ();
+  cpu = clock ();
+  sent = 0U;
+  t0 = ticks ();
+  while ((received < FRAMES) && ((ticks () - t0) < TIMEOUT))
+    {
+      if ((sent < FRAMES) && ((w->stream != 0U) || (received == sent)))
+        {
+          if (frame_out (w->from, sent) != 0U)
+            {
+              sent++;
+              t0 = ticks ();
+            }
+        }
+      if (w->from == 1U)
+        {
+          queue_in ();
+        }
+    }
+  cpu = clock () - cpu;
+  bits = vbus_time () - bits;
+  writes = vbus.writes;
+  irqs = vbus.irqs;
+  drv[w->from]->Control (ARM_CAN_GET_STATISTICS, ADDR (&stat));
+
+  if ((received != FRAMES) || (errors != 0U) || (vbus.irq_storm != 0U)
+      || (vbus.locked != 0U))
+    {
+      printf ("%-22s %u of %u frames, %u errors\n", w->name, (unsigned) received,
+              (unsigned) FRAMES, (unsigned) errors);
+      return;
+    }
+  printf ("%-22s %9.1f %7.1f%% %7llu %8.1f %7llu %8.1f %7.2f %8.1f\n", w->name,
+          (double) bits / FRAMES, stat.bus_load / 10.0, (unsigned long long) lat_min,
+          (double) lat_sum / FRAMES, (unsigned long long) lat_max,
+          (double) writes / FRAMES, (double) irqs / FRAMES,
+          ((double) cpu * 1000000.0 / CLOCKS_PER_SEC) / FRAMES);
+}
+
+int
+main (void)
+{
+  static const workload_t workloads[] =
+    {
+      { "CAN1 queue > CAN2",    0U, 0U },
+      { "  stream",             0U, 1U },
+      { "CAN2 > CAN1 queue",    1U, 0U },
+      { "  stream",             1U, 1U },
+    };
+  uint32_t i;
+
+  drv[0]->Initialize (NULL, NULL);
+  drv[1]->Initialize (NULL, can2_object_event);
+  vbus_start (100U);
+
+  printf ("%-22s %9s %8s %7s %8s %7s %8s %7s %8s\n", "workload", "bits/frm",
+          "load", "lat min", "lat avg", "lat max", "wr/frm", "irq/frm", "cpu us");
+  for (i = 0U; i < (sizeof (workloads) / sizeof (workloads[0])); i++)
+    {
+      run (&workloads[i]);
+    }
+  vbus_stop ();
+
+  return 0;
+}
@@ -0,0 +1,41 @@
+/*
+ * Host build of the CAN driver: Cortex-M7 core definitions.
+ *
+ * PRIMASK is the SIGALRM mask of the process: the virtual bus runs the
+ * controller models and the interrupt handlers from SIGALRM (see vbus.c),
+ * so __disable_irq() keeps interrupts out exactly like on the target.
+ * The NVIC enable and pending bits are kept by the virtual bus.
+ */
+
+#ifndef __CORE_CM7_H
+#define __CORE_CM7_H
+
+#include <stdint.h>
+
+#define __I     volatile const
+#define __O     volatile
+#define __IO    volatile
+#define __IM    volatile const
+#define __OM    volatile
+#define __IOM   volatile
+
+#define __ALIGNED(x)    __attribute__((aligned(x)))
+#define __STATIC_INLINE static inline
+#define __packed
+
+static inline void __NOP (void) { }
+static inline void __DSB (void) { }
+static inline void __ISB (void) { }
+static inline void __DMB (void) { }
+
+uint32_t __get_PRIMASK (void);
+void     __set_PRIMASK (uint32_t priMask);
+void     __disable_irq (void);
+void     __enable_irq  (void);
+
+void NVIC_EnableIRQ       (IRQn_Type IRQn);
+void NVIC_DisableIRQ      (IRQn_Type IRQn);
+void NVIC_SetPendingIRQ   (IRQn_Type IRQn);
+void NVIC_ClearPendingIRQ (IRQn_Type IRQn);
+
+#endif /* __CORE_CM7_H */
@@ -0,0 +1,36 @@
+/*
+ * Host build of CMSIS/Driver/CAN_STM32F7xx.c for the virtual bus test.
+ *
+ * The driver source is included unchanged, with software receive and
+ * transmit queues on CAN1 (CAN2 uses the FIFOs and mailboxes directly);
+ * the functions below give the tests access to driver internals that are
+ * static.
+ */
+
+#define CAN1_RX_QUEUE_SIZE      32U
+#define CAN1_TX_QUEUE_SIZE      32U
+
+#include "CAN_STM32F7xx.c"
+
+#include "vbus.h"
+
+/* Arbitration priority of a mailbox identifier (lower wins) */
+uint32_t
+vbus_tx_priority (uint32_t tir)
+{
+  return CAN_TxPriority (tir);
+}
+
+/* First filter bank of CAN2 as kept by the driver */
+uint32_t
+vbus_filter_split (void)
+{
+  return can_filter_bank[1][0];
+}
+
+/* Messages in the software transmit queue of controller x */
+uint32_t
+vbus_tx_queued (uint32_t x)
+{
+  return can_tx_queue[x].cnt;
+}
@@ -0,0 +1,1631 @@
+/*
+ * Host test of the STM32F7xx CAN driver (CMSIS/Driver/CAN_STM32F7xx.c) on
+ * the virtual bus (vbus.c).
+ *
+ * CAN1 (software receive and transmit queues) and CAN2 (FIFOs and
+ * mailboxes, messages read in the object callback) are connected to one
+ * bus and checked by the frames on the bus (vbus_log), the frames the
+ * other controller received, the driver events and the bus counters:
+ *  - init: power up, bit timing, unit state;
+ *  - loopback: internal and external loopback, back to normal mode;
+ *  - frames: standard/extended, data/remote frames both ways, FIFO
+ *    selection by the filter table;
+ *  - arbitration: simultaneous requests of CAN1 and CAN2;
+ *  - errors: acknowledgment errors up to error passive, abort, recovery,
+ *    one shot mode and abort without queue, receive queue overrun;
+ *  - tx priority: CAN_TxPriority against bitwise arbitration, transmit
+ *    queue order with and without mailbox replacement (reference model);
+ *  - filter table: ARM_CAN_SET_FILTER_TABLE on random tables of both
+ *    controllers against the entries (exact, mask, range, data only),
+ *    bank split, full tables, frames through the compiled filters;
+ *  - set filter: ObjectSetFilter exact and mask filters, add and remove;
+ *  - timestamp: 64-bit time stamps across 16-bit counter wraps;
+ *  - trace: candump log output and replay, SocketCAN bridge (-i).
+ *
+ * Each test must leave the interrupt lines quiet (no handler storm) and
+ * must not write locked registers.
+ *
+ * Options:
+ *   -i ifname  bridge the external node to SocketCAN interface ifname
+ *   -w file    keep the candump log of the trace test in file
+ */
+
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+
+#include "vbus.h"
+
+#define TIMEOUT         20000U          // Wait limit in bus ticks (2 s)
+#define RX2_SIZE        256U            // CAN2 receive ring
+
+/* 500 kbit/s at 50 MHz: 10 time quanta, BRP 10 */
+#define SEGMENTS        (ARM_CAN_BIT_PROP_SEG (3U) | ARM_CAN_BIT_PHASE_SEG1 (3U) \
+                         | ARM_CAN_BIT_PHASE_SEG2 (3U) | ARM_CAN_BIT_SJW (1U))
+
+/* Control argument: static objects have 32-bit addresses (no PIE) */
+#define ADDR(p)         ((uint32_t) (uintptr_t) (p))
+
+typedef struct
+{
+  CAN_RX_MSG msg;
+  uint32_t obj_idx;
+} rx_t;
+
+static ARM_DRIVER_CAN * const drv[2] = { &Driver_CAN1, &Driver_CAN2 };
+
+/* Control arguments and send buffer (static: 32-bit addresses) */
+static CAN_RX_QUEUE_READ rq;
+static CAN_RX_MSG rx_buf[64];
+static CAN_FILTER_ENTRY ft_entry[64];
+static CAN_FILTER_TABLE ft;
+static CAN_TIMESTAMP ts;
+static uint8_t tx_buf[8];
+
+static volatile uint32_t unit_events[2];        // Mask of unit events (1 << event)
+static volatile uint32_t obj_events[2][5];      // Object events
+static volatile uint32_t send_done[2][5];       // Send complete events
+
+/* Messages read by CAN2 in the object callback */
+static rx_t rx2[RX2_SIZE];
+static volatile uint32_t rx2_cnt;
+
+static uint32_t storms;                 // Interrupt storms before clear ()
+static uint32_t locked_writes;          // Locked register writes before clear ()
+
+static const char *ifname;
+static const char *trace_file;
+static uint32_t rnd_state = 0x12345678U;
+static uint32_t failed;
+
+#define CHECK(cond, ...)                                                \
+  do                                                                    \
+    {                                                                   \
+      if (!(cond))                                                      \
+        {                                                               \
+          printf ("  %s:%d: ", __func__, __LINE__);                     \
+          printf (__VA_ARGS__);                                         \
+          printf ("\n");                                                \
+          failed++;                                                     \
+        }                                                               \
+    }                                                                   \
+  while (0)
+
+static uint32_t
+rnd (void)
+{
+  rnd_state ^= rnd_state << 13;
+  rnd_state ^= rnd_state >> 17;
+  rnd_state ^= rnd_state << 5;
+  return rnd_state;
+}
+
+static uint32_t
+ticks (void)
+{
+  return *(volatile uint32_t *) &vbus.ticks;
+}
+
+/* Wait until *p reaches n, returns 0 on timeout */
+static uint32_t
+wait_for (const volatile uint32_t *p, uint32_t n)
+{
+  uint32_t t0;
+
+  t0 = ticks ();
+  while ((*p < n) && ((ticks () - t0) < TIMEOUT))
+    {
+    }
+  return (*p >= n) ? 1U : 0U;
+}
+
+static void
+wait_ticks (uint32_t n)
+{
+  uint32_t t0;
+
+  t0 = ticks ();
+  while ((ticks () - t0) < n)
+    {
+    }
+}
+
+/* Wait until the bus time passed n bit times */
+static void
+wait_bits (uint64_t n)
+{
+  uint64_t t0;
+  uint32_t k0;
+
+  t0 = vbus_time ();
+  k0 = ticks ();
+  while (((vbus_time () - t0) < n) && ((ticks () - k0) < (TIMEOUT * 4U)))
+    {
+    }
+}
+
+/* Clear bus counters and log, keeping the storm and lock counts */
+static void
+clear (void)
+{
+  __disable_irq ();
+  storms += vbus.irq_storm;
+  locked_writes += vbus.locked;
+  vbus_clear ();
+  __enable_irq ();
+}
+
+static uint32_t
+storms_now (void)
+{
+  return storms + vbus.irq_storm;
+}
+
+static uint32_t
+locked_now (void)
+{
+  return locked_writes + vbus.locked;
+}
+
+static void
+unit_event (uint32_t x, uint32_t event)
+{
+  unit_events[x] |= 1UL << event;
+}
+
+static void
+object_event (uint32_t x, uint32_t obj_idx, uint32_t event)
+{
+  ARM_CAN_MSG_INFO info;
+  rx_t *r;
+  int32_t n;
+
+  obj_events[x][obj_idx] |= event;
+  if (event & ARM_CAN_EVENT_SEND_COMPLETE)
+    {
+      send_done[x][obj_idx]++;
+    }
+
+  /* CAN2 reads the message here: the FIFO is released by MessageRead */
+  if ((x == 1U) && (obj_idx < 2U) && (event & ARM_CAN_EVENT_RECEIVE))
+    {
+      r = &rx2[rx2_cnt % RX2_SIZE];
+      memset (r, 0, sizeof (*r));
+      memset (&info, 0, sizeof (info));
+      n = drv[1]->MessageRead (obj_idx, &info, r->msg.data, 8U);
+      if (n >= 0)
+        {
+          r->msg.id  = info.id;
+          r->msg.rtr = (uint8_t) info.rtr;
+          r->msg.dlc = (uint8_t) info.dlc;
+          r->obj_idx = obj_idx;
+          rx2_cnt++;
+        }
+    }
+}
+
+static void can1_unit_event (uint32_t event) { unit_event (0U, event); }
+static void can2_unit_event (uint32_t event) { unit_event (1U, event); }
+static void can1_object_event (uint32_t obj_idx, uint32_t event) { object_event (0U, obj_idx, event); }
+static void can2_object_event (uint32_t obj_idx, uint32_t event) { object_event (1U, obj_idx, event); }
+
+static void
+events_clear (void)
+{
+  memset ((void *) unit_events, 0, sizeof (unit_events));
+  memset ((void *) obj_events, 0, sizeof (obj_events));
+  memset ((void *) send_done, 0, sizeof (send_done));
+}
+
+/* Standard frames to FIFO0, extended frames to FIFO1 */
+static int32_t
+filter_all (uint32_t x)
+{
+  memset (ft_entry, 0, sizeof (ft_entry));
+  ft_entry[0].id      = ARM_CAN_STANDARD_ID (0U);
+  ft_entry[0].type    = CAN_FILTER_ENTRY_MASK;
+  ft_entry[0].obj_idx = 0U;
+  ft_entry[1].id      = ARM_CAN_EXTENDED_ID (0U);
+  ft_entry[1].type    = CAN_FILTER_ENTRY_MASK;
+  ft_entry[1].obj_idx = 1U;
+  ft.entry = ft_entry;
+  ft.num   = 2U;
+  return drv[x]->Control (ARM_CAN_SET_FILTER_TABLE, ADDR (&ft));
+}
+
+/* Power cycle controller x into mode, receive everything */
+static uint32_t
+start (uint32_t x, ARM_CAN_MODE mode)
+{
+  ARM_DRIVER_CAN *d = drv[x];
+  uint32_t obj, err;
+
+  err = 0U;
+  err |= (d->PowerControl (ARM_POWER_OFF) != ARM_DRIVER_OK);
+  err |= (d->PowerControl (ARM_POWER_FULL) != ARM_DRIVER_OK);
+  err |= (d->SetMode (ARM_CAN_MODE_INITIALIZATION) != ARM_DRIVER_OK);
+  err |= (d->SetBitrate (ARM_CAN_BITRATE_NOMINAL, 500000U, SEGMENTS) != ARM_DRIVER_OK);
+  for (obj = 0U; obj < 5U; obj++)
+    {
+      err |= (d->ObjectConfigure (obj, (obj < 2U) ? ARM_CAN_OBJ_RX : ARM_CAN_OBJ_TX)
+              != ARM_DRIVER_OK);
+    }
+  err |= (filter_all (x) != ARM_DRIVER_OK);
+  err |= (d->SetMode (mode) != ARM_DRIVER_OK);
+  CHECK (err == 0U, "CAN%u start failed", (unsigned) (x + 1U));
+  return (err == 0U) ? 1U : 0U;
+}
+
+static void
+stop (uint32_t x)
+{
+  drv[x]->PowerControl (ARM_POWER_OFF);
+}
+
+/* Both controllers in normal mode, bus counters and log cleared */
+static uint32_t
+start_both (void)
+{
+  uint32_t ok;
+
+  ok = start (0U, ARM_CAN_MODE_NORMAL) & start (1U, ARM_CAN_MODE_NORMAL);
+  wait_ticks (2U);
+  clear ();
+  events_clear ();
+  rx2_cnt = 0U;
+  return ok;
+}
+
+/* Send on object obj of controller x, wait while the object is busy (bus
+   running only) */
+static int32_t
+msg_send (uint32_t x, uint32_t obj, uint32_t id, uint32_t rtr, const uint8_t *data,
+          uint32_t len)
+{
+  ARM_CAN_MSG_INFO info;
+  uint32_t t0;
+  int32_t status;
+
+  memset (&info, 0, sizeof (info));
+  info.id  = id;
+  info.rtr = rtr & 1U;
+  info.dlc = len & 0xFU;
+  memset (tx_buf, 0, sizeof (tx_buf));
+  if ((rtr == 0U) && (data != NULL))
+    {
+      memcpy (tx_buf, data, (len > 8U) ? 8U : len);
+    }
+  t0 = ticks ();
+  do
+    {
+      status = drv[x]->MessageSend (obj, &info, tx_buf, (uint8_t) len);
+    }
+  while ((status == ARM_DRIVER_ERROR_BUSY) && (__get_PRIMASK () == 0U)
+         && ((ticks () - t0) < TIMEOUT));
+  return status;
+}
+
+/* Read up to num messages of object obj_idx from the CAN1 receive queue */
+static int32_t
+read1 (uint32_t obj_idx, uint32_t num)
+{
+  rq.obj_idx = obj_idx;
+  rq.msg     = rx_buf;
+  rq.num     = num;
+  return drv[0]->Control (ARM_CAN_READ_RX_QUEUE, ADDR (&rq));
+}
+
+static uint32_t
+frame_is (const vbus_frame_t *f, uint32_t id, uint32_t rtr, uint32_t dlc,
+          const uint8_t *data)
+{
+  if ((f->id != id) || (f->rtr != rtr) || (f->dlc != dlc))
+    {
+      return 0U;
+    }
+  return ((rtr != 0U) || (memcmp (f->data, data, dlc) == 0)) ? 1U : 0U;
+}
+
+static uint32_t
+msg_is (const CAN_RX_MSG *m, uint32_t id, uint32_t rtr, uint32_t dlc,
+        const uint8_t *data)
+{
+  if ((m->id != id) || (m->rtr != rtr) || (m->dlc != dlc))
+    {
+      return 0U;
+    }
+  return ((rtr != 0U) || (memcmp (m->data, data, dlc) == 0)) ? 1U : 0U;
+}
+
+/* --------------------------------------------------------------------------
+ * Tests
+ */
+
+static void
+test_init (void)
+{
+  ARM_DRIVER_VERSION ver;
+  ARM_CAN_CAPABILITIES cap;
+  ARM_CAN_STATUS st;
+  uint32_t x;
+
+  ver = drv[0]->GetVersion ();
+  CHECK (ver.api == ARM_CAN_API_VERSION, "api version %04X", (unsigned) ver.api);
+  cap = drv[0]->GetCapabilities ();
+  CHECK (cap.num_objects == 5U, "%u objects", (unsigned) cap.num_objects);
+
+  CHECK (drv[0]->Initialize (can1_unit_event, can1_object_event) == ARM_DRIVER_OK,
+         "CAN1 initialize");
+  CHECK (drv[1]->Initialize (can2_unit_event, can2_object_event) == ARM_DRIVER_OK,
+         "CAN2 initialize");
+  CHECK (drv[0]->MessageSend (2U, NULL, tx_buf, 0U) == ARM_DRIVER_ERROR,
+         "send before power up");
+
+  start_both ();
+  CHECK ((CAN1->BTR & CAN_BTR_BRP) == 9U, "CAN1 BTR %08X", (unsigned) CAN1->BTR);
+  CHECK ((CAN2->BTR & CAN_BTR_BRP) == 9U, "CAN2 BTR %08X", (unsigned) CAN2->BTR);
+  CHECK (drv[0]->SetBitrate (ARM_CAN_BITRATE_NOMINAL, 1234567U, SEGMENTS)
+         == ARM_CAN_INVALID_BITRATE, "inexact bitrate accepted");
+  for (x = 0U; x < 2U; x++)
+    {
+      st = drv[x]->GetStatus ();
+      CHECK (st.unit_state == ARM_CAN_UNIT_STATE_ACTIVE, "CAN%u state %u",
+             (unsigned) (x + 1U), (unsigned) st.unit_state);
+      CHECK ((st.tx_error_count == 0U) && (st.rx_error_count == 0U),
+             "CAN%u error counters", (unsigned) (x + 1U));
+    }
+}
+
+static void
+test_loopback (void)
+{
+  static const uint8_t d1[8] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88 };
+  ARM_CAN_STATUS st;
+  uint32_t locked;
+
+  start_both ();
+  locked = locked_now ();
+
+  /* Internal loopback: own frames only, nothing on the bus */
+  CHECK (drv[0]->SetMode (ARM_CAN_MODE_LOOPBACK_INTERNAL) == ARM_DRIVER_OK, "mode");
+  events_clear ();
+  CHECK (msg_send (0U, 2U, 0x321U, 0U, d1, 8U) == 8, "send");
+  wait_for (&send_done[0][2], 1U);
+  wait_ticks (4U);
+  CHECK (read1 (0U, 4U) == 1, "internal loopback: no frame");
+  CHECK (msg_is (&rx_buf[0], 0x321U, 0U, 8U, d1), "internal loopback frame");
+  CHECK (vbus.log_num == 0U, "internal loopback frame on the bus");
+  CHECK (rx2_cnt == 0U, "internal loopback frame at CAN2");
+
+  /* Back to normal mode: loopback and silent bits changed in init mode */
+  CHECK (drv[0]->SetMode (ARM_CAN_MODE_NORMAL) == ARM_DRIVER_OK, "mode");
+  CHECK (locked_now () == locked, "BTR written outside initialization mode");
+  CHECK ((CAN1->BTR & (CAN_BTR_LBKM | CAN_BTR_SILM)) == 0U, "BTR %08X",
+         (unsigned) CAN1->BTR);
+  st = drv[0]->GetStatus ();
+  CHECK (st.unit_state == ARM_CAN_UNIT_STATE_ACTIVE, "state %u",
+         (unsigned) st.unit_state);
+  CHECK (msg_send (0U, 2U, 0x322U, 0U, d1, 2U) == 2, "send");
+  CHECK (wait_for (&rx2_cnt, 1U), "normal mode: no frame at CAN2");
+  CHECK (msg_is (&rx2[0].msg, 0x322U, 0U, 2U, d1), "frame at CAN2");
+
+  /* External loopback: frame on the bus, received by both */
+  CHECK (drv[0]->SetMode (ARM_CAN_MODE_LOOPBACK_EXTERNAL) == ARM_DRIVER_OK, "mode");
+  clear ();
+  rx2_cnt = 0U;
+  CHECK (msg_send (0U, 2U, ARM_CAN_EXTENDED_ID (0x1ABCDEFU), 0U, d1, 5U) == 5, "send");
+  CHECK (wait_for (&rx2_cnt, 1U), "external loopback: no frame at CAN2");
+  wait_ticks (4U);
+  CHECK (read1 (1U, 4U) == 1, "external loopback: no own frame");
+  CHECK (msg_is (&rx_buf[0], ARM_CAN_EXTENDED_ID (0x1ABCDEFU), 0U, 5U, d1),
+         "external loopback frame");
+  CHECK ((vbus.log_num == 1U) && (vbus_log[0].sender == VBUS_CAN1),
+         "external loopback: %u frames on the bus", (unsigned) vbus.log_num);
+
+  CHECK (drv[0]->SetMode (ARM_CAN_MODE_NORMAL) == ARM_DRIVER_OK, "mode");
+  CHECK (locked_now () == locked, "BTR written outside initialization mode");
+  CHECK ((CAN1->BTR & (CAN_BTR_LBKM | CAN_BTR_SILM)) == 0U, "BTR %08X",
+         (unsigned) CAN1->BTR);
+
+  /* Monitor mode: receives, does not acknowledge */
+  CHECK (drv[1]->SetMode (ARM_CAN_MODE_MONITOR) == ARM_DRIVER_OK, "mode");
+  clear ();
+  vbus.ack = 1U;
+  rx2_cnt = 0U;
+  CHECK (msg_send (0U, 2U, 0x323U, 0U, d1, 1U) == 1, "send");
+  CHECK (wait_for (&rx2_cnt, 1U), "monitor mode: no frame");
+  vbus.ack = 0U;
+  CHECK (drv[1]->SetMode (ARM_CAN_MODE_NORMAL) == ARM_DRIVER_OK, "mode");
+  CHECK (locked_now () == locked, "BTR written outside initialization mode");
+}
+
+static void
+test_frames (void)
+{
+  static const uint8_t d[8] = { 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7 };
+  static const struct
+  {
+    uint32_t id, rtr, dlc;
+  } f[] =
+    {
+      { 0x000U,                            0U, 0U },
+      { 0x7FFU,                            0U, 8U },
+      { 0x555U,                            1U, 4U },
+      { ARM_CAN_EXTENDED_ID (0x00000000U), 0U, 3U },
+      { ARM_CAN_EXTENDED_ID (0x1FFFFFFFU), 0U, 8U },
+      { ARM_CAN_EXTENDED_ID (0x0AAAAAAAU), 1U, 8U },
+      { 0x0F0U,                            0U, 1U },
+    };
+  uint32_t n, i, k, obj, got;
+
+  start_both ();
+  n = sizeof (f) / sizeof (f[0]);
+
+  /* CAN1 to CAN2: mailbox order is kept by sending one at a time */
+  for (i = 0U; i < n; i++)
+    {
+      CHECK (msg_send (0U, 2U + (i % 3U), f[i].id, f[i].rtr, d, f[i].dlc)
+             == (int32_t) (f[i].rtr ? 0U : f[i].dlc), "CAN1 send %u", (unsigned) i);
+      CHECK (wait_for (&rx2_cnt, i + 1U), "CAN2: frame %u missing", (unsigned) i);
+    }
+  for (i = 0U; i < n; i++)
+    {
+      obj = (f[i].id & ARM_CAN_ID_IDE_Msk) ? 1U : 0U;
+      CHECK (msg_is (&rx2[i].msg, f[i].id, f[i].rtr, f[i].dlc, d)
+             && (rx2[i].obj_idx == obj), "CAN2 frame %u", (unsigned) i);
+      CHECK (frame_is (&vbus_log[i], f[i].id, f[i].rtr, f[i].dlc, d)
+             && (vbus_log[i].sender == VBUS_CAN1), "bus frame %u", (unsigned) i);
+    }
+  CHECK (send_done[0][2] + send_done[0][3] + send_done[0][4] == n,
+         "CAN1 send complete events");
+
+  /* CAN2 to CAN1 */
+  clear ();
+  for (i = 0U; i < n; i++)
+    {
+      CHECK (msg_send (1U, 2U, f[i].id, f[i].rtr, d, f[i].dlc) >= 0, "CAN2 send");
+      CHECK (wait_for (&vbus.log_num, i + 1U), "CAN2 frame %u missing", (unsigned) i);
+    }
+  wait_ticks (4U);
+  CHECK (send_done[1][2] == n, "CAN2 send complete events %u",
+         (unsigned) send_done[1][2]);
+  for (obj = 0U; obj < 2U; obj++)
+    {
+      got = (uint32_t) read1 (obj, 64U);
+      for (i = 0U, k = 0U; i < n; i++)
+        {
+          if (((f[i].id & ARM_CAN_ID_IDE_Msk) ? 1U : 0U) != obj)
+            {
+              continue;
+            }
+          CHECK ((k < got) && msg_is (&rx_buf[k], f[i].id, f[i].rtr, f[i].dlc, d),
+                 "CAN1 object %u frame %u", (unsigned) obj, (unsigned) i);
+          k++;
+        }
+      CHECK (k == got, "CAN1 object %u: %u frames", (unsigned) obj, (unsigned) got);
+    }
+  CHECK (vbus.bad_bitrate == 0U, "bit timing mismatch");
+}
+
+static void
+test_arbitration (void)
+{
+  static const uint8_t d[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+  start_both ();
+
+  /* Lower identifier wins, the loser sends after it */
+  __disable_irq ();
+  msg_send (0U, 2U, 0x100U, 0U, d, 8U);
+  msg_send (1U, 2U, 0x0FFU, 0U, d, 8U);
+  __enable_irq ();
+  CHECK (wait_for (&vbus.log_num, 2U), "frames missing");
+  CHECK ((vbus_log[0].id == 0x0FFU) && (vbus_log[0].sender == VBUS_CAN2)
+         && (vbus_log[1].id == 0x100U) && (vbus_log[1].sender == VBUS_CAN1),
+         "order %03X %03X", (unsigned) vbus_log[0].id, (unsigned) vbus_log[1].id);
+  CHECK (vbus.arb_lost == 1U, "%u lost arbitrations", (unsigned) vbus.arb_lost);
+
+  /* Standard data frame before extended frame of same base identifier,
+     data frame before remote frame */
+  clear ();
+  __disable_irq ();
+  msg_send (0U, 2U, ARM_CAN_EXTENDED_ID (0x123U << 18), 0U, d, 1U);
+  msg_send (1U, 2U, 0x123U, 1U, NULL, 0U);
+  msg_send (1U, 3U, 0x123U, 0U, d, 1U);
+  __enable_irq ();
+  CHECK (wait_for (&vbus.log_num, 3U), "frames missing");
+  CHECK ((vbus_log[0].id == 0x123U) && (vbus_log[0].rtr == 0U)
+         && (vbus_log[1].id == 0x123U) && (vbus_log[1].rtr == 1U)
+         && (vbus_log[2].id == ARM_CAN_EXTENDED_ID (0x123U << 18)),
+         "standard/extended order");
+  CHECK (vbus.bit_errors == 0U, "bit errors");
+}
+
+static void
+test_errors (void)
+{
+  static const uint8_t d[8] = { 0x55, 0xAA };
+  static CAN_RX_MSG first[32];
+  ARM_CAN_STATUS st;
+  uint32_t i, n;
+
+  /* Acknowledgment errors: CAN1 alone on the bus */
+  start_both ();
+  stop (1U);
+  events_clear ();
+  CHECK (msg_send (0U, 2U, 0x200U, 0U, d, 2U) == 2, "send");
+  wait_for (&vbus.ack_errors, 20U);
+  st = drv[0]->GetStatus ();
+  CHECK (st.unit_state == ARM_CAN_UNIT_STATE_PASSIVE, "state %u", (unsigned) st.unit_state);
+  CHECK (st.tx_error_count == 128U, "TEC %u", (unsigned) st.tx_error_count);
+  CHECK (st.last_error_code == ARM_CAN_LEC_ACK_ERROR, "LEC %u",
+         (unsigned) st.last_error_code);
+  CHECK (unit_events[0] & (1UL << ARM_CAN_EVENT_UNIT_WARNING), "no warning event");
+  CHECK (unit_events[0] & (1UL << ARM_CAN_EVENT_UNIT_PASSIVE), "no passive event");
+
+  CHECK (drv[0]->Control (ARM_CAN_ABORT_MESSAGE_SEND, 2U) == ARM_DRIVER_OK, "abort");
+  wait_ticks (10U);
+  CHECK ((CAN1->TSR & (CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2))
+         == (CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2), "mailbox not aborted");
+  CHECK (send_done[0][2] == 0U, "send complete after abort");
+
+  /* Recovery: one successful frame lowers TEC below 128 */
+  start (1U, ARM_CAN_MODE_NORMAL);
+  unit_events[0] = 0U;
+  CHECK (msg_send (0U, 2U, 0x201U, 0U, d, 2U) == 2, "send");
+  CHECK (wait_for (&send_done[0][2], 1U), "no send complete");
+  wait_ticks (4U);
+  st = drv[0]->GetStatus ();
+  CHECK (st.unit_state == ARM_CAN_UNIT_STATE_ACTIVE, "state %u", (unsigned) st.unit_state);
+  CHECK (st.tx_error_count == 127U, "TEC %u", (unsigned) st.tx_error_count);
+  CHECK (unit_events[0] & (1UL << ARM_CAN_EVENT_UNIT_ACTIVE), "no active event");
+
+  /* One shot mode without transmit queue: failed request completes */
+  start_both ();
+  stop (0U);
+  CHECK (drv[1]->Control (ARM_CAN_CONTROL_RETRANSMISSION, 0U) == ARM_DRIVER_OK, "NART");
+  CHECK (msg_send (1U, 2U, 0x202U, 0U, d, 2U) == 2, "send");
+  wait_ticks (20U);
+  CHECK (vbus.ack_errors == 1U, "%u transmissions", (unsigned) vbus.ack_errors);
+  CHECK ((CAN2->TSR & (CAN_TSR_RQCP0 | CAN_TSR_TME0)) == CAN_TSR_TME0,
+         "TSR %08X", (unsigned) CAN2->TSR);
+  CHECK (send_done[1][2] == 0U, "send complete in one shot mode");
+
+  /* Abort without transmit queue */
+  CHECK (drv[1]->Control (ARM_CAN_CONTROL_RETRANSMISSION, 1U) == ARM_DRIVER_OK, "retry");
+  CHECK (msg_send (1U, 3U, 0x203U, 0U, d, 2U) == 2, "send");
+  wait_for (&vbus.ack_errors, 4U);
+  CHECK (drv[1]->Control (ARM_CAN_ABORT_MESSAGE_SEND, 3U) == ARM_DRIVER_OK, "abort");
+  wait_ticks (20U);
+  CHECK ((CAN2->TSR & (CAN_TSR_RQCP1 | CAN_TSR_TME1)) == CAN_TSR_TME1,
+         "TSR %08X", (unsigned) CAN2->TSR);
+  CHECK (send_done[1][3] == 0U, "send complete after abort");
+
+  /* Receive queue overrun: oldest 32 frames kept */
+  start_both ();
+  n = 40U;
+  for (i = 0U; i < n; i++)
+    {
+      CHECK (msg_send (1U, 2U, 0x300U + i, 0U, d, 2U) == 2, "send");
+      wait_for (&vbus.log_num, i + 1U);
+    }
+  wait_ticks (4U);
+  CHECK (obj_events[0][0] & ARM_CAN_EVENT_RECEIVE_OVERRUN, "no overrun event");
+  CHECK (read1 (0U, 64U) == 32, "receive queue");
+  memcpy (first, rx_buf, sizeof (first));
+  for (i = 0U; i < 32U; i++)
+    {
+      CHECK (first[i].id == (0x300U + i), "queued frame %u: %03X", (unsigned) i,
+             (unsigned) first[i].id);
+    }
+  CHECK (read1 (0U, 64U) == 0, "receive queue not empty");
+}
+
+/* --------------------------------------------------------------------------
+ * Transmit priority
+ */
+
+typedef struct
+{
+  uint32_t tir, dlc, seq, prio;
+} tx_ref_t;
+
+/* Driver identifier of a mailbox identifier */
+static uint32_t
+tir_id (uint32_t tir)
+{
+  if (tir & CAN_TI0R_IDE)
+    {
+      return ARM_CAN_EXTENDED_ID (tir >> 3);
+    }
+  return ARM_CAN_STANDARD_ID (tir >> 21);
+}
+
+static uint32_t
+random_tir (void)
+{
+  uint32_t tir;
+
+  if (rnd () & 1U)
+    {
+      tir = ((rnd () & 0x1FFFFFFFU) << 3) | CAN_TI0R_IDE;
+    }
+  else
+    {
+      tir = (rnd () & 0x7FFU) << 21;
+    }
+  return (rnd () & 1U) ? (tir | CAN_TI0R_RTR) : tir;
+}
+
+/* Identifier close to tir: bits changed near the end of a field */
+static uint32_t
+near_tir (uint32_t tir)
+{
+  switch (rnd () % 5U)
+    {
+    case 0U:
+      return tir ^ CAN_TI0R_RTR;
+    case 1U:
+      return tir ^ (1UL << (3U + (rnd () % 29U)));
+    case 2U:
+      /* Same base identifier, other format */
+      if (tir & CAN_TI0R_IDE)
+        {
+          return (tir & CAN_TI0R_STID) | (tir & CAN_TI0R_RTR);
+        }
+      return (tir & CAN_TI0R_STID) | CAN_TI0R_IDE | ((rnd () & 0x3FFFFU) << 3);
+    case 3U:
+      return tir;
+    default:
+      return random_tir ();
+    }
+}
+
+/* Bus order of the transmit queue without replacement */
+static uint32_t
+tx_model (const tx_ref_t *in, uint32_t n, tx_ref_t *out)
+{
+  tx_ref_t mb[3], q[64];
+  uint32_t nm, nq, no, i, k, best;
+
+  nm = 0U;
+  nq = 0U;
+  for (i = 0U; i < n; i++)
+    {
+      for (k = 0U; (k < nm) && (mb[k].prio != in[i].prio); k++)
+        {
+        }
+      if ((nq == 0U) && (nm < 3U) && (k == nm))
+        {
+          mb[nm++] = in[i];
+          continue;
+        }
+      /* Queue ordered by priority, in request order for equal priority */
+      for (k = nq; (k > 0U) && (q[k - 1U].prio > in[i].prio); k--)
+        {
+          q[k] = q[k - 1U];
+        }
+      q[k] = in[i];
+      nq++;
+    }
+
+  no = 0U;
+  while (nm != 0U)
+    {
+      best = 0U;
+      for (k = 1U; k < nm; k++)
+        {
+          if (mb[k].prio < mb[best].prio)
+            {
+              best = k;
+            }
+        }
+      out[no++] = mb[best];
+      mb[best] = mb[--nm];
+
+      /* Refill from the queue head while no mailbox has equal priority */
+      while ((nq != 0U) && (nm < 3U))
+        {
+          for (k = 0U; (k < nm) && (mb[k].prio != q[0].prio); k++)
+            {
+            }
+          if (k != nm)
+            {
+              break;
+            }
+          mb[nm++] = q[0];
+          nq--;
+          memmove (&q[0], &q[1], nq * sizeof (q[0]));
+        }
+    }
+  return no;
+}
+
+static void
+test_tx_priority (void)
+{
+  static tx_ref_t in[24], out[24], tmp;
+  uint32_t i, k, n, a, b, err, batch, replace, seq;
+  int32_t s, want;
+  uint8_t d[8];
+
+  /* Priority value against bitwise arbitration */
+  err = 0U;
+  for (i = 0U; i < 200000U; i++)
+    {
+      a = random_tir ();
+      b = near_tir (a);
+      s = vbus_arbitrate (a, b);
+      want = (vbus_tx_priority (a) < vbus_tx_priority (b)) ? -1
+             : ((vbus_tx_priority (a) > vbus_tx_priority (b)) ? 1 : 0);
+      if ((s != want) && (err++ < 5U))
+        {
+          CHECK (0, "%08X vs %08X: arbitration %d, priority %d", (unsigned) a,
+                 (unsigned) b, (int) s, (int) want);
+        }
+    }
+  CHECK (err == 0U, "%u priority mismatches", (unsigned) err);
+
+  /* Transmit queue batches, bus order against the reference */
+  start_both ();
+  seq = 0U;
+  for (replace = 0U; replace < 2U; replace++)
+    {
+      CHECK (drv[0]->Control (ARM_CAN_CONTROL_TX_REPLACE, replace) == ARM_DRIVER_OK,
+             "replace");
+      for (batch = 0U; batch < 150U; batch++)
+        {
+          n = 1U + (rnd () % 20U);
+          for (i = 0U; i < n; i++)
+            {
+              a = 0x100U + (rnd () % 8U);
+              if (rnd () & 1U)
+                {
+                  in[i].tir = (((a << 18) | (rnd () % 4U)) << 3) | CAN_TI0R_IDE;
+                }
+              else
+                {
+                  in[i].tir = a << 21;
+                }
+              if ((rnd () % 4U) == 0U)
+                {
+                  in[i].tir |= CAN_TI0R_RTR;
+                }
+              in[i].dlc  = rnd () % 9U;
+              in[i].seq  = seq++;
+              in[i].prio = vbus_tx_priority (in[i].tir);
+            }
+
+          clear ();
+          __disable_irq ();
+          for (i = 0U; i < n; i++)
+            {
+              memset (d, 0, sizeof (d));
+              d[0] = (uint8_t) in[i].seq;
+              d[1] = (uint8_t) (in[i].seq >> 8);
+              if (msg_send (0U, 2U, tir_id (in[i].tir), (in[i].tir & CAN_TI0R_RTR) ? 1U : 0U, d,
+                        in[i].dlc) < 0)
+                {
+                  err++;
+                }
+            }
+          __enable_irq ();
+          wait_for (&vbus.log_num, n);
+
+          if (replace == 0U)
+            {
+              tx_model (in, n, out);
+            }
+          else
+            {
+              /* Replacement: strict priority order, request order on ties */
+              memcpy (out, in, n * sizeof (in[0]));
+              for (i = 1U; i < n; i++)
+                {
+                  tmp = out[i];
+                  for (k = i; (k > 0U) && (out[k - 1U].prio > tmp.prio); k--)
+                    {
+                      out[k] = out[k - 1U];
+                    }
+                  out[k] = tmp;
+                }
+            }
+
+          for (i = 0U; i < n; i++)
+            {
+              memset (d, 0, sizeof (d));
+              d[0] = (uint8_t) out[i].seq;
+              d[1] = (uint8_t) (out[i].seq >> 8);
+              if ((i >= vbus.log_num)
+                  || !frame_is (&vbus_log[i], tir_id (out[i].tir),
+                                (out[i].tir & CAN_TI0R_RTR) ? 1U : 0U, out[i].dlc, d))
+                {
+                  break;
+                }
+            }
+          if ((i != n) || (vbus.log_num != n))
+            {
+              if (err++ < 5U)
+                {
+                  CHECK (0, "replace %u batch %u: frame %u of %u differs",
+                         (unsigned) replace, (unsigned) batch, (unsigned) i,
+                         (unsigned) n);
+                }
+            }
+        }
+    }
+  CHECK (err == 0U, "%u batches in wrong order", (unsigned) err);
+  CHECK (vbus_tx_queued (0U) == 0U, "transmit queue not empty");
+  drv[0]->Control (ARM_CAN_CONTROL_TX_REPLACE, 0U);
+}
+
+/* --------------------------------------------------------------------------
+ * Filter table
+ */
+
+#define PROBE_MAX       128U
+
+typedef struct
+{
+  uint32_t id, rtr;
+} probe_t;
+
+static probe_t probe[PROBE_MAX];
+static int32_t acc_before[2][PROBE_MAX];
+static uint32_t probe_num;
+
+static uint32_t
+id_mask (uint32_t id)
+{
+  return (id & ARM_CAN_ID_IDE_Msk) ? 0x1FFFFFFFU : 0x7FFU;
+}
+
+/* FIFOs (bit 0: FIFO0, bit 1: FIFO1) of the table entries matching a frame */
+static uint32_t
+table_match (const CAN_FILTER_ENTRY *e, uint32_t num, uint32_t id, uint32_t rtr)
+{
+  uint32_t i, m, v, first, fifos;
+
+  fifos = 0U;
+  for (i = 0U; i < num; i++, e++)
+    {
+      if (((e->id ^ id) & ARM_CAN_ID_IDE_Msk)
+          || ((e->type & CAN_FILTER_ENTRY_DATA_ONLY) && (rtr != 0U)))
+        {
+          continue;
+        }
+      m = id_mask (id);
+      v = id & m;
+      first = e->id & m;
+      switch (e->type & CAN_FILTER_ENTRY_TYPE_Msk)
+        {
+        case CAN_FILTER_ENTRY_EXACT:
+          m = (v == first);
+          break;
+        case CAN_FILTER_ENTRY_MASK:
+          m = (((v ^ first) & e->arg & m) == 0U);
+          break;
+        default:
+          m = ((v >= first) && (v <= (e->arg & m)));
+          break;
+        }
+      if (m)
+        {
+          fifos |= 1UL << e->obj_idx;
+        }
+    }
+  return fifos;
+}
+
+static void
+probe_add (uint32_t id)
+{
+  uint32_t rtr;
+
+  for (rtr = 0U; (rtr < 2U) && (probe_num < PROBE_MAX); rtr++)
+    {
+      probe[probe_num].id  = id;
+      probe[probe_num].rtr = rtr;
+      probe_num++;
+    }
+}
+
+/* Identifiers at and around the edges of the entries, random identifiers */
+static void
+probes_make (const CAN_FILTER_ENTRY *e, uint32_t num)
+{
+  uint32_t i, k, m, ide, first, last;
+
+  probe_num = 0U;
+  for (i = 0U; i < num; i++, e++)
+    {
+      ide = e->id & ARM_CAN_ID_IDE_Msk;
+      m = id_mask (e->id);
+      first = e->id & m;
+      last = first;
+      if ((e->type & CAN_FILTER_ENTRY_TYPE_Msk) == CAN_FILTER_ENTRY_MASK)
+        {
+          first &= e->arg;
+          last = first | (~e->arg & m);
+        }
+      else if ((e->type & CAN_FILTER_ENTRY_TYPE_Msk) == CAN_FILTER_ENTRY_RANGE)
+        {
+          last = e->arg & m;
+        }
+      probe_add (ide | first);
+      probe_add (ide | last);
+      probe_add (ide | ((first - 1U) & m));
+      probe_add (ide | ((last + 1U) & m));
+      probe_add (ide | ((e->id ^ (1UL << (rnd () % ((m == 0x7FFU) ? 11U : 29U)))) & m));
+      probe_add ((ide ^ ARM_CAN_ID_IDE_Msk) | (first & 0x7FFU));
+    }
+  for (k = 0U; probe_num < PROBE_MAX; k++)
+    {
+      probe_add ((k & 1U) ? ARM_CAN_EXTENDED_ID (rnd ()) : ARM_CAN_STANDARD_ID (rnd ()));
+    }
+}
+
+static void
+entry_random (CAN_FILTER_ENTRY *e)
+{
+  uint32_t m, shift;
+
+  memset (e, 0, sizeof (*e));
+  m = (rnd () & 1U) ? 0x1FFFFFFFU : 0x7FFU;
+  e->id = rnd () & m;
+  e->type = (uint8_t) (rnd () % 3U);
+  switch (e->type)
+    {
+    case CAN_FILTER_ENTRY_MASK:
+      /* Mostly contiguous masks, some random bits cleared */
+      shift = rnd () % ((m == 0x7FFU) ? 11U : 29U);
+      e->arg = (m << shift) & m;
+      if ((rnd () % 4U) == 0U)
+        {
+          e->arg &= rnd ();
+        }
+      break;
+    case CAN_FILTER_ENTRY_RANGE:
+      e->arg = e->id + (rnd () % ((m == 0x7FFU) ? 64U : 300U));
+      if (e->arg > m)
+        {
+          e->arg = m;
+        }
+      break;
+    default:
+      break;
+    }
+  if (m != 0x7FFU)
+    {
+      e->id |= ARM_CAN_ID_IDE_Msk;
+    }
+  if ((rnd () % 4U) == 0U)
+    {
+      e->type |= CAN_FILTER_ENTRY_DATA_ONLY;
+    }
+  e->obj_idx = (uint8_t) (rnd () & 1U);
+}
+
+/* Entry next to e: one compared identifier bit flipped, data only flag
+   drawn again (terms the compiler may merge) */
+static void
+entry_neighbour (CAN_FILTER_ENTRY *n, const CAN_FILTER_ENTRY *e)
+{
+  uint32_t m, bit;
+
+  *n = *e;
+  m = id_mask (e->id);
+  if ((e->type & CAN_FILTER_ENTRY_TYPE_Msk) == CAN_FILTER_ENTRY_MASK)
+    {
+      m &= e->arg;
+    }
+  if (m == 0U)
+    {
+      return;
+    }
+  do
+    {
+      bit = 1UL << (rnd () % 29U);
+    }
+  while ((bit & m) == 0U);
+  n->id ^= bit;
+  if ((e->type & CAN_FILTER_ENTRY_TYPE_Msk) == CAN_FILTER_ENTRY_RANGE)
+    {
+      /* Same length, flipped first identifier */
+      m = id_mask (e->id);
+      n->arg = (n->id & m) + (e->arg - (e->id & m));
+      if (n->arg > m)
+        {
+          n->arg = m;
+        }
+    }
+  n->type = (uint8_t) ((n->type & ~CAN_FILTER_ENTRY_DATA_ONLY)
+                       | ((rnd () & 1U) ? CAN_FILTER_ENTRY_DATA_ONLY : 0U));
+}
+
+/* Active filter banks of controller x */
+static uint32_t
+banks_active (uint32_t x)
+{
+  uint32_t split, msk;
+
+  split = vbus_filter_split ();
+  msk = (x == 0U) ? ((1UL << split) - 1U) : (((1UL << 28) - 1U) & ~((1UL << split) - 1U));
+  return (uint32_t) __builtin_popcount (CAN1->FA1R & msk);
+}
+
+/* Frames of the external node through the filters of CAN1 */
+static void
+filter_frames (void)
+{
+  static vbus_frame_t f;
+  static uint8_t want[PROBE_MAX];
+  uint32_t i, k, n, obj, got;
+  int32_t fifo;
+
+  for (i = 0U; i < probe_num; i += n)
+    {
+      n = ((probe_num - i) > 16U) ? 16U : (probe_num - i);
+      clear ();
+      for (k = 0U; k < n; k++)
+        {
+          memset (&f, 0, sizeof (f));
+          f.id = probe[i + k].id;
+          f.rtr = (uint8_t) probe[i + k].rtr;
+          f.dlc = 1U;
+          f.data[0] = (uint8_t) k;
+          vbus_inject (&f, 0U);
+        }
+      CHECK (wait_for (&vbus.log_num, n), "injected frames missing");
+      wait_ticks (4U);
+      memset (want, 0, sizeof (want));
+      for (obj = 0U; obj < 2U; obj++)
+        {
+          got = (uint32_t) read1 (obj, 64U);
+          for (k = 0U; k < n; k++)
+            {
+              fifo = vbus_accept (0U, probe[i + k].id, probe[i + k].rtr);
+              if (fifo != (int32_t) obj)
+                {
+                  continue;
+                }
+              if ((want[obj] >= got) || (rx_buf[want[obj]].id != probe[i + k].id)
+                  || (rx_buf[want[obj]].rtr != probe[i + k].rtr))
+                {
+                  CHECK (0, "frame %08X rtr %u not received on object %u",
+                         (unsigned) probe[i + k].id, (unsigned) probe[i + k].rtr,
+                         (unsigned) obj);
+                  return;
+                }
+              want[obj]++;
+            }
+          CHECK (want[obj] == got, "object %u: %u frames, %u expected", (unsigned) obj,
+                 (unsigned) got, (unsigned) want[obj]);
+        }
+    }
+}
+
+static void
+test_filter_table (void)
+{
+  uint32_t t, i, x, n, ok_num, err_num, frames_num, fifos, bad;
+  int32_t status, a;
+
+  start_both ();
+  ok_num = 0U;
+  err_num = 0U;
+  frames_num = 0U;
+  bad = 0U;
+  for (t = 0U; (t < 300U) && (bad < 5U); t++)
+    {
+      x = rnd () & 1U;
+      n = 1U + (rnd () % 8U);
+      for (i = 0U; i < n; i++)
+        {
+          if ((i != 0U) && ((rnd () % 3U) == 0U))
+            {
+              entry_neighbour (&ft_entry[i], &ft_entry[i - 1U]);
+            }
+          else
+            {
+              entry_random (&ft_entry[i]);
+            }
+        }
+      probes_make (ft_entry, n);
+      for (i = 0U; i < probe_num; i++)
+        {
+          acc_before[0][i] = vbus_accept (0U, probe[i].id, probe[i].rtr);
+          acc_before[1][i] = vbus_accept (1U, probe[i].id, probe[i].rtr);
+        }
+
+      ft.entry = ft_entry;
+      ft.num   = n;
+      ft.banks = 0xFFFFU;
+      status = drv[x]->Control (ARM_CAN_SET_FILTER_TABLE, ADDR (&ft));
+      CHECK ((status == ARM_DRIVER_OK) || (status == ARM_DRIVER_ERROR),
+             "table %u: status %d", (unsigned) t, (int) status);
+
+      for (i = 0U; i < probe_num; i++)
+        {
+          a = vbus_accept (x, probe[i].id, probe[i].rtr);
+          if (status == ARM_DRIVER_OK)
+            {
+              fifos = table_match (ft_entry, n, probe[i].id, probe[i].rtr);
+              if ((a < 0) ? (fifos != 0U) : ((fifos & (1UL << a)) == 0U))
+                {
+                  CHECK (0, "table %u CAN%u: %08X rtr %u: FIFO %d, entries 0x%X",
+                         (unsigned) t, (unsigned) (x + 1U), (unsigned) probe[i].id,
+                         (unsigned) probe[i].rtr, (int) a, (unsigned) fifos);
+                  bad++;
+                  break;
+                }
+            }
+          else if (a != acc_before[x][i])
+            {
+              CHECK (0, "table %u CAN%u: filters changed by failed table",
+                     (unsigned) t, (unsigned) (x + 1U));
+              bad++;
+              break;
+            }
+          if (vbus_accept (x ^ 1U, probe[i].id, probe[i].rtr) != acc_before[x ^ 1U][i])
+            {
+              CHECK (0, "table %u CAN%u: filters of other controller changed",
+                     (unsigned) t, (unsigned) (x + 1U));
+              bad++;
+              break;
+            }
+        }
+
+      if (status == ARM_DRIVER_OK)
+        {
+          ok_num++;
+          CHECK (ft.banks == banks_active (x), "table %u: %u banks, %u active",
+                 (unsigned) t, (unsigned) ft.banks, (unsigned) banks_active (x));
+          if ((x == 0U) && (frames_num < 8U))
+            {
+              frames_num++;
+              filter_frames ();
+            }
+        }
+      else
+        {
+          err_num++;
+          CHECK (ft.banks == 0xFFFFU, "banks set by failed table");
+        }
+    }
+  CHECK ((ok_num > 100U) && (err_num > 0U), "%u tables compiled, %u failed",
+         (unsigned) ok_num, (unsigned) err_num);
+
+  /* More terms than the compiler keeps: no filter changed */
+  for (i = 0U; i < 60U; i++)
+    {
+      memset (&ft_entry[i], 0, sizeof (ft_entry[i]));
+      ft_entry[i].id = ARM_CAN_EXTENDED_ID (i * 0x10101U);
+      ft_entry[i].type = CAN_FILTER_ENTRY_EXACT;
+    }
+  probes_make (ft_entry, 20U);
+  for (i = 0U; i < probe_num; i++)
+    {
+      acc_before[0][i] = vbus_accept (0U, probe[i].id, probe[i].rtr);
+    }
+  ft.num = 60U;
+  CHECK (drv[0]->Control (ARM_CAN_SET_FILTER_TABLE, ADDR (&ft)) == ARM_DRIVER_ERROR,
+         "oversized table accepted");
+  for (i = 0U; i < probe_num; i++)
+    {
+      CHECK (vbus_accept (0U, probe[i].id, probe[i].rtr) == acc_before[0][i],
+             "filters changed by oversized table");
+    }
+
+  CHECK ((filter_all (0U) == ARM_DRIVER_OK) && (filter_all (1U) == ARM_DRIVER_OK),
+         "default filters");
+}
+
+static void
+test_set_filter (void)
+{
+  static vbus_frame_t f;
+  uint32_t i;
+
+  start_both ();
+
+  /* Reserve filter banks for CAN1, then start without filters */
+  memset (ft_entry, 0, sizeof (ft_entry));
+  for (i = 0U; i < 10U; i++)
+    {
+      ft_entry[i].id = ARM_CAN_EXTENDED_ID (i * 0x10101U);
+    }
+  ft.entry = ft_entry;
+  ft.num = 0U;
+  CHECK (drv[1]->Control (ARM_CAN_SET_FILTER_TABLE, ADDR (&ft)) == ARM_DRIVER_OK, "table");
+  ft.num = 10U;
+  CHECK (drv[0]->Control (ARM_CAN_SET_FILTER_TABLE, ADDR (&ft)) == ARM_DRIVER_OK, "table");
+  ft.num = 0U;
+  CHECK (drv[0]->Control (ARM_CAN_SET_FILTER_TABLE, ADDR (&ft)) == ARM_DRIVER_OK, "table");
+  CHECK (vbus_accept (0U, 0x125U, 0U) == -1, "frame accepted without filters");
+
+  /* Standard identifier mask, identifier format compared */
+  CHECK (drv[0]->ObjectSetFilter (0U, ARM_CAN_FILTER_ID_MASKABLE_ADD, 0x120U,
+                                  0x7F0U | ARM_CAN_ID_IDE_Msk) == ARM_DRIVER_OK, "mask add");
+  CHECK (vbus_accept (0U, 0x125U, 0U) == 0, "0x125 rejected");
+  CHECK (vbus_accept (0U, 0x125U, 1U) == 0, "0x125 remote frame rejected");
+  CHECK (vbus_accept (0U, 0x135U, 0U) == -1, "0x135 accepted");
+  CHECK (vbus_accept (0U, ARM_CAN_EXTENDED_ID (0x125U << 18), 0U) == -1,
+         "extended identifier accepted by standard mask");
+
+  /* Exact identifiers */
+  CHECK (drv[0]->ObjectSetFilter (1U, ARM_CAN_FILTER_ID_EXACT_ADD, 0x300U, 0U)
+         == ARM_DRIVER_OK, "exact add");
+  CHECK (drv[0]->ObjectSetFilter (1U, ARM_CAN_FILTER_ID_EXACT_ADD,
+                                  ARM_CAN_EXTENDED_ID (0x1234567U), 0U) == ARM_DRIVER_OK,
+         "extended exact add");
+  CHECK (vbus_accept (0U, 0x300U, 0U) == 1, "0x300 rejected");
+  CHECK (vbus_accept (0U, 0x301U, 0U) == -1, "0x301 accepted");
+  CHECK (vbus_accept (0U, ARM_CAN_EXTENDED_ID (0x1234567U), 0U) == 1,
+         "extended identifier rejected");
+  CHECK (vbus_accept (0U, ARM_CAN_EXTENDED_ID (0x1234566U), 0U) == -1,
+         "other extended identifier accepted");
+
+  /* Extended identifier mask */
+  CHECK (drv[0]->ObjectSetFilter (0U, ARM_CAN_FILTER_ID_MASKABLE_ADD,
+                                  ARM_CAN_EXTENDED_ID (0x1800000U), 0x1F800000U)
+         == ARM_DRIVER_OK, "extended mask add");
+  CHECK (vbus_accept (0U, ARM_CAN_EXTENDED_ID (0x18ABCDEU), 1U) == 0,
+         "extended mask rejected");
+  CHECK (vbus_accept (0U, ARM_CAN_EXTENDED_ID (0x10ABCDEU), 0U) == -1,
+         "extended mask accepted");
+
+  /* Frames through the filters */
+  clear ();
+  memset (&f, 0, sizeof (f));
+  f.dlc = 1U;
+  f.id = 0x12FU;
+  vbus_inject (&f, 0U);
+  f.id = 0x301U;
+  vbus_inject (&f, 0U);
+  f.id = 0x300U;
+  vbus_inject (&f, 0U);
+  CHECK (wait_for (&vbus.log_num, 3U), "frames missing");
+  wait_ticks (4U);
+  CHECK ((read1 (0U, 8U) == 1) && (rx_buf[0].id == 0x12FU), "object 0 frames");
+  CHECK ((read1 (1U, 8U) == 1) && (rx_buf[0].id == 0x300U), "object 1 frames");
+
+  /* Remove */
+  CHECK (drv[0]->ObjectSetFilter (0U, ARM_CAN_FILTER_ID_MASKABLE_REMOVE, 0x120U,
+                                  0x7F0U | ARM_CAN_ID_IDE_Msk) == ARM_DRIVER_OK,
+         "mask remove");
+  CHECK (drv[0]->ObjectSetFilter (1U, ARM_CAN_FILTER_ID_EXACT_REMOVE,
+                                  ARM_CAN_EXTENDED_ID (0x1234567U), 0U) == ARM_DRIVER_OK,
+         "extended exact remove");
+  CHECK (vbus_accept (0U, 0x125U, 0U) == -1, "0x125 accepted after remove");
+  CHECK (vbus_accept (0U, ARM_CAN_EXTENDED_ID (0x1234567U), 0U) == -1,
+         "extended identifier accepted after remove");
+  CHECK (vbus_accept (0U, 0x300U, 0U) == 1, "0x300 removed");
+
+  CHECK ((filter_all (0U) == ARM_DRIVER_OK) && (filter_all (1U) == ARM_DRIVER_OK),
+         "default filters");
+}
+
+static void
+test_timestamp (void)
+{
+  static const uint8_t d[2] = { 0x12, 0x34 };
+  uint64_t tx_time[2];
+  uint32_t i;
+
+  start_both ();
+  CHECK ((drv[0]->Control (ARM_CAN_CONTROL_TIMESTAMP, 1U) == ARM_DRIVER_OK)
+         && (drv[1]->Control (ARM_CAN_CONTROL_TIMESTAMP, 1U) == ARM_DRIVER_OK),
+         "time stamping");
+
+  /* Idle gap over two wraps of the 16-bit counter */
+  ts.obj_idx = 2U;
+  for (i = 0U; i < 2U; i++)
+    {
+      if (i != 0U)
+        {
+          wait_bits (150000U);
+        }
+      CHECK (msg_send (1U, 2U, 0x400U + i, 0U, d, 2U) == 2, "send");
+      CHECK (wait_for (&send_done[1][2], i + 1U), "no send complete");
+      CHECK (drv[1]->Control (ARM_CAN_GET_TIMESTAMP, ADDR (&ts)) == ARM_DRIVER_OK,
+             "get time stamp");
+      tx_time[i] = ts.time;
+    }
+  wait_ticks (4U);
+  CHECK ((vbus.log_num == 2U) && ((vbus_log[1].time - vbus_log[0].time) > 131072U),
+         "bus frames");
+  CHECK (read1 (0U, 4U) == 2, "received frames");
+  CHECK ((rx_buf[1].timestamp - rx_buf[0].timestamp) == (vbus_log[1].time - vbus_log[0].time),
+         "receive time difference %llu, bus %llu",
+         (unsigned long long) (rx_buf[1].timestamp - rx_buf[0].timestamp),
+         (unsigned long long) (vbus_log[1].time - vbus_log[0].time));
+  CHECK ((tx_time[1] - tx_time[0]) == (vbus_log[1].time - vbus_log[0].time),
+         "transmit time difference %llu, bus %llu",
+         (unsigned long long) (tx_time[1] - tx_time[0]),
+         (unsigned long long) (vbus_log[1].time - vbus_log[0].time));
+
+  drv[0]->Control (ARM_CAN_CONTROL_TIMESTAMP, 0U);
+  drv[1]->Control (ARM_CAN_CONTROL_TIMESTAMP, 0U);
+}
+
+/* --------------------------------------------------------------------------
+ * Trace and SocketCAN
+ */
+
+/* candump log notation of a frame */
+static void
+frame_str (char *s, size_t size, const vbus_frame_t *f)
+{
+  size_t n;
+  uint32_t i;
+
+  if (f->id & ARM_CAN_ID_IDE_Msk)
+    {
+      n = (size_t) snprintf (s, size, "%08X#", (unsigned) (f->id & 0x1FFFFFFFU));
+    }
+  else
+    {
+      n = (size_t) snprintf (s, size, "%03X#", (unsigned) f->id);
+    }
+  if (f->rtr != 0U)
+    {
+      snprintf (&s[n], size - n, (f->dlc != 0U) ? "R%u" : "R", (unsigned) f->dlc);
+      return;
+    }
+  for (i = 0U; i < f->dlc; i++)
+    {
+      n += (size_t) snprintf (&s[n], size - n, "%02X", (unsigned) f->data[i]);
+    }
+}
+
+/* Create an empty temporary file */
+static int
+tmp_file (char *path, size_t size)
+{
+  int fd;
+
+  snprintf (path, size, "/tmp/can_vbus_XXXXXX");
+  fd = mkstemp (path);
+  if (fd < 0)
+    {
+      return -1;
+    }
+  close (fd);
+  return 0;
+}
+
+static void
+test_trace (void)
+{
+  static const uint8_t d[8] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88 };
+  static vbus_frame_t rec[8];
+  static const char *const replay =
+    "# candump log\n"
+    "(100.000000) can0 301#0102\n"
+    "(100.000500) can0 1FFFFFFF#R8\n"
+    "not a frame\n"
+    "(100.010500) can0 302#\n";
+  char path[256], line[128], iface[32], str[64], want[64];
+  unsigned long long sec, usec;
+  uint32_t i, n;
+  FILE *fp;
+
+  if (trace_file != NULL)
+    {
+      snprintf (path, sizeof (path), "%s", trace_file);
+    }
+  else if (tmp_file (path, sizeof (path)) != 0)
+    {
+      CHECK (0, "temporary file");
+      return;
+    }
+
+  /* Record */
+  start_both ();
+  CHECK (vbus_trace_out (path) == 0, "open %s", path);
+  CHECK (msg_send (0U, 2U, 0x123U, 0U, d, 3U) == 3, "send");
+  wait_for (&vbus.log_num, 1U);
+  CHECK (msg_send (1U, 2U, ARM_CAN_EXTENDED_ID (0x1ABCDEFU), 1U, NULL, 2U) == 0, "send");
+  wait_for (&vbus.log_num, 2U);
+  wait_bits (1000U);
+  CHECK (msg_send (0U, 3U, 0x7FFU, 0U, d, 0U) == 0, "send");
+  wait_for (&vbus.log_num, 3U);
+  CHECK (msg_send (1U, 2U, ARM_CAN_EXTENDED_ID (1U), 0U, d, 8U) == 8, "send");
+  wait_for (&vbus.log_num, 4U);
+  wait_ticks (2U);
+  vbus_trace_out (NULL);
+  n = vbus.log_num;
+  CHECK (n == 4U, "%u frames", (unsigned) n);
+  memcpy (rec, vbus_log, sizeof (rec));
+
+  fp = fopen (path, "r");
+  CHECK (fp != NULL, "open %s", path);
+  if (fp == NULL)
+    {
+      return;
+    }
+  for (i = 0U; fgets (line, sizeof (line), fp) != NULL; i++)
+    {
+      if ((i >= n)
+          || (sscanf (line, "(%llu.%llu) %31s %63s", &sec, &usec, iface, str) != 4))
+        {
+          CHECK (0, "line %u: %s", (unsigned) i, line);
+          break;
+        }
+      frame_str (want, sizeof (want), &rec[i]);
+      CHECK ((strcmp (iface, "vbus") == 0) && (strcmp (str, want) == 0),
+             "line %u: %s %s, expected %s", (unsigned) i, iface, str, want);
+      CHECK (((sec * 1000000U) + usec) == (rec[i].time * 2U), "line %u: time %llu.%06llu",
+             (unsigned) i, sec, usec);
+    }
+  fclose (fp);
+  CHECK (i == n, "%u lines", (unsigned) i);
+
+  /* Replay of the recording: same frames, same spacing */
+  start_both ();
+  CHECK (vbus_trace_in (path) == (int) n, "replay");
+  CHECK (wait_for (&vbus.log_num, n), "replayed frames missing");
+  for (i = 0U; i < n; i++)
+    {
+      CHECK (frame_is (&vbus_log[i], rec[i].id, rec[i].rtr, rec[i].dlc, rec[i].data)
+             && (vbus_log[i].sender == VBUS_EXT), "replayed frame %u", (unsigned) i);
+      CHECK ((vbus_log[i].time - vbus_log[0].time) == (rec[i].time - rec[0].time),
+             "replayed frame %u at %llu bits, recorded at %llu", (unsigned) i,
+             (unsigned long long) (vbus_log[i].time - vbus_log[0].time),
+             (unsigned long long) (rec[i].time - rec[0].time));
+    }
+
+  if (trace_file == NULL)
+    {
+      unlink (path);
+    }
+
+  /* Handwritten log: comment and malformed lines skipped */
+  if (tmp_file (path, sizeof (path)) != 0)
+    {
+      CHECK (0, "temporary file");
+      return;
+    }
+  fp = fopen (path, "w");
+  CHECK (fp != NULL, "open %s", path);
+  if (fp != NULL)
+    {
+      fputs (replay, fp);
+      fclose (fp);
+    }
+  start_both ();
+  CHECK (vbus_trace_in (path) == 3, "log lines");
+  unlink (path);
+  CHECK (wait_for (&vbus.log_num, 3U), "frames missing");
+  CHECK (frame_is (&vbus_log[0], 0x301U, 0U, 2U, (const uint8_t *) "\x01\x02")
+         && frame_is (&vbus_log[1], ARM_CAN_EXTENDED_ID (0x1FFFFFFFU), 1U, 8U, NULL)
+         && frame_is (&vbus_log[2], 0x302U, 0U, 0U, NULL), "log frames");
+  CHECK (((vbus_log[1].time - vbus_log[0].time) == 250U)
+         && ((vbus_log[2].time - vbus_log[0].time) == 5250U), "log times");
+  wait_ticks (4U);
+  CHECK (read1 (0U, 8U) == 2, "standard frames");
+  CHECK ((read1 (1U, 8U) == 1) && (rx_buf[0].rtr == 1U) && (rx_buf[0].dlc == 8U),
+         "extended remote frame");
+}
+
+static void
+test_socket (void)
+{
+  static const uint8_t d[4] = { 0xDE, 0xAD, 0xBE, 0xEF };
+  struct sockaddr_can addr;
+  struct can_frame cf;
+  struct ifreq ifr;
+  struct pollfd pfd;
+  int s;
+
+  s = socket (PF_CAN, SOCK_RAW, CAN_RAW);
+  CHECK (s >= 0, "socket");
+  if (s < 0)
+    {
+      return;
+    }
+  memset (&ifr, 0, sizeof (ifr));
+  strncpy (ifr.ifr_name, ifname, IFNAMSIZ - 1);
+  memset (&addr, 0, sizeof (addr));
+  addr.can_family = AF_CAN;
+  if (ioctl (s, SIOCGIFINDEX, &ifr) == 0)
+    {
+      addr.can_ifindex = ifr.ifr_ifindex;
+    }
+  CHECK (bind (s, (struct sockaddr *) &addr, sizeof (addr)) == 0, "bind %s", ifname);
+  CHECK (vbus_socket (ifname) == 0, "vbus on %s", ifname);
+
+  /* CAN1 to the interface */
+  start_both ();
+  CHECK (msg_send (0U, 2U, 0x555U, 0U, d, 4U) == 4, "send");
+  pfd.fd = s;
+  pfd.events = POLLIN;
+  CHECK ((poll (&pfd, 1, 1000) == 1) && (read (s, &cf, sizeof (cf)) == (ssize_t) sizeof (cf))
+         && (cf.can_id == 0x555U) && (cf.can_dlc == 4U) && (memcmp (cf.data, d, 4U) == 0),
+         "frame on %s", ifname);
+
+  /* Interface to CAN1 */
+  memset (&cf, 0, sizeof (cf));
+  cf.can_id = 0x1234567U | CAN_EFF_FLAG;
+  cf.can_dlc = 4U;
+  memcpy (cf.data, d, 4U);
+  CHECK (write (s, &cf, sizeof (cf)) == (ssize_t) sizeof (cf), "write %s", ifname);
+  wait_for (&vbus.log_num, 2U);
+  wait_ticks (4U);
+  CHECK ((read1 (1U, 8U) == 1) && msg_is (&rx_buf[0], ARM_CAN_EXTENDED_ID (0x1234567U), 0U, 4U, d),
+         "frame from %s", ifname);
+
+  vbus_socket (NULL);
+  close (s);
+}
+
+int
+main (int argc, char **argv)
+{
+  static const struct
+  {
+    const char *name;
+    void (*fn) (void);
+  } tests[] =
+    {
+      { "init",         test_init },
+      { "loopback",     test_loopback },
+      { "frames",       test_frames },
+      { "arbitration",  test_arbitration },
+      { "errors",       test_errors },
+      { "tx priority",  test_tx_priority },
+      { "filter table", test_filter_table },
+      { "set filter",   test_set_filter },
+      { "timestamp",    test_timestamp },
+      { "trace",        test_trace },
+      { "socket",       test_socket },
+    };
+  uint32_t i, f0, s0, l0, ok;
+  int opt;
+
+  while ((opt = getopt (argc, argv, "i:w:")) != -1)
+    {
+      switch (opt)
+        {
+        case 'i':
+          ifname = optarg;
+          break;
+        case 'w':
+          trace_file = optarg;
+          break;
+        default:
+          fprintf (stderr, "usage: %s [-i ifname] [-w file]\n", argv[0]);
+          return 2;
+        }
+    }
+
+  vbus_start (100U);
+  for (i = 0U; i < (sizeof (tests) / sizeof (tests[0])); i++)
+    {
+      if ((tests[i].fn == test_socket) && (ifname == NULL))
+        {
+          printf ("%-14s %s\n", tests[i].name, "skipped (-i ifname)");
+          continue;
+        }
+      f0 = failed;
+      s0 = storms_now ();
+      l0 = locked_now ();
+      tests[i].fn ();
+      CHECK (storms_now () == s0, "%s: interrupt storm", tests[i].name);
+      CHECK (locked_now () == l0, "%s: locked register written", tests[i].name);
+      ok = (failed == f0);
+      printf ("%-14s %s\n", tests[i].name, ok ? "ok" : "FAILED");
+    }
+  vbus_stop ();
+
+  return (failed != 0U) ? 1 : 0;
+}
@@ -0,0 +1,54 @@
+/*
+ * Host build of the CAN driver: subset of the STM32F7xx HAL.
+ *
+ * The device header provides the register definitions. CAN1 and CAN2
+ * are redirected to the register model of the virtual bus, RCC to a plain
+ * register block. The CAN handle functions, the HAL tick (derived from
+ * the bus time) and the APB1 clock are implemented by the virtual bus
+ * (vbus.c).
+ */
+
+#ifndef __STM32F7xx_HAL_H
+#define __STM32F7xx_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define STM32F746xx
+#include "stm32f746xx.h"
+
+/* CAN1 and CAN2 registers of the virtual bus, RCC */
+extern uint8_t vbus_regs[2][4096];
+extern RCC_TypeDef vbus_rcc;
+
+#undef  CAN1
+#define CAN1                    ((CAN_TypeDef *)vbus_regs[0])
+#undef  CAN2
+#define CAN2                    ((CAN_TypeDef *)vbus_regs[1])
+#undef  RCC
+#define RCC                     (&vbus_rcc)
+
+typedef enum
+{
+  HAL_OK       = 0x00U,
+  HAL_ERROR    = 0x01U,
+  HAL_BUSY     = 0x02U,
+  HAL_TIMEOUT  = 0x03U
+} HAL_StatusTypeDef;
+
+/* RCC */
+uint32_t HAL_RCC_GetPCLK1Freq (void);
+
+/* Tick */
+uint32_t HAL_GetTick (void);
+
+/* CAN */
+typedef struct
+{
+  CAN_TypeDef                *Instance;
+} CAN_HandleTypeDef;
+
+void              HAL_CAN_MspInit (CAN_HandleTypeDef *hcan);
+HAL_StatusTypeDef HAL_CAN_DeInit  (CAN_HandleTypeDef *hcan);
+
+#endif /* __STM32F7xx_HAL_H */
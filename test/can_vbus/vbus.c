@@ -0,0 +1,2226 @@
+/*
+ * Virtual CAN bus for host tests of the CAN driver.
+ *
+ * The driver runs unchanged against a model of the bxCAN controllers CAN1
+ * and CAN2 connected to one bus:
+ *  - registers: MCR/MSR initialization and sleep handshake, software
+ *    reset, TSR with the three transmit mailboxes (request, abort, CODE),
+ *    the receive FIFOs (3 messages, FMP/FULL/FOVR, RFLM, RFOM release),
+ *    IER/ESR with the error counters, error warning, error passive and
+ *    bus-off (automatic or software recovery after 128 x 11 bits), the
+ *    LEC and ERRI, BTR writable in initialization mode only;
+ *  - filter banks (in CAN1, split at CAN2SB): 16/32-bit scale, list and
+ *    mask mode, FIFO assignment, activation, match priority and FMI; the
+ *    filter registers follow the FINIT and FA1R write locks;
+ *  - the bus: frames are built bit by bit (stuffing, CRC-15), senders
+ *    arbitrate on the wired-AND of their bits, a recessive bit overwritten
+ *    outside the arbitration field is a bit error (error frame, or the
+ *    error passive sender drops out), frames without acknowledgment fail;
+ *    error counters follow the fault confinement rules;
+ *  - operating modes: silent (bus monitoring), loopback (own frames only,
+ *    bits still on the bus), loopback and silent (separate segment),
+ *    sleep with wake-up on bus activity; a controller with a bitrate other
+ *    than vbus.bitrate (APB1 at 50 MHz) is not connected;
+ *  - an external node injecting frames (vbus_inject, a candump log file
+ *    with vbus_trace_in or a SocketCAN interface), writing successful
+ *    frames to a candump log file or the SocketCAN interface and
+ *    acknowledging frames if vbus.ack is set or a socket is open.
+ *
+ * Register writes: vbus_regs is mapped read-only, the model works on a
+ * writable alias of the same memory. A write by the driver faults, the
+ * fault handler unlocks the registers and single steps the instruction,
+ * the trap handler then applies the write (write 1 to clear flags, mailbox
+ * requests, FIFO release, locks, ...) before the driver executes its next
+ * instruction. Busy waits on INAK or RFOM therefore end at once, as on
+ * the target. Reads are not trapped. Register trapping is x86-64 Linux
+ * code.
+ *
+ * Time: the bus advances vbus.bits bit times per SIGALRM tick, frames span
+ * ticks. The tick runs the interrupt handlers while their NVIC lines are
+ * enabled and active, lowest IRQ number first, like an interrupt preempts
+ * thread code; __disable_irq() blocks SIGALRM. HAL_GetTick() is derived
+ * from the bus time. Control of pointer arguments are 32-bit: the test is
+ * linked without PIE and keeps those objects in static memory.
+ *
+ * Simplifications: a frame is decided when it starts (the outcome is
+ * applied at its end), frames are not overload or error delimited beyond
+ * the fixed error frame length, a node in loopback mode sees its own bits
+ * only and retries if the others destroy the frame, time triggered
+ * transmission (TGT) and the LOW flags of TSR are not modeled.
+ */
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+
+#include "vbus.h"
+
+#if !defined(__x86_64__) || !defined(__linux__)
+#error "Register write trapping needs x86-64 Linux"
+#endif
+
+vbus_t vbus;
+vbus_frame_t vbus_log[VBUS_LOG_SIZE];
+
+/* CAN1 and CAN2 registers (read-only mapping), RCC and CubeMX handles */
+uint8_t vbus_regs[2][4096] __attribute__ ((aligned (4096)));
+RCC_TypeDef vbus_rcc;
+
+CAN_HandleTypeDef hcan1;
+CAN_HandleTypeDef hcan2;
+
+/* Writable alias of vbus_regs */
+static uint8_t *alias;
+
+#define REG(x)          ((CAN_TypeDef *) (void *) (alias + ((x) * 4096U)))
+
+#define PCLK1           50000000U
+
+/* Writable register bits */
+#define MCR_MASK        0x000100FFU
+#define IER_MASK        0x00038F7FU
+#define BTR_MASK        0xC37F03FFU
+#define FILTER_MASK     0x0FFFFFFFU
+
+/* Register reset values */
+#define MCR_RESET       0x00010002U
+#define MSR_RESET       0x00000C02U
+#define TSR_RESET       0x1C000000U
+#define BTR_RESET       0x01230000U
+#define FMR_RESET       0x2A1C0E01U
+#define FMR_FIXED       0x2A1C0000U
+
+/* Bits per mailbox in TSR: RQCP, TXOK, ALST, TERR, ABRQ */
+#define TSR_MB_BITS     0x0000008FU
+#define TSR_MB_FLAGS    0x0000000FU
+
+/* Bus-off recovery: 128 occurrences of 11 recessive bits */
+#define BOFF_BITS       1408U
+
+/* Frame after the CRC: delimiter, ACK slot, ACK delimiter, EOF, IFS */
+#define FRAME_TAIL      13U
+/* Error flag, error delimiter and intermission */
+#define ERROR_FRAME     17U
+
+/* Interrupt handler calls per tick before a line counts as stuck */
+#define IRQ_LIMIT       1000U
+
+/* Segments: bus, loopback and silent mode of CAN1 and CAN2 */
+#define SEG_NUM         3U
+
+/* Controller connection (node_mode) */
+#define NODE_OFF        0U      // Initialization, sleep or bus-off
+#define NODE_NORMAL     1U
+#define NODE_SILENT     2U      // Receives, does not acknowledge or send
+#define NODE_LOOP       3U      // Sends on the bus, receives own frames
+#define NODE_LOOP_INT   4U      // Loopback and silent: own segment
+#define NODE_BITRATE    5U      // Bit timing does not match the bus
+
+/* Transmit result */
+#define TX_NONE         0U
+#define TX_OK           1U
+#define TX_LOST         2U      // Arbitration lost
+#define TX_ERROR        3U      // Bit or acknowledgment error
+#define TX_RETRY        4U      // Loopback node, frame destroyed by others
+
+/* Stuffed frame up to the CRC, arbitration field flag per bit */
+#define STREAM_MAX      160U
+
+typedef struct
+{
+  uint32_t len;
+  uint8_t bit[STREAM_MAX];
+  uint8_t arb[STREAM_MAX];
+} stream_t;
+
+/* Message in mailbox layout */
+typedef struct
+{
+  uint32_t tir;                         // Identifier (TIxR/RIxR without TXRQ)
+  uint32_t dlc;
+  uint32_t data[2];                     // TDLR/TDHR
+} msg_t;
+
+typedef struct
+{
+  uint32_t tec;                         // Transmit error counter
+  uint32_t rec;                         // Receive error counter
+  uint32_t boff;                        // Bus-off
+  uint64_t boff_end;                    // Bus-off recovery end (0 = not running)
+  uint32_t fifo[2][3][4];               // FIFO messages (RIR, RDTR, RDLR, RDHR)
+  uint32_t fmp[2];                      // Messages pending
+  uint32_t seq[3];                      // Mailbox request order (TXFP)
+  uint32_t req;                         // Request counter
+  uint32_t txing;                       // Mailboxes on the bus
+  uint32_t abort;                       // Abort requested while on the bus
+  uint32_t gen;                         // Reset generation
+} ctrl_t;
+
+/* Outcome of a frame for a controller, applied at the frame end */
+typedef struct
+{
+  uint8_t tx;                           // Transmit result (TX_xxx)
+  uint8_t mb;                           // Transmitting mailbox
+  uint8_t rx;                           // Received message (1 + sender index, 0 = none)
+  int8_t lec;                           // Last error code (-1 = unchanged)
+  int16_t tec;                          // Transmit error counter change
+  int16_t rec;                          // Receive error counter change
+  uint32_t gen;                         // Controller reset generation
+} node_t;
+
+typedef struct
+{
+  uint32_t busy;
+  uint64_t sof;                         // Start of frame
+  uint64_t end;                         // End of frame and intermission
+  uint32_t ext;                         // External node result (TX_xxx)
+  uint32_t done;                        // Successful frame: index of sender
+  uint32_t from_socket;                 // Successful frame came from the socket
+  msg_t msg[3];                         // Frames of the senders
+  uint8_t who[3];                       // Senders (VBUS_CAN1, VBUS_CAN2, VBUS_EXT)
+  node_t node[2];
+} seg_t;
+
+/* External node transmit queue */
+#define EXT_QUEUE_SIZE  4096U
+
+typedef struct
+{
+  vbus_frame_t frame;
+  uint64_t due;                         // Earliest start of frame
+  uint32_t from_socket;
+} ext_msg_t;
+
+static ctrl_t ctrl[2];
+static seg_t seg[SEG_NUM];
+static uint64_t now;
+
+static ext_msg_t ext_q[EXT_QUEUE_SIZE];
+static uint32_t ext_head, ext_cnt;
+
+static int trace_fd = -1;
+static int sock_fd = -1;
+
+/* NVIC */
+static volatile uint8_t nvic_enabled[128];
+static volatile uint8_t nvic_pending[128];
+
+static const IRQn_Type irq_num[2][4] =
+{
+  { CAN1_TX_IRQn, CAN1_RX0_IRQn, CAN1_RX1_IRQn, CAN1_SCE_IRQn },
+  { CAN2_TX_IRQn, CAN2_RX0_IRQn, CAN2_RX1_IRQn, CAN2_SCE_IRQn }
+};
+
+static void (* const irq_handler[2][4]) (void) =
+{
+  { CAN1_TX_IRQHandler, CAN1_RX0_IRQHandler, CAN1_RX1_IRQHandler, CAN1_SCE_IRQHandler },
+  { CAN2_TX_IRQHandler, CAN2_RX0_IRQHandler, CAN2_RX1_IRQHandler, CAN2_SCE_IRQHandler }
+};
+
+/* Register write in progress (fault to trap) */
+static volatile uint32_t trap_busy;
+static uint32_t trap_x, trap_off, trap_old[2];
+static sigset_t trap_mask;
+
+static uint32_t
+rd (uint32_t x, uint32_t off)
+{
+  return *(volatile uint32_t *) (void *) (alias + (x * 4096U) + off);
+}
+
+static void
+wr (uint32_t x, uint32_t off, uint32_t val)
+{
+  *(volatile uint32_t *) (void *) (alias + (x * 4096U) + off) = val;
+}
+
+/* --------------------------------------------------------------------------
+ * Core
+ */
+
+uint32_t
+__get_PRIMASK (void)
+{
+  sigset_t set;
+
+  sigprocmask (SIG_BLOCK, NULL, &set);
+  return (sigismember (&set, SIGALRM) == 1) ? 1U : 0U;
+}
+
+void
+__disable_irq (void)
+{
+  sigset_t set;
+
+  sigemptyset (&set);
+  sigaddset (&set, SIGALRM);
+  sigprocmask (SIG_BLOCK, &set, NULL);
+}
+
+void
+__enable_irq (void)
+{
+  sigset_t set;
+
+  sigemptyset (&set);
+  sigaddset (&set, SIGALRM);
+  sigprocmask (SIG_UNBLOCK, &set, NULL);
+}
+
+void
+__set_PRIMASK (uint32_t priMask)
+{
+  if (priMask != 0U)
+    {
+      __disable_irq ();
+    }
+  else
+    {
+      __enable_irq ();
+    }
+}
+
+void
+NVIC_EnableIRQ (IRQn_Type IRQn)
+{
+  nvic_enabled[IRQn] = 1U;
+}
+
+void
+NVIC_DisableIRQ (IRQn_Type IRQn)
+{
+  nvic_enabled[IRQn] = 0U;
+}
+
+void
+NVIC_SetPendingIRQ (IRQn_Type IRQn)
+{
+  nvic_pending[IRQn] = 1U;
+}
+
+void
+NVIC_ClearPendingIRQ (IRQn_Type IRQn)
+{
+  nvic_pending[IRQn] = 0U;
+}
+
+/* --------------------------------------------------------------------------
+ * HAL
+ */
+
+uint32_t
+HAL_RCC_GetPCLK1Freq (void)
+{
+  return PCLK1;
+}
+
+uint32_t
+HAL_GetTick (void)
+{
+  return (uint32_t) ((now * 1000U) / vbus.bitrate);
+}
+
+void
+HAL_CAN_MspInit (CAN_HandleTypeDef *hcan)
+{
+  uint32_t x, n;
+
+  x = (hcan->Instance == CAN1) ? 0U : 1U;
+  vbus_rcc.APB1ENR |= (x == 0U) ? RCC_APB1ENR_CAN1EN : RCC_APB1ENR_CAN2EN;
+  for (n = 0U; n < 4U; n++)
+    {
+      NVIC_EnableIRQ (irq_num[x][n]);
+    }
+}
+
+HAL_StatusTypeDef
+HAL_CAN_DeInit (CAN_HandleTypeDef *hcan)
+{
+  uint32_t x, n;
+
+  x = (hcan->Instance == CAN1) ? 0U : 1U;
+  for (n = 0U; n < 4U; n++)
+    {
+      NVIC_DisableIRQ (irq_num[x][n]);
+    }
+  vbus_rcc.APB1ENR &= (x == 0U) ? ~RCC_APB1ENR_CAN1EN : ~RCC_APB1ENR_CAN2EN;
+  return HAL_OK;
+}
+
+/* --------------------------------------------------------------------------
+ * Frames
+ */
+
+/* Append a field MSB first */
+static uint32_t
+field (uint8_t *raw, uint8_t *arb, uint32_t n, uint32_t val, uint32_t bits,
+       uint32_t a)
+{
+  while (bits != 0U)
+    {
+      bits--;
+      raw[n] = (uint8_t) ((val >> bits) & 1U);
+      arb[n] = (uint8_t) a;
+      n++;
+    }
+  return n;
+}
+
+/* Frame bits from SOF to the CRC, stuffed */
+static void
+stream_build (stream_t *s, const msg_t *m)
+{
+  uint8_t raw[128], arb[128];
+  uint32_t n, i, b, crc, run, last, rtr, len;
+
+  rtr = (m->tir & CAN_TI0R_RTR) ? 1U : 0U;
+  n = field (raw, arb, 0U, 0U, 1U, 0U);                 // SOF
+  n = field (raw, arb, n, m->tir >> 21, 11U, 1U);       // Base identifier
+  if ((m->tir & CAN_TI0R_IDE) == 0U)
+    {
+      n = field (raw, arb, n, rtr, 1U, 1U);             // RTR
+      n = field (raw, arb, n, 0U, 2U, 0U);              // IDE, r0
+    }
+  else
+    {
+      n = field (raw, arb, n, 3U, 2U, 1U);              // SRR, IDE
+      n = field (raw, arb, n, (m->tir >> 3) & 0x3FFFFU, 18U, 1U);
+      n = field (raw, arb, n, rtr, 1U, 1U);             // RTR
+      n = field (raw, arb, n, 0U, 2U, 0U);              // r1, r0
+    }
+  n = field (raw, arb, n, m->dlc, 4U, 0U);
+  if (rtr == 0U)
+    {
+      len = (m->dlc > 8U) ? 8U : m->dlc;
+      for (i = 0U; i < len; i++)
+        {
+          n = field (raw, arb, n, m->data[i / 4U] >> ((i % 4U) * 8U), 8U, 0U);
+        }
+    }
+
+  crc = 0U;
+  for (i = 0U; i < n; i++)
+    {
+      b = raw[i] ^ ((crc >> 14) & 1U);
+      crc = (crc << 1) & 0x7FFFU;
+      if (b != 0U)
+        {
+          crc ^= 0x4599U;
+        }
+    }
+  n = field (raw, arb, n, crc, 15U, 0U);
+
+  /* Stuff bit after five equal bits, part of the field it follows */
+  s->len = 0U;
+  run = 0U;
+  last = 2U;
+  for (i = 0U; i < n; i++)
+    {
+      b = raw[i];
+      s->bit[s->len] = (uint8_t) b;
+      s->arb[s->len] = arb[i];
+      s->len++;
+      run = (b == last) ? (run + 1U) : 1U;
+      last = b;
+      if (run == 5U)
+        {
+          s->bit[s->len] = (uint8_t) (b ^ 1U);
+          s->arb[s->len] = arb[i];
+          s->len++;
+          last = b ^ 1U;
+          run = 1U;
+        }
+    }
+}
+
+/* Identifier in mailbox layout */
+static uint32_t
+frame_tir (uint32_t id, uint32_t rtr)
+{
+  uint32_t tir;
+
+  if (id & ARM_CAN_ID_IDE_Msk)
+    {
+      tir = ((id & 0x1FFFFFFFU) << 3) | CAN_TI0R_IDE;
+    }
+  else
+    {
+      tir = (id & 0x7FFU) << 21;
+    }
+  return (rtr != 0U) ? (tir | CAN_TI0R_RTR) : tir;
+}
+
+static void
+frame_to_msg (msg_t *m, const vbus_frame_t *f)
+{
+  uint32_t i;
+
+  m->tir = frame_tir (f->id, f->rtr);
+  m->dlc = f->dlc & 0xFU;
+  m->data[0] = 0U;
+  m->data[1] = 0U;
+  for (i = 0U; i < 8U; i++)
+    {
+      m->data[i / 4U] |= (uint32_t) f->data[i] << ((i % 4U) * 8U);
+    }
+}
+
+static void
+msg_to_frame (vbus_frame_t *f, const msg_t *m)
+{
+  uint32_t i;
+
+  memset (f, 0, sizeof (*f));
+  if (m->tir & CAN_TI0R_IDE)
+    {
+      f->id = ((m->tir >> 3) & 0x1FFFFFFFU) | ARM_CAN_ID_IDE_Msk;
+    }
+  else
+    {
+      f->id = m->tir >> 21;
+    }
+  f->rtr = (m->tir & CAN_TI0R_RTR) ? 1U : 0U;
+  f->dlc = (uint8_t) m->dlc;
+  if (f->rtr == 0U)
+    {
+      for (i = 0U; (i < m->dlc) && (i < 8U); i++)
+        {
+          f->data[i] = (uint8_t) (m->data[i / 4U] >> ((i % 4U) * 8U));
+        }
+    }
+}
+
+/* Sign of the arbitration between two identifiers: -1 = a wins */
+int32_t
+vbus_arbitrate (uint32_t tir_a, uint32_t tir_b)
+{
+  stream_t sa, sb;
+  msg_t ma, mb;
+  uint32_t i;
+
+  memset (&ma, 0, sizeof (ma));
+  memset (&mb, 0, sizeof (mb));
+  ma.tir = tir_a & ~CAN_TI0R_TXRQ;
+  mb.tir = tir_b & ~CAN_TI0R_TXRQ;
+  stream_build (&sa, &ma);
+  stream_build (&sb, &mb);
+
+  for (i = 0U; (i < sa.len) && (i < sb.len); i++)
+    {
+      if (sa.bit[i] != sb.bit[i])
+        {
+          if (sa.bit[i] == 0U)
+            {
+              return (sb.arb[i] != 0U) ? -1 : 0;
+            }
+          return (sa.arb[i] != 0U) ? 1 : 0;
+        }
+    }
+  return 0;
+}
+
+/* --------------------------------------------------------------------------
+ * Filters
+ */
+
+/* Matching filter of controller x: FIFO and FMI, -1 if rejected */
+static int32_t
+filter_match (uint32_t x, uint32_t rir, uint32_t *fmi)
+{
+  const CAN_TypeDef *f = REG (0U);
+  uint32_t sb, bank, first, end, msk, fifo, n, i, m, h, fr[2], half, hit;
+  uint32_t key, best, num[2];
+  int32_t result;
+
+  sb = (f->FMR & CAN_FMR_CAN2SB) >> 8;
+  if (sb > 28U)
+    {
+      sb = 28U;
+    }
+  first = (x == 0U) ? 0U : sb;
+  end   = (x == 0U) ? sb : 28U;
+
+  /* 32-bit: STID/EXID[31:3] IDE[2] RTR[1], 16-bit: STID RTR IDE EXID[17:15] */
+  m = rir & ~1U;
+  h = ((m >> 21) << 5) | (((m >> 1) & 1U) << 4) | (((m >> 2) & 1U) << 3)
+      | ((m >> 18) & 7U);
+
+  num[0] = 0U;
+  num[1] = 0U;
+  best = 0xFFFFFFFFU;
+  result = -1;
+  for (bank = first; bank < end; bank++)
+    {
+      msk  = 1UL << bank;
+      fifo = (f->FFA1R & msk) ? 1U : 0U;
+      if (f->FS1R & msk)
+        {
+          n = (f->FM1R & msk) ? 2U : 1U;
+        }
+      else
+        {
+          n = (f->FM1R & msk) ? 4U : 2U;
+        }
+      fr[0] = f->sFilterRegister[bank].FR1;
+      fr[1] = f->sFilterRegister[bank].FR2;
+
+      for (i = 0U; (i < n) && (f->FA1R & msk); i++)
+        {
+          if (f->FS1R & msk)
+            {
+              if (f->FM1R & msk)
+                {
+                  hit = (m == (fr[i] & ~1U));
+                }
+              else
+                {
+                  hit = (((m ^ fr[0]) & fr[1] & ~1U) == 0U);
+                }
+            }
+          else if (f->FM1R & msk)
+            {
+              half = (fr[i / 2U] >> ((i % 2U) * 16U)) & 0xFFFFU;
+              hit = (h == half);
+            }
+          else
+            {
+              hit = (((h ^ fr[i]) & (fr[i] >> 16) & 0xFFFFU) == 0U);
+            }
+
+          /* 32-bit before 16-bit, list before mask, then lower number */
+          key = (((f->FS1R & msk) ? 0U : 2U) + ((f->FM1R & msk) ? 0U : 1U)) << 8;
+          key |= num[fifo] + i;
+          if (hit && (key < best))
+            {
+              best = key;
+              *fmi = num[fifo] + i;
+              result = (int32_t) fifo;
+            }
+        }
+      num[fifo] += n;
+    }
+  return result;
+}
+
+int32_t
+vbus_accept (uint32_t x, uint32_t id, uint32_t rtr)
+{
+  uint32_t fmi;
+
+  return filter_match (x, frame_tir (id, rtr), &fmi);
+}
+
+/* --------------------------------------------------------------------------
+ * Controllers
+ */
+
+static void
+tsr_code (uint32_t x)
+{
+  CAN_TypeDef *r = REG (x);
+  uint32_t mb;
+
+  for (mb = 0U; mb < 3U; mb++)
+    {
+      if (r->TSR & (CAN_TSR_TME0 << mb))
+        {
+          r->TSR = (r->TSR & ~CAN_TSR_CODE) | (mb << CAN_TSR_CODE_Pos);
+          return;
+        }
+    }
+}
+
+/* Mailbox emptied: request completed with flags (TXOK, ALST, TERR) */
+static void
+tx_done (uint32_t x, uint32_t mb, uint32_t flags)
+{
+  CAN_TypeDef *r = REG (x);
+  uint32_t sh;
+
+  sh = mb * 8U;
+  r->sTxMailBox[mb].TIR &= ~CAN_TI0R_TXRQ;
+  r->TSR = (r->TSR & ~(TSR_MB_BITS << sh))
+           | ((CAN_TSR_RQCP0 | flags) << sh) | (CAN_TSR_TME0 << mb);
+  ctrl[x].abort &= ~(1UL << mb);
+  tsr_code (x);
+}
+
+static void
+fifo_update (uint32_t x, uint32_t f)
+{
+  CAN_TypeDef *r = REG (x);
+  volatile uint32_t *rfr;
+  ctrl_t *c = &ctrl[x];
+
+  rfr = (f == 0U) ? &r->RF0R : &r->RF1R;
+  *rfr = (*rfr & (CAN_RF0R_FULL0 | CAN_RF0R_FOVR0)) | c->fmp[f];
+  if (c->fmp[f] != 0U)
+    {
+      r->sFIFOMailBox[f].RIR  = c->fifo[f][0][0];
+      r->sFIFOMailBox[f].RDTR = c->fifo[f][0][1];
+      r->sFIFOMailBox[f].RDLR = c->fifo[f][0][2];
+      r->sFIFOMailBox[f].RDHR = c->fifo[f][0][3];
+    }
+}
+
+static void
+fifo_push (uint32_t x, uint32_t f, const uint32_t *mb)
+{
+  CAN_TypeDef *r = REG (x);
+  volatile uint32_t *rfr;
+  ctrl_t *c = &ctrl[x];
+
+  rfr = (f == 0U) ? &r->RF0R : &r->RF1R;
+  if (c->fmp[f] == 3U)
+    {
+      /* Overrun: newest message overwritten unless FIFO locked */
+      *rfr |= CAN_RF0R_FOVR0;
+      vbus.overruns++;
+      if ((r->MCR & CAN_MCR_RFLM) == 0U)
+        {
+          memcpy (c->fifo[f][2], mb, 16U);
+        }
+    }
+  else
+    {
+      memcpy (c->fifo[f][c->fmp[f]], mb, 16U);
+      if (++c->fmp[f] == 3U)
+        {
+          *rfr |= CAN_RF0R_FULL0;
+        }
+    }
+  fifo_update (x, f);
+}
+
+static void
+fifo_release (uint32_t x, uint32_t f)
+{
+  ctrl_t *c = &ctrl[x];
+
+  if (c->fmp[f] != 0U)
+    {
+      c->fmp[f]--;
+      memmove (c->fifo[f][0], c->fifo[f][1], c->fmp[f] * 16U);
+    }
+  fifo_update (x, f);
+}
+
+/* Error flags from counters, ERRI on a new flag or error code */
+static void
+esr_update (uint32_t x, int32_t lec)
+{
+  CAN_TypeDef *r = REG (x);
+  ctrl_t *c = &ctrl[x];
+  uint32_t old, esr, rise, ier;
+
+  old = r->ESR;
+  esr = (lec >= 0) ? ((uint32_t) lec << CAN_ESR_LEC_Pos) : (old & CAN_ESR_LEC);
+  if (c->boff != 0U)
+    {
+      esr |= CAN_ESR_BOFF;
+    }
+  if ((c->tec > 127U) || (c->rec > 127U))
+    {
+      esr |= CAN_ESR_EPVF;
+    }
+  if ((c->tec >= 96U) || (c->rec >= 96U))
+    {
+      esr |= CAN_ESR_EWGF;
+    }
+  esr |= (((c->tec > 255U) ? 255U : c->tec) << CAN_ESR_TEC_Pos)
+         | (((c->rec > 255U) ? 255U : c->rec) << CAN_ESR_REC_Pos);
+  r->ESR = esr;
+
+  ier = r->IER;
+  rise = esr & ~old;
+  if (((rise & CAN_ESR_EWGF) && (ier & CAN_IER_EWGIE))
+      || ((rise & CAN_ESR_EPVF) && (ier & CAN_IER_EPVIE))
+      || ((rise & CAN_ESR_BOFF) && (ier & CAN_IER_BOFIE))
+      || ((lec >= 1) && (lec <= 6) && (ier & CAN_IER_LECIE)))
+    {
+      r->MSR |= CAN_MSR_ERRI;
+    }
+}
+
+static void
+ctrl_reset (uint32_t x)
+{
+  CAN_TypeDef *r = REG (x);
+  ctrl_t *c = &ctrl[x];
+  uint32_t gen;
+
+  memset (alias + (x * 4096U), 0, offsetof (CAN_TypeDef, FMR));
+  r->MCR = MCR_RESET;
+  r->MSR = MSR_RESET;
+  r->TSR = TSR_RESET;
+  r->BTR = BTR_RESET;
+
+  gen = c->gen + 1U;
+  memset (c, 0, sizeof (*c));
+  c->gen = gen;
+}
+
+static void
+mcr_write (uint32_t x, uint32_t old, uint32_t val)
+{
+  CAN_TypeDef *r = REG (x);
+  ctrl_t *c = &ctrl[x];
+  uint32_t msr;
+
+  if (val & CAN_MCR_RESET)
+    {
+      ctrl_reset (x);
+      return;
+    }
+  val &= MCR_MASK;
+  r->MCR = val;
+
+  msr = r->MSR & ~(CAN_MSR_INAK | CAN_MSR_SLAK);
+  if (val & CAN_MCR_INRQ)
+    {
+      msr |= CAN_MSR_INAK;
+    }
+  else if (val & CAN_MCR_SLEEP)
+    {
+      msr |= CAN_MSR_SLAK;
+      if ((r->MSR & CAN_MSR_SLAK) == 0U)
+        {
+          msr |= CAN_MSR_SLAKI;
+        }
+    }
+  r->MSR = msr;
+
+  /* Software recovery from bus-off starts when leaving initialization */
+  if ((old & CAN_MCR_INRQ) && !(val & CAN_MCR_INRQ) && (c->boff != 0U)
+      && (c->boff_end == 0U))
+    {
+      c->boff_end = now + BOFF_BITS;
+    }
+}
+
+static void
+tsr_write (uint32_t x, uint32_t old, uint32_t val)
+{
+  CAN_TypeDef *r = REG (x);
+  ctrl_t *c = &ctrl[x];
+  uint32_t mb, sh, tsr;
+
+  tsr = old;
+  for (mb = 0U; mb < 3U; mb++)
+    {
+      sh = mb * 8U;
+      if (val & (CAN_TSR_RQCP0 << sh))
+        {
+          tsr &= ~(TSR_MB_FLAGS << sh);
+        }
+    }
+  r->TSR = tsr;
+
+  for (mb = 0U; mb < 3U; mb++)
+    {
+      sh = mb * 8U;
+      if (!(val & (CAN_TSR_ABRQ0 << sh)) || (tsr & (CAN_TSR_TME0 << mb)))
+        {
+          continue;
+        }
+      if (c->txing & (1UL << mb))
+        {
+          c->abort |= 1UL << mb;        // Decided at the end of the frame
+          r->TSR |= CAN_TSR_ABRQ0 << sh;
+        }
+      else
+        {
+          tx_done (x, mb, 0U);
+        }
+    }
+}
+
+static void
+rfr_write (uint32_t x, uint32_t f, uint32_t old, uint32_t val)
+{
+  CAN_TypeDef *r = REG (x);
+  volatile uint32_t *rfr;
+
+  rfr = (f == 0U) ? &r->RF0R : &r->RF1R;
+  *rfr = old & ~(val & (CAN_RF0R_FULL0 | CAN_RF0R_FOVR0));
+  if (val & CAN_RF0R_RFOM0)
+    {
+      fifo_release (x, f);
+    }
+  else
+    {
+      fifo_update (x, f);
+    }
+}
+
+/* Transmit mailbox register, writable while the mailbox is empty */
+static uint32_t
+mailbox_write (uint32_t x, uint32_t off, uint32_t val)
+{
+  CAN_TypeDef *r = REG (x);
+  ctrl_t *c = &ctrl[x];
+  uint32_t mb;
+
+  mb = (off - offsetof (CAN_TypeDef, sTxMailBox)) / 16U;
+  if ((r->TSR & (CAN_TSR_TME0 << mb)) == 0U)
+    {
+      return 0U;
+    }
+  if ((off % 16U) == 0U)
+    {
+      r->sTxMailBox[mb].TIR = val;
+      if (val & CAN_TI0R_TXRQ)
+        {
+          r->TSR &= ~((TSR_MB_FLAGS << (mb * 8U)) | (CAN_TSR_TME0 << mb));
+          c->seq[mb] = ++c->req;
+          tsr_code (x);
+        }
+    }
+  return 1U;
+}
+
+/* CAN1 filter registers */
+static uint32_t
+filter_write (uint32_t off, uint32_t old, uint32_t val)
+{
+  CAN_TypeDef *r = REG (0U);
+  uint32_t finit, bank;
+
+  finit = r->FMR & CAN_FMR_FINIT;
+  switch (off)
+    {
+    case offsetof (CAN_TypeDef, FMR):
+      if (((old | val) & CAN_FMR_FINIT) == 0U)
+        {
+          val = (val & ~CAN_FMR_CAN2SB) | (old & CAN_FMR_CAN2SB);
+        }
+      r->FMR = FMR_FIXED | (val & (CAN_FMR_CAN2SB | CAN_FMR_FINIT));
+      return 1U;
+    case offsetof (CAN_TypeDef, FM1R):
+    case offsetof (CAN_TypeDef, FS1R):
+    case offsetof (CAN_TypeDef, FFA1R):
+      if (finit == 0U)
+        {
+          return 0U;
+        }
+      wr (0U, off, val & FILTER_MASK);
+      return 1U;
+    case offsetof (CAN_TypeDef, FA1R):
+      r->FA1R = val & FILTER_MASK;
+      return 1U;
+    default:
+      break;
+    }
+  if (off < offsetof (CAN_TypeDef, sFilterRegister))
+    {
+      return 0U;
+    }
+  bank = (off - offsetof (CAN_TypeDef, sFilterRegister)) / 8U;
+  return ((finit != 0U) || ((r->FA1R & (1UL << bank)) == 0U)) ? 1U : 0U;
+}
+
+/* Apply a register write of the driver (trap handler) */
+static void
+reg_write (uint32_t x, uint32_t off, uint32_t old, uint32_t val)
+{
+  CAN_TypeDef *r = REG (x);
+  uint32_t ok;
+
+  ok = 1U;
+  switch (off)
+    {
+    case offsetof (CAN_TypeDef, MCR):
+      mcr_write (x, old, val);
+      break;
+    case offsetof (CAN_TypeDef, MSR):
+      r->MSR = old & ~(val & (CAN_MSR_ERRI | CAN_MSR_WKUI | CAN_MSR_SLAKI));
+      break;
+    case offsetof (CAN_TypeDef, TSR):
+      tsr_write (x, old, val);
+      break;
+    case offsetof (CAN_TypeDef, RF0R):
+      rfr_write (x, 0U, old, val);
+      break;
+    case offsetof (CAN_TypeDef, RF1R):
+      rfr_write (x, 1U, old, val);
+      break;
+    case offsetof (CAN_TypeDef, IER):
+      r->IER = val & IER_MASK;
+      break;
+    case offsetof (CAN_TypeDef, ESR):
+      r->ESR = (old & ~CAN_ESR_LEC) | (val & CAN_ESR_LEC);
+      break;
+    case offsetof (CAN_TypeDef, BTR):
+      ok = (r->MSR & CAN_MSR_INAK) ? 1U : 0U;
+      if (ok != 0U)
+        {
+          r->BTR = val & BTR_MASK;
+        }
+      break;
+    default:
+      if ((off >= offsetof (CAN_TypeDef, sTxMailBox))
+          && (off < offsetof (CAN_TypeDef, sFIFOMailBox)))
+        {
+          ok = mailbox_write (x, off, val);
+        }
+      else if ((x == 0U) && (off >= offsetof (CAN_TypeDef, FMR))
+               && (off < sizeof (CAN_TypeDef)))
+        {
+          ok = filter_write (off, old, val);
+        }
+      else
+        {
+          ok = 0U;                      // Read-only or reserved
+        }
+      break;
+    }
+
+  if (ok == 0U)
+    {
+      wr (x, off, old);
+      vbus.locked++;
+    }
+}
+
+/* Connection of controller x to the bus */
+static uint32_t
+node_mode (uint32_t x)
+{
+  CAN_TypeDef *r = REG (x);
+  uint32_t btr, tq;
+
+  if ((r->MSR & (CAN_MSR_INAK | CAN_MSR_SLAK)) || (ctrl[x].boff != 0U))
+    {
+      return NODE_OFF;
+    }
+  btr = r->BTR;
+  if ((btr & CAN_BTR_LBKM) && (btr & CAN_BTR_SILM))
+    {
+      return NODE_LOOP_INT;
+    }
+  tq = 3U + ((btr & CAN_BTR_TS1) >> CAN_BTR_TS1_Pos)
+       + ((btr & CAN_BTR_TS2) >> CAN_BTR_TS2_Pos);
+  if ((PCLK1 / (((btr & CAN_BTR_BRP) + 1U) * tq)) != vbus.bitrate)
+    {
+      return NODE_BITRATE;
+    }
+  if (btr & CAN_BTR_LBKM)
+    {
+      return NODE_LOOP;
+    }
+  return (btr & CAN_BTR_SILM) ? NODE_SILENT : NODE_NORMAL;
+}
+
+/* Mailbox to send next (3 = none): identifier priority or request order */
+static uint32_t
+tx_select (uint32_t x)
+{
+  CAN_TypeDef *r = REG (x);
+  uint32_t mb, best;
+
+  best = 3U;
+  for (mb = 0U; mb < 3U; mb++)
+    {
+      if (r->TSR & (CAN_TSR_TME0 << mb))
+        {
+          continue;
+        }
+      if (best == 3U)
+        {
+          best = mb;
+        }
+      else if (r->MCR & CAN_MCR_TXFP)
+        {
+          if ((int32_t) (ctrl[x].seq[mb] - ctrl[x].seq[best]) < 0)
+            {
+              best = mb;
+            }
+        }
+      else if (vbus_arbitrate (r->sTxMailBox[mb].TIR,
+                               r->sTxMailBox[best].TIR) < 0)
+        {
+          best = mb;
+        }
+    }
+  return best;
+}
+
+static void
+mailbox_msg (uint32_t x, uint32_t mb, msg_t *m)
+{
+  CAN_TypeDef *r = REG (x);
+
+  m->tir = r->sTxMailBox[mb].TIR & ~CAN_TI0R_TXRQ;
+  m->dlc = r->sTxMailBox[mb].TDTR & CAN_TDT0R_DLC;
+  m->data[0] = r->sTxMailBox[mb].TDLR;
+  m->data[1] = r->sTxMailBox[mb].TDHR;
+}
+
+static uint32_t
+passive (uint32_t x)
+{
+  return ((ctrl[x].tec > 127U) || (ctrl[x].rec > 127U)) ? 1U : 0U;
+}
+
+/* --------------------------------------------------------------------------
+ * Bus
+ */
+
+static void
+node_init (seg_t *s)
+{
+  uint32_t x;
+
+  memset (s, 0, sizeof (*s));
+  s->busy = 1U;
+  s->sof = now;
+  for (x = 0U; x < 2U; x++)
+    {
+      s->node[x].lec = -1;
+      s->node[x].gen = ctrl[x].gen;
+    }
+}
+
+/* Loopback and silent mode: frame on the private segment of x */
+static void
+loop_start (uint32_t x)
+{
+  static stream_t st;
+  seg_t *s = &seg[1U + x];
+  node_t *nd;
+  uint32_t mb;
+
+  if (node_mode (x) != NODE_LOOP_INT)
+    {
+      return;
+    }
+  mb = tx_select (x);
+  if (mb == 3U)
+    {
+      return;
+    }
+  node_init (s);
+  s->who[0] = (uint8_t) x;
+  mailbox_msg (x, mb, &s->msg[0]);
+  stream_build (&st, &s->msg[0]);
+  s->end = now + st.len + FRAME_TAIL;
+
+  nd = &s->node[x];
+  nd->tx  = TX_OK;
+  nd->mb  = (uint8_t) mb;
+  nd->rx  = 1U;
+  nd->lec = 0;
+  nd->tec = -1;
+  ctrl[x].txing |= 1UL << mb;
+}
+
+/* Next frame on the bus: arbitration, errors and acknowledgment */
+static void
+bus_start (void)
+{
+  static stream_t st[3];
+  static uint8_t wire[STREAM_MAX];
+  seg_t *s = &seg[0];
+  node_t *nd;
+  uint32_t mode[2], loop[3], n, k, x, mb, alive, lost, errs, p, bus, any;
+  uint32_t w, clean, ack, senders, err_pos;
+
+  n = 0U;
+  for (x = 0U; x < 2U; x++)
+    {
+      mode[x] = node_mode (x);
+    }
+  node_init (s);
+  for (x = 0U; x < 2U; x++)
+    {
+      if ((mode[x] != NODE_NORMAL) && (mode[x] != NODE_LOOP))
+        {
+          continue;
+        }
+      mb = tx_select (x);
+      if (mb != 3U)
+        {
+          s->who[n] = (uint8_t) x;
+          s->node[x].mb = (uint8_t) mb;
+          mailbox_msg (x, mb, &s->msg[n]);
+          loop[n] = (mode[x] == NODE_LOOP) ? 1U : 0U;
+          n++;
+        }
+    }
+  if ((ext_cnt != 0U) && (ext_q[ext_head].due <= now))
+    {
+      s->who[n] = VBUS_EXT;
+      frame_to_msg (&s->msg[n], &ext_q[ext_head].frame);
+      s->from_socket = ext_q[ext_head].from_socket;
+      loop[n] = 0U;
+      n++;
+    }
+  if (n == 0U)
+    {
+      s->busy = 0U;
+      return;
+    }
+
+  /* Start of frame wakes sleeping controllers, others miss the frame */
+  for (x = 0U; x < 2U; x++)
+    {
+      CAN_TypeDef *r = REG (x);
+
+      if ((r->MSR & CAN_MSR_SLAK) && !(r->MSR & CAN_MSR_INAK))
+        {
+          r->MSR |= CAN_MSR_WKUI;
+          if (r->MCR & CAN_MCR_AWUM)
+            {
+              r->MCR &= ~CAN_MCR_SLEEP;
+              r->MSR &= ~CAN_MSR_SLAK;
+            }
+        }
+      else if (mode[x] == NODE_BITRATE)
+        {
+          vbus.bad_bitrate++;
+        }
+    }
+
+  for (k = 0U; k < n; k++)
+    {
+      stream_build (&st[k], &s->msg[k]);
+      if (s->who[k] != VBUS_EXT)
+        {
+          ctrl[s->who[k]].txing |= 1UL << s->node[s->who[k]].mb;
+        }
+    }
+
+  /* Bitwise arbitration on the wired-AND of the senders */
+  alive = (1UL << n) - 1U;
+  lost = 0U;
+  errs = 0U;
+  err_pos = STREAM_MAX;
+  for (p = 0U; p < STREAM_MAX; p++)
+    {
+      bus = 1U;
+      any = 0U;
+      for (k = 0U; k < n; k++)
+        {
+          if ((alive & (1UL << k)) && (p < st[k].len))
+            {
+              bus &= st[k].bit[p];
+              any = 1U;
+            }
+        }
+      if (any == 0U)
+        {
+          break;
+        }
+      wire[p] = (uint8_t) bus;
+
+      errs = 0U;
+      for (k = 0U; k < n; k++)
+        {
+          if (!(alive & (1UL << k)) || (p >= st[k].len) || (loop[k] != 0U)
+              || (st[k].bit[p] == bus))
+            {
+              continue;
+            }
+          if (st[k].arb[p] != 0U)
+            {
+              alive &= ~(1UL << k);
+              lost |= 1UL << k;
+            }
+          else
+            {
+              errs |= 1UL << k;
+            }
+        }
+      if (errs == 0U)
+        {
+          continue;
+        }
+
+      /* Error passive senders drop out with a recessive error flag */
+      for (k = 0U; k < n; k++)
+        {
+          if ((errs & (1UL << k))
+              && ((s->who[k] == VBUS_EXT) || (passive (s->who[k]) == 0U)))
+            {
+              break;
+            }
+        }
+      if (k < n)
+        {
+          err_pos = p;
+          break;
+        }
+      for (k = 0U; k < n; k++)
+        {
+          if (errs & (1UL << k))
+            {
+              nd = &s->node[s->who[k]];
+              nd->tx  = TX_ERROR;
+              nd->lec = 4;
+              nd->tec = 8;
+            }
+        }
+      alive &= ~errs;
+      errs = 0U;
+      vbus.bit_errors++;
+    }
+
+  for (k = 0U; k < n; k++)
+    {
+      if (lost & (1UL << k))
+        {
+          vbus.arb_lost++;
+          if (s->who[k] == VBUS_EXT)
+            {
+              s->ext = TX_LOST;
+            }
+          else
+            {
+              s->node[s->who[k]].tx = TX_LOST;
+            }
+        }
+    }
+
+  if (err_pos != STREAM_MAX)
+    {
+      /* Error frame: senders and receivers see the error flag */
+      vbus.bit_errors++;
+      s->end = now + err_pos + 1U + ERROR_FRAME;
+      for (k = 0U; k < n; k++)
+        {
+          if (!(alive & (1UL << k)))
+            {
+              continue;
+            }
+          if (s->who[k] == VBUS_EXT)
+            {
+              s->ext = TX_RETRY;
+              continue;
+            }
+          nd = &s->node[s->who[k]];
+          if (loop[k] != 0U)
+            {
+              nd->tx = TX_RETRY;
+              continue;
+            }
+          nd->tx  = TX_ERROR;
+          nd->lec = (errs & (1UL << k)) ? 4 : 1;
+          nd->tec = 8;
+        }
+      for (x = 0U; x < 2U; x++)
+        {
+          nd = &s->node[x];
+          if (((mode[x] == NODE_NORMAL) || (mode[x] == NODE_SILENT))
+              && ((nd->tx == TX_NONE) || (nd->tx == TX_LOST)))
+            {
+              nd->lec = 1;
+              nd->rec = 1;
+            }
+        }
+      return;
+    }
+
+  if (alive == 0U)
+    {
+      s->end = now + p + ERROR_FRAME;
+      return;
+    }
+
+  /* Frame on the wire: first sender that does not loop back */
+  w = n;
+  for (k = 0U; k < n; k++)
+    {
+      if ((alive & (1UL << k)) && ((w == n) || (loop[w] != 0U)))
+        {
+          w = k;
+        }
+    }
+  clean = (memcmp (wire, st[w].bit, st[w].len) == 0) ? 1U : 0U;
+
+  /* Receivers acknowledge: controllers in normal mode not sending */
+  senders = 0U;
+  for (k = 0U; k < n; k++)
+    {
+      if ((alive & (1UL << k)) && (s->who[k] != VBUS_EXT))
+        {
+          senders |= 1UL << s->who[k];
+        }
+    }
+  ack = 0U;
+  if (clean != 0U)
+    {
+      for (x = 0U; x < 2U; x++)
+        {
+          nd = &s->node[x];
+          if ((mode[x] == NODE_NORMAL) && !(senders & (1UL << x))
+              && ((nd->tx == TX_NONE) || (nd->tx == TX_LOST)))
+            {
+              ack = 1U;
+            }
+        }
+      if ((s->who[w] != VBUS_EXT) && ((vbus.ack != 0U) || (sock_fd >= 0)))
+        {
+          ack = 1U;
+        }
+    }
+
+  if ((ack == 0U) && (loop[w] == 0U))
+    {
+      /* Acknowledgment error */
+      vbus.ack_errors++;
+      s->end = now + st[w].len + 2U + ERROR_FRAME;
+      for (k = 0U; k < n; k++)
+        {
+          if (!(alive & (1UL << k)))
+            {
+              continue;
+            }
+          if (s->who[k] == VBUS_EXT)
+            {
+              s->ext = TX_ERROR;
+              continue;
+            }
+          nd = &s->node[s->who[k]];
+          if (loop[k] != 0U)
+            {
+              nd->tx  = TX_OK;
+              nd->rx  = (uint8_t) (k + 1U);
+              nd->lec = 0;
+              nd->tec = -1;
+              continue;
+            }
+          nd->tx  = TX_ERROR;
+          nd->lec = 3;
+          nd->tec = passive (s->who[k]) ? 0 : 8;
+        }
+      return;
+    }
+
+  /* Successful frame */
+  s->end = now + st[w].len + FRAME_TAIL;
+  for (k = 0U; k < n; k++)
+    {
+      if (!(alive & (1UL << k)))
+        {
+          continue;
+        }
+      if (s->who[k] == VBUS_EXT)
+        {
+          s->ext = TX_OK;
+          continue;
+        }
+      nd = &s->node[s->who[k]];
+      nd->tx  = TX_OK;
+      nd->lec = 0;
+      nd->tec = -1;
+      if (loop[k] != 0U)
+        {
+          nd->rx = (uint8_t) (k + 1U);
+        }
+    }
+  for (x = 0U; x < 2U; x++)
+    {
+      nd = &s->node[x];
+      if (((mode[x] != NODE_NORMAL) && (mode[x] != NODE_SILENT))
+          || ((nd->tx != TX_NONE) && (nd->tx != TX_LOST)))
+        {
+          continue;
+        }
+      if (clean != 0U)
+        {
+          nd->rx  = (uint8_t) (w + 1U);
+          nd->lec = 0;
+          nd->rec = -1;
+        }
+      else
+        {
+          nd->lec = 6;
+          nd->rec = 1;
+        }
+    }
+  if (clean != 0U)
+    {
+      s->done = w + 1U;
+    }
+}
+
+/* Store a received message in the FIFO selected by the filters */
+static void
+rx_store (uint32_t x, const msg_t *m, uint64_t sof)
+{
+  CAN_TypeDef *r = REG (x);
+  uint32_t mb[4], fmi;
+  int32_t f;
+
+  if (REG (0U)->FMR & CAN_FMR_FINIT)
+    {
+      return;
+    }
+  f = filter_match (x, m->tir, &fmi);
+  if (f < 0)
+    {
+      return;
+    }
+  mb[0] = m->tir;
+  mb[1] = m->dlc | (fmi << CAN_RDT0R_FMI_Pos);
+  if (r->MCR & CAN_MCR_TTCM)
+    {
+      mb[1] |= (uint32_t) (sof & 0xFFFFU) << CAN_RDT0R_TIME_Pos;
+    }
+  mb[2] = m->data[0];
+  mb[3] = m->data[1];
+  fifo_push (x, (uint32_t) f, mb);
+}
+
+static void
+tx_end (uint32_t x, const node_t *nd, uint64_t sof)
+{
+  CAN_TypeDef *r = REG (x);
+  uint32_t retry;
+
+  retry = ((r->MCR & CAN_MCR_NART) == 0U)
+          && ((ctrl[x].abort & (1UL << nd->mb)) == 0U);
+  switch (nd->tx)
+    {
+    case TX_OK:
+      if (r->MCR & CAN_MCR_TTCM)
+        {
+          r->sTxMailBox[nd->mb].TDTR = (r->sTxMailBox[nd->mb].TDTR & 0xFFFFU)
+                                       | ((uint32_t) (sof & 0xFFFFU) << 16);
+        }
+      tx_done (x, nd->mb, CAN_TSR_TXOK0);
+      break;
+    case TX_LOST:
+      if (retry == 0U)
+        {
+          tx_done (x, nd->mb, CAN_TSR_ALST0);
+        }
+      break;
+    case TX_ERROR:
+      if (retry == 0U)
+        {
+          tx_done (x, nd->mb, CAN_TSR_TERR0);
+        }
+      break;
+    default:
+      if (ctrl[x].abort & (1UL << nd->mb))
+        {
+          tx_done (x, nd->mb, 0U);
+        }
+      break;
+    }
+}
+
+static void
+counters (uint32_t x, const node_t *nd)
+{
+  ctrl_t *c = &ctrl[x];
+  int32_t v;
+
+  v = (int32_t) c->tec + nd->tec;
+  c->tec = (v < 0) ? 0U : (uint32_t) v;
+  if ((nd->rec < 0) && (c->rec > 127U))
+    {
+      c->rec = 127U;
+    }
+  else
+    {
+      v = (int32_t) c->rec + nd->rec;
+      c->rec = (v < 0) ? 0U : ((v > 255) ? 255U : (uint32_t) v);
+    }
+  if ((c->tec > 255U) && (c->boff == 0U))
+    {
+      c->boff = 1U;
+      if (REG (x)->MCR & CAN_MCR_ABOM)
+        {
+          c->boff_end = now + BOFF_BITS;
+        }
+    }
+  esr_update (x, nd->lec);
+}
+
+static void
+trace_write (const vbus_frame_t *f)
+{
+  char line[96];
+  uint64_t us;
+  uint32_t i, n;
+
+  us = (f->time * 1000000U) / vbus.bitrate;
+  n = (uint32_t) snprintf (line, sizeof (line), "(%llu.%06llu) vbus ",
+                           (unsigned long long) (us / 1000000U),
+                           (unsigned long long) (us % 1000000U));
+  if (f->id & ARM_CAN_ID_IDE_Msk)
+    {
+      n += (uint32_t) snprintf (&line[n], sizeof (line) - n, "%08X#",
+                                (unsigned) (f->id & 0x1FFFFFFFU));
+    }
+  else
+    {
+      n += (uint32_t) snprintf (&line[n], sizeof (line) - n, "%03X#",
+                                (unsigned) f->id);
+    }
+  if (f->rtr != 0U)
+    {
+      n += (uint32_t) snprintf (&line[n], sizeof (line) - n, "R");
+      if (f->dlc != 0U)
+        {
+          n += (uint32_t) snprintf (&line[n], sizeof (line) - n, "%u",
+                                    (unsigned) ((f->dlc > 8U) ? 8U : f->dlc));
+        }
+    }
+  else
+    {
+      for (i = 0U; (i < f->dlc) && (i < 8U); i++)
+        {
+          n += (uint32_t) snprintf (&line[n], sizeof (line) - n, "%02X",
+                                    (unsigned) f->data[i]);
+        }
+    }
+  line[n++] = '\n';
+  if (write (trace_fd, line, n) != (ssize_t) n)
+    {
+      vbus_trace_out (NULL);
+    }
+}
+
+static void
+socket_write (const vbus_frame_t *f)
+{
+  struct can_frame cf;
+  ssize_t ret;
+
+  memset (&cf, 0, sizeof (cf));
+  if (f->id & ARM_CAN_ID_IDE_Msk)
+    {
+      cf.can_id = (f->id & CAN_EFF_MASK) | CAN_EFF_FLAG;
+    }
+  else
+    {
+      cf.can_id = f->id & CAN_SFF_MASK;
+    }
+  if (f->rtr != 0U)
+    {
+      cf.can_id |= CAN_RTR_FLAG;
+    }
+  cf.can_dlc = (f->dlc > 8U) ? 8U : f->dlc;
+  memcpy (cf.data, f->data, 8U);
+  ret = write (sock_fd, &cf, sizeof (cf));   // Frame dropped if the queue is full
+  (void) ret;
+}
+
+static void
+socket_poll (void)
+{
+  struct can_frame cf;
+  ext_msg_t *e;
+
+  if (sock_fd < 0)
+    {
+      return;
+    }
+  while ((ext_cnt < EXT_QUEUE_SIZE)
+         && (read (sock_fd, &cf, sizeof (cf)) == (ssize_t) sizeof (cf)))
+    {
+      if (cf.can_id & CAN_ERR_FLAG)
+        {
+          continue;
+        }
+      e = &ext_q[(ext_head + ext_cnt) % EXT_QUEUE_SIZE];
+      memset (e, 0, sizeof (*e));
+      if (cf.can_id & CAN_EFF_FLAG)
+        {
+          e->frame.id = (cf.can_id & CAN_EFF_MASK) | ARM_CAN_ID_IDE_Msk;
+        }
+      else
+        {
+          e->frame.id = cf.can_id & CAN_SFF_MASK;
+        }
+      e->frame.rtr = (cf.can_id & CAN_RTR_FLAG) ? 1U : 0U;
+      e->frame.dlc = (cf.can_dlc > 8U) ? 8U : cf.can_dlc;
+      memcpy (e->frame.data, cf.data, 8U);
+      e->frame.sender = VBUS_EXT;
+      e->due = now;
+      e->from_socket = 1U;
+      ext_cnt++;
+    }
+}
+
+static void
+seg_end (seg_t *s)
+{
+  vbus_frame_t f;
+  node_t *nd;
+  uint32_t x;
+
+  s->busy = 0U;
+  for (x = 0U; x < 2U; x++)
+    {
+      nd = &s->node[x];
+      if (nd->gen != ctrl[x].gen)
+        {
+          continue;                     // Controller reset during the frame
+        }
+      if ((nd->lec >= 0) || (nd->tec != 0) || (nd->rec != 0))
+        {
+          counters (x, nd);
+        }
+      if (nd->tx != TX_NONE)
+        {
+          ctrl[x].txing &= ~(1UL << nd->mb);
+          tx_end (x, nd, s->sof);
+        }
+      if (nd->rx != 0U)
+        {
+          rx_store (x, &s->msg[nd->rx - 1U], s->sof);
+        }
+    }
+
+  if ((s->ext == TX_OK) || (s->ext == TX_ERROR))
+    {
+      ext_head = (ext_head + 1U) % EXT_QUEUE_SIZE;
+      ext_cnt--;
+    }
+
+  if ((s != &seg[0]) || (s->done == 0U))
+    {
+      return;
+    }
+  msg_to_frame (&f, &s->msg[s->done - 1U]);
+  f.time = s->sof;
+  f.sender = s->who[s->done - 1U];
+  vbus.frames++;
+  if (vbus.log_num < VBUS_LOG_SIZE)
+    {
+      vbus_log[vbus.log_num++] = f;
+    }
+  if (trace_fd >= 0)
+    {
+      trace_write (&f);
+    }
+  if ((sock_fd >= 0) && (s->from_socket == 0U))
+    {
+      socket_write (&f);
+    }
+}
+
+/* --------------------------------------------------------------------------
+ * Interrupts
+ */
+
+static uint32_t
+irq_line (uint32_t x, uint32_t n)
+{
+  CAN_TypeDef *r = REG (x);
+  uint32_t ier, rfr;
+
+  ier = r->IER;
+  switch (n)
+    {
+    case 0U:
+      return (ier & CAN_IER_TMEIE)
+             && (r->TSR & (CAN_TSR_RQCP0 | CAN_TSR_RQCP1 | CAN_TSR_RQCP2));
+    case 1U:
+    case 2U:
+      rfr = (n == 1U) ? r->RF0R : r->RF1R;
+      if (n == 2U)
+        {
+          ier >>= 3;                    // FMPIE1, FFIE1, FOVIE1
+        }
+      return ((ier & CAN_IER_FMPIE0) && (rfr & CAN_RF0R_FMP0))
+             || ((ier & CAN_IER_FFIE0) && (rfr & CAN_RF0R_FULL0))
+             || ((ier & CAN_IER_FOVIE0) && (rfr & CAN_RF0R_FOVR0));
+    default:
+      return ((ier & CAN_IER_ERRIE) && (r->MSR & CAN_MSR_ERRI))
+             || ((ier & CAN_IER_WKUIE) && (r->MSR & CAN_MSR_WKUI))
+             || ((ier & CAN_IER_SLKIE) && (r->MSR & CAN_MSR_SLAKI));
+    }
+}
+
+/* Run interrupt handlers while lines are active, lowest IRQ first */
+static void
+dispatch (void)
+{
+  uint32_t calls, x, n, found;
+  IRQn_Type irq;
+
+  for (calls = 0U; calls < IRQ_LIMIT; calls++)
+    {
+      found = 8U;
+      for (x = 0U; x < 2U; x++)
+        {
+          for (n = 0U; n < 4U; n++)
+            {
+              irq = irq_num[x][n];
+              if (irq_line (x, n))
+                {
+                  nvic_pending[irq] = 1U;
+                }
+              if ((found == 8U) && nvic_enabled[irq] && nvic_pending[irq])
+                {
+                  found = (x * 4U) + n;
+                }
+            }
+        }
+      if (found == 8U)
+        {
+          return;
+        }
+      nvic_pending[irq_num[found / 4U][found % 4U]] = 0U;
+      vbus.irqs++;
+      irq_handler[found / 4U][found % 4U] ();
+    }
+  vbus.irq_storm++;
+}
+
+static void
+vbus_tick (int sig)
+{
+  uint64_t target, next;
+  uint32_t s, x, done;
+
+  (void) sig;
+
+  vbus.ticks++;
+  socket_poll ();
+  dispatch ();
+
+  target = now + vbus.bits;
+  for (;;)
+    {
+      if (seg[0].busy == 0U)
+        {
+          bus_start ();
+        }
+      for (x = 0U; x < 2U; x++)
+        {
+          if (seg[1U + x].busy == 0U)
+            {
+              loop_start (x);
+            }
+        }
+
+      next = target;
+      for (s = 0U; s < SEG_NUM; s++)
+        {
+          if ((seg[s].busy != 0U) && (seg[s].end < next))
+            {
+              next = seg[s].end;
+            }
+        }
+      if ((seg[0].busy == 0U) && (ext_cnt != 0U)
+          && (ext_q[ext_head].due > now) && (ext_q[ext_head].due < next))
+        {
+          next = ext_q[ext_head].due;
+        }
+      for (x = 0U; x < 2U; x++)
+        {
+          if ((ctrl[x].boff_end > now) && (ctrl[x].boff_end < next))
+            {
+              next = ctrl[x].boff_end;
+            }
+        }
+      now = next;
+
+      done = 0U;
+      for (s = 0U; s < SEG_NUM; s++)
+        {
+          if ((seg[s].busy != 0U) && (seg[s].end <= now))
+            {
+              seg_end (&seg[s]);
+              done = 1U;
+            }
+        }
+      for (x = 0U; x < 2U; x++)
+        {
+          if ((ctrl[x].boff_end != 0U) && (ctrl[x].boff_end <= now))
+            {
+              /* Bus-off recovery */
+              ctrl[x].boff = 0U;
+              ctrl[x].boff_end = 0U;
+              ctrl[x].tec = 0U;
+              ctrl[x].rec = 0U;
+              esr_update (x, -1);
+              done = 1U;
+            }
+        }
+      if ((done == 0U) && (now >= target))
+        {
+          break;
+        }
+      dispatch ();
+    }
+}
+
+/* --------------------------------------------------------------------------
+ * Register write trapping
+ */
+
+static void
+trap_fault (int sig, siginfo_t *si, void *context)
+{
+  ucontext_t *uc = context;
+  uintptr_t a, base;
+
+  (void) sig;
+
+  a = (uintptr_t) si->si_addr;
+  base = (uintptr_t) vbus_regs;
+  if ((a < base) || (a >= (base + sizeof (vbus_regs))))
+    {
+      signal (SIGSEGV, SIG_DFL);        // Not a register: crash
+      return;
+    }
+  trap_x = (uint32_t) ((a - base) / 4096U);
+  trap_off = (uint32_t) ((a - base) % 4096U) & ~3U;
+  trap_old[0] = rd (trap_x, trap_off);
+  trap_old[1] = (trap_off < 4092U) ? rd (trap_x, trap_off + 4U) : 0U;
+
+  /* Let the instruction write, trap after it with SIGALRM blocked */
+  mprotect (vbus_regs, sizeof (vbus_regs), PROT_READ | PROT_WRITE);
+  trap_mask = uc->uc_sigmask;
+  sigaddset (&uc->uc_sigmask, SIGALRM);
+  uc->uc_mcontext.gregs[REG_EFL] |= 0x100;
+  trap_busy = 1U;
+}
+
+static void
+trap_step (int sig, siginfo_t *si, void *context)
+{
+  ucontext_t *uc = context;
+  uint32_t val[2];
+
+  (void) sig;
+  (void) si;
+
+  if (trap_busy == 0U)
+    {
+      return;
+    }
+  trap_busy = 0U;
+  mprotect (vbus_regs, sizeof (vbus_regs), PROT_READ);
+  uc->uc_mcontext.gregs[REG_EFL] &= ~0x100;
+  uc->uc_sigmask = trap_mask;
+
+  val[0] = rd (trap_x, trap_off);
+  val[1] = (trap_off < 4092U) ? rd (trap_x, trap_off + 4U) : 0U;
+  reg_write (trap_x, trap_off, trap_old[0], val[0]);
+  if (val[1] != trap_old[1])
+    {
+      reg_write (trap_x, trap_off + 4U, trap_old[1], val[1]);
+    }
+  vbus.writes++;
+}
+
+static void
+regs_map (void)
+{
+  int fd;
+
+  fd = memfd_create ("vbus", 0);
+  if ((fd < 0) || (ftruncate (fd, sizeof (vbus_regs)) != 0))
+    {
+      perror ("vbus: memfd");
+      exit (1);
+    }
+  alias = mmap (NULL, sizeof (vbus_regs), PROT_READ | PROT_WRITE, MAP_SHARED,
+                fd, 0);
+  if ((alias == MAP_FAILED)
+      || (mmap (vbus_regs, sizeof (vbus_regs), PROT_READ,
+                MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED))
+    {
+      perror ("vbus: mmap");
+      exit (1);
+    }
+  close (fd);
+}
+
+/* --------------------------------------------------------------------------
+ * Bus control
+ */
+
+void
+vbus_start (uint32_t period_us)
+{
+  struct sigaction sa;
+  struct itimerval it;
+  uint32_t x;
+
+  if (vbus.bitrate == 0U)
+    {
+      vbus.bitrate = 500000U;
+    }
+  if (vbus.bits == 0U)
+    {
+      vbus.bits = (uint32_t) (((uint64_t) period_us * vbus.bitrate) / 1000000U);
+      if (vbus.bits == 0U)
+        {
+          vbus.bits = 1U;
+        }
+    }
+
+  if (alias == NULL)
+    {
+      regs_map ();
+      for (x = 0U; x < 2U; x++)
+        {
+          ctrl_reset (x);
+        }
+      REG (0U)->FMR = FMR_RESET;
+    }
+
+  memset (&sa, 0, sizeof (sa));
+  sa.sa_flags = SA_SIGINFO;
+  sigemptyset (&sa.sa_mask);
+  sigaddset (&sa.sa_mask, SIGALRM);
+  sa.sa_sigaction = trap_fault;
+  sigaction (SIGSEGV, &sa, NULL);
+  sa.sa_sigaction = trap_step;
+  sigaction (SIGTRAP, &sa, NULL);
+
+  memset (&sa, 0, sizeof (sa));
+  sa.sa_handler = vbus_tick;
+  sa.sa_flags   = SA_RESTART;
+  sigemptyset (&sa.sa_mask);
+  sigaction (SIGALRM, &sa, NULL);
+
+  it.it_interval.tv_sec  = 0;
+  it.it_interval.tv_usec = (suseconds_t) period_us;
+  it.it_value            = it.it_interval;
+  setitimer (ITIMER_REAL, &it, NULL);
+}
+
+void
+vbus_stop (void)
+{
+  struct itimerval it;
+
+  memset (&it, 0, sizeof (it));
+  setitimer (ITIMER_REAL, &it, NULL);
+}
+
+/* Clear statistics counters and frame log */
+void
+vbus_clear (void)
+{
+  uint32_t primask;
+
+  primask = __get_PRIMASK ();
+  __disable_irq ();
+
+  memset (&vbus.frames, 0, sizeof (vbus) - offsetof (vbus_t, frames));
+
+  __set_PRIMASK (primask);
+}
+
+/* Bus time in bit times */
+uint64_t
+vbus_time (void)
+{
+  return now;
+}
+
+/* --------------------------------------------------------------------------
+ * External node
+ */
+
+/* Queue a frame of the external node, sent delay bit times from now */
+int
+vbus_inject (const vbus_frame_t *frame, uint32_t delay)
+{
+  ext_msg_t *e;
+  uint32_t primask;
+  int ret;
+
+  primask = __get_PRIMASK ();
+  __disable_irq ();
+
+  ret = -1;
+  if (ext_cnt < EXT_QUEUE_SIZE)
+    {
+      e = &ext_q[(ext_head + ext_cnt) % EXT_QUEUE_SIZE];
+      memset (e, 0, sizeof (*e));
+      e->frame = *frame;
+      e->frame.sender = VBUS_EXT;
+      e->due = now + delay;
+      ext_cnt++;
+      ret = 0;
+    }
+
+  __set_PRIMASK (primask);
+  return ret;
+}
+
+/* Write frames on the bus to a candump log file (NULL closes) */
+int
+vbus_trace_out (const char *path)
+{
+  if (trace_fd >= 0)
+    {
+      close (trace_fd);
+      trace_fd = -1;
+    }
+  if (path == NULL)
+    {
+      return 0;
+    }
+  trace_fd = open (path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  return (trace_fd < 0) ? -1 : 0;
+}
+
+/* Parse "ID#DATA" or "ID#R[len]" of a candump log line */
+static int
+trace_parse (const char *s, vbus_frame_t *f)
+{
+  const char *hash;
+  char *end;
+  uint32_t n, v;
+
+  memset (f, 0, sizeof (*f));
+  hash = strchr (s, '#');
+  if (hash == NULL)
+    {
+      return -1;
+    }
+  f->id = (uint32_t) strtoul (s, &end, 16);
+  if (end != hash)
+    {
+      return -1;
+    }
+  if ((hash - s) > 3)
+    {
+      f->id = (f->id & 0x1FFFFFFFU) | ARM_CAN_ID_IDE_Msk;
+    }
+  else if (f->id > 0x7FFU)
+    {
+      return -1;
+    }
+
+  s = hash + 1;
+  if ((*s == 'R') || (*s == 'r'))
+    {
+      f->rtr = 1U;
+      if ((s[1] >= '0') && (s[1] <= '8'))
+        {
+          f->dlc = (uint8_t) (s[1] - '0');
+        }
+      return 0;
+    }
+  for (n = 0U; (n < 8U) && (s[0] != '\0'); n++)
+    {
+      if (s[0] == '.')
+        {
+          s++;
+        }
+      if ((sscanf (s, "%2x", &v) != 1) || (s[1] == '\0'))
+        {
+          break;
+        }
+      f->data[n] = (uint8_t) v;
+      s += 2;
+    }
+  f->dlc = (uint8_t) n;
+  return 0;
+}
+
+/* Queue the frames of a candump log file, times relative to now */
+int
+vbus_trace_in (const char *path)
+{
+  FILE *fp;
+  char line[256], frame[128];
+  unsigned long long sec, usec, t, t0;
+  vbus_frame_t f;
+  uint32_t delay, primask;
+  int n;
+
+  fp = fopen (path, "r");
+  if (fp == NULL)
+    {
+      return -1;
+    }
+
+  /* Bus stopped while queuing: delays are relative to the same time */
+  primask = __get_PRIMASK ();
+  __disable_irq ();
+
+  n = 0;
+  t0 = 0U;
+  while (fgets (line, sizeof (line), fp) != NULL)
+    {
+      if ((sscanf (line, "(%llu.%llu) %*s %127s", &sec, &usec, frame) != 3)
+          || (trace_parse (frame, &f) != 0))
+        {
+          continue;
+        }
+      t = (sec * 1000000U) + usec;
+      if (n == 0)
+        {
+          t0 = t;
+        }
+      delay = (uint32_t) ((((t - t0) * vbus.bitrate) / 1000000U));
+      if (vbus_inject (&f, delay) != 0)
+        {
+          n = -1;
+          break;
+        }
+      n++;
+    }
+
+  __set_PRIMASK (primask);
+  fclose (fp);
+  return n;
+}
+
+/* Bridge the external node to a SocketCAN interface (NULL closes) */
+int
+vbus_socket (const char *ifname)
+{
+  struct sockaddr_can addr;
+  struct ifreq ifr;
+  int fd;
+
+  if (sock_fd >= 0)
+    {
+      close (sock_fd);
+      sock_fd = -1;
+    }
+  if (ifname == NULL)
+    {
+      return 0;
+    }
+
+  fd = socket (PF_CAN, SOCK_RAW, CAN_RAW);
+  if (fd < 0)
+    {
+      return -1;
+    }
+  memset (&ifr, 0, sizeof (ifr));
+  strncpy (ifr.ifr_name, ifname, IFNAMSIZ - 1);
+  memset (&addr, 0, sizeof (addr));
+  addr.can_family = AF_CAN;
+  if ((ioctl (fd, SIOCGIFINDEX, &ifr) < 0)
+      || ((addr.can_ifindex = ifr.ifr_ifindex),
+          (bind (fd, (struct sockaddr *) &addr, sizeof (addr)) < 0))
+      || (fcntl (fd, F_SETFL, O_NONBLOCK) < 0))
+    {
+      close (fd);
+      return -1;
+    }
+  sock_fd = fd;
+  return 0;
+}
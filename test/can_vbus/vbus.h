@@ -0,0 +1,90 @@
+/*
+ * Virtual CAN bus for host tests of the CAN driver.
+ */
+
+#ifndef VBUS_H
+#define VBUS_H
+
+#include <stdint.h>
+
+#include "CAN_STM32F7xx.h"
+
+/* Frame senders (vbus_frame_t.sender) */
+#define VBUS_CAN1               0U      // Controller CAN1
+#define VBUS_CAN2               1U      // Controller CAN2
+#define VBUS_EXT                2U      // External node (injected, trace, SocketCAN)
+
+/* Frame log size */
+#define VBUS_LOG_SIZE           8192U
+
+/* Frame on the bus */
+typedef struct
+{
+  uint64_t time;                        // Start of frame (bit times)
+  uint32_t id;                          // Identifier (ARM_CAN_ID_IDE_Msk for extended)
+  uint8_t rtr;                          // Remote frame
+  uint8_t dlc;                          // Data length code
+  uint8_t sender;                       // VBUS_CAN1, VBUS_CAN2 or VBUS_EXT
+  uint8_t reserved;
+  uint8_t data[8];
+} vbus_frame_t;
+
+typedef struct
+{
+  /* Bus options */
+  uint32_t bitrate;                     // Bus bitrate (controllers must match)
+  uint32_t bits;                        // Bit times per tick
+  uint32_t ack;                         // External node acknowledges frames
+
+  /* Statistics */
+  uint32_t ticks;                       // Virtual bus ticks
+  uint32_t frames;                      // Frames sent successfully on CAN bus
+  uint32_t arb_lost;                    // Transmissions that lost arbitration
+  uint32_t bit_errors;                  // Frames ended by a bit error
+  uint32_t ack_errors;                  // Frames without acknowledgment
+  uint32_t overruns;                    // Frames lost in full receive FIFOs
+  uint32_t bad_bitrate;                 // Frames missed by bit timing mismatch
+  uint32_t writes;                      // Register writes
+  uint32_t locked;                      // Writes to read-only or locked registers
+  uint32_t irqs;                        // Interrupt handler calls
+  uint32_t irq_storm;                   // Interrupt lines that did not clear
+  uint32_t log_num;                     // Frames in vbus_log
+} vbus_t;
+
+extern vbus_t vbus;
+extern vbus_frame_t vbus_log[VBUS_LOG_SIZE];
+
+extern ARM_DRIVER_CAN Driver_CAN1;
+extern ARM_DRIVER_CAN Driver_CAN2;
+
+void vbus_start (uint32_t period_us);
+void vbus_stop (void);
+void vbus_clear (void);
+uint64_t vbus_time (void);
+
+/* External node */
+int vbus_inject (const vbus_frame_t *frame, uint32_t delay);
+int vbus_trace_out (const char *path);
+int vbus_trace_in (const char *path);
+int vbus_socket (const char *ifname);
+
+/* Hardware models */
+int32_t vbus_accept (uint32_t x, uint32_t id, uint32_t rtr);
+int32_t vbus_arbitrate (uint32_t tir_a, uint32_t tir_b);
+
+/* Driver interrupt handlers */
+void CAN1_TX_IRQHandler (void);
+void CAN1_RX0_IRQHandler (void);
+void CAN1_RX1_IRQHandler (void);
+void CAN1_SCE_IRQHandler (void);
+void CAN2_TX_IRQHandler (void);
+void CAN2_RX0_IRQHandler (void);
+void CAN2_RX1_IRQHandler (void);
+void CAN2_SCE_IRQHandler (void);
+
+/* Driver internals (driver.c) */
+uint32_t vbus_tx_priority (uint32_t tir);
+uint32_t vbus_filter_split (void);
+uint32_t vbus_tx_queued (uint32_t x);
+
+#endif /* VBUS_H */
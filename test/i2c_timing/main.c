@@ -0,0 +1,221 @@
+/*
+ * Host test for the I2C TIMINGR calculation of the STM32F7xx I2C driver.
+ *
+ * The solver output is decoded with the timing model of the STM32F7 reference
+ * manual (RM0385, I2C timings) and checked against the I2C-bus specification
+ * limits, which are listed here from the I2C-bus specification (UM10204,
+ * table 10) independently of the driver's table. The SCL frequency must be
+ * within 3% below the requested bus speed.
+ *
+ * Where ST publishes an example TIMINGR value for the kernel clock (RM0385
+ * timing examples for fI2CCLK = 16 MHz and 48 MHz), the solver must reach the
+ * SCL frequency of the ST value within 3%. There is no ST example for
+ * fI2CCLK = 54 MHz (APB1 clock at 216 MHz system clock). For every case the
+ * exact solver output is fixed in the table; the 54 MHz values were checked
+ * by hand against the limits (tPRESC = 55.56 ns for PRESC = 2, else 18.52 ns):
+ *   100 kHz 0x20605A53: tLOW 4667 ns, tHIGH 5056 ns, tSU;DAT 389 ns, 99.9 kHz
+ *   400 kHz 0x00A03541: tLOW 1222 ns, tHIGH 1000 ns, tSU;DAT 204 ns, 399 kHz
+ *   1 MHz   0x00800F16: tLOW  426 ns, tHIGH  296 ns, tSU;DAT 167 ns, 994 kHz
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define I2C_TIMINGR_SCLL_Pos            (0U)
+#define I2C_TIMINGR_SCLH_Pos            (8U)
+#define I2C_TIMINGR_SDADEL_Pos          (16U)
+#define I2C_TIMINGR_SCLDEL_Pos          (20U)
+#define I2C_TIMINGR_PRESC_Pos           (28U)
+
+/* Extracted from CMSIS/Driver/I2C_STM32F7xx.h and .c by the makefile */
+#include "i2c_timing.h"
+#include "i2c_timing.c"
+
+/* Rise/fall times (ns) used for all cases (driver defaults) */
+#define RISE_TIME       100U
+#define FALL_TIME       10U
+
+typedef struct
+{
+  uint32_t fclk;                        // I2C kernel clock in Hz
+  uint32_t bus_speed;                   // Requested SCL frequency in Hz
+  uint32_t timingr;                     // Expected TIMINGR value
+  uint32_t st_timingr;                  // ST example TIMINGR value (0 = none)
+} test_case_t;
+
+static const test_case_t test_cases[] =
+  {
+    { 16000000U,  100000U, 0x00504F48U, 0x30420F13U },
+    { 16000000U,  400000U, 0x00300E11U, 0x10320309U },
+    { 16000000U, 1000000U, 0x00200205U, 0x00200204U },
+    { 48000000U,  100000U, 0x1080796EU, 0xB0420F13U },
+    { 48000000U,  400000U, 0x00902E3AU, 0x50330309U },
+    { 48000000U, 1000000U, 0x00700D13U, 0x50100103U },
+    { 54000000U,  100000U, 0x20605A53U, 0U },
+    { 54000000U,  400000U, 0x00A03541U, 0U },
+    { 54000000U, 1000000U, 0x00800F16U, 0U },
+  };
+
+/* I2C-bus specification limits in ns (UM10204, table 10) */
+typedef struct
+{
+  uint32_t freq;                        // Maximum SCL frequency in Hz
+  uint32_t low_min;                     // tLOW minimum
+  uint32_t high_min;                    // tHIGH minimum
+  uint32_t su_dat_min;                  // tSU;DAT minimum
+  uint32_t vd_dat_max;                  // tVD;DAT maximum
+} spec_t;
+
+static const spec_t spec[] =
+  {
+    {  100000U, 4700U, 4000U, 250U, 3450U },      // Standard-mode
+    {  400000U, 1300U,  600U, 100U,  900U },      // Fast-mode
+    { 1000000U,  500U,  260U,  50U,  450U },      // Fast-mode Plus
+  };
+
+#define FIELD(v, pos, msk)      (((v) >> (pos)) & (msk))
+
+/* SCL period in ps of a TIMINGR value (analog filter on, no digital filter) */
+static uint32_t
+scl_period (uint32_t fclk, uint32_t timingr)
+{
+  uint32_t tclk, tpresc, tsync;
+
+  tclk   = (uint32_t) (1000000000000ULL / fclk);
+  tpresc = (FIELD (timingr, I2C_TIMINGR_PRESC_Pos, 0xFU) + 1U) * tclk;
+  tsync  = 2U * (50000U + (2U * tclk));
+
+  return ((FIELD (timingr, I2C_TIMINGR_SCLL_Pos, 0xFFU) + 1U) * tpresc)
+      + ((FIELD (timingr, I2C_TIMINGR_SCLH_Pos, 0xFFU) + 1U) * tpresc)
+      + tsync + ((RISE_TIME + FALL_TIME) * 1000U);
+}
+
+/* Check a TIMINGR value against the I2C-bus specification, returns error text */
+static const char *
+check_spec (uint32_t fclk, uint32_t bus_speed, uint32_t timingr)
+{
+  const spec_t *sc;
+  uint32_t tclk, tpresc, tsync;
+  int32_t sda_max;
+
+  if (timingr == 0U)
+    {
+      return "no timing found";
+    }
+
+  if (bus_speed <= spec[0].freq)
+    {
+      sc = &spec[0];
+    }
+  else if (bus_speed <= spec[1].freq)
+    {
+      sc = &spec[1];
+    }
+  else
+    {
+      sc = &spec[2];
+    }
+
+  tclk   = (uint32_t) (1000000000000ULL / fclk);
+  tpresc = (FIELD (timingr, I2C_TIMINGR_PRESC_Pos, 0xFU) + 1U) * tclk;
+  tsync  = 2U * (50000U + (2U * tclk));
+
+  if (scl_period (fclk, timingr) < (uint32_t) (1000000000000ULL / bus_speed))
+    {
+      return "SCL frequency above requested bus speed";
+    }
+  if (scl_period (fclk, timingr)
+      > (uint32_t) (1000000000000ULL / (bus_speed - (bus_speed / 32U))))
+    {
+      return "SCL frequency more than 3% below requested bus speed";
+    }
+  if (((FIELD (timingr, I2C_TIMINGR_SCLL_Pos, 0xFFU) + 1U) * tpresc)
+      + (tsync / 2U) < (sc->low_min * 1000U))
+    {
+      return "tLOW below minimum";
+    }
+  if (((FIELD (timingr, I2C_TIMINGR_SCLH_Pos, 0xFFU) + 1U) * tpresc)
+      + (tsync / 2U) < (sc->high_min * 1000U))
+    {
+      return "tHIGH below minimum";
+    }
+  if (((FIELD (timingr, I2C_TIMINGR_SCLDEL_Pos, 0xFU) + 1U) * tpresc)
+      < ((RISE_TIME + sc->su_dat_min) * 1000U))
+    {
+      return "data setup time below minimum";
+    }
+
+  sda_max = (int32_t) (sc->vd_dat_max * 1000U)
+      - (int32_t) ((RISE_TIME * 1000U) + 260000U + (4U * tclk));
+  if (sda_max < 0)
+    {
+      sda_max = 0;
+    }
+  if ((int32_t) (FIELD (timingr, I2C_TIMINGR_SDADEL_Pos, 0xFU) * tpresc)
+      > sda_max)
+    {
+      return "data valid time above maximum";
+    }
+
+  return NULL;
+}
+
+int
+main (void)
+{
+  const test_case_t *tc;
+  I2C_BUS_TIMING t;
+  const char *err;
+  uint32_t timingr, period, st_period;
+  uint32_t i, failed;
+
+  failed = 0U;
+
+  for (i = 0U; i < (sizeof (test_cases) / sizeof (test_cases[0])); i++)
+    {
+      tc = &test_cases[i];
+
+      t.bus_speed = tc->bus_speed;
+      t.rise_time = RISE_TIME;
+      t.fall_time = FALL_TIME;
+      t.dnf       = 0U;
+      t.anf       = 1U;
+      t.reserved  = 0U;
+
+      timingr = I2C_TimingCalc (tc->fclk, &t);
+      err     = check_spec (tc->fclk, tc->bus_speed, timingr);
+
+      if ((err == NULL) && (timingr != tc->timingr))
+        {
+          err = "TIMINGR differs from expected value";
+        }
+
+      if ((err == NULL) && (tc->st_timingr != 0U))
+        {
+          /* Not more than 3% slower than the ST example (limited to the
+             requested speed); the solver works on full prescaler steps */
+          period    = scl_period (tc->fclk, timingr);
+          st_period = scl_period (tc->fclk, tc->st_timingr);
+          if (st_period < (uint32_t) (1000000000000ULL / tc->bus_speed))
+            {
+              st_period = (uint32_t) (1000000000000ULL / tc->bus_speed);
+            }
+          if (period > (st_period + (st_period / 32U)))
+            {
+              err = "SCL frequency below ST example";
+            }
+        }
+
+      printf ("%2u MHz %4u kHz: TIMINGR 0x%08X (ST 0x%08X) %s\n",
+              (unsigned) (tc->fclk / 1000000U),
+              (unsigned) (tc->bus_speed / 1000U), (unsigned) timingr,
+              (unsigned) tc->st_timingr, (err != NULL) ? err : "ok");
+
+      if (err != NULL)
+        {
+          failed++;
+        }
+    }
+
+  return (failed != 0U) ? 1 : 0;
+}
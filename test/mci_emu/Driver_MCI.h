@@ -0,0 +1,138 @@
+/*
+ * Host build of the MCI driver: subset of the CMSIS-Driver Driver_MCI.h
+ * (API V2.2) used by CMSIS/Driver/MCI_STM32F7xx.c and the tests.
+ */
+
+#ifndef DRIVER_MCI_H_
+#define DRIVER_MCI_H_
+
+#include "Driver_Common.h"
+
+#define ARM_MCI_API_VERSION ARM_DRIVER_VERSION_MAJOR_MINOR(2,2)
+
+/* SendCommand flags */
+#define ARM_MCI_CARD_INITIALIZE         (1UL << 0)
+#define ARM_MCI_RESPONSE_Pos             1
+#define ARM_MCI_RESPONSE_Msk            (3UL << ARM_MCI_RESPONSE_Pos)
+#define ARM_MCI_RESPONSE_NONE           (0UL << ARM_MCI_RESPONSE_Pos)
+#define ARM_MCI_RESPONSE_SHORT          (1UL << ARM_MCI_RESPONSE_Pos)
+#define ARM_MCI_RESPONSE_SHORT_BUSY     (2UL << ARM_MCI_RESPONSE_Pos)
+#define ARM_MCI_RESPONSE_LONG           (3UL << ARM_MCI_RESPONSE_Pos)
+#define ARM_MCI_RESPONSE_INDEX          (1UL << 3)
+#define ARM_MCI_RESPONSE_CRC            (1UL << 4)
+#define ARM_MCI_WAIT_BUSY               (1UL << 5)
+#define ARM_MCI_TRANSFER_DATA           (1UL << 6)
+#define ARM_MCI_CARD_SWITCH             (1UL << 7)
+
+/* SetupTransfer mode */
+#define ARM_MCI_TRANSFER_READ           (0UL << 0)
+#define ARM_MCI_TRANSFER_WRITE          (1UL << 0)
+#define ARM_MCI_TRANSFER_BLOCK          (0UL << 1)
+#define ARM_MCI_TRANSFER_STREAM         (1UL << 1)
+
+/* Control operations */
+#define ARM_MCI_BUS_SPEED               (0x01UL)
+#define ARM_MCI_BUS_SPEED_MODE          (0x02UL)
+#define ARM_MCI_BUS_CMD_MODE            (0x03UL)
+#define ARM_MCI_BUS_DATA_WIDTH          (0x04UL)
+#define ARM_MCI_DRIVER_STRENGTH         (0x05UL)
+#define ARM_MCI_CONTROL_RESET           (0x06UL)
+#define ARM_MCI_CONTROL_CLOCK_IDLE      (0x07UL)
+#define ARM_MCI_UHS_TUNING_OPERATION    (0x08UL)
+#define ARM_MCI_UHS_TUNING_RESULT       (0x09UL)
+#define ARM_MCI_DATA_TIMEOUT            (0x0AUL)
+#define ARM_MCI_CSS_TIMEOUT             (0x0BUL)
+#define ARM_MCI_MONITOR_SDIO_INTERRUPT  (0x0CUL)
+#define ARM_MCI_CONTROL_READ_WAIT       (0x0DUL)
+#define ARM_MCI_SUSPEND_TRANSFER        (0x0EUL)
+#define ARM_MCI_RESUME_TRANSFER         (0x0FUL)
+
+/* Control arguments */
+#define ARM_MCI_BUS_DEFAULT_SPEED       (0x00UL)
+#define ARM_MCI_BUS_HIGH_SPEED          (0x01UL)
+#define ARM_MCI_BUS_CMD_PUSH_PULL       (0x00UL)
+#define ARM_MCI_BUS_CMD_OPEN_DRAIN      (0x01UL)
+#define ARM_MCI_BUS_DATA_WIDTH_1        (0x00UL)
+#define ARM_MCI_BUS_DATA_WIDTH_4        (0x01UL)
+#define ARM_MCI_BUS_DATA_WIDTH_8        (0x02UL)
+
+/* Events */
+#define ARM_MCI_EVENT_CARD_INSERTED     (1UL << 0)
+#define ARM_MCI_EVENT_CARD_REMOVED      (1UL << 1)
+#define ARM_MCI_EVENT_COMMAND_COMPLETE  (1UL << 2)
+#define ARM_MCI_EVENT_COMMAND_TIMEOUT   (1UL << 3)
+#define ARM_MCI_EVENT_COMMAND_ERROR     (1UL << 4)
+#define ARM_MCI_EVENT_TRANSFER_COMPLETE (1UL << 5)
+#define ARM_MCI_EVENT_TRANSFER_TIMEOUT  (1UL << 6)
+#define ARM_MCI_EVENT_TRANSFER_ERROR    (1UL << 7)
+#define ARM_MCI_EVENT_SDIO_INTERRUPT    (1UL << 8)
+#define ARM_MCI_EVENT_CCS               (1UL << 9)
+#define ARM_MCI_EVENT_CCS_TIMEOUT       (1UL << 10)
+
+/* MCI Status */
+typedef volatile struct _ARM_MCI_STATUS {
+  uint32_t command_active   :  1;       // Command active flag
+  uint32_t command_timeout  :  1;       // Command timeout flag (cleared on start of next command)
+  uint32_t command_error    :  1;       // Command error flag (cleared on start of next command)
+  uint32_t transfer_active  :  1;       // Transfer active flag
+  uint32_t transfer_timeout :  1;       // Transfer timeout flag (cleared on start of next command)
+  uint32_t transfer_error   :  1;       // Transfer error flag (cleared on start of next command)
+  uint32_t sdio_interrupt   :  1;       // SD I/O Interrupt flag (cleared on start of monitoring)
+  uint32_t ccs              :  1;       // CCS flag (cleared on start of next command)
+  uint32_t reserved         : 24;
+} ARM_MCI_STATUS;
+
+typedef void (*ARM_MCI_SignalEvent_t) (uint32_t event);
+
+/* MCI Driver Capabilities */
+typedef struct _ARM_MCI_CAPABILITIES {
+  uint32_t cd_state          : 1;
+  uint32_t cd_event          : 1;
+  uint32_t wp_state          : 1;
+  uint32_t vdd               : 1;
+  uint32_t vdd_1v8           : 1;
+  uint32_t vccq              : 1;
+  uint32_t vccq_1v8          : 1;
+  uint32_t vccq_1v2          : 1;
+  uint32_t data_width_4      : 1;
+  uint32_t data_width_8      : 1;
+  uint32_t data_width_4_ddr  : 1;
+  uint32_t data_width_8_ddr  : 1;
+  uint32_t high_speed        : 1;
+  uint32_t uhs_signaling     : 1;
+  uint32_t uhs_tuning        : 1;
+  uint32_t uhs_sdr50         : 1;
+  uint32_t uhs_sdr104        : 1;
+  uint32_t uhs_ddr50         : 1;
+  uint32_t uhs_driver_type_a : 1;
+  uint32_t uhs_driver_type_c : 1;
+  uint32_t uhs_driver_type_d : 1;
+  uint32_t sdio_interrupt    : 1;
+  uint32_t read_wait         : 1;
+  uint32_t suspend_resume    : 1;
+  uint32_t mmc_interrupt     : 1;
+  uint32_t mmc_boot          : 1;
+  uint32_t rst_n             : 1;
+  uint32_t ccs               : 1;
+  uint32_t ccs_timeout       : 1;
+  uint32_t reserved          : 3;
+} ARM_MCI_CAPABILITIES;
+
+/* Access structure of the MCI Driver */
+typedef struct _ARM_DRIVER_MCI {
+  ARM_DRIVER_VERSION   (*GetVersion)      (void);
+  ARM_MCI_CAPABILITIES (*GetCapabilities) (void);
+  int32_t              (*Initialize)      (ARM_MCI_SignalEvent_t cb_event);
+  int32_t              (*Uninitialize)    (void);
+  int32_t              (*PowerControl)    (ARM_POWER_STATE state);
+  int32_t              (*CardPower)       (uint32_t voltage);
+  int32_t              (*ReadCD)          (void);
+  int32_t              (*ReadWP)          (void);
+  int32_t              (*SendCommand)     (uint32_t cmd, uint32_t arg, uint32_t flags, uint32_t *response);
+  int32_t              (*SetupTransfer)   (uint8_t *data, uint32_t block_count, uint32_t block_size, uint32_t mode);
+  int32_t              (*AbortTransfer)   (void);
+  int32_t              (*Control)         (uint32_t control, uint32_t arg);
+  ARM_MCI_STATUS       (*GetStatus)       (void);
+} const ARM_DRIVER_MCI;
+
+#endif /* DRIVER_MCI_H_ */
@@ -0,0 +1,10 @@
+/*
+ * Host build of the MCI driver: SDMMC1 with 4-bit data bus, no card detect
+ * and write protect pins.
+ */
+
+#define MX_SDMMC1
+#define MX_SDMMC1_D0_Pin                PC8
+#define MX_SDMMC1_D1_Pin                PC9
+#define MX_SDMMC1_D2_Pin                PC10
+#define MX_SDMMC1_D3_Pin                PC11
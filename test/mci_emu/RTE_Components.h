@@ -0,0 +1,6 @@
+/*
+ * Host build of the MCI driver: STM32CubeMX framework, MCI0 on SDMMC1.
+ */
+
+#define RTE_DEVICE_FRAMEWORK_CUBE_MX
+#define RTE_Drivers_MCI0
@@ -0,0 +1,530 @@
+/*
+ * Host benchmark of the MCI block cache (ARM_MCI_CACHE_xxx) on the
+ * emulator, with the card storage in a temporary file.
+ *
+ * Each workload runs uncached (one queued CMD17/CMD24 per sector, as an
+ * application without cache) and through the cache, and lists the card
+ * commands, the blocks read and written on the card, the emulated bus
+ * time in ticks and, for reads, the share of reads served without a card
+ * command (hit rate). The card content is checked against the expected
+ * data after each workload.
+ *
+ * Two checks of the cache bookkeeping run first:
+ *  - read-ahead of sequential reads at the end of the card stops at the
+ *    last sector (no access beyond capacity);
+ *  - LRU eviction picks the oldest line while the 32-bit LRU clock wraps.
+ *
+ * Use the numbers to compare cache configurations and workloads; bus
+ * time is in emulator ticks (32 bus words per tick), not card timing.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "emu.h"
+
+#define SECTORS         65536U          // Card capacity (32 MB)
+#define TIMEOUT         250000U         // Wait limit in emulator ticks (5 s)
+
+/* Control argument: static objects have 32-bit addresses (no PIE) */
+#define ADDR(p)         ((uint32_t) (uintptr_t) (p))
+
+/* Cache: 16 KB staging buffer, 64 sets of 4 lines */
+#define STAGE           32U
+#define LINES           256U
+
+static uint8_t cache_mem[(STAGE * 512U) + (LINES * (512U + sizeof (MCI_CACHE_LINE)))]
+  __attribute__ ((aligned (32)));
+static uint8_t sec[512] __attribute__ ((aligned (32)));
+static uint8_t chk[512];
+
+static MCI_CACHE_CONFIG cfg;
+static MCI_CACHE_IO io;
+static MCI_REQUEST req;
+
+static ARM_DRIVER_MCI *drv = &Driver_MCI0;
+
+static volatile uint32_t events;
+static uint32_t rca;
+static int card_fd;
+static uint32_t failed;
+
+/* Card storage in a file (called from the emulator tick) */
+static void
+file_read (uint32_t sector, uint8_t *data)
+{
+  if (pread (card_fd, data, 512U, (off_t) sector * 512) != 512)
+    {
+      memset (data, 0xFF, 512U);
+    }
+}
+
+static void
+file_write (uint32_t sector, const uint8_t *data)
+{
+  if (pwrite (card_fd, data, 512U, (off_t) sector * 512) != 512)
+    {
+      emu.lost++;
+    }
+}
+
+static const emu_storage_t storage = { file_read, file_write };
+
+static uint32_t
+ticks (void)
+{
+  return *(volatile uint32_t *) &emu.ticks;
+}
+
+static uint32_t
+commands (void)
+{
+  return *(volatile uint32_t *) &emu.commands;
+}
+
+static void
+signal_event (uint32_t event)
+{
+  events |= event;
+}
+
+static int32_t
+command (uint32_t cmd, uint32_t arg, uint32_t flags, uint32_t *rsp)
+{
+  uint32_t t0;
+
+  events = 0U;
+  if (drv->SendCommand (cmd, arg, flags, rsp) != ARM_DRIVER_OK)
+    {
+      return ARM_DRIVER_ERROR;
+    }
+  t0 = ticks ();
+  while (((events & (ARM_MCI_EVENT_COMMAND_COMPLETE | ARM_MCI_EVENT_COMMAND_TIMEOUT
+                     | ARM_MCI_EVENT_COMMAND_ERROR)) == 0U)
+         && ((ticks () - t0) < TIMEOUT))
+    {
+    }
+  return (events & ARM_MCI_EVENT_COMMAND_COMPLETE) ? ARM_DRIVER_OK
+                                                  : ARM_DRIVER_ERROR;
+}
+
+/* Identify and select the card, 4-bit bus at 24 MHz */
+static int32_t
+card_init (void)
+{
+  uint32_t rsp[4], i;
+
+  drv->Initialize (signal_event);
+  drv->PowerControl (ARM_POWER_FULL);
+  drv->Control (ARM_MCI_BUS_SPEED, 400000U);
+
+  if ((command (0U, 0U, ARM_MCI_CARD_INITIALIZE | ARM_MCI_RESPONSE_NONE, NULL) != 0)
+      || (command (8U, 0x1AAU, ARM_MCI_RESPONSE_SHORT | ARM_MCI_RESPONSE_CRC, rsp) != 0))
+    {
+      return ARM_DRIVER_ERROR;
+    }
+  rsp[0] = 0U;
+  for (i = 0U; (i < 10U) && ((rsp[0] & 0x80000000U) == 0U); i++)
+    {
+      if ((command (55U, 0U, ARM_MCI_RESPONSE_SHORT | ARM_MCI_RESPONSE_CRC, rsp) != 0)
+          || (command (41U, 0x40FF8000U, ARM_MCI_RESPONSE_SHORT, rsp) != 0))
+        {
+          return ARM_DRIVER_ERROR;
+        }
+    }
+  if ((command (2U, 0U, ARM_MCI_RESPONSE_LONG | ARM_MCI_RESPONSE_CRC, rsp) != 0)
+      || (command (3U, 0U, ARM_MCI_RESPONSE_SHORT | ARM_MCI_RESPONSE_CRC, rsp) != 0))
+    {
+      return ARM_DRIVER_ERROR;
+    }
+  rca = rsp[0] >> 16;
+  if ((command (7U, rca << 16, ARM_MCI_RESPONSE_SHORT_BUSY | ARM_MCI_RESPONSE_CRC, rsp) != 0)
+      || (command (55U, rca << 16, ARM_MCI_RESPONSE_SHORT | ARM_MCI_RESPONSE_CRC, rsp) != 0)
+      || (command (6U, 2U, ARM_MCI_RESPONSE_SHORT | ARM_MCI_RESPONSE_CRC, rsp) != 0))
+    {
+      return ARM_DRIVER_ERROR;
+    }
+  drv->Control (ARM_MCI_BUS_DATA_WIDTH, ARM_MCI_BUS_DATA_WIDTH_4);
+  drv->Control (ARM_MCI_BUS_SPEED, 25000000U);
+
+  return ARM_DRIVER_OK;
+}
+
+/* Sector access: uncached (queued CMD17/CMD24) or through the cache */
+static int32_t
+sector_io (uint32_t cached, uint32_t write, uint32_t sector)
+{
+  uint32_t t0;
+
+  if (cached != 0U)
+    {
+      io.sector = sector;
+      io.buf    = sec;
+      io.count  = 1U;
+      return drv->Control (write ? ARM_MCI_CACHE_WRITE : ARM_MCI_CACHE_READ,
+                           ADDR (&io));
+    }
+
+  memset (&req, 0, sizeof (req));
+  req.cmd         = write ? 24U : 17U;
+  req.arg         = sector;
+  req.data        = sec;
+  req.block_count = 1U;
+  req.block_size  = 512U;
+  req.mode        = write ? ARM_MCI_TRANSFER_WRITE : ARM_MCI_TRANSFER_READ;
+  req.rca         = rca;
+  if (drv->Control (ARM_MCI_QUEUE_REQUEST, ADDR (&req)) != ARM_DRIVER_OK)
+    {
+      return ARM_DRIVER_ERROR;
+    }
+  t0 = ticks ();
+  while ((*(volatile int32_t *) &req.status == ARM_DRIVER_ERROR_BUSY)
+         && ((ticks () - t0) < TIMEOUT))
+    {
+    }
+  return req.status;
+}
+
+static void
+cache_setup (void)
+{
+  cfg.mem        = cache_mem;
+  cfg.size       = sizeof (cache_mem);
+  cfg.ways       = 4U;
+  cfg.stage      = STAGE;
+  cfg.read_ahead = 16U;
+  cfg.erase_size = 64U;
+  cfg.sectors    = SECTORS;
+  cfg.rca        = rca;
+  cfg.flags      = MCI_CACHE_CMD23;
+  if (drv->Control (ARM_MCI_CACHE_SETUP, ADDR (&cfg)) != ARM_DRIVER_OK)
+    {
+      printf ("cache setup failed\n");
+      failed++;
+    }
+}
+
+/* Expected content of a sector: written data or the initial pattern */
+static void
+sector_data (uint8_t *p, uint32_t sector, uint32_t gen)
+{
+  uint32_t i;
+
+  for (i = 0U; i < 512U; i++)
+    {
+      p[i] = (uint8_t) ((sector * 13U) + (gen * 29U) + i);
+    }
+}
+
+static int32_t
+file_check (uint32_t sector, uint32_t gen)
+{
+  file_read (sector, chk);
+  sector_data (sec, sector, gen);
+  return (memcmp (sec, chk, 512U) == 0) ? 0 : -1;
+}
+
+typedef struct
+{
+  const char *name;
+  uint32_t cmds;
+  uint32_t rd;
+  uint32_t wr;
+  uint32_t ticks;
+  uint32_t reads;
+  uint32_t hits;
+  double ms;
+} result_t;
+
+static void
+result_start (result_t *r, const char *name)
+{
+  memset (r, 0, sizeof (*r));
+  r->name  = name;
+  r->cmds  = commands ();
+  r->rd    = emu.blocks_read;
+  r->wr    = emu.blocks_written;
+  r->ticks = ticks ();
+  r->ms    = (double) clock () * 1000.0 / CLOCKS_PER_SEC;
+}
+
+static void
+result_print (result_t *r)
+{
+  printf ("%-22s %8u %8u %8u %8u", r->name, (unsigned) (commands () - r->cmds),
+          (unsigned) (emu.blocks_read - r->rd),
+          (unsigned) (emu.blocks_written - r->wr), (unsigned) (ticks () - r->ticks));
+  if (r->reads != 0U)
+    {
+      printf (" %6.1f%%", 100.0 * r->hits / r->reads);
+    }
+  else
+    {
+      printf ("        ");
+    }
+  printf (" %8.1f\n", ((double) clock () * 1000.0 / CLOCKS_PER_SEC) - r->ms);
+}
+
+/* Read one sector, counting reads served without card command */
+static int32_t
+read_hit (result_t *r, uint32_t cached, uint32_t sector)
+{
+  uint32_t c;
+  int32_t status;
+
+  c = commands ();
+  status = sector_io (cached, 0U, sector);
+  r->reads++;
+  if (commands () == c)
+    {
+      r->hits++;
+    }
+  return status;
+}
+
+/* Read-ahead of sequential single sector reads stops at the card end */
+static void
+check_read_ahead (void)
+{
+  uint32_t s, err;
+
+  cache_setup ();
+  emu_clear ();
+  err = 0U;
+  for (s = SECTORS - 6U; s < SECTORS; s++)
+    {
+      file_read (s, chk);
+      if ((sector_io (1U, 0U, s) != ARM_DRIVER_OK) || (memcmp (sec, chk, 512U) != 0))
+        {
+          err++;
+        }
+    }
+  io.sector = SECTORS;
+  if (drv->Control (ARM_MCI_CACHE_READ, ADDR (&io)) != ARM_DRIVER_ERROR_PARAMETER)
+    {
+      err++;
+    }
+  printf ("read-ahead at card end: %s (%s)\n",
+          ((err == 0U) && (emu.out_of_range == 0U)) ? "ok" : "FAILED", emu_log ());
+  if ((err != 0U) || (emu.out_of_range != 0U))
+    {
+      failed++;
+    }
+}
+
+/* LRU victim while the LRU clock wraps from 0xFFFFFFFF to 0 */
+static void
+check_lru_wrap (void)
+{
+  MCI_CACHE_INFO *c;
+  uint32_t a, b, cc, d, e, sets, cmd, err;
+
+  cache_setup ();
+  c    = emu_cache_info ();
+  sets = c->sets;
+
+  /* Five sectors of one set, not sequential (no read-ahead) */
+  a  = 40000U;
+  b  = a + sets;
+  cc = a + (2U * sets);
+  d  = a + (3U * sets);
+  e  = a + (4U * sets);
+
+  /* Line ages in comments: c is the oldest line when e is read, d is
+     older than a and b but has the smallest raw age */
+  c->tick = 0xFFFFFFFCU;
+  err = 0U;
+  err += (uint32_t) (sector_io (1U, 0U, a) != 0);      // a: fffffffd
+  err += (uint32_t) (sector_io (1U, 0U, b) != 0);      // b: fffffffe
+  err += (uint32_t) (sector_io (1U, 0U, cc) != 0);     // c: ffffffff
+  err += (uint32_t) (sector_io (1U, 0U, d) != 0);      // d: 0
+  err += (uint32_t) (sector_io (1U, 0U, a) != 0);      // a: 1 (hit)
+  err += (uint32_t) (sector_io (1U, 0U, b) != 0);      // b: 2 (hit)
+  err += (uint32_t) (sector_io (1U, 0U, e) != 0);      // evicts c
+  emu_log ();
+
+  /* d is still cached, c was evicted */
+  cmd = commands ();
+  err += (uint32_t) (sector_io (1U, 0U, d) != 0);
+  err += (uint32_t) (commands () != cmd);
+  cmd = commands ();
+  err += (uint32_t) (sector_io (1U, 0U, cc) != 0);
+  err += (uint32_t) (commands () == cmd);
+
+  printf ("LRU across clock wrap:  %s\n", (err == 0U) ? "ok" : "FAILED");
+  if (err != 0U)
+    {
+      failed++;
+    }
+  emu_log ();
+}
+
+/* Data logger: 64-byte records appended by read-modify-write */
+static void
+bench_logger (uint32_t cached)
+{
+  result_t r;
+  uint32_t i, s, base, n, err;
+
+  base = 8192U;
+  n    = 4096U;
+  if (cached != 0U)
+    {
+      cache_setup ();
+    }
+  result_start (&r, cached ? "logger, cached" : "logger, uncached");
+  err = 0U;
+  for (i = 0U; i < n; i++)
+    {
+      s = base + (i / 8U);
+      err += (uint32_t) (sector_io (cached, 0U, s) != 0);
+      sector_data (chk, s, 1U + cached);
+      memcpy (&sec[(i % 8U) * 64U], &chk[(i % 8U) * 64U], 64U);
+      err += (uint32_t) (sector_io (cached, 1U, s) != 0);
+    }
+  if (cached != 0U)
+    {
+      err += (uint32_t) (drv->Control (ARM_MCI_CACHE_FLUSH, 0U) != 0);
+    }
+  result_print (&r);
+  for (s = base; s < (base + (n / 8U)); s++)
+    {
+      err += (uint32_t) (file_check (s, 1U + cached) != 0);
+    }
+  if (err != 0U)
+    {
+      printf ("  %u errors\n", (unsigned) err);
+      failed++;
+    }
+  emu_log ();
+}
+
+/* Sequential single sector reads */
+static void
+bench_sequential (uint32_t cached)
+{
+  result_t r;
+  uint32_t s, err;
+
+  if (cached != 0U)
+    {
+      cache_setup ();
+    }
+  result_start (&r, cached ? "sequential, cached" : "sequential, uncached");
+  err = 0U;
+  for (s = 16384U; s < (16384U + 4096U); s++)
+    {
+      err += (uint32_t) (read_hit (&r, cached, s) != 0);
+      file_read (s, chk);
+      err += (uint32_t) (memcmp (sec, chk, 512U) != 0);
+    }
+  result_print (&r);
+  if (err != 0U)
+    {
+      printf ("  %u errors\n", (unsigned) err);
+      failed++;
+    }
+  emu_log ();
+}
+
+/* Random reads: 90% in 128 hot sectors, 10% anywhere */
+static void
+bench_random (uint32_t cached)
+{
+  result_t r;
+  uint32_t i, s, x, err;
+
+  if (cached != 0U)
+    {
+      cache_setup ();
+    }
+  result_start (&r, cached ? "random 90/10, cached" : "random 90/10, uncached");
+  err = 0U;
+  x = 12345U;
+  for (i = 0U; i < 8192U; i++)
+    {
+      x = (x * 1103515245U) + 12345U;
+      if (((x >> 16) % 10U) != 0U)
+        {
+          s = 24576U + ((x >> 8) % 128U);
+        }
+      else
+        {
+          s = (x >> 8) % SECTORS;
+        }
+      err += (uint32_t) (read_hit (&r, cached, s) != 0);
+      file_read (s, chk);
+      err += (uint32_t) (memcmp (sec, chk, 512U) != 0);
+    }
+  result_print (&r);
+  if (err != 0U)
+    {
+      printf ("  %u errors\n", (unsigned) err);
+      failed++;
+    }
+  emu_log ();
+}
+
+int
+main (void)
+{
+  FILE *f;
+  uint32_t s;
+
+  f = tmpfile ();
+  if (f == NULL)
+    {
+      perror ("tmpfile");
+      return 1;
+    }
+  card_fd = fileno (f);
+
+  /* Card content: sector pattern of generation 0 */
+  for (s = 0U; s < SECTORS; s++)
+    {
+      sector_data (sec, s, 0U);
+      file_write (s, sec);
+    }
+
+  emu.storage   = &storage;
+  emu.sectors   = SECTORS;
+  emu.prg_ticks = 5U;
+  emu_start (20U);
+
+  if (card_init () != ARM_DRIVER_OK)
+    {
+      printf ("card init failed\n");
+      emu_stop ();
+      return 1;
+    }
+  emu_log ();
+
+  check_read_ahead ();
+  check_lru_wrap ();
+
+  printf ("\n%-22s %8s %8s %8s %8s %7s %8s\n", "workload", "commands",
+          "read", "written", "ticks", "hits", "host ms");
+  bench_logger (0U);
+  bench_logger (1U);
+  bench_sequential (0U);
+  bench_sequential (1U);
+  bench_random (0U);
+  bench_random (1U);
+
+  drv->Control (ARM_MCI_CACHE_SETUP, 0U);
+  emu_stop ();
+  fclose (f);
+
+  if ((emu.bad_cmd | emu.out_of_range | emu.corrupt | emu.lost | emu.overrun
+       | emu.underrun | emu.dma_other | emu.dma_error) != 0U)
+    {
+      printf ("emulator errors\n");
+      failed++;
+    }
+
+  return (failed != 0U) ? 1 : 0;
+}
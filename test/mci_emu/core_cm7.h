@@ -0,0 +1,56 @@
+/*
+ * Host build of the MCI driver: Cortex-M7 core definitions.
+ *
+ * PRIMASK is the SIGALRM mask of the process: the emulator runs the
+ * peripheral model and the interrupt handlers from SIGALRM (see emu.c),
+ * so __disable_irq() keeps interrupts out exactly like on the target.
+ * The data cache maintenance functions only record their use.
+ */
+
+#ifndef __CORE_CM7_H
+#define __CORE_CM7_H
+
+#include <stdint.h>
+
+#define __I     volatile const
+#define __O     volatile
+#define __IO    volatile
+#define __IM    volatile const
+#define __OM    volatile
+#define __IOM   volatile
+
+#define __ALIGNED(x)    __attribute__((aligned(x)))
+#define __STATIC_INLINE static inline
+
+static inline void __NOP (void) { }
+static inline void __DSB (void) { }
+static inline void __ISB (void) { }
+static inline void __DMB (void) { }
+
+uint32_t __get_PRIMASK (void);
+void     __set_PRIMASK (uint32_t priMask);
+void     __disable_irq (void);
+void     __enable_irq  (void);
+
+/* System Control Block (only CCR is used) */
+typedef struct
+{
+  __IM  uint32_t CPUID;
+  __IOM uint32_t ICSR;
+  __IOM uint32_t VTOR;
+  __IOM uint32_t AIRCR;
+  __IOM uint32_t SCR;
+  __IOM uint32_t CCR;
+} SCB_Type;
+
+extern SCB_Type emu_scb;
+
+#define SCB                     (&emu_scb)
+#define SCB_CCR_DC_Pos          16U
+#define SCB_CCR_DC_Msk          (1UL << SCB_CCR_DC_Pos)
+
+void SCB_CleanDCache_by_Addr           (uint32_t *addr, int32_t dsize);
+void SCB_InvalidateDCache_by_Addr      (uint32_t *addr, int32_t dsize);
+void SCB_CleanInvalidateDCache_by_Addr (uint32_t *addr, int32_t dsize);
+
+#endif /* __CORE_CM7_H */
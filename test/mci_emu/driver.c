@@ -0,0 +1,36 @@
+/*
+ * Host build of CMSIS/Driver/MCI_STM32F7xx.c for the emulator test.
+ *
+ * The driver source is included unchanged; the functions below give the
+ * tests access to driver internals that are static.
+ */
+
+#include "MCI_STM32F7xx.c"
+
+#include "emu.h"
+
+/* Block cache state of MCI0 */
+MCI_CACHE_INFO *
+emu_cache_info (void)
+{
+  return &MCI0_Info.cache;
+}
+
+/* Classify DMA access: inside the transfer buffer, parked target, other */
+uint32_t
+emu_dma_target (uint32_t addr)
+{
+  uint32_t lo;
+
+  lo = (uint32_t)MCI0_Info.xfer.data;
+  if ((addr >= lo) && (addr < (lo + MCI0_Info.xfer.len)))
+    {
+      return EMU_DMA_BUFFER;
+    }
+  lo = (uint32_t)MCI_DMA_Dummy;
+  if ((addr >= lo) && (addr < (lo + sizeof (MCI_DMA_Dummy))))
+    {
+      return EMU_DMA_DUMMY;
+    }
+  return EMU_DMA_OTHER;
+}
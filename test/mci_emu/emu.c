@@ -0,0 +1,1405 @@
+/*
+ * SDMMC1, DMA and SD card emulator for host tests of the MCI driver.
+ *
+ * The driver runs unchanged against three models:
+ *  - SDMMC1 registers: command path state machine (CPSM), data path state
+ *    machine (DPSM) with the 32 word FIFO and the STA/ICR/MASK flags;
+ *  - two DMA2 streams behind the STM32Cube HAL DMA API: normal, peripheral
+ *    flow controlled and double buffer mode, NDTR, CT and M0AR/M1AR;
+ *  - an SD card (SDHC, or SDSC with byte addresses): identification,
+ *    transfer states, CMD6 high speed switch, CMD23/ACMD23, CMD12, CMD13
+ *    with programming time, sector storage provided by the test.
+ *
+ * Interrupts: the models advance in a SIGALRM handler (a "tick"), which
+ * then calls SDMMC1_IRQHandler() and HAL_DMA_IRQHandler() while their
+ * flags are pending. The handler preempts the test like an interrupt
+ * preempts thread code, and __disable_irq() blocks SIGALRM, so the
+ * driver's critical sections work as on the target. Each tick moves up
+ * to emu.words data words on the bus; commands take one tick.
+ *
+ * Register writes are seen when the model runs: CPSMEN in CMD and DTEN
+ * in DCTRL are cleared by the model when it takes the command or starts
+ * the data path, ICR is applied and cleared before each model step and
+ * before each interrupt handler call.
+ *
+ * DMA accesses are checked against the driver's transfer buffer and the
+ * parked double buffer target (emu_dma_target); other addresses are
+ * counted and not accessed. Memory addresses are 32-bit, the test is
+ * linked without PIE so that static buffers are below 4 GB.
+ */
+
+#include <signal.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "emu.h"
+
+emu_t emu;
+
+/* Core, SDMMC1 registers, DMA streams and CubeMX handles */
+SCB_Type emu_scb;
+uint32_t emu_sdmmc1[sizeof (SDMMC_TypeDef) / 4U];
+
+static DMA_Stream_TypeDef emu_stream[2];
+
+DMA_HandleTypeDef hdma_sdmmc1_rx;
+DMA_HandleTypeDef hdma_sdmmc1_tx;
+SD_HandleTypeDef hsd1;
+
+/* Register view of the model: status registers are written here */
+typedef struct
+{
+  volatile uint32_t POWER;
+  volatile uint32_t CLKCR;
+  volatile uint32_t ARG;
+  volatile uint32_t CMD;
+  volatile uint32_t RESPCMD;
+  volatile uint32_t RESP1;
+  volatile uint32_t RESP2;
+  volatile uint32_t RESP3;
+  volatile uint32_t RESP4;
+  volatile uint32_t DTIMER;
+  volatile uint32_t DLEN;
+  volatile uint32_t DCTRL;
+  volatile uint32_t DCOUNT;
+  volatile uint32_t STA;
+  volatile uint32_t ICR;
+  volatile uint32_t MASK;
+  uint32_t RESERVED0[2];
+  volatile uint32_t FIFOCNT;
+  uint32_t RESERVED1[13];
+  volatile uint32_t FIFO;
+} emu_regs_t;
+
+_Static_assert (offsetof (emu_regs_t, FIFO) == offsetof (SDMMC_TypeDef, FIFO),
+                "SDMMC register layout");
+
+#define REG             ((emu_regs_t *) emu_sdmmc1)
+
+/* Static flags cleared by ICR */
+#define STA_STATIC      0x004005FFU
+
+/* DPSM without data for this many ticks signals data timeout */
+#define DATA_TIMEOUT    200U
+
+/* SD card states (CURRENT_STATE of R1) */
+#define CARD_IDLE       0U
+#define CARD_READY      1U
+#define CARD_IDENT      2U
+#define CARD_STBY       3U
+#define CARD_TRAN       4U
+#define CARD_DATA       5U
+#define CARD_RCV        6U
+#define CARD_PRG        7U
+
+/* Card status bits */
+#define R1_OUT_OF_RANGE (1UL << 31)
+#define R1_ADDR_ERROR   (1UL << 30)
+#define R1_READY        (1UL << 8)
+#define R1_APP_CMD      (1UL << 5)
+
+/* Command response of the card model */
+#define RSP_NONE        0U
+#define RSP_R1          1U
+#define RSP_R2          2U
+#define RSP_R3          3U
+#define RSP_TIMEOUT     4U
+
+#define CARD_RCA        0x1234U
+
+typedef struct
+{
+  uint32_t state;                       // CURRENT_STATE
+  uint32_t status;                      // Error bits reported with next R1
+  uint32_t app;                         // Next command is application command
+  uint32_t acmd41;                      // ACMD41 count (power up busy)
+  uint32_t width;                       // Data bus width (ACMD6)
+  uint32_t sbc;                         // CMD23 block count
+  uint32_t prg;                         // Programming ticks left
+  uint32_t cmd;                         // Active data command
+  uint32_t sector;                      // Next block of active data command
+  uint32_t left;                        // Blocks left (0 = open-ended)
+  uint32_t blen;                        // Block length
+  uint32_t pos;                         // Byte position in block
+  uint32_t loaded;                      // Read block loaded
+  uint32_t crc;                         // Block transferred with CRC error
+  uint32_t blocks;                      // Data blocks of transfer (fail_block)
+  uint32_t log;                         // Log entry of active data command
+  uint8_t blk[512];                     // Block buffer
+} emu_card_t;
+
+typedef struct
+{
+  uint32_t active;                      // DPSM transfers data
+  uint32_t rx;                          // Direction card to controller
+  uint32_t count;                       // Bytes left (DCOUNT)
+  uint32_t words;                       // Transfer length in words
+  uint32_t bsize;                       // Block size
+  uint32_t bpos;                        // Byte position in block
+  uint32_t fed;                         // TX words requested from DMA
+  uint32_t tx_req;                      // TX DMA requests enabled
+  uint32_t rx_last;                     // RX done, last request on FIFO empty
+  uint32_t idle;                        // Ticks without data
+  uint32_t fifo[32];
+  uint32_t head;
+  uint32_t n;
+} emu_dpsm_t;
+
+typedef struct
+{
+  DMA_HandleTypeDef *h;
+  uint32_t tcif;                        // Transfer complete flag
+  uint32_t teif;                        // Transfer error flag
+  uint32_t off;                         // Bytes moved in current target
+  uint32_t ndtr;                        // NDTR reload (double buffer mode)
+} emu_dma_t;
+
+typedef struct
+{
+  uint8_t cmd;
+  uint8_t app;
+  uint32_t arg;
+  uint32_t blocks;
+} emu_log_t;
+
+static emu_card_t card;
+static emu_dpsm_t dpsm;
+static emu_dma_t dma[2];
+
+static emu_log_t log_buf[4096];
+static uint32_t log_cnt;
+static char log_str[65536];
+
+/* Memory at a 32-bit address */
+static uint8_t *
+mem (uint32_t addr)
+{
+  return (uint8_t *) (uintptr_t) addr;
+}
+
+/* --------------------------------------------------------------------------
+ * Core
+ */
+
+uint32_t
+__get_PRIMASK (void)
+{
+  sigset_t set;
+
+  sigprocmask (SIG_BLOCK, NULL, &set);
+  return (sigismember (&set, SIGALRM) == 1) ? 1U : 0U;
+}
+
+void
+__disable_irq (void)
+{
+  sigset_t set;
+
+  sigemptyset (&set);
+  sigaddset (&set, SIGALRM);
+  sigprocmask (SIG_BLOCK, &set, NULL);
+}
+
+void
+__enable_irq (void)
+{
+  sigset_t set;
+
+  sigemptyset (&set);
+  sigaddset (&set, SIGALRM);
+  sigprocmask (SIG_UNBLOCK, &set, NULL);
+}
+
+void
+__set_PRIMASK (uint32_t priMask)
+{
+  if (priMask != 0U)
+    {
+      __disable_irq ();
+    }
+  else
+    {
+      __enable_irq ();
+    }
+}
+
+void
+SCB_CleanDCache_by_Addr (uint32_t *addr, int32_t dsize)
+{
+  (void) addr;
+  (void) dsize;
+  emu.cache_ops++;
+}
+
+void
+SCB_InvalidateDCache_by_Addr (uint32_t *addr, int32_t dsize)
+{
+  (void) addr;
+  (void) dsize;
+  emu.cache_ops++;
+}
+
+void
+SCB_CleanInvalidateDCache_by_Addr (uint32_t *addr, int32_t dsize)
+{
+  (void) addr;
+  (void) dsize;
+  emu.cache_ops++;
+}
+
+/* Busy-wait loops of the driver scale with HCLK: a high value gives the
+   emulator time to run (Queue_Wait waits about 1 s on the target) */
+uint32_t
+HAL_RCC_GetHCLKFreq (void)
+{
+  return 4000000000U;
+}
+
+/* --------------------------------------------------------------------------
+ * SD card
+ */
+
+/* Bus clock and width do not match the card: data is corrupted */
+static uint32_t
+card_bus_bad (void)
+{
+  uint32_t clk, width;
+
+  if (REG->CLKCR & SDMMC_CLKCR_BYPASS)
+    {
+      clk = SDMMCCLK;
+    }
+  else
+    {
+      clk = SDMMCCLK / ((REG->CLKCR & SDMMC_CLKCR_CLKDIV) + 2U);
+    }
+  width = (REG->CLKCR & SDMMC_CLKCR_WIDBUS_0) ? 4U : 1U;
+
+  if ((clk > 25000000U) && ((emu.hs == 0U) || (emu.hs_fail != 0U)))
+    {
+      return 1U;
+    }
+  return (width != card.width) ? 1U : 0U;
+}
+
+static uint32_t
+card_r1 (void)
+{
+  uint32_t r1;
+
+  r1 = card.status | (card.state << 9) | (card.app ? R1_APP_CMD : 0U);
+  if ((card.state == CARD_TRAN) || (card.state == CARD_RCV))
+    {
+      r1 |= R1_READY;
+    }
+  card.status = 0U;
+  return r1;
+}
+
+/* Sector of a data command argument */
+static uint32_t
+card_sector (uint32_t arg)
+{
+  if (emu.byte_addr != 0U)
+    {
+      if ((arg & 511U) != 0U)
+        {
+          card.status |= R1_ADDR_ERROR;
+          emu.out_of_range++;
+        }
+      return arg / 512U;
+    }
+  return arg;
+}
+
+/* CMD6 switch function status */
+static void
+card_switch (uint32_t arg)
+{
+  uint32_t fn;
+
+  memset (card.blk, 0, 64U);
+  card.blk[0] = 0x00U;                  // Maximum current 100 mA
+  card.blk[1] = 0x64U;
+  card.blk[13] = emu.hs_support ? 0x03U : 0x01U;        // Group 1 support
+
+  fn = arg & 0xFU;
+  if (fn == 0xFU)
+    {
+      fn = (emu.hs != 0U) ? 1U : 0U;    // No change: current function
+    }
+  else if ((fn > 1U) || ((fn == 1U) && (emu.hs_support == 0U)))
+    {
+      fn = 0xFU;                        // Not supported
+    }
+  card.blk[16] = (uint8_t) fn;
+
+  if ((arg & 0x80000000U) && (fn == 1U))
+    {
+      emu.hs = 1U;
+    }
+}
+
+static uint32_t
+card_data (uint32_t cmd, uint32_t sector, uint32_t left, uint32_t state)
+{
+  card.state  = state;
+  card.cmd    = cmd;
+  card.sector = sector;
+  card.left   = left;
+  card.blen   = 512U;
+  card.pos    = 0U;
+  card.loaded = 0U;
+  card.blocks = 0U;
+  card.log    = log_cnt - 1U;
+  return RSP_R1;
+}
+
+/* Execute command, returns response type */
+static uint32_t
+card_command (uint32_t idx, uint32_t arg, uint32_t *rsp)
+{
+  uint32_t app, state;
+
+  app      = card.app;
+  state    = card.state;
+  card.app = 0U;
+
+  emu.commands++;
+
+  if (log_cnt < (sizeof (log_buf) / sizeof (log_buf[0])))
+    {
+      log_buf[log_cnt].cmd    = (uint8_t) idx;
+      log_buf[log_cnt].app    = (uint8_t) app;
+      log_buf[log_cnt].arg    = arg;
+      log_buf[log_cnt].blocks = 0U;
+      log_cnt++;
+    }
+
+  if ((emu.fail_cmd != 0U) && (emu.fail_cmd == idx) && (app == 0U))
+    {
+      /* No response */
+      emu.fail_cmd = 0U;
+      return RSP_TIMEOUT;
+    }
+
+  if (app != 0U)
+    {
+      switch (idx)
+        {
+        case 41:                        // SD_SEND_OP_COND
+          if (state > CARD_READY)
+            {
+              break;
+            }
+          rsp[0] = 0x00FF8000U;
+          if (++card.acmd41 >= 3U)
+            {
+              rsp[0] |= 0x80000000U | (emu.byte_addr ? 0U : 0x40000000U);
+              card.state = CARD_READY;
+            }
+          return RSP_R3;
+
+        case 6:                         // SET_BUS_WIDTH
+          if (state != CARD_TRAN)
+            {
+              break;
+            }
+          rsp[0] = card_r1 ();
+          card.width = ((arg & 3U) == 2U) ? 4U : 1U;
+          return RSP_R1;
+
+        case 23:                        // SET_WR_BLK_ERASE_COUNT
+          if (state != CARD_TRAN)
+            {
+              break;
+            }
+          card.app = 1U;
+          rsp[0] = card_r1 ();
+          card.app = 0U;
+          return RSP_R1;
+
+        default:
+          break;
+        }
+      emu.bad_cmd++;
+      return RSP_TIMEOUT;
+    }
+
+  switch (idx)
+    {
+    case 0:                             // GO_IDLE_STATE
+      emu_card_reset ();
+      return RSP_NONE;
+
+    case 8:                             // SEND_IF_COND
+      if (state != CARD_IDLE)
+        {
+          break;
+        }
+      rsp[0] = arg & 0xFFFU;
+      return RSP_R1;
+
+    case 55:                            // APP_CMD
+      if ((state >= CARD_STBY) && ((arg >> 16) != CARD_RCA))
+        {
+          break;
+        }
+      card.app = 1U;
+      rsp[0] = card_r1 ();
+      return RSP_R1;
+
+    case 2:                             // ALL_SEND_CID
+      if (state != CARD_READY)
+        {
+          break;
+        }
+      rsp[0] = 0x12345678U;
+      rsp[1] = 0x9ABCDEF0U;
+      rsp[2] = 0x0FEDCBA9U;
+      rsp[3] = 0x87654321U;
+      card.state = CARD_IDENT;
+      return RSP_R2;
+
+    case 3:                             // SEND_RELATIVE_ADDR
+      if ((state != CARD_IDENT) && (state != CARD_STBY))
+        {
+          break;
+        }
+      rsp[0] = (CARD_RCA << 16) | (state << 9);
+      card.state = CARD_STBY;
+      return RSP_R1;
+
+    case 7:                             // SELECT_CARD
+      if ((state != CARD_STBY) || ((arg >> 16) != CARD_RCA))
+        {
+          break;
+        }
+      rsp[0] = card_r1 ();
+      card.state = CARD_TRAN;
+      return RSP_R1;
+
+    case 13:                            // SEND_STATUS
+      if ((state < CARD_STBY) || ((arg >> 16) != CARD_RCA))
+        {
+          break;
+        }
+      rsp[0] = card_r1 ();
+      return RSP_R1;
+
+    case 16:                            // SET_BLOCKLEN
+      if ((state != CARD_TRAN) || (arg != 512U))
+        {
+          break;
+        }
+      rsp[0] = card_r1 ();
+      return RSP_R1;
+
+    case 23:                            // SET_BLOCK_COUNT
+      if (state != CARD_TRAN)
+        {
+          break;
+        }
+      rsp[0] = card_r1 ();
+      card.sbc = arg & 0xFFFFU;
+      return RSP_R1;
+
+    case 6:                             // SWITCH_FUNC
+      if (state != CARD_TRAN)
+        {
+          break;
+        }
+      rsp[0] = card_r1 ();
+      card_data (idx, 0U, 1U, CARD_DATA);
+      card.blen   = 64U;
+      card.loaded = 1U;
+      card_switch (arg);
+      return RSP_R1;
+
+    case 17:                            // READ_SINGLE_BLOCK
+    case 18:                            // READ_MULTIPLE_BLOCK
+    case 24:                            // WRITE_BLOCK
+    case 25:                            // WRITE_MULTIPLE_BLOCK
+      if (state != CARD_TRAN)
+        {
+          break;
+        }
+      rsp[0] = card_r1 ();
+      card_data (idx, card_sector (arg),
+                 ((idx == 17U) || (idx == 24U)) ? 1U : card.sbc,
+                 (idx < 24U) ? CARD_DATA : CARD_RCV);
+      card.sbc = 0U;
+      return RSP_R1;
+
+    case 12:                            // STOP_TRANSMISSION
+      if (state == CARD_DATA)
+        {
+          rsp[0] = card_r1 ();
+          card.state = CARD_TRAN;
+          return RSP_R1;
+        }
+      if (state == CARD_RCV)
+        {
+          rsp[0] = card_r1 ();
+          card.state = CARD_PRG;
+          card.prg   = emu.prg_ticks;
+          return RSP_R1;
+        }
+      break;
+
+    default:
+      break;
+    }
+
+  emu.bad_cmd++;
+  return RSP_TIMEOUT;
+}
+
+/* Data block done: next block or end of data command */
+static void
+card_block_end (void)
+{
+  card.pos    = 0U;
+  card.loaded = 0U;
+  card.sector++;
+
+  if (card.log < log_cnt)
+    {
+      log_buf[card.log].blocks++;
+    }
+
+  if ((card.left != 0U) && (--card.left == 0U))
+    {
+      if (card.state == CARD_RCV)
+        {
+          card.state = CARD_PRG;
+          card.prg   = emu.prg_ticks;
+        }
+      else
+        {
+          card.state = CARD_TRAN;
+        }
+    }
+}
+
+/* Card sends data word, returns 0 when there is no data */
+static uint32_t
+card_read (uint32_t *w)
+{
+  if (card.state != CARD_DATA)
+    {
+      return 0U;
+    }
+  if (card.loaded == 0U)
+    {
+      if (card.sector >= emu.sectors)
+        {
+          /* Read past the end of the card: no more data */
+          card.status |= R1_OUT_OF_RANGE;
+          card.state   = CARD_TRAN;
+          emu.out_of_range++;
+          return 0U;
+        }
+      emu.storage->read (card.sector, card.blk);
+      emu.blocks_read++;
+      card.loaded = 1U;
+    }
+
+  memcpy (w, &card.blk[card.pos], 4U);
+  if (card_bus_bad ())
+    {
+      *w ^= 0x00000100U;
+      emu.corrupt++;
+    }
+
+  card.pos += 4U;
+  if (card.pos == card.blen)
+    {
+      card.crc = 0U;
+      if ((emu.fail_block != 0U) && (++card.blocks == emu.fail_block))
+        {
+          emu.fail_block = 0U;
+          card.crc = 1U;
+        }
+      card_block_end ();
+    }
+  return 1U;
+}
+
+/* Card receives data word */
+static void
+card_write (uint32_t w)
+{
+  if (card.state != CARD_RCV)
+    {
+      emu.lost++;
+      return;
+    }
+  if (card_bus_bad ())
+    {
+      w ^= 0x00000100U;
+      emu.corrupt++;
+    }
+  memcpy (&card.blk[card.pos], &w, 4U);
+
+  card.pos += 4U;
+  if (card.pos == card.blen)
+    {
+      card.crc = 0U;
+      if ((emu.fail_block != 0U) && (++card.blocks == emu.fail_block))
+        {
+          /* Negative CRC status: block is not programmed, a multiple
+             block write ignores further data until CMD12 */
+          emu.fail_block = 0U;
+          card.crc = 1U;
+          card.pos = 0U;
+          card.state = (card.cmd == 24U) ? CARD_TRAN : CARD_RCV;
+          card.left = 0U;
+          return;
+        }
+      if (card.sector >= emu.sectors)
+        {
+          card.status |= R1_OUT_OF_RANGE;
+          emu.out_of_range++;
+        }
+      else
+        {
+          emu.storage->write (card.sector, card.blk);
+          emu.blocks_written++;
+        }
+      card_block_end ();
+    }
+}
+
+void
+emu_card_reset (void)
+{
+  memset (&card, 0, sizeof (card));
+  card.width = 1U;
+  emu.hs     = 0U;
+}
+
+/* --------------------------------------------------------------------------
+ * SDMMC1
+ */
+
+void
+emu_sdmmc_reset (void)
+{
+  memset (emu_sdmmc1, 0, sizeof (emu_sdmmc1));
+  memset (&dpsm, 0, sizeof (dpsm));
+}
+
+static void
+sdmmc_icr (void)
+{
+  REG->STA &= ~(REG->ICR & STA_STATIC);
+  REG->ICR  = 0U;
+}
+
+/* Command path */
+static void
+sdmmc_command (void)
+{
+  uint32_t cmd, idx, rsp[4], type;
+
+  cmd = REG->CMD;
+  if ((cmd & SDMMC_CMD_CPSMEN) == 0U)
+    {
+      return;
+    }
+  REG->CMD = cmd & ~SDMMC_CMD_CPSMEN;
+
+  idx = cmd & SDMMC_CMD_CMDINDEX;
+  memset (rsp, 0, sizeof (rsp));
+  type = card_command (idx, REG->ARG, rsp);
+
+  if ((cmd & SDMMC_CMD_WAITRESP) == 0U)
+    {
+      REG->STA |= SDMMC_STA_CMDSENT;
+      return;
+    }
+  if ((type == RSP_TIMEOUT) || (type == RSP_NONE))
+    {
+      REG->STA |= SDMMC_STA_CTIMEOUT;
+      return;
+    }
+
+  REG->RESPCMD = ((type == RSP_R2) || (type == RSP_R3)) ? 0x3FU : idx;
+  REG->RESP1   = rsp[0];
+  REG->RESP2   = rsp[1];
+  REG->RESP3   = rsp[2];
+  REG->RESP4   = rsp[3];
+
+  /* R3 has no valid CRC */
+  REG->STA |= (type == RSP_R3) ? SDMMC_STA_CCRCFAIL : SDMMC_STA_CMDREND;
+}
+
+/* Data path start (DTEN) and stop (DMAEN cleared) */
+static void
+sdmmc_data_control (void)
+{
+  uint32_t dctrl;
+
+  dctrl = REG->DCTRL;
+
+  if ((dctrl & SDMMC_DCTRL_DMAEN) == 0U)
+    {
+      dpsm.tx_req = 0U;
+      dpsm.active = 0U;
+    }
+  if ((dctrl & SDMMC_DCTRL_DTEN) == 0U)
+    {
+      return;
+    }
+  REG->DCTRL = dctrl & ~SDMMC_DCTRL_DTEN;
+
+  dpsm.active  = 1U;
+  dpsm.rx      = (dctrl & SDMMC_DCTRL_DTDIR) ? 1U : 0U;
+  dpsm.count   = REG->DLEN & SDMMC_DLEN_DATALENGTH;
+  dpsm.words   = dpsm.count / 4U;
+  dpsm.bsize   = 1UL << ((dctrl & SDMMC_DCTRL_DBLOCKSIZE) >> SDMMC_DCTRL_DBLOCKSIZE_Pos);
+  dpsm.bpos    = 0U;
+  dpsm.fed     = 0U;
+  dpsm.tx_req  = ((dpsm.rx == 0U) && (dctrl & SDMMC_DCTRL_DMAEN)) ? 1U : 0U;
+  dpsm.rx_last = 0U;
+  dpsm.idle    = 0U;
+  dpsm.head    = 0U;
+  dpsm.n       = 0U;
+  REG->DCOUNT  = dpsm.count;
+}
+
+/* Block and transfer end of the data path */
+static void
+sdmmc_data_word (void)
+{
+  dpsm.count -= 4U;
+  dpsm.bpos  += 4U;
+  REG->DCOUNT = dpsm.count;
+
+  if (dpsm.bpos == dpsm.bsize)
+    {
+      dpsm.bpos = 0U;
+      if ((card.crc != 0U) || (card.pos != 0U))
+        {
+          /* CRC error or block size differs from card */
+          card.crc = 0U;
+          REG->STA |= SDMMC_STA_DCRCFAIL;
+          dpsm.active = 0U;
+          return;
+        }
+      REG->STA |= SDMMC_STA_DBCKEND;
+    }
+  if (dpsm.count == 0U)
+    {
+      REG->STA |= SDMMC_STA_DATAEND;
+      dpsm.active  = 0U;
+      dpsm.rx_last = dpsm.rx;
+    }
+}
+
+/* Card to FIFO */
+static uint32_t
+sdmmc_rx_word (void)
+{
+  uint32_t w;
+
+  if ((dpsm.active == 0U) || (dpsm.rx == 0U))
+    {
+      return 0U;
+    }
+  if (card_read (&w) == 0U)
+    {
+      return 0U;
+    }
+  if (dpsm.n == 32U)
+    {
+      REG->STA |= SDMMC_STA_RXOVERR;
+      emu.overrun++;
+    }
+  else
+    {
+      dpsm.fifo[(dpsm.head + dpsm.n) % 32U] = w;
+      dpsm.n++;
+    }
+  sdmmc_data_word ();
+  return 1U;
+}
+
+/* FIFO to card */
+static uint32_t
+sdmmc_tx_word (void)
+{
+  if ((dpsm.active == 0U) || (dpsm.rx != 0U))
+    {
+      return 0U;
+    }
+  if (dpsm.n == 0U)
+    {
+      if (dpsm.bpos != 0U)
+        {
+          REG->STA |= SDMMC_STA_TXUNDERR;
+          emu.underrun++;
+        }
+      /* Block is sent when FIFO holds data */
+      return 0U;
+    }
+  card_write (dpsm.fifo[dpsm.head]);
+  dpsm.head = (dpsm.head + 1U) % 32U;
+  dpsm.n--;
+  sdmmc_data_word ();
+  return 1U;
+}
+
+/* --------------------------------------------------------------------------
+ * DMA2 streams
+ */
+
+static emu_dma_t *
+dma_of (DMA_HandleTypeDef *hdma)
+{
+  return (hdma == dma[0].h) ? &dma[0] : &dma[1];
+}
+
+/* Address of the next word and the stream advanced by one word */
+static uint32_t
+dma_word (emu_dma_t *d)
+{
+  DMA_Stream_TypeDef *s = d->h->Instance;
+  uint32_t addr;
+
+  addr = (((s->CR & (DMA_SxCR_DBM | DMA_SxCR_CT)) == (DMA_SxCR_DBM | DMA_SxCR_CT))
+          ? s->M1AR : s->M0AR) + d->off;
+
+  d->off += 4U;
+  s->NDTR--;
+
+  if ((s->CR & DMA_SxCR_PFCTRL) != 0U)
+    {
+      if (s->NDTR == 0U)
+        {
+          /* More than 65535 words under peripheral flow control */
+          emu.dma_error++;
+        }
+    }
+  else if (s->NDTR == 0U)
+    {
+      if (d->tcif != 0U)
+        {
+          /* Previous completion not yet handled */
+          emu.dma_error++;
+        }
+      d->tcif = 1U;
+      if (s->CR & DMA_SxCR_DBM)
+        {
+          s->CR  ^= DMA_SxCR_CT;
+          s->NDTR = d->ndtr;
+          d->off  = 0U;
+          emu.dma_chunks++;
+        }
+      else
+        {
+          s->CR &= ~DMA_SxCR_EN;
+        }
+    }
+
+  switch (emu_dma_target (addr))
+    {
+    case EMU_DMA_BUFFER:
+      return addr;
+    case EMU_DMA_DUMMY:
+      emu.dma_dummy++;
+      return addr;
+    default:
+      emu.dma_other++;
+      return 0U;
+    }
+}
+
+/* Peripheral flow control: last request done */
+static void
+dma_last (emu_dma_t *d)
+{
+  d->tcif = 1U;
+  d->h->Instance->CR &= ~DMA_SxCR_EN;
+}
+
+/* FIFO to memory */
+static uint32_t
+dma_rx_word (void)
+{
+  emu_dma_t *d = &dma[0];
+  DMA_Stream_TypeDef *s = d->h->Instance;
+  uint32_t addr;
+
+  /* Receive requests while the FIFO holds data of a read */
+  if (((s->CR & DMA_SxCR_EN) == 0U) || (dpsm.rx == 0U) || (dpsm.n == 0U))
+    {
+      return 0U;
+    }
+  addr = dma_word (d);
+  if (addr != 0U)
+    {
+      memcpy (mem (addr), &dpsm.fifo[dpsm.head], 4U);
+    }
+  dpsm.head = (dpsm.head + 1U) % 32U;
+  dpsm.n--;
+
+  if ((dpsm.n == 0U) && (dpsm.rx_last != 0U) && (s->CR & DMA_SxCR_PFCTRL))
+    {
+      /* Request emptying the FIFO after data end is the last one */
+      dpsm.rx_last = 0U;
+      dma_last (d);
+    }
+  return 1U;
+}
+
+/* Memory to FIFO */
+static uint32_t
+dma_tx_word (void)
+{
+  emu_dma_t *d = &dma[1];
+  DMA_Stream_TypeDef *s = d->h->Instance;
+  uint32_t addr, w;
+
+  if (((s->CR & DMA_SxCR_EN) == 0U) || (dpsm.tx_req == 0U) || (dpsm.n == 32U))
+    {
+      return 0U;
+    }
+  if ((s->CR & DMA_SxCR_PFCTRL) && (dpsm.fed >= dpsm.words))
+    {
+      return 0U;
+    }
+
+  if (dpsm.fed >= dpsm.words)
+    {
+      /* SDMMC keeps requesting while its FIFO has space */
+      emu.dma_overfeed++;
+      addr = (((s->CR & (DMA_SxCR_DBM | DMA_SxCR_CT)) == (DMA_SxCR_DBM | DMA_SxCR_CT))
+              ? s->M1AR : s->M0AR) + d->off;
+      if (emu_dma_target (addr) != EMU_DMA_DUMMY)
+        {
+          emu.dma_stale++;
+        }
+    }
+
+  w = 0U;
+  addr = dma_word (d);
+  if (addr != 0U)
+    {
+      memcpy (&w, mem (addr), 4U);
+    }
+  dpsm.fifo[(dpsm.head + dpsm.n) % 32U] = w;
+  dpsm.n++;
+  dpsm.fed++;
+
+  if ((s->CR & DMA_SxCR_PFCTRL) && (dpsm.fed == dpsm.words))
+    {
+      dma_last (d);
+    }
+  return 1U;
+}
+
+static void
+dma_enable (emu_dma_t *d)
+{
+  DMA_Stream_TypeDef *s = d->h->Instance;
+
+  d->tcif = 0U;
+  d->teif = 0U;
+  d->off  = 0U;
+  if (s->CR & DMA_SxCR_PFCTRL)
+    {
+      /* NDTR is forced to 0xFFFF under peripheral flow control */
+      s->NDTR = 0xFFFFU;
+    }
+  d->ndtr = s->NDTR;
+  s->CR  |= DMA_SxCR_TCIE | DMA_SxCR_TEIE | DMA_SxCR_DMEIE | DMA_SxCR_EN;
+}
+
+/* Source and destination of a stream by direction */
+static void
+dma_config (DMA_HandleTypeDef *hdma, uint32_t src, uint32_t dst, uint32_t len)
+{
+  DMA_Stream_TypeDef *s = hdma->Instance;
+
+  s->NDTR = len;
+  if ((s->CR & DMA_SxCR_DIR) == DMA_SxCR_DIR_0)
+    {
+      s->PAR  = dst;
+      s->M0AR = src;
+    }
+  else
+    {
+      s->PAR  = src;
+      s->M0AR = dst;
+    }
+  if (s->PAR != (uint32_t) (uintptr_t) &REG->FIFO)
+    {
+      emu.dma_error++;
+    }
+}
+
+HAL_StatusTypeDef
+HAL_DMA_Start_IT (DMA_HandleTypeDef *hdma, uint32_t SrcAddress,
+                  uint32_t DstAddress, uint32_t DataLength)
+{
+  if (hdma->State != HAL_DMA_STATE_READY)
+    {
+      return HAL_BUSY;
+    }
+  hdma->State     = HAL_DMA_STATE_BUSY;
+  hdma->ErrorCode = HAL_DMA_ERROR_NONE;
+
+  hdma->Instance->CR &= ~DMA_SxCR_DBM;
+  dma_config (hdma, SrcAddress, DstAddress, DataLength);
+  dma_enable (dma_of (hdma));
+
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef
+HAL_DMAEx_MultiBufferStart_IT (DMA_HandleTypeDef *hdma, uint32_t SrcAddress,
+                               uint32_t DstAddress, uint32_t SecondMemAddress,
+                               uint32_t DataLength)
+{
+  if ((hdma->XferCpltCallback == NULL) || (hdma->XferM1CpltCallback == NULL)
+      || (hdma->XferErrorCallback == NULL))
+    {
+      hdma->ErrorCode = HAL_DMA_ERROR_PARAM;
+      return HAL_ERROR;
+    }
+  if (hdma->State != HAL_DMA_STATE_READY)
+    {
+      return HAL_BUSY;
+    }
+  hdma->State     = HAL_DMA_STATE_BUSY;
+  hdma->ErrorCode = HAL_DMA_ERROR_NONE;
+
+  hdma->Instance->CR  |= DMA_SxCR_DBM;
+  hdma->Instance->M1AR = SecondMemAddress;
+  dma_config (hdma, SrcAddress, DstAddress, DataLength);
+  dma_enable (dma_of (hdma));
+
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef
+HAL_DMAEx_ChangeMemory (DMA_HandleTypeDef *hdma, uint32_t Address,
+                        HAL_DMA_MemoryTypeDef memory)
+{
+  DMA_Stream_TypeDef *s = hdma->Instance;
+  emu_dma_t *d = dma_of (hdma);
+
+  if ((s->CR & DMA_SxCR_EN) && (((s->CR & DMA_SxCR_CT) ? MEMORY1 : MEMORY0) == memory))
+    {
+      /* Address of the current target: stream stops with transfer error */
+      emu.dma_error++;
+      s->CR  &= ~DMA_SxCR_EN;
+      d->teif = 1U;
+      return HAL_OK;
+    }
+  if (memory == MEMORY0)
+    {
+      s->M0AR = Address;
+    }
+  else
+    {
+      s->M1AR = Address;
+    }
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef
+HAL_DMA_Abort (DMA_HandleTypeDef *hdma)
+{
+  emu_dma_t *d = dma_of (hdma);
+
+  hdma->Instance->CR &= ~(DMA_SxCR_TCIE | DMA_SxCR_TEIE | DMA_SxCR_DMEIE
+                          | DMA_SxCR_HTIE | DMA_SxCR_EN);
+  d->tcif = 0U;
+  d->teif = 0U;
+  hdma->State = HAL_DMA_STATE_READY;
+
+  return HAL_OK;
+}
+
+void
+HAL_DMA_IRQHandler (DMA_HandleTypeDef *hdma)
+{
+  DMA_Stream_TypeDef *s = hdma->Instance;
+  emu_dma_t *d = dma_of (hdma);
+
+  if ((d->teif != 0U) && (s->CR & DMA_SxCR_TEIE))
+    {
+      s->CR &= ~DMA_SxCR_TEIE;
+      d->teif = 0U;
+      hdma->ErrorCode |= HAL_DMA_ERROR_TE;
+    }
+
+  if ((d->tcif != 0U) && (s->CR & DMA_SxCR_TCIE))
+    {
+      d->tcif = 0U;
+      if (s->CR & DMA_SxCR_DBM)
+        {
+          /* Current target after the switch tells which one completed */
+          if ((s->CR & DMA_SxCR_CT) == 0U)
+            {
+              if (hdma->XferM1CpltCallback != NULL)
+                {
+                  hdma->XferM1CpltCallback (hdma);
+                }
+            }
+          else if (hdma->XferCpltCallback != NULL)
+            {
+              hdma->XferCpltCallback (hdma);
+            }
+        }
+      else
+        {
+          s->CR &= ~DMA_SxCR_TCIE;
+          hdma->State = HAL_DMA_STATE_READY;
+          if (hdma->XferCpltCallback != NULL)
+            {
+              hdma->XferCpltCallback (hdma);
+            }
+        }
+    }
+
+  if (hdma->ErrorCode != HAL_DMA_ERROR_NONE)
+    {
+      if (hdma->ErrorCode & HAL_DMA_ERROR_TE)
+        {
+          s->CR &= ~DMA_SxCR_EN;
+          hdma->State = HAL_DMA_STATE_READY;
+        }
+      if (hdma->XferErrorCallback != NULL)
+        {
+          hdma->XferErrorCallback (hdma);
+        }
+    }
+}
+
+static uint32_t
+dma_pending (emu_dma_t *d)
+{
+  DMA_Stream_TypeDef *s = d->h->Instance;
+
+  return ((d->tcif && (s->CR & DMA_SxCR_TCIE))
+          || (d->teif && (s->CR & DMA_SxCR_TEIE))) ? 1U : 0U;
+}
+
+/* CubeMX generated MSP: DMA2 stream configuration of HAL_DMA_Init */
+void
+HAL_SD_MspInit (SD_HandleTypeDef *hsd)
+{
+  (void) hsd;
+
+  emu_stream[0].CR = DMA_SxCR_PFCTRL | DMA_SxCR_MINC | DMA_SxCR_PSIZE_1
+      | DMA_SxCR_MSIZE_1 | DMA_SxCR_PBURST_0 | DMA_SxCR_MBURST_0;
+  emu_stream[1].CR = emu_stream[0].CR | DMA_SxCR_DIR_0;
+
+  hdma_sdmmc1_rx.State = HAL_DMA_STATE_READY;
+  hdma_sdmmc1_tx.State = HAL_DMA_STATE_READY;
+}
+
+void
+HAL_SD_MspDeInit (SD_HandleTypeDef *hsd)
+{
+  (void) hsd;
+
+  emu_stream[0].CR = 0U;
+  emu_stream[1].CR = 0U;
+
+  hdma_sdmmc1_rx.State = HAL_DMA_STATE_RESET;
+  hdma_sdmmc1_tx.State = HAL_DMA_STATE_RESET;
+}
+
+/* --------------------------------------------------------------------------
+ * Emulator
+ */
+
+static void
+emu_tick (int sig)
+{
+  uint32_t i, k, m, moved;
+
+  (void) sig;
+
+  emu.ticks++;
+
+  sdmmc_icr ();
+  sdmmc_command ();
+  sdmmc_data_control ();
+
+  if ((card.state == CARD_PRG) && ((card.prg == 0U) || (--card.prg == 0U)))
+    {
+      card.state = CARD_TRAN;
+    }
+
+  moved = 0U;
+  for (i = 0U; i < emu.words; i++)
+    {
+      /* DMA bursts of 4 words are faster than the bus: the TX FIFO runs
+         full, the RX FIFO is emptied */
+      m = 0U;
+      for (k = 0U; k < 4U; k++)
+        {
+          m |= dma_rx_word () | dma_tx_word ();
+        }
+      if ((m | sdmmc_rx_word () | sdmmc_tx_word ()) == 0U)
+        {
+          break;
+        }
+      moved = 1U;
+    }
+
+  if (moved != 0U)
+    {
+      dpsm.idle = 0U;
+    }
+  else if ((dpsm.active != 0U) && (++dpsm.idle == DATA_TIMEOUT))
+    {
+      REG->STA |= SDMMC_STA_DTIMEOUT;
+      dpsm.active = 0U;
+    }
+
+  /* Interrupts */
+  for (i = 0U; i < 16U; i++)
+    {
+      sdmmc_icr ();
+      if (REG->STA & REG->MASK)
+        {
+          SDMMC1_IRQHandler ();
+        }
+      else if (dma_pending (&dma[0]))
+        {
+          HAL_DMA_IRQHandler (dma[0].h);
+        }
+      else if (dma_pending (&dma[1]))
+        {
+          HAL_DMA_IRQHandler (dma[1].h);
+        }
+      else
+        {
+          break;
+        }
+    }
+}
+
+void
+emu_start (uint32_t period_us)
+{
+  struct sigaction sa;
+  struct itimerval it;
+
+  hdma_sdmmc1_rx.Instance = &emu_stream[0];
+  hdma_sdmmc1_tx.Instance = &emu_stream[1];
+  dma[0].h = &hdma_sdmmc1_rx;
+  dma[1].h = &hdma_sdmmc1_tx;
+
+  if (emu.words == 0U)
+    {
+      emu.words = 32U;
+    }
+  emu_sdmmc_reset ();
+  emu_card_reset ();
+
+  memset (&sa, 0, sizeof (sa));
+  sa.sa_handler = emu_tick;
+  sa.sa_flags   = SA_RESTART;
+  sigemptyset (&sa.sa_mask);
+  sigaction (SIGALRM, &sa, NULL);
+
+  it.it_interval.tv_sec  = 0;
+  it.it_interval.tv_usec = (suseconds_t) period_us;
+  it.it_value            = it.it_interval;
+  setitimer (ITIMER_REAL, &it, NULL);
+}
+
+void
+emu_stop (void)
+{
+  struct itimerval it;
+
+  memset (&it, 0, sizeof (it));
+  setitimer (ITIMER_REAL, &it, NULL);
+}
+
+/* Clear statistics counters and command log */
+void
+emu_clear (void)
+{
+  uint32_t primask;
+
+  primask = __get_PRIMASK ();
+  __disable_irq ();
+
+  memset (&emu.bad_cmd, 0, sizeof (emu) - offsetof (emu_t, bad_cmd));
+  log_cnt = 0U;
+
+  __set_PRIMASK (primask);
+}
+
+/* Commands since last call; repeated CMD13 polls are listed once */
+const char *
+emu_log (void)
+{
+  const emu_log_t *e;
+  uint32_t i, n, primask;
+
+  primask = __get_PRIMASK ();
+  __disable_irq ();
+
+  n = 0U;
+  log_str[0] = '\0';
+  for (i = 0U; (i < log_cnt) && (n < (sizeof (log_str) - 32U)); i++)
+    {
+      e = &log_buf[i];
+      if ((i != 0U) && (e->cmd == 13U) && (e->app == 0U)
+          && (log_buf[i - 1U].cmd == 13U) && (log_buf[i - 1U].app == 0U))
+        {
+          continue;
+        }
+      n += (uint32_t) snprintf (&log_str[n], sizeof (log_str) - n, "%s%c%u",
+                                (n != 0U) ? " " : "", e->app ? 'a' : 'c',
+                                (unsigned) e->cmd);
+      if (e->app != 0U)
+        {
+          if (e->cmd == 23U)
+            {
+              n += (uint32_t) snprintf (&log_str[n], sizeof (log_str) - n,
+                                        ":%u", (unsigned) e->arg);
+            }
+          continue;
+        }
+      switch (e->cmd)
+        {
+        case 6:
+          n += (uint32_t) snprintf (&log_str[n], sizeof (log_str) - n, ":%08x",
+                                    (unsigned) e->arg);
+          break;
+        case 23:
+          n += (uint32_t) snprintf (&log_str[n], sizeof (log_str) - n, ":%u",
+                                    (unsigned) e->arg);
+          break;
+        case 17:
+        case 18:
+        case 24:
+        case 25:
+          n += (uint32_t) snprintf (&log_str[n], sizeof (log_str) - n,
+                                    ":%u/%u", (unsigned) e->arg,
+                                    (unsigned) e->blocks);
+          break;
+        default:
+          break;
+        }
+    }
+  log_cnt = 0U;
+
+  __set_PRIMASK (primask);
+
+  return log_str;
+}
@@ -0,0 +1,77 @@
+/*
+ * SDMMC1, DMA and SD card emulator for host tests of the MCI driver.
+ */
+
+#ifndef EMU_H
+#define EMU_H
+
+#include <stdint.h>
+
+#include "MCI_STM32F7xx.h"
+
+/* DMA access classes (emu_dma_target) */
+#define EMU_DMA_BUFFER          0U      // Driver transfer buffer
+#define EMU_DMA_DUMMY           1U      // Parked double buffer target
+#define EMU_DMA_OTHER           2U      // Anything else (not accessed)
+
+/* Card storage */
+typedef struct
+{
+  void (*read)  (uint32_t sector, uint8_t *buf);
+  void (*write) (uint32_t sector, const uint8_t *buf);
+} emu_storage_t;
+
+typedef struct
+{
+  /* Card options */
+  const emu_storage_t *storage;         // Sector storage
+  uint32_t sectors;                     // Capacity in 512-byte sectors
+  uint32_t byte_addr;                   // Standard capacity card (byte address)
+  uint32_t hs_support;                  // High speed function supported (CMD6)
+  uint32_t hs_fail;                     // Data corrupted above 25 MHz even in HS
+  uint32_t prg_ticks;                   // Programming time after write (ticks)
+  uint32_t fail_cmd;                    // Command index that times out once
+  uint32_t fail_block;                  // Data block (from 1) with CRC error once
+
+  /* Emulator options */
+  uint32_t words;                       // Bus words per tick
+
+  /* Statistics */
+  uint32_t ticks;                       // Emulator ticks
+  uint32_t hs;                          // Card switched to high speed
+  uint32_t commands;                    // Commands received by the card
+  uint32_t bad_cmd;                     // Commands illegal in card state
+  uint32_t out_of_range;                // Block access beyond capacity
+  uint32_t corrupt;                     // Data words corrupted on the bus
+  uint32_t blocks_read;                 // Blocks read from storage
+  uint32_t blocks_written;              // Blocks written to storage
+  uint32_t lost;                        // Write data without write command
+  uint32_t overrun;                     // SDMMC RX FIFO overruns
+  uint32_t underrun;                    // SDMMC TX FIFO underruns
+  uint32_t dma_chunks;                  // Double buffer target switches
+  uint32_t dma_dummy;                   // Words moved from/to parked target
+  uint32_t dma_other;                   // Words outside transfer buffer
+  uint32_t dma_overfeed;                // TX words beyond data length
+  uint32_t dma_stale;                   // Overfed words not from parked target
+  uint32_t dma_error;                   // Illegal stream programming
+  uint32_t cache_ops;                   // D-Cache maintenance calls
+} emu_t;
+
+extern emu_t emu;
+
+extern ARM_DRIVER_MCI Driver_MCI0;
+
+void emu_start (uint32_t period_us);
+void emu_stop (void);
+void emu_clear (void);
+void emu_card_reset (void);
+const char *emu_log (void);
+
+/* Driver interrupt handler */
+void SDMMC1_IRQHandler (void);
+
+/* Driver internals (driver.c) */
+MCI_CACHE_INFO *emu_cache_info (void);
+uint32_t emu_dma_target (uint32_t addr);
+
+#endif /* EMU_H */
@@ -0,0 +1,811 @@
+/*
+ * Host test of the STM32F7xx MCI driver (CMSIS/Driver/MCI_STM32F7xx.c)
+ * against the SDMMC1, DMA and SD card emulator (emu.c).
+ *
+ * The card is identified and selected with the CMSIS-Driver API, then the
+ * driver extensions are run against it and checked by the commands the
+ * card received (emu_log), the data in the card storage and the emulator
+ * counters (bus corruption, FIFO overruns/underruns, DMA accesses outside
+ * the transfer buffer):
+ *  - direct transfers (SetupTransfer + SendCommand);
+ *  - request queue: mixed reads and writes, CMD23 block count or CMD12
+ *    stop, ACMD23 pre-erase, CMD13 polling, completion order, command
+ *    timeout and data CRC error recovery;
+ *  - CMD6 high speed switch: unsupported, unstable at 48 MHz, success;
+ *  - DMA double buffer mode above 64 KB: chunk counts with and without a
+ *    shorter final chunk, direct and queued, read and write;
+ *  - block cache: write-back coalescing into pre-erased multiple block
+ *    writes, runs split at gaps and erase block boundaries, eviction,
+ *    read-ahead of sequential reads, dirty lines on staged reads, SDSC
+ *    byte addresses;
+ *  - D-Cache: unaligned reads through the bounce buffer.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "emu.h"
+
+#define SECTORS         4096U           // Card capacity (2 MB)
+#define MAX_BLOCKS      512U            // Largest transfer in blocks
+#define TIMEOUT         250000U         // Wait limit in emulator ticks (5 s)
+
+#define CARD_TRAN       4U              // CURRENT_STATE tran
+
+/* Control argument: static objects have 32-bit addresses (no PIE) */
+#define ADDR(p)         ((uint32_t) (uintptr_t) (p))
+
+/* Card storage and transfer buffers (static: DMA addresses are 32-bit) */
+static uint8_t disk[SECTORS][512];
+static uint8_t buf[(MAX_BLOCKS * 512U) + 64U] __attribute__ ((aligned (32)));
+static uint8_t ref[MAX_BLOCKS * 512U];
+
+static MCI_REQUEST req[8];
+static MCI_HS_SWITCH hs;
+static uint8_t hs_buf[1024] __attribute__ ((aligned (32)));
+
+static MCI_CACHE_CONFIG cfg;
+static MCI_CACHE_IO io;
+static uint8_t cache_mem[(16U * 512U) + (16U * (512U + sizeof (MCI_CACHE_LINE)))]
+  __attribute__ ((aligned (32)));
+
+static ARM_DRIVER_MCI *drv = &Driver_MCI0;
+
+static volatile uint32_t events;        // Driver events since last command
+static uint32_t rca;                    // Relative card address
+static uint32_t order[8];               // Request completion order
+static volatile uint32_t done_cnt;
+static uint32_t failed;
+
+#define CHECK(cond, ...)                                                \
+  do                                                                    \
+    {                                                                   \
+      if (!(cond))                                                      \
+        {                                                               \
+          printf ("  %s:%d: ", __func__, __LINE__);                     \
+          printf (__VA_ARGS__);                                         \
+          printf ("\n");                                                \
+          failed++;                                                     \
+        }                                                               \
+    }                                                                   \
+  while (0)
+
+/* Card storage */
+static void
+disk_read (uint32_t sector, uint8_t *data)
+{
+  memcpy (data, disk[sector], 512U);
+}
+
+static void
+disk_write (uint32_t sector, const uint8_t *data)
+{
+  memcpy (disk[sector], data, 512U);
+}
+
+static const emu_storage_t storage = { disk_read, disk_write };
+
+/* Data pattern of sector s, generation g */
+static void
+pattern (uint8_t *p, uint32_t s, uint32_t g)
+{
+  uint32_t i;
+
+  for (i = 0U; i < 512U; i++)
+    {
+      p[i] = (uint8_t) ((s * 31U) + (g * 101U) + (i * 7U) + (i >> 8));
+    }
+}
+
+static void
+pattern_n (uint8_t *p, uint32_t s, uint32_t n, uint32_t g)
+{
+  uint32_t i;
+
+  for (i = 0U; i < n; i++)
+    {
+      pattern (&p[i * 512U], s + i, g);
+    }
+}
+
+/* Compare n sectors with card storage, returns first differing sector + 1 */
+static uint32_t
+disk_cmp (const uint8_t *p, uint32_t s, uint32_t n)
+{
+  uint32_t i;
+
+  for (i = 0U; i < n; i++)
+    {
+      if (memcmp (&p[i * 512U], disk[s + i], 512U) != 0)
+        {
+          return i + 1U;
+        }
+    }
+  return 0U;
+}
+
+static uint32_t
+ticks (void)
+{
+  return *(volatile uint32_t *) &emu.ticks;
+}
+
+static void
+signal_event (uint32_t event)
+{
+  events |= event;
+}
+
+static uint32_t
+wait_event (uint32_t mask)
+{
+  uint32_t t0;
+
+  t0 = ticks ();
+  while (((events & mask) == 0U) && ((ticks () - t0) < TIMEOUT))
+    {
+    }
+  return events;
+}
+
+/* Direct command, returns execution status */
+static int32_t
+command (uint32_t cmd, uint32_t arg, uint32_t flags, uint32_t *rsp)
+{
+  int32_t status;
+
+  events = 0U;
+  status = drv->SendCommand (cmd, arg, flags, rsp);
+  if (status != ARM_DRIVER_OK)
+    {
+      return status;
+    }
+  if (wait_event (ARM_MCI_EVENT_COMMAND_COMPLETE | ARM_MCI_EVENT_COMMAND_TIMEOUT
+                  | ARM_MCI_EVENT_COMMAND_ERROR) & ARM_MCI_EVENT_COMMAND_COMPLETE)
+    {
+      return ARM_DRIVER_OK;
+    }
+  return ARM_DRIVER_ERROR;
+}
+
+/* Poll CMD13 until the card is back in tran state */
+static int32_t
+wait_tran (void)
+{
+  uint32_t rsp, i;
+
+  for (i = 0U; i < 1000U; i++)
+    {
+      if (command (13U, rca << 16, ARM_MCI_RESPONSE_SHORT | ARM_MCI_RESPONSE_CRC,
+                   &rsp) != ARM_DRIVER_OK)
+        {
+          return ARM_DRIVER_ERROR;
+        }
+      if (((rsp >> 9) & 0xFU) == CARD_TRAN)
+        {
+          return ARM_DRIVER_OK;
+        }
+    }
+  return ARM_DRIVER_ERROR_TIMEOUT;
+}
+
+/* Direct transfer: open-ended multiple block transfers end with CMD12 */
+static int32_t
+transfer (uint32_t sector, uint8_t *data, uint32_t n, uint32_t mode)
+{
+  uint32_t cmd, rsp;
+  int32_t status;
+
+  status = drv->SetupTransfer (data, n, 512U, mode);
+  if (status != ARM_DRIVER_OK)
+    {
+      return status;
+    }
+  if (mode & ARM_MCI_TRANSFER_WRITE)
+    {
+      cmd = (n > 1U) ? 25U : 24U;
+    }
+  else
+    {
+      cmd = (n > 1U) ? 18U : 17U;
+    }
+  if (command (cmd, sector, ARM_MCI_RESPONSE_SHORT | ARM_MCI_RESPONSE_CRC
+               | ARM_MCI_TRANSFER_DATA, &rsp) != ARM_DRIVER_OK)
+    {
+      return ARM_DRIVER_ERROR;
+    }
+  if ((wait_event (ARM_MCI_EVENT_TRANSFER_COMPLETE | ARM_MCI_EVENT_TRANSFER_TIMEOUT
+                   | ARM_MCI_EVENT_TRANSFER_ERROR)
+       & ARM_MCI_EVENT_TRANSFER_COMPLETE) == 0U)
+    {
+      status = ARM_DRIVER_ERROR;
+    }
+  if ((n > 1U) && (command (12U, 0U, ARM_MCI_RESPONSE_SHORT_BUSY
+                            | ARM_MCI_RESPONSE_CRC, &rsp) != ARM_DRIVER_OK))
+    {
+      status = ARM_DRIVER_ERROR;
+    }
+  if ((mode & ARM_MCI_TRANSFER_WRITE) && (wait_tran () != ARM_DRIVER_OK))
+    {
+      status = ARM_DRIVER_ERROR;
+    }
+  return status;
+}
+
+static void
+request_done (MCI_REQUEST *r)
+{
+  if (done_cnt < (sizeof (order) / sizeof (order[0])))
+    {
+      order[done_cnt] = (uint32_t) (r - req);
+    }
+  done_cnt++;
+}
+
+static void
+request (MCI_REQUEST *r, uint32_t cmd, uint32_t arg, uint8_t *data,
+         uint32_t n, uint32_t sbc, uint32_t pre_erase)
+{
+  memset (r, 0, sizeof (*r));
+  r->cmd         = cmd;
+  r->arg         = arg;
+  r->data        = data;
+  r->block_count = n;
+  r->block_size  = 512U;
+  r->mode        = ((cmd == 24U) || (cmd == 25U)) ? ARM_MCI_TRANSFER_WRITE
+                                                  : ARM_MCI_TRANSFER_READ;
+  r->sbc         = sbc;
+  r->rca         = rca;
+  r->pre_erase   = pre_erase;
+  r->cb_done     = request_done;
+}
+
+static int32_t
+request_wait (MCI_REQUEST *r)
+{
+  uint32_t t0;
+
+  t0 = ticks ();
+  while ((*(volatile int32_t *) &r->status == ARM_DRIVER_ERROR_BUSY)
+         && ((ticks () - t0) < TIMEOUT))
+    {
+    }
+  return r->status;
+}
+
+/* Queue request and wait for its completion */
+static int32_t
+queue (MCI_REQUEST *r)
+{
+  int32_t status;
+
+  status = drv->Control (ARM_MCI_QUEUE_REQUEST, ADDR (r));
+  if (status != ARM_DRIVER_OK)
+    {
+      return status;
+    }
+  return request_wait (r);
+}
+
+static void
+check_log (const char *func, int line, const char *expect)
+{
+  const char *log;
+
+  log = emu_log ();
+  if (strcmp (log, expect) != 0)
+    {
+      printf ("  %s:%d: commands\n    got:      %s\n    expected: %s\n",
+              func, line, log, expect);
+      failed++;
+    }
+}
+
+#define CHECK_LOG(expect)       check_log (__func__, __LINE__, expect)
+
+/* Emulator counters that must stay zero */
+static void
+check_emu (const char *func, int line)
+{
+  if ((emu.bad_cmd | emu.out_of_range | emu.corrupt | emu.lost | emu.overrun
+       | emu.underrun | emu.dma_other | emu.dma_stale | emu.dma_error) != 0U)
+    {
+      printf ("  %s:%d: bad_cmd %u out_of_range %u corrupt %u lost %u "
+              "overrun %u underrun %u dma_other %u dma_stale %u dma_error %u\n",
+              func, line, (unsigned) emu.bad_cmd, (unsigned) emu.out_of_range,
+              (unsigned) emu.corrupt, (unsigned) emu.lost,
+              (unsigned) emu.overrun, (unsigned) emu.underrun,
+              (unsigned) emu.dma_other, (unsigned) emu.dma_stale,
+              (unsigned) emu.dma_error);
+      failed++;
+    }
+  emu_clear ();
+}
+
+#define CHECK_EMU()             check_emu (__func__, __LINE__)
+
+/* Identification, selection, 4-bit bus at 24 MHz */
+static void
+test_init (void)
+{
+  uint32_t rsp[4], i;
+
+  CHECK (drv->Initialize (signal_event) == ARM_DRIVER_OK, "Initialize");
+  CHECK (drv->PowerControl (ARM_POWER_FULL) == ARM_DRIVER_OK, "PowerControl");
+  CHECK (drv->Control (ARM_MCI_BUS_SPEED, 400000U) == 400000,
+         "identification bus speed");
+
+  CHECK (command (0U, 0U, ARM_MCI_CARD_INITIALIZE | ARM_MCI_RESPONSE_NONE,
+                  NULL) == ARM_DRIVER_OK, "CMD0");
+  CHECK (command (8U, 0x1AAU, ARM_MCI_RESPONSE_SHORT | ARM_MCI_RESPONSE_CRC,
+                  rsp) == ARM_DRIVER_OK, "CMD8");
+  CHECK (rsp[0] == 0x1AAU, "CMD8 echo 0x%08X", (unsigned) rsp[0]);
+
+  for (i = 0U; i < 10U; i++)
+    {
+      CHECK (command (55U, 0U, ARM_MCI_RESPONSE_SHORT | ARM_MCI_RESPONSE_CRC,
+                      rsp) == ARM_DRIVER_OK, "CMD55");
+      /* R3 has no CRC: the driver reports the response without CRC check */
+      CHECK (command (41U, 0x40FF8000U, ARM_MCI_RESPONSE_SHORT, rsp)
+             == ARM_DRIVER_OK, "ACMD41");
+      if (rsp[0] & 0x80000000U)
+        {
+          break;
+        }
+    }
+  CHECK (rsp[0] == 0xC0FF8000U, "OCR 0x%08X", (unsigned) rsp[0]);
+
+  CHECK (command (2U, 0U, ARM_MCI_RESPONSE_LONG | ARM_MCI_RESPONSE_CRC, rsp)
+         == ARM_DRIVER_OK, "CMD2");
+  CHECK ((rsp[0] == 0x87654321U) && (rsp[3] == 0x12345678U), "CID");
+  CHECK (command (3U, 0U, ARM_MCI_RESPONSE_SHORT | ARM_MCI_RESPONSE_CRC, rsp)
+         == ARM_DRIVER_OK, "CMD3");
+  rca = rsp[0] >> 16;
+  CHECK (command (7U, rca << 16, ARM_MCI_RESPONSE_SHORT_BUSY
+                  | ARM_MCI_RESPONSE_CRC, rsp) == ARM_DRIVER_OK, "CMD7");
+  CHECK (command (55U, rca << 16, ARM_MCI_RESPONSE_SHORT | ARM_MCI_RESPONSE_CRC,
+                  rsp) == ARM_DRIVER_OK, "CMD55");
+  CHECK (command (6U, 2U, ARM_MCI_RESPONSE_SHORT | ARM_MCI_RESPONSE_CRC, rsp)
+         == ARM_DRIVER_OK, "ACMD6");
+
+  CHECK (drv->Control (ARM_MCI_BUS_DATA_WIDTH, ARM_MCI_BUS_DATA_WIDTH_4)
+         == ARM_DRIVER_OK, "bus width");
+  CHECK (drv->Control (ARM_MCI_BUS_SPEED, 25000000U) == 24000000,
+         "default speed bus");
+
+  CHECK_LOG ("c0 c8 c55 a41 c55 a41 c55 a41 c2 c3 c7 c55 a6");
+  CHECK_EMU ();
+}
+
+static void
+test_direct (void)
+{
+  CHECK (transfer (5U, buf, 1U, ARM_MCI_TRANSFER_READ) == ARM_DRIVER_OK, "CMD17");
+  CHECK (disk_cmp (buf, 5U, 1U) == 0U, "CMD17 data");
+
+  CHECK (transfer (10U, buf, 8U, ARM_MCI_TRANSFER_READ) == ARM_DRIVER_OK, "CMD18");
+  CHECK (disk_cmp (buf, 10U, 8U) == 0U, "CMD18 data");
+
+  pattern_n (buf, 100U, 4U, 1U);
+  CHECK (transfer (100U, buf, 4U, ARM_MCI_TRANSFER_WRITE) == ARM_DRIVER_OK, "CMD25");
+  CHECK (disk_cmp (buf, 100U, 4U) == 0U, "CMD25 data");
+
+  pattern_n (buf, 104U, 1U, 1U);
+  CHECK (transfer (104U, buf, 1U, ARM_MCI_TRANSFER_WRITE) == ARM_DRIVER_OK, "CMD24");
+  CHECK (disk_cmp (buf, 104U, 1U) == 0U, "CMD24 data");
+
+  CHECK_LOG ("c17:5/1 c18:10/8 c12 c25:100/4 c12 c13 c24:104/1 c13");
+  CHECK_EMU ();
+}
+
+/* Six requests queued at once complete in order with their own commands */
+static void
+test_queue (void)
+{
+  static const uint32_t expect[6] = { 0U, 1U, 2U, 3U, 4U, 5U };
+  uint32_t i;
+
+  pattern_n (ref, 300U, 4U, 2U);
+  pattern_n (&ref[4U * 512U], 301U, 1U, 3U);
+  pattern_n (&ref[5U * 512U], 302U, 2U, 4U);
+
+  request (&req[0], 18U, 200U, &buf[0], 8U, 1U, 0U);
+  request (&req[1], 25U, 300U, &ref[0], 4U, 1U, 4U);
+  request (&req[2], 17U, 7U, &buf[8U * 512U], 1U, 0U, 0U);
+  request (&req[3], 24U, 301U, &ref[4U * 512U], 1U, 0U, 0U);
+  request (&req[4], 18U, 400U, &buf[9U * 512U], 3U, 0U, 0U);
+  request (&req[5], 25U, 302U, &ref[5U * 512U], 2U, 0U, 0U);
+
+  /* Writes of request 1 and 3 overlap at sector 301: order matters */
+  done_cnt = 0U;
+  for (i = 0U; i < 6U; i++)
+    {
+      CHECK (drv->Control (ARM_MCI_QUEUE_REQUEST, ADDR (&req[i]))
+             == ARM_DRIVER_OK, "queue request %u", (unsigned) i);
+    }
+  /* Direct access is refused while the engine runs */
+  CHECK ((request_wait (&req[5]) == ARM_DRIVER_OK) && (done_cnt == 6U),
+         "requests not completed");
+
+  for (i = 0U; i < 6U; i++)
+    {
+      CHECK (req[i].status == ARM_DRIVER_OK, "request %u status %d",
+             (unsigned) i, (int) req[i].status);
+      CHECK (order[i] == expect[i], "completion %u: request %u",
+             (unsigned) i, (unsigned) order[i]);
+    }
+  CHECK (((req[0].response >> 9) & 0xFU) == CARD_TRAN, "data command response");
+  CHECK (disk_cmp (&buf[0], 200U, 8U) == 0U, "read 200");
+  CHECK (disk_cmp (&buf[8U * 512U], 7U, 1U) == 0U, "read 7");
+  CHECK (disk_cmp (&buf[9U * 512U], 400U, 3U) == 0U, "read 400");
+  CHECK (disk_cmp (&ref[0], 300U, 1U) == 0U, "write 300");
+  CHECK (disk_cmp (&ref[4U * 512U], 301U, 1U) == 0U, "write 301");
+  CHECK (disk_cmp (&ref[2U * 512U], 302U, 2U) != 0U, "write 302 order");
+  CHECK (disk_cmp (&ref[5U * 512U], 302U, 2U) == 0U, "write 302");
+
+  CHECK_LOG ("c23:8 c18:200/8 c55 a23:4 c23:4 c25:300/4 c13 c17:7/1 "
+             "c24:301/1 c13 c18:400/3 c12 c25:302/2 c12 c13");
+  CHECK_EMU ();
+}
+
+/* Failed requests report an error, the card is left in tran state */
+static void
+test_queue_error (void)
+{
+  /* Data command times out: no CMD12, next request runs */
+  emu.fail_cmd = 18U;
+  request (&req[0], 18U, 10U, buf, 4U, 0U, 0U);
+  request (&req[1], 17U, 11U, &buf[4U * 512U], 1U, 0U, 0U);
+  done_cnt = 0U;
+  CHECK (drv->Control (ARM_MCI_QUEUE_REQUEST, ADDR (&req[0])) == ARM_DRIVER_OK,
+         "queue");
+  CHECK (queue (&req[1]) == ARM_DRIVER_OK, "request after timeout");
+  CHECK (req[0].status == ARM_DRIVER_ERROR, "timeout status %d",
+         (int) req[0].status);
+  CHECK (disk_cmp (&buf[4U * 512U], 11U, 1U) == 0U, "read 11");
+  CHECK_LOG ("c18:10/0 c17:11/1");
+
+  /* CRC error in second block of a CMD23 read: stopped with CMD12 */
+  emu.fail_block = 2U;
+  request (&req[0], 18U, 20U, buf, 4U, 1U, 0U);
+  CHECK (queue (&req[0]) == ARM_DRIVER_ERROR, "read CRC error");
+  CHECK_LOG ("c23:4 c18:20/2 c12");
+
+  /* CRC error in second block of a CMD23 write: first block programmed */
+  pattern_n (ref, 500U, 4U, 5U);
+  emu.fail_block = 2U;
+  request (&req[0], 25U, 500U, ref, 4U, 1U, 0U);
+  CHECK (queue (&req[0]) == ARM_DRIVER_ERROR, "write CRC error");
+  CHECK ((disk_cmp (ref, 500U, 1U) == 0U) && (disk_cmp (&ref[512], 501U, 1U) != 0U),
+         "write CRC error data");
+  CHECK_LOG ("c23:4 c25:500/1 c12 c13");
+
+  /* Single block write with CRC error */
+  emu.fail_block = 1U;
+  request (&req[0], 24U, 502U, &ref[1024], 1U, 0U, 0U);
+  CHECK (queue (&req[0]) == ARM_DRIVER_ERROR, "CMD24 CRC error");
+  CHECK (disk_cmp (&ref[1024], 502U, 1U) != 0U, "CMD24 CRC error data");
+  CHECK_LOG ("c24:502/0 c13");
+
+  /* Card works after the errors */
+  CHECK (transfer (20U, buf, 4U, ARM_MCI_TRANSFER_READ) == ARM_DRIVER_OK, "read");
+  CHECK (disk_cmp (buf, 20U, 4U) == 0U, "read data");
+  CHECK_LOG ("c18:20/4 c12");
+  CHECK_EMU ();
+}
+
+static void
+test_high_speed (void)
+{
+  uint32_t clkcr;
+
+  hs.buf       = hs_buf;
+  hs.test_addr = 50U;
+
+  /* Function not supported: stays at default speed */
+  emu.hs_support = 0U;
+  CHECK (drv->Control (ARM_MCI_HIGH_SPEED_SWITCH, ADDR (&hs))
+         == ARM_DRIVER_ERROR_UNSUPPORTED, "unsupported");
+  CHECK_LOG ("c6:00fffff1");
+
+  /* Card switches, but data is not stable at 48 MHz: clock restored */
+  emu.hs_support = 1U;
+  emu.hs_fail    = 1U;
+  clkcr = SDMMC1->CLKCR;
+  CHECK (drv->Control (ARM_MCI_HIGH_SPEED_SWITCH, ADDR (&hs))
+         == ARM_DRIVER_ERROR, "unstable");
+  CHECK (SDMMC1->CLKCR == clkcr, "CLKCR 0x%08X not restored",
+         (unsigned) SDMMC1->CLKCR);
+  CHECK (emu.corrupt != 0U, "no corrupted data at 48 MHz");
+  CHECK_LOG ("c6:00fffff1 c17:50/1 c6:80fffff1 c17:50/1");
+  emu_clear ();
+
+  emu.hs_fail = 0U;
+  CHECK (drv->Control (ARM_MCI_HIGH_SPEED_SWITCH, ADDR (&hs)) == 48000000,
+         "switch");
+  CHECK (SDMMC1->CLKCR & SDMMC_CLKCR_BYPASS, "clock divider not bypassed");
+  CHECK ((emu.hs != 0U) && (disk_cmp (hs_buf, 50U, 1U) == 0U), "switch data");
+  CHECK_LOG ("c6:00fffff1 c17:50/1 c6:80fffff1 c17:50/1");
+
+  CHECK (transfer (60U, buf, 16U, ARM_MCI_TRANSFER_READ) == ARM_DRIVER_OK, "read");
+  CHECK (disk_cmp (buf, 60U, 16U) == 0U, "read data at 48 MHz");
+  CHECK_LOG ("c18:60/16 c12");
+  CHECK_EMU ();
+}
+
+/* Transfers above 64 KB in DMA double buffer mode */
+static void
+test_double_buffer (void)
+{
+  /* Shorter final chunk (128, 131, 500) or whole chunks (254, 381); the
+     last 128 follows a transfer that ended on memory 1 */
+  static const uint32_t blocks[] = { 128U, 131U, 254U, 381U, 500U, 128U };
+  uint32_t i, n, s, g, chunks;
+
+  s = 1024U;
+  for (i = 0U; i < (sizeof (blocks) / sizeof (blocks[0])); i++)
+    {
+      n = blocks[i];
+      g = 10U + i;
+      /* Chunk switches: one less than the number of 65024 byte chunks */
+      chunks = ((n * 512U) - 1U) / 65024U;
+
+      /* Direct write and read */
+      pattern_n (buf, s, n, g);
+      CHECK (transfer (s, buf, n, ARM_MCI_TRANSFER_WRITE) == ARM_DRIVER_OK,
+             "%u blocks: direct write", (unsigned) n);
+      CHECK (disk_cmp (buf, s, n) == 0U, "%u blocks: direct write data, sector +%u",
+             (unsigned) n, (unsigned) (disk_cmp (buf, s, n) - 1U));
+      memset (buf, 0, n * 512U);
+      CHECK (transfer (s, buf, n, ARM_MCI_TRANSFER_READ) == ARM_DRIVER_OK,
+             "%u blocks: direct read", (unsigned) n);
+      CHECK (disk_cmp (buf, s, n) == 0U, "%u blocks: direct read data, sector +%u",
+             (unsigned) n, (unsigned) (disk_cmp (buf, s, n) - 1U));
+      CHECK (emu.dma_chunks >= (2U * chunks), "%u blocks: %u chunk switches",
+             (unsigned) n, (unsigned) emu.dma_chunks);
+      /* Write in full chunks: stream overruns into the parked target */
+      CHECK (((n * 512U) % 65024U) || (emu.dma_dummy != 0U),
+             "%u blocks: parked target not used", (unsigned) n);
+      CHECK_EMU ();
+
+      /* Queued write (CMD23) and read (CMD12) */
+      pattern_n (buf, s, n, g + 1U);
+      request (&req[0], 25U, s, buf, n, 1U, 0U);
+      CHECK (queue (&req[0]) == ARM_DRIVER_OK, "%u blocks: queued write",
+             (unsigned) n);
+      CHECK (disk_cmp (buf, s, n) == 0U, "%u blocks: queued write data, sector +%u",
+             (unsigned) n, (unsigned) (disk_cmp (buf, s, n) - 1U));
+      memset (buf, 0, n * 512U);
+      request (&req[0], 18U, s, buf, n, 0U, 0U);
+      CHECK (queue (&req[0]) == ARM_DRIVER_OK, "%u blocks: queued read",
+             (unsigned) n);
+      CHECK (disk_cmp (buf, s, n) == 0U, "%u blocks: queued read data, sector +%u",
+             (unsigned) n, (unsigned) (disk_cmp (buf, s, n) - 1U));
+      CHECK_EMU ();
+      emu_log ();
+    }
+
+  /* Chunks must be a multiple of the DMA burst */
+  CHECK (drv->SetupTransfer (buf, 3000U, 24U, ARM_MCI_TRANSFER_READ)
+         == ARM_DRIVER_ERROR_UNSUPPORTED, "24 byte blocks above 64 KB");
+}
+
+static void
+cache_setup (uint32_t flags)
+{
+  cfg.mem        = cache_mem;
+  cfg.size       = sizeof (cache_mem);
+  cfg.ways       = 4U;
+  cfg.stage      = 16U;
+  cfg.read_ahead = 8U;
+  cfg.erase_size = 16U;
+  cfg.sectors    = SECTORS;
+  cfg.rca        = rca;
+  cfg.flags      = flags;
+  CHECK (drv->Control (ARM_MCI_CACHE_SETUP, ADDR (&cfg)) == ARM_DRIVER_OK,
+         "cache setup");
+  CHECK ((emu_cache_info ()->sets == 4U) && (emu_cache_info ()->ways == 4U),
+         "cache geometry");
+  emu_log ();
+}
+
+static int32_t
+cache_io (uint32_t control, uint32_t sector, uint8_t *data, uint32_t count)
+{
+  io.sector = sector;
+  io.buf    = data;
+  io.count  = count;
+  return drv->Control (control, ADDR (&io));
+}
+
+/* Write-back coalescing and eviction */
+static void
+test_cache_write (void)
+{
+  uint32_t i;
+
+  /* Consecutive dirty sectors: one pre-erased CMD23 write */
+  cache_setup (MCI_CACHE_CMD23);
+  pattern_n (ref, 1000U, 8U, 20U);
+  CHECK (cache_io (ARM_MCI_CACHE_WRITE, 1000U, ref, 8U) == ARM_DRIVER_OK, "write");
+  CHECK_LOG ("");
+  CHECK (disk_cmp (ref, 1000U, 1U) != 0U, "written through");
+  CHECK (drv->Control (ARM_MCI_CACHE_FLUSH, 0U) == ARM_DRIVER_OK, "flush");
+  CHECK (disk_cmp (ref, 1000U, 8U) == 0U, "flush data");
+  CHECK_LOG ("c55 a23:8 c23:8 c25:1000/8 c13");
+  CHECK (drv->Control (ARM_MCI_CACHE_FLUSH, 0U) == ARM_DRIVER_OK, "flush clean");
+  CHECK_LOG ("");
+
+  /* Gap: two runs, a single sector is written without ACMD23 */
+  cache_setup (MCI_CACHE_CMD23);
+  pattern_n (ref, 1010U, 4U, 21U);
+  CHECK (cache_io (ARM_MCI_CACHE_WRITE, 1010U, ref, 2U) == ARM_DRIVER_OK, "write");
+  CHECK (cache_io (ARM_MCI_CACHE_WRITE, 1013U, &ref[3U * 512U], 1U) == ARM_DRIVER_OK,
+         "write");
+  CHECK (drv->Control (ARM_MCI_CACHE_FLUSH, 0U) == ARM_DRIVER_OK, "flush");
+  CHECK ((disk_cmp (ref, 1010U, 2U) == 0U) && (disk_cmp (&ref[1536], 1013U, 1U) == 0U),
+         "flush data");
+  CHECK_LOG ("c55 a23:2 c23:2 c25:1010/2 c13 c24:1013/1 c13");
+
+  /* Run split at the erase block boundary */
+  cache_setup (MCI_CACHE_CMD23);
+  pattern_n (ref, 1020U, 8U, 22U);
+  CHECK (cache_io (ARM_MCI_CACHE_WRITE, 1020U, ref, 8U) == ARM_DRIVER_OK, "write");
+  CHECK (drv->Control (ARM_MCI_CACHE_FLUSH, 0U) == ARM_DRIVER_OK, "flush");
+  CHECK (disk_cmp (ref, 1020U, 8U) == 0U, "flush data");
+  CHECK_LOG ("c55 a23:4 c23:4 c25:1020/4 c13 c55 a23:4 c23:4 c25:1024/4 c13");
+
+  /* Fifth sector of a set evicts the least recently used dirty line,
+     which writes back the dirty sectors of its erase block */
+  cache_setup (MCI_CACHE_CMD23);
+  pattern_n (ref, 2000U, 17U, 23U);
+  for (i = 0U; i < 4U; i++)
+    {
+      CHECK (cache_io (ARM_MCI_CACHE_WRITE, 2000U + (i * 4U), &ref[i * 4U * 512U], 1U)
+             == ARM_DRIVER_OK, "write");
+    }
+  CHECK_LOG ("");
+  CHECK (cache_io (ARM_MCI_CACHE_WRITE, 2016U, &ref[16U * 512U], 1U) == ARM_DRIVER_OK,
+         "evicting write");
+  CHECK_LOG ("c24:2000/1 c13 c24:2004/1 c13 c24:2008/1 c13 c24:2012/1 c13");
+  CHECK (disk_cmp (&ref[12U * 512U], 2012U, 1U) == 0U, "evicted data");
+  CHECK (drv->Control (ARM_MCI_CACHE_FLUSH, 0U) == ARM_DRIVER_OK, "flush");
+  CHECK (disk_cmp (&ref[16U * 512U], 2016U, 1U) == 0U, "flush data");
+  CHECK_LOG ("c24:2016/1 c13");
+
+  /* Cache disabled: flushed first */
+  cache_setup (MCI_CACHE_CMD23);
+  pattern_n (ref, 2100U, 2U, 24U);
+  CHECK (cache_io (ARM_MCI_CACHE_WRITE, 2100U, ref, 2U) == ARM_DRIVER_OK, "write");
+  CHECK (drv->Control (ARM_MCI_CACHE_SETUP, 0U) == ARM_DRIVER_OK, "disable");
+  CHECK (disk_cmp (ref, 2100U, 2U) == 0U, "disable data");
+  CHECK_LOG ("c55 a23:2 c23:2 c25:2100/2 c13");
+  CHECK_EMU ();
+}
+
+/* Read-ahead and hits */
+static void
+test_cache_read (void)
+{
+  uint32_t i;
+
+  /* Single sector, then sequential: read-ahead fills the cache */
+  cache_setup (MCI_CACHE_CMD23);
+  CHECK (cache_io (ARM_MCI_CACHE_READ, 3000U, buf, 1U) == ARM_DRIVER_OK, "read");
+  CHECK_LOG ("c17:3000/1");
+  for (i = 1U; i < 9U; i++)
+    {
+      CHECK (cache_io (ARM_MCI_CACHE_READ, 3000U + i, &buf[i * 512U], 1U)
+             == ARM_DRIVER_OK, "read");
+      if (i == 1U)
+        {
+          CHECK_LOG ("c23:8 c18:3001/8");
+        }
+    }
+  CHECK_LOG ("");
+  CHECK (disk_cmp (buf, 3000U, 9U) == 0U, "read data");
+
+  /* Hits of a multiple sector read */
+  CHECK (cache_io (ARM_MCI_CACHE_READ, 3002U, buf, 4U) == ARM_DRIVER_OK, "read hit");
+  CHECK (disk_cmp (buf, 3002U, 4U) == 0U, "read hit data");
+  CHECK_LOG ("");
+
+  /* Staged read returns the dirty cached copy of a sector */
+  cache_setup (MCI_CACHE_CMD23);
+  pattern (ref, 3100U, 30U);
+  CHECK (cache_io (ARM_MCI_CACHE_WRITE, 3100U, ref, 1U) == ARM_DRIVER_OK, "write");
+  CHECK (cache_io (ARM_MCI_CACHE_READ, 3099U, buf, 4U) == ARM_DRIVER_OK, "read");
+  CHECK_LOG ("c23:8 c18:3099/8");
+  CHECK (memcmp (&buf[512], ref, 512U) == 0, "dirty sector");
+  CHECK ((disk_cmp (buf, 3099U, 1U) == 0U) && (disk_cmp (&buf[1024], 3101U, 2U) == 0U),
+         "read data");
+  CHECK (disk_cmp (ref, 3100U, 1U) != 0U, "dirty sector written");
+  CHECK (drv->Control (ARM_MCI_CACHE_FLUSH, 0U) == ARM_DRIVER_OK, "flush");
+  CHECK_LOG ("c24:3100/1 c13");
+
+  /* SDSC card: byte addresses, no CMD23 */
+  emu.byte_addr = 1U;
+  cache_setup (MCI_CACHE_BYTE_ADDR);
+  pattern_n (ref, 1500U, 2U, 31U);
+  CHECK (cache_io (ARM_MCI_CACHE_WRITE, 1500U, ref, 2U) == ARM_DRIVER_OK, "write");
+  CHECK (drv->Control (ARM_MCI_CACHE_FLUSH, 0U) == ARM_DRIVER_OK, "flush");
+  CHECK (disk_cmp (ref, 1500U, 2U) == 0U, "flush data");
+  CHECK (cache_io (ARM_MCI_CACHE_READ, 1600U, buf, 3U) == ARM_DRIVER_OK, "read");
+  CHECK (disk_cmp (buf, 1600U, 3U) == 0U, "read data");
+  CHECK_LOG ("c55 a23:2 c25:768000/2 c12 c13 c18:819200/8 c12");
+  emu.byte_addr = 0U;
+
+  CHECK (drv->Control (ARM_MCI_CACHE_SETUP, 0U) == ARM_DRIVER_OK, "disable");
+  CHECK_EMU ();
+}
+
+/* D-Cache enabled: unaligned reads go through the bounce buffer */
+static void
+test_dcache (void)
+{
+  emu_scb.CCR |= SCB_CCR_DC_Msk;
+
+  memset (buf, 0, 1024U);
+  request (&req[0], 17U, 70U, &buf[4], 1U, 0U, 0U);
+  CHECK (queue (&req[0]) == ARM_DRIVER_OK, "unaligned read");
+  CHECK (disk_cmp (&buf[4], 70U, 1U) == 0U, "unaligned read data");
+  CHECK ((buf[0] == 0U) && (buf[516] == 0U), "data outside buffer changed");
+  CHECK (emu.cache_ops != 0U, "no cache maintenance");
+
+  request (&req[0], 18U, 70U, &buf[4], 2U, 0U, 0U);
+  CHECK (queue (&req[0]) == ARM_DRIVER_ERROR_UNSUPPORTED,
+         "unaligned read above bounce buffer size");
+
+  pattern_n (&buf[4], 71U, 2U, 40U);
+  request (&req[0], 25U, 71U, &buf[4], 2U, 1U, 0U);
+  CHECK (queue (&req[0]) == ARM_DRIVER_OK, "unaligned write");
+  CHECK (disk_cmp (&buf[4], 71U, 2U) == 0U, "unaligned write data");
+  CHECK_LOG ("c17:70/1 c23:2 c25:71/2 c13");
+
+  emu_scb.CCR &= ~SCB_CCR_DC_Msk;
+  CHECK_EMU ();
+}
+
+int
+main (void)
+{
+  static const struct
+  {
+    const char *name;
+    void (*fn) (void);
+  } tests[] =
+    {
+      { "init",          test_init },
+      { "direct",        test_direct },
+      { "queue",         test_queue },
+      { "queue error",   test_queue_error },
+      { "high speed",    test_high_speed },
+      { "double buffer", test_double_buffer },
+      { "cache write",   test_cache_write },
+      { "cache read",    test_cache_read },
+      { "d-cache",       test_dcache },
+    };
+  uint32_t i, s, prev;
+
+  for (s = 0U; s < SECTORS; s++)
+    {
+      pattern (disk[s], s, 0U);
+    }
+
+  emu.storage   = &storage;
+  emu.sectors   = SECTORS;
+  emu.prg_ticks = 5U;
+  emu_start (20U);
+
+  for (i = 0U; i < (sizeof (tests) / sizeof (tests[0])); i++)
+    {
+      prev = failed;
+      tests[i].fn ();
+      printf ("%-14s %s\n", tests[i].name, (failed == prev) ? "ok" : "FAILED");
+    }
+
+  emu_stop ();
+
+  return (failed != 0U) ? 1 : 0;
+}
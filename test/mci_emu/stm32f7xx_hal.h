@@ -0,0 +1,160 @@
+/*
+ * Host build of the MCI driver: subset of the STM32F7xx HAL.
+ *
+ * The device header provides the register definitions. SDMMC1 is
+ * redirected to the register model of the emulator, the DMA and SD
+ * handle functions are implemented by the emulator (emu.c) with the
+ * semantics of the STM32Cube F7 HAL. Clock and GPIO control are no-ops.
+ */
+
+#ifndef __STM32F7xx_HAL_H
+#define __STM32F7xx_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define STM32F746xx
+#include "stm32f746xx.h"
+
+/* SDMMC1 registers of the emulator */
+extern uint32_t emu_sdmmc1[];
+
+#undef  SDMMC1
+#define SDMMC1                  ((SDMMC_TypeDef *)emu_sdmmc1)
+
+typedef enum
+{
+  HAL_OK       = 0x00U,
+  HAL_ERROR    = 0x01U,
+  HAL_BUSY     = 0x02U,
+  HAL_TIMEOUT  = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum
+{
+  HAL_UNLOCKED = 0x00U,
+  HAL_LOCKED   = 0x01U
+} HAL_LockTypeDef;
+
+/* GPIO */
+typedef enum
+{
+  GPIO_PIN_RESET = 0,
+  GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct
+{
+  uint32_t Pin;
+  uint32_t Mode;
+  uint32_t Pull;
+  uint32_t Speed;
+  uint32_t Alternate;
+} GPIO_InitTypeDef;
+
+#define GPIO_PIN_2              ((uint16_t)0x0004U)
+#define GPIO_PIN_7              ((uint16_t)0x0080U)
+#define GPIO_MODE_INPUT         0x00000000U
+#define GPIO_MODE_AF_PP         0x00000002U
+#define GPIO_MODE_AF_OD         0x00000012U
+#define GPIO_NOPULL             0x00000000U
+#define GPIO_PULLUP             0x00000001U
+#define GPIO_SPEED_HIGH         0x00000003U
+#define GPIO_AF12_SDMMC1        ((uint8_t)0x0CU)
+
+static inline void HAL_GPIO_Init (GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init)
+{ (void)GPIOx; (void)GPIO_Init; }
+static inline void HAL_GPIO_DeInit (GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin)
+{ (void)GPIOx; (void)GPIO_Pin; }
+static inline GPIO_PinState HAL_GPIO_ReadPin (GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{ (void)GPIOx; (void)GPIO_Pin; return GPIO_PIN_RESET; }
+
+/* RCC */
+uint32_t HAL_RCC_GetHCLKFreq (void);
+void     emu_sdmmc_reset (void);
+
+#define __HAL_RCC_GPIOA_CLK_ENABLE()            do { } while (0)
+#define __HAL_RCC_GPIOB_CLK_ENABLE()            do { } while (0)
+#define __HAL_RCC_GPIOC_CLK_ENABLE()            do { } while (0)
+#define __HAL_RCC_GPIOD_CLK_ENABLE()            do { } while (0)
+#define __HAL_RCC_GPIOE_CLK_ENABLE()            do { } while (0)
+#define __HAL_RCC_GPIOF_CLK_ENABLE()            do { } while (0)
+#define __HAL_RCC_GPIOG_CLK_ENABLE()            do { } while (0)
+#define __HAL_RCC_GPIOH_CLK_ENABLE()            do { } while (0)
+#define __HAL_RCC_GPIOI_CLK_ENABLE()            do { } while (0)
+#define __HAL_RCC_GPIOJ_CLK_ENABLE()            do { } while (0)
+#define __HAL_RCC_GPIOK_CLK_ENABLE()            do { } while (0)
+#define __HAL_RCC_SDMMC1_CLK_ENABLE()           do { } while (0)
+#define __HAL_RCC_SDMMC1_CLK_DISABLE()          do { } while (0)
+#define __HAL_RCC_SDMMC1_FORCE_RESET()          emu_sdmmc_reset ()
+#define __HAL_RCC_SDMMC1_RELEASE_RESET()        do { } while (0)
+
+/* DMA */
+typedef struct
+{
+  uint32_t Channel;
+  uint32_t Direction;
+  uint32_t PeriphInc;
+  uint32_t MemInc;
+  uint32_t PeriphDataAlignment;
+  uint32_t MemDataAlignment;
+  uint32_t Mode;
+  uint32_t Priority;
+  uint32_t FIFOMode;
+  uint32_t FIFOThreshold;
+  uint32_t MemBurst;
+  uint32_t PeriphBurst;
+} DMA_InitTypeDef;
+
+typedef enum
+{
+  HAL_DMA_STATE_RESET = 0x00U,
+  HAL_DMA_STATE_READY = 0x01U,
+  HAL_DMA_STATE_BUSY  = 0x02U,
+  HAL_DMA_STATE_ABORT = 0x05U
+} HAL_DMA_StateTypeDef;
+
+typedef enum
+{
+  MEMORY0 = 0x00U,
+  MEMORY1 = 0x01U
+} HAL_DMA_MemoryTypeDef;
+
+typedef struct __DMA_HandleTypeDef
+{
+  DMA_Stream_TypeDef         *Instance;
+  DMA_InitTypeDef             Init;
+  HAL_LockTypeDef             Lock;
+  __IO HAL_DMA_StateTypeDef   State;
+  void                       *Parent;
+  void (* XferCpltCallback)       (struct __DMA_HandleTypeDef *hdma);
+  void (* XferHalfCpltCallback)   (struct __DMA_HandleTypeDef *hdma);
+  void (* XferM1CpltCallback)     (struct __DMA_HandleTypeDef *hdma);
+  void (* XferM1HalfCpltCallback) (struct __DMA_HandleTypeDef *hdma);
+  void (* XferErrorCallback)      (struct __DMA_HandleTypeDef *hdma);
+  void (* XferAbortCallback)      (struct __DMA_HandleTypeDef *hdma);
+  __IO uint32_t               ErrorCode;
+} DMA_HandleTypeDef;
+
+#define HAL_DMA_ERROR_NONE      0x00000000U
+#define HAL_DMA_ERROR_TE        0x00000001U
+#define HAL_DMA_ERROR_PARAM     0x00000040U
+
+#define __HAL_DMA_GET_COUNTER(__HANDLE__)       ((__HANDLE__)->Instance->NDTR)
+
+HAL_StatusTypeDef HAL_DMA_Start_IT (DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength);
+HAL_StatusTypeDef HAL_DMA_Abort    (DMA_HandleTypeDef *hdma);
+void              HAL_DMA_IRQHandler (DMA_HandleTypeDef *hdma);
+HAL_StatusTypeDef HAL_DMAEx_MultiBufferStart_IT (DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t SecondMemAddress, uint32_t DataLength);
+HAL_StatusTypeDef HAL_DMAEx_ChangeMemory (DMA_HandleTypeDef *hdma, uint32_t Address, HAL_DMA_MemoryTypeDef memory);
+
+/* SD */
+typedef struct
+{
+  SDMMC_TypeDef              *Instance;
+} SD_HandleTypeDef;
+
+void HAL_SD_MspInit   (SD_HandleTypeDef *hsd);
+void HAL_SD_MspDeInit (SD_HandleTypeDef *hsd);
+
+#endif /* __STM32F7xx_HAL_H */
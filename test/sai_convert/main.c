@@ -0,0 +1,564 @@
+/*
+ * Host test for the streaming sample format conversion of the STM32F7xx SAI
+ * driver.
+ *
+ * SAI_ConvertTx and SAI_ConvertRx are run on one DMA buffer half for every
+ * application format (float, Q31, Q15, 24-bit in 32-bit, packed 24-bit),
+ * every data size the driver accepts (8, 10, 16, 20, 24 and 32 bits) and
+ * every channel layout (interleaved, planar with 1 to 32 channels), for odd
+ * and even frame counts and for both buffer halves. The result is compared
+ * byte by byte with a reference implementation written from the format
+ * definitions, including the bytes outside the converted half.
+ *
+ * The reference works on a signed, left aligned 32-bit value per sample:
+ *   transmit: application sample -> Q31 (saturated) -> upper data bits
+ *   receive:  data bits, sign extended -> Q31 -> application sample
+ * Float samples are scaled by 2^31 and truncated, +1.0 saturates to
+ * 0x7FFFFFFF. NaN inputs are not defined by the driver and not tested.
+ *
+ * With the argument "bench" the driver conversion is timed instead and the
+ * host cycles (or ns) per sample are listed per format, data size and layout.
+ * Host numbers do not predict Cortex-M7 cycles, they compare formats and
+ * layouts and show regressions of the kernels.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define __INLINE        inline
+
+/* Signed saturation (CMSIS __SSAT) */
+static inline int32_t
+__SSAT (int32_t val, uint32_t sat)
+{
+  int32_t max = (int32_t) ((1U << (sat - 1U)) - 1U);
+
+  if (val > max)
+    {
+      return max;
+    }
+  if (val < (-max - 1))
+    {
+      return -max - 1;
+    }
+  return val;
+}
+
+#if (defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1))
+/* Halfword packing (CMSIS C definitions) */
+#define __PKHBT(ARG1, ARG2, ARG3) \
+  (((((uint32_t) (ARG1))) & 0x0000FFFFUL) | ((((uint32_t) (ARG2)) << (ARG3)) & 0xFFFF0000UL))
+#define __PKHTB(ARG1, ARG2, ARG3) \
+  (((((uint32_t) (ARG1))) & 0xFFFF0000UL) | ((((uint32_t) (ARG2)) >> (ARG3)) & 0x0000FFFFUL))
+#endif
+
+/* Stream fields used by the conversion (see CMSIS/Driver/SAI_STM32F7xx.h) */
+typedef struct _SAI_STREAM_INFO
+{
+  uint8_t *buf;                         // Pointer to DMA buffer
+  uint8_t data_bits;                    // Number of data bits
+  uint32_t format;                      // Application sample format
+  uint8_t *app;                         // Application buffer
+} SAI_STREAM_INFO;
+
+typedef const struct _SAI_STREAM
+{
+  SAI_STREAM_INFO *info;                // Pointer to Stream Run-Time information
+} SAI_STREAM;
+
+/* Extracted from CMSIS/Driver/SAI_STM32F7xx.h and .c by the makefile */
+#include "sai_format.h"
+#include "sai_convert.c"
+
+#define MAX_CH          32U             // Channels per frame
+#define MAX_FRAMES      8U              // Frames per buffer half (test)
+#define MAX_ITEMS       (2U * MAX_CH * MAX_FRAMES)
+
+static const uint32_t data_bits[] = { 8U, 10U, 16U, 20U, 24U, 32U };
+
+static const uint32_t formats[] =
+  {
+    ARM_SAI_FORMAT_FLOAT,
+    ARM_SAI_FORMAT_Q31,
+    ARM_SAI_FORMAT_Q15,
+    ARM_SAI_FORMAT_INT24,
+    ARM_SAI_FORMAT_PACKED_24,
+  };
+
+static const char *const format_name[] =
+  {
+    "none", "float", "Q31", "Q15", "int24", "packed24",
+  };
+
+/* Application sample size in bytes */
+static uint32_t
+app_size (uint32_t format)
+{
+  switch (format)
+    {
+    case ARM_SAI_FORMAT_Q15:
+      return 2U;
+    case ARM_SAI_FORMAT_PACKED_24:
+      return 3U;
+    default:
+      return 4U;
+    }
+}
+
+/* Slot container size in bytes */
+static uint32_t
+slot_size (uint32_t bits)
+{
+  return (bits > 16U) ? 4U : ((bits > 8U) ? 2U : 1U);
+}
+
+/* Little endian load/store of n bytes */
+static uint32_t
+load_le (const uint8_t *p, uint32_t n)
+{
+  uint32_t v = 0U;
+
+  while (n-- != 0U)
+    {
+      v = (v << 8) | p[n];
+    }
+  return v;
+}
+
+static void
+store_le (uint8_t *p, uint32_t n, uint32_t v)
+{
+  uint32_t k;
+
+  for (k = 0U; k < n; k++)
+    {
+      p[k] = (uint8_t) (v >> (8U * k));
+    }
+}
+
+/* Application sample j as left aligned Q31 (saturated) */
+static int32_t
+ref_to_q31 (uint32_t format, const uint8_t *app, uint32_t j)
+{
+  float f;
+  double d;
+  int64_t v;
+
+  switch (format)
+    {
+    case ARM_SAI_FORMAT_FLOAT:
+      memcpy (&f, &app[j * 4U], 4U);
+      d = (double) f * 2147483648.0;
+      if (d > 2147483647.0)
+        {
+          return INT32_MAX;
+        }
+      if (d < -2147483648.0)
+        {
+          return INT32_MIN;
+        }
+      return (int32_t) d;
+    case ARM_SAI_FORMAT_Q31:
+      return (int32_t) load_le (&app[j * 4U], 4U);
+    case ARM_SAI_FORMAT_Q15:
+      return (int32_t) ((int64_t) (int16_t) load_le (&app[j * 2U], 2U) * 65536);
+    case ARM_SAI_FORMAT_INT24:
+      v = (int32_t) load_le (&app[j * 4U], 4U);
+      if (v > 0x7FFFFF)
+        {
+          v = 0x7FFFFF;
+        }
+      if (v < -0x800000)
+        {
+          v = -0x800000;
+        }
+      return (int32_t) (v * 256);
+    default:
+      v = load_le (&app[j * 3U], 3U);
+      if (v >= 0x800000)
+        {
+          v -= 0x1000000;
+        }
+      return (int32_t) (v * 256);
+    }
+}
+
+/* Store left aligned Q31 as application sample j */
+static void
+ref_from_q31 (uint32_t format, uint8_t *app, uint32_t j, int32_t q31)
+{
+  float f;
+
+  switch (format)
+    {
+    case ARM_SAI_FORMAT_FLOAT:
+      f = (float) ((double) q31 / 2147483648.0);
+      memcpy (&app[j * 4U], &f, 4U);
+      break;
+    case ARM_SAI_FORMAT_Q31:
+      store_le (&app[j * 4U], 4U, (uint32_t) q31);
+      break;
+    case ARM_SAI_FORMAT_Q15:
+      store_le (&app[j * 2U], 2U, (uint32_t) (((int64_t) q31 - (q31 & 0xFFFF)) / 65536));
+      break;
+    case ARM_SAI_FORMAT_INT24:
+      store_le (&app[j * 4U], 4U, (uint32_t) (((int64_t) q31 - (q31 & 0xFF)) / 256));
+      break;
+    default:
+      store_le (&app[j * 3U], 3U, (uint32_t) (((int64_t) q31 - (q31 & 0xFF)) / 256));
+      break;
+    }
+}
+
+/* Upper data bits of a Q31 value, right aligned */
+static uint32_t
+ref_slot (int32_t q31, uint32_t bits)
+{
+  return (uint32_t) (((int64_t) q31 >> (32U - bits)) & ((1LL << bits) - 1));
+}
+
+/* Sign extended data bits of a slot, as Q31 */
+static int32_t
+ref_q31 (uint32_t slot, uint32_t bits)
+{
+  int64_t v = slot & ((1LL << bits) - 1);
+
+  if ((v & (1LL << (bits - 1U))) != 0)
+    {
+      v -= (1LL << bits);
+    }
+  return (int32_t) (v * (1LL << (32U - bits)));
+}
+
+/* Application sample index of data item i in a buffer half at offset */
+static uint32_t
+ref_index (uint32_t offset, uint32_t i, uint32_t ch, uint32_t frames)
+{
+  uint32_t k = i - offset;
+
+  return offset + ((k % ch) * frames) + (k / ch);
+}
+
+static void
+ref_tx (uint32_t format, uint32_t bits, uint32_t ch, const uint8_t *app,
+        uint8_t *dma, uint32_t offset, uint32_t num)
+{
+  uint32_t i, ss;
+
+  ss = slot_size (bits);
+  for (i = offset; i < (offset + num); i++)
+    {
+      store_le (&dma[i * ss], ss,
+                ref_slot (ref_to_q31 (format, app,
+                                      ref_index (offset, i, ch, num / ch)),
+                          bits));
+    }
+}
+
+static void
+ref_rx (uint32_t format, uint32_t bits, uint32_t ch, const uint8_t *dma,
+        uint8_t *app, uint32_t offset, uint32_t num)
+{
+  uint32_t i, ss;
+
+  ss = slot_size (bits);
+  for (i = offset; i < (offset + num); i++)
+    {
+      ref_from_q31 (format, app, ref_index (offset, i, ch, num / ch),
+                    ref_q31 (load_le (&dma[i * ss], ss), bits));
+    }
+}
+
+/* Pseudo random generator (xorshift32), reproducible */
+static uint32_t rnd_state = 0x12345678U;
+
+static uint32_t
+rnd (void)
+{
+  rnd_state ^= rnd_state << 13;
+  rnd_state ^= rnd_state >> 17;
+  rnd_state ^= rnd_state << 5;
+  return rnd_state;
+}
+
+/* Fill application buffer with n samples, including full scale values */
+static void
+fill_app (uint32_t format, uint8_t *app, uint32_t n)
+{
+  static const float edge[] =
+    { 1.0f, -1.0f, 0.0f, -0.0f, 1.5f, -1.5f, 0.99999994f, 1.0e-10f };
+  uint32_t j, r;
+  float f;
+
+  for (j = 0U; j < n; j++)
+    {
+      r = rnd ();
+      switch (format)
+        {
+        case ARM_SAI_FORMAT_FLOAT:
+          if ((r & 7U) == 0U)
+            {
+              f = edge[(r >> 3) % (sizeof (edge) / sizeof (edge[0]))];
+            }
+          else
+            {
+              f = ((float) (int32_t) rnd () / 2147483648.0f) * 1.25f;
+            }
+          memcpy (&app[j * 4U], &f, 4U);
+          break;
+        case ARM_SAI_FORMAT_INT24:
+          if ((r & 3U) == 0U)
+            {
+              /* Out of 24-bit range, saturated */
+              store_le (&app[j * 4U], 4U, rnd ());
+            }
+          else
+            {
+              store_le (&app[j * 4U], 4U,
+                        (uint32_t) ((int32_t) rnd () >> 8));
+            }
+          break;
+        default:
+          store_le (&app[j * app_size (format)], app_size (format), r);
+          break;
+        }
+    }
+}
+
+static uint8_t app_buf[MAX_ITEMS * 4U] __attribute__ ((aligned (4)));
+static uint8_t app_ref[MAX_ITEMS * 4U] __attribute__ ((aligned (4)));
+static uint8_t dma_buf[MAX_ITEMS * 4U] __attribute__ ((aligned (4)));
+static uint8_t dma_ref[MAX_ITEMS * 4U] __attribute__ ((aligned (4)));
+
+/* Convert one buffer half both ways, returns number of mismatches */
+static uint32_t
+check_case (uint32_t format, uint32_t bits, uint32_t ch, uint32_t frames,
+            uint32_t half)
+{
+  SAI_STREAM_INFO info;
+  SAI_STREAM stream = { &info };
+  uint32_t num, offset, items, k, failed;
+
+  failed = 0U;
+  num    = ch * frames;
+  offset = half * num;
+  items  = 2U * num;
+
+  info.buf       = dma_buf;
+  info.app       = app_buf;
+  info.data_bits = (uint8_t) bits;
+  info.format    = format;
+  if (ch != 0U)
+    {
+      info.format |= ARM_SAI_FORMAT_PLANAR | ARM_SAI_FORMAT_CHANNELS (ch);
+    }
+  else
+    {
+      /* Interleaved: any number of items, channel count ignored */
+      info.format |= ARM_SAI_FORMAT_CHANNELS (2U);
+      ch   = 1U;
+      num  = frames;
+      offset = half * num;
+      items  = 2U * num;
+    }
+
+  /* Transmit: application samples to slot data */
+  fill_app (format, app_buf, items);
+  for (k = 0U; k < sizeof (dma_buf); k++)
+    {
+      dma_buf[k] = (uint8_t) (0xA5U + k);
+    }
+  memcpy (dma_ref, dma_buf, sizeof (dma_buf));
+
+  SAI_ConvertTx (&stream, offset, num);
+  ref_tx (format, bits, ch, app_buf, dma_ref, offset, num);
+
+  if (memcmp (dma_buf, dma_ref, sizeof (dma_buf)) != 0)
+    {
+      failed++;
+    }
+
+  /* Receive: slot data (random unused container bits) to samples */
+  for (k = 0U; k < sizeof (dma_buf); k++)
+    {
+      dma_buf[k] = (uint8_t) rnd ();
+    }
+  for (k = 0U; k < sizeof (app_buf); k++)
+    {
+      app_buf[k] = (uint8_t) (0x5AU + k);
+    }
+  memcpy (app_ref, app_buf, sizeof (app_buf));
+
+  SAI_ConvertRx (&stream, offset, num);
+  ref_rx (format, bits, ch, dma_buf, app_ref, offset, num);
+
+  if (memcmp (app_buf, app_ref, sizeof (app_buf)) != 0)
+    {
+      failed += 2U;
+    }
+
+  return failed;
+}
+
+static int
+run_check (void)
+{
+  static const uint32_t frame_counts[] = { 1U, 6U, 7U };
+  uint32_t f, b, ch, n, half, err, cases, failed;
+
+  cases  = 0U;
+  failed = 0U;
+
+  for (f = 0U; f < (sizeof (formats) / sizeof (formats[0])); f++)
+    {
+      for (b = 0U; b < (sizeof (data_bits) / sizeof (data_bits[0])); b++)
+        {
+          /* ch = 0: interleaved, else planar with ch channels */
+          for (ch = 0U; ch <= MAX_CH; ch++)
+            {
+              for (n = 0U; n < (sizeof (frame_counts) / sizeof (frame_counts[0])); n++)
+                {
+                  for (half = 0U; half < 2U; half++)
+                    {
+                      err = check_case (formats[f], data_bits[b], ch,
+                                        frame_counts[n], half);
+                      cases++;
+                      if (err != 0U)
+                        {
+                          failed++;
+                          printf ("%-8s %2u bits %s %2u ch %u frames half %u:%s%s\n",
+                                  format_name[formats[f]],
+                                  (unsigned) data_bits[b],
+                                  (ch != 0U) ? "planar" : "interleaved",
+                                  (unsigned) ch, (unsigned) frame_counts[n],
+                                  (unsigned) half,
+                                  ((err & 1U) != 0U) ? " TX differs" : "",
+                                  ((err & 2U) != 0U) ? " RX differs" : "");
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+  printf ("%s: %u cases, %u failed\n",
+#if (defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1))
+          "DSP path",
+#else
+          "C path",
+#endif
+          (unsigned) cases, (unsigned) failed);
+
+  return (failed != 0U) ? 1 : 0;
+}
+
+/* Time stamp in host cycles (x86 time stamp counter) or ns */
+static uint64_t
+stamp (void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __builtin_ia32_rdtsc ();
+#else
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ((uint64_t) ts.tv_sec * 1000000000U) + (uint64_t) ts.tv_nsec;
+#endif
+}
+
+#define BENCH_FRAMES    256U
+#define BENCH_REPEAT    2000U
+
+static int
+run_bench (void)
+{
+  static const uint32_t bench_bits[] = { 16U, 24U, 32U };
+  static const uint32_t bench_ch[] = { 0U, 2U, 8U };
+  static uint8_t app[2U * 8U * BENCH_FRAMES * 4U] __attribute__ ((aligned (4)));
+  static uint8_t dma[2U * 8U * BENCH_FRAMES * 4U] __attribute__ ((aligned (4)));
+  SAI_STREAM_INFO info;
+  SAI_STREAM stream = { &info };
+  uint32_t f, b, c, r, num;
+  uint64_t t0, t1, t2;
+
+  printf ("%s, %s per sample\n",
+#if (defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1))
+          "DSP path",
+#else
+          "C path",
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+          "host cycles"
+#else
+          "ns"
+#endif
+          );
+  printf ("format   bits layout           TX      RX\n");
+
+  fill_app (ARM_SAI_FORMAT_Q31, app, sizeof (app) / 4U);
+  fill_app (ARM_SAI_FORMAT_Q31, dma, sizeof (dma) / 4U);
+
+  for (f = 0U; f < (sizeof (formats) / sizeof (formats[0])); f++)
+    {
+      for (b = 0U; b < (sizeof (bench_bits) / sizeof (bench_bits[0])); b++)
+        {
+          for (c = 0U; c < (sizeof (bench_ch) / sizeof (bench_ch[0])); c++)
+            {
+              info.buf       = dma;
+              info.app       = app;
+              info.data_bits = (uint8_t) bench_bits[b];
+              info.format    = formats[f];
+              if (bench_ch[c] != 0U)
+                {
+                  info.format |= ARM_SAI_FORMAT_PLANAR
+                      | ARM_SAI_FORMAT_CHANNELS (bench_ch[c]);
+                  num = bench_ch[c] * BENCH_FRAMES;
+                }
+              else
+                {
+                  num = 2U * BENCH_FRAMES;
+                }
+              if (formats[f] == ARM_SAI_FORMAT_FLOAT)
+                {
+                  /* Valid float samples */
+                  fill_app (ARM_SAI_FORMAT_FLOAT, app, 2U * num);
+                }
+
+              t0 = stamp ();
+              for (r = 0U; r < BENCH_REPEAT; r++)
+                {
+                  SAI_ConvertTx (&stream, (r & 1U) * num, num);
+                }
+              t1 = stamp ();
+              for (r = 0U; r < BENCH_REPEAT; r++)
+                {
+                  SAI_ConvertRx (&stream, (r & 1U) * num, num);
+                }
+              t2 = stamp ();
+
+              printf ("%-8s %4u %-11s %2u ch %7.2f %7.2f\n",
+                      format_name[formats[f]], (unsigned) bench_bits[b],
+                      (bench_ch[c] != 0U) ? "planar" : "interleaved",
+                      (unsigned) ((bench_ch[c] != 0U) ? bench_ch[c] : 2U),
+                      (double) (t1 - t0) / ((double) BENCH_REPEAT * num),
+                      (double) (t2 - t1) / ((double) BENCH_REPEAT * num));
+            }
+        }
+    }
+
+  return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  if ((argc > 1) && (strcmp (argv[1], "bench") == 0))
+    {
+      return run_bench ();
+    }
+  return run_check ();
+}